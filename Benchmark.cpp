@@ -0,0 +1,2230 @@
+// BENCHMARK DRIVER
+// Standalone timing program for the city graph engines, built separately
+// from the main application:
+//
+//   g++ -O2 -std=c++11 -pthread -o city_benchmark Benchmark.cpp
+//   ./city_benchmark routing [nodes ...]     (default: 10000 100000 1000000)
+//   ./city_benchmark ch [nodes ...]          (default: 10000 100000)
+//   ./city_benchmark spatial [nodes ...]     (default: 10000 100000 1000000)
+//   ./city_benchmark locations [count ...]   (default: 10000 200000)
+//   ./city_benchmark matrix [nodes] [size]   (default: 100000 nodes, 2000 x 2000)
+//   ./city_benchmark cache [nodes ...]       (default: 10000 100000)
+//   ./city_benchmark remove [nodes ...]      (default: 10000 100000 1000000)
+//   ./city_benchmark engine [nodes ...]      (default: 100000 1000000)
+//   ./city_benchmark hot [nodes ...]         (default: 100000 1000000)
+//   ./city_benchmark yen [nodes ...]         (default: 10000 50000)
+//   ./city_benchmark delta [nodes ...]       (default: 1000000)
+//   ./city_benchmark components [nodes ...]  (default: 100000 1000000)
+//   ./city_benchmark isochrone [nodes ...]   (default: 1000000)
+//   ./city_benchmark traffic [nodes ...]     (default: 100000 1000000)
+//   ./city_benchmark overlay [nodes ...]     (default: 100000 1000000)
+//   ./city_benchmark generate [citizens] [seed]  (default: 100000 citizens, seed 42)
+//   ./city_benchmark load [citizens ...]     (default: 1000 10000 100000)
+//   ./city_benchmark snapshot [citizens ...] (default: 10000 100000)
+//   ./city_benchmark csv [rows]              (default: 10000000)
+//   ./city_benchmark numbers [count]         (default: 10000000)
+//   ./city_benchmark pipeline [citizens ...] (default: 10000 100000)
+//   ./city_benchmark ingest [citizens ...]   (default: 100000 1000000 5000000)
+//   ./city_benchmark btree [citizens ...]    (default: 100000 1000000)
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <chrono>
+
+#include "Utils.h"
+#include "GlobalLocationManager.h"
+#include "CityGraph.h"
+#include "ContractionHierarchy.h"
+#include "Transport.h"
+#include "Commercial.h"
+#include "Facilities.h"
+#include "RoadOverlay.h"
+#include "Medical.h"
+#include "Education.h"
+#include "Population.h"
+#include "CityGenerator.h"
+#include "CitySnapshot.h"
+#include "LoadPipeline.h"
+
+using namespace std;
+
+// Milliseconds elapsed since start
+double elapsedMs(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+string gridID(int row, int col) {
+    return "G" + intToString(row) + "_" + intToString(col);
+}
+
+// Build a side x side grid city (about 'nodes' locations). Road lengths are
+// the straight-line distance stretched by up to 50%, like real streets.
+int buildGridCity(int nodes, unsigned int seed) {
+    CityGraph* cityGraph = CityGraph::getInstance();
+    cityGraph->reset();
+    srand(seed);
+
+    int side = 1;
+    while (side * side < nodes) side++;
+
+    const double spacing = 0.001;
+    for (int r = 0; r < side; r++) {
+        for (int c = 0; c < side; c++) {
+            cityGraph->addLocation(gridID(r, c), gridID(r, c), (r * side + c) % 8,
+                33.6 + r * spacing, 73.0 + c * spacing);
+        }
+    }
+
+    for (int r = 0; r < side; r++) {
+        for (int c = 0; c < side; c++) {
+            double stretch = 1.0 + (rand() % 50) / 100.0;
+            if (c + 1 < side) cityGraph->connectLocations(gridID(r, c), gridID(r, c + 1), spacing * stretch);
+            stretch = 1.0 + (rand() % 50) / 100.0;
+            if (r + 1 < side) cityGraph->connectLocations(gridID(r, c), gridID(r + 1, c), spacing * stretch);
+        }
+    }
+    return side;
+}
+
+// ROUTING: Dijkstra vs A* vs ALT
+
+void runRoutingBenchmark(int nodes) {
+    const int QUERIES = 200;
+    CityGraph* cityGraph = CityGraph::getInstance();
+    cityGraph->getPathCache().setCapacity(0);   // Time the searches themselves
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    int side = buildGridCity(nodes, 42);
+    cityGraph->ensureCompactGraph();
+    double buildMs = elapsedMs(start);
+
+    start = chrono::steady_clock::now();
+    cityGraph->rebuildLandmarks();
+    double landmarkMs = elapsedMs(start);
+
+    cout << "\n=== Routing: " << side << " x " << side << " grid ("
+        << cityGraph->getLocationCount() << " nodes) ===" << endl;
+    cout << "Graph build: " << buildMs << " ms, ALT landmarks: " << landmarkMs << " ms" << endl;
+
+    string* srcIDs = new string[QUERIES];
+    string* destIDs = new string[QUERIES];
+    double* expected = new double[QUERIES];
+    srand(7);
+    for (int q = 0; q < QUERIES; q++) {
+        srcIDs[q] = gridID(rand() % side, rand() % side);
+        destIDs[q] = gridID(rand() % side, rand() % side);
+    }
+
+    int maxPathLen = 4 * side + 10;
+    string* path = new string[maxPathLen];
+    int pathLen = 0;
+
+    const int modes[3] = { ROUTE_DIJKSTRA, ROUTE_ASTAR, ROUTE_ALT };
+    const string modeNames[3] = { "Dijkstra", "A*", "ALT" };
+
+    cout << left << setw(10) << "Mode" << right << setw(16) << "Avg settled"
+        << setw(14) << "Avg ms" << setw(12) << "Mismatch" << endl;
+
+    for (int m = 0; m < 3; m++) {
+        long long settled = 0;
+        int mismatches = 0;
+
+        start = chrono::steady_clock::now();
+        for (int q = 0; q < QUERIES; q++) {
+            double dist = cityGraph->findShortestPath(srcIDs[q], destIDs[q], path, pathLen, maxPathLen, modes[m]);
+            settled += cityGraph->getLastSettledCount();
+
+            if (m == 0) expected[q] = dist;
+            else if (fabs(dist - expected[q]) > 1e-9 * (1.0 + expected[q])) mismatches++;
+        }
+        double totalMs = elapsedMs(start);
+
+        cout << left << setw(10) << modeNames[m] << right << setw(16) << (settled / QUERIES)
+            << setw(14) << fixed << setprecision(3) << (totalMs / QUERIES)
+            << setw(12) << mismatches << endl;
+        cout.unsetf(ios::fixed);
+        cout << setprecision(6);
+    }
+
+    delete[] path;
+    delete[] srcIDs;
+    delete[] destIDs;
+    delete[] expected;
+}
+
+// CONTRACTION HIERARCHIES: preprocessing cost and query speed-up
+
+void runCHBenchmark(int nodes) {
+    const int QUERIES = 200;
+    CityGraph* cityGraph = CityGraph::getInstance();
+    CityContractionHierarchy* ch = CityContractionHierarchy::getInstance();
+    cityGraph->getPathCache().setCapacity(0);
+
+    int side = buildGridCity(nodes, 42);
+    cityGraph->ensureCompactGraph();
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    ch->build();
+    double buildMs = elapsedMs(start);
+
+    start = chrono::steady_clock::now();
+    ch->saveToFile("benchmark_grid.ch");
+    double saveMs = elapsedMs(start);
+
+    cout << "\n=== Contraction Hierarchies: " << cityGraph->getLocationCount() << " nodes ===" << endl;
+    cout << "Preprocessing: " << buildMs << " ms (" << ch->getShortcutCount() << " shortcuts), save: "
+        << saveMs << " ms" << endl;
+
+    int maxPathLen = 4 * side + 10;
+    string* path = new string[maxPathLen];
+    int pathLen = 0;
+    double dijkstraMs = 0;
+    double chMs = 0;
+    int mismatches = 0;
+
+    srand(7);
+    for (int q = 0; q < QUERIES; q++) {
+        string src = gridID(rand() % side, rand() % side);
+        string dest = gridID(rand() % side, rand() % side);
+
+        start = chrono::steady_clock::now();
+        double expected = cityGraph->findShortestPath(src, dest, path, pathLen, maxPathLen);
+        dijkstraMs += elapsedMs(start);
+
+        start = chrono::steady_clock::now();
+        double dist = ch->findShortestPath(src, dest, path, pathLen, maxPathLen);
+        chMs += elapsedMs(start);
+
+        if (fabs(dist - expected) > 1e-9 * (1.0 + expected)) mismatches++;
+    }
+
+    cout << "Avg query: Dijkstra " << (dijkstraMs / QUERIES) << " ms, CH " << (chMs / QUERIES)
+        << " ms, mismatches: " << mismatches << endl;
+
+    remove("benchmark_grid.ch");
+    delete[] path;
+}
+
+// SPATIAL INDEX: grid nearest / k-nearest / radius vs a full scan
+
+void runSpatialBenchmark(int nodes) {
+    const int QUERIES = 1000;
+    const int K = 5;
+    CityGraph* cityGraph = CityGraph::getInstance();
+    cityGraph->reset();
+
+    // Random locations scattered over a city-sized square (about 50 km)
+    srand(42);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < nodes; i++) {
+        double lat = 33.5 + (rand() % 100000) * 0.000005;
+        double lon = 72.8 + (rand() % 100000) * 0.000005;
+        cityGraph->addLocation("P" + intToString(i), "Point", i % LOCATION_TYPE_COUNT, lat, lon);
+    }
+    double buildMs = elapsedMs(start);
+
+    cout << "\n=== Spatial index: " << nodes << " locations ===" << endl;
+    cout << "Insert: " << buildMs << " ms" << endl;
+
+    CityLocation** all = new CityLocation * [nodes];
+    int total = 0;
+    for (int t = 0; t < LOCATION_TYPE_COUNT; t++) {
+        total += cityGraph->getLocationsOfType(t, all + total, nodes - total);
+    }
+
+    CityLocation* found[K];
+    double foundDist[K];
+    CityLocation** inRadius = new CityLocation * [1024];
+    double* inRadiusDist = new double[1024];
+
+    double scanMs = 0, gridMs = 0, kMs = 0, radiusMs = 0;
+    int mismatches = 0;
+
+    srand(7);
+    for (int q = 0; q < QUERIES; q++) {
+        double lat = 33.5 + (rand() % 100000) * 0.000005;
+        double lon = 72.8 + (rand() % 100000) * 0.000005;
+        int type = q % LOCATION_TYPE_COUNT;
+
+        // Full scan, as findNearestOfType used to work
+        start = chrono::steady_clock::now();
+        double best = DBL_MAX;
+        for (int i = 0; i < total; i++) {
+            if (all[i]->type != type) continue;
+            double dist = calculateDistance(lat, lon, all[i]->lat, all[i]->lon);
+            if (dist < best) best = dist;
+        }
+        scanMs += elapsedMs(start);
+
+        start = chrono::steady_clock::now();
+        double gridDist = DBL_MAX;
+        cityGraph->findNearestOfType(lat, lon, type, gridDist);
+        gridMs += elapsedMs(start);
+
+        start = chrono::steady_clock::now();
+        int count = cityGraph->findKNearestOfType(lat, lon, type, K, found, foundDist);
+        kMs += elapsedMs(start);
+
+        start = chrono::steady_clock::now();
+        cityGraph->findLocationsInRadius(lat, lon, 0.005, type, inRadius, inRadiusDist, 1024);
+        radiusMs += elapsedMs(start);
+
+        if (fabs(gridDist - best) > 1e-12 || count == 0 || fabs(foundDist[0] - best) > 1e-12) mismatches++;
+    }
+
+    cout << "Avg query: scan " << (scanMs / QUERIES) << " ms, grid nearest " << (gridMs / QUERIES)
+        << " ms, " << K << "-nearest " << (kMs / QUERIES) << " ms, radius " << (radiusMs / QUERIES)
+        << " ms, mismatches: " << mismatches << endl;
+
+    delete[] all;
+    delete[] inRadius;
+    delete[] inRadiusDist;
+}
+
+// LOCATION REGISTRY: GlobalLocationManager occupancy checks
+
+void runLocationRegistryBenchmark(int count) {
+    GlobalLocationManager* locMgr = GlobalLocationManager::getInstance();
+    locMgr->reset();
+
+    // Entities on a 0.001 grid, then a second pass that must all collide
+    int side = 1;
+    while (side * side < count) side++;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    int registered = 0;
+    for (int i = 0; i < count; i++) {
+        if (locMgr->registerLocation(33.5 + (i / side) * 0.001, 72.8 + (i % side) * 0.001, "Benchmark", "Entity")) {
+            registered++;
+        }
+    }
+    double registerMs = elapsedMs(start);
+
+    start = chrono::steady_clock::now();
+    int collisions = 0;
+    string occupiedBy;
+    for (int i = 0; i < count; i++) {
+        if (locMgr->isLocationOccupied(33.5 + (i / side) * 0.001 + 0.00005, 72.8 + (i % side) * 0.001 - 0.00005, occupiedBy)) {
+            collisions++;
+        }
+    }
+    double checkMs = elapsedMs(start);
+
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) {
+        locMgr->removeLocation(33.5 + (i / side) * 0.001, 72.8 + (i % side) * 0.001);
+    }
+    double removeMs = elapsedMs(start);
+
+    cout << "\n=== Location registry: " << count << " entities ===" << endl;
+    cout << "Register: " << registerMs << " ms (" << registered << " ok), occupancy checks: " << checkMs
+        << " ms (" << collisions << " hits), remove: " << removeMs << " ms, left: "
+        << locMgr->getLocationCount() << endl;
+}
+
+// DISTANCE MATRIX: many-to-many on the thread pool
+
+void runMatrixBenchmark(int nodes, int size) {
+    CityGraph* cityGraph = CityGraph::getInstance();
+    CityThreadPool* pool = CityThreadPool::getInstance();
+    int side = buildGridCity(nodes, 42);
+    cityGraph->ensureCompactGraph();
+
+    string* sources = new string[size];
+    string* targets = new string[size];
+    srand(7);
+    for (int i = 0; i < size; i++) {
+        sources[i] = gridID(rand() % side, rand() % side);
+        targets[i] = gridID(rand() % side, rand() % side);
+    }
+
+    cout << "\n=== Distance matrix: " << size << " x " << size << " on " << cityGraph->getLocationCount()
+        << " nodes ===" << endl;
+
+    int hardware = pool->getThreadCount();
+    // 1, 2, 4, ... threads, finishing with every hardware thread
+    for (int threads = 1; ; threads = (threads * 2 < hardware) ? threads * 2 : hardware) {
+        pool->setThreadCount(threads);
+        CityDistanceMatrix matrix;
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        cityGraph->distanceMatrix(sources, size, targets, size, matrix);
+        double ms = elapsedMs(start);
+
+        // Spot check against single point-to-point queries
+        int maxPathLen = 4 * side + 10;
+        string* path = new string[maxPathLen];
+        int pathLen = 0;
+        int mismatches = 0;
+        for (int q = 0; q < 20; q++) {
+            int r = rand() % size, c = rand() % size;
+            double expected = cityGraph->findShortestPath(sources[r], targets[c], path, pathLen, maxPathLen);
+            if (fabs(expected - matrix.at(r, c)) > 1e-9 * (1.0 + expected)) mismatches++;
+        }
+        delete[] path;
+
+        cout << "Threads: " << setw(2) << threads << "  time: " << ms << " ms  mismatches: " << mismatches << endl;
+        if (threads == hardware) break;
+    }
+    pool->setThreadCount(hardware);
+
+    delete[] sources;
+    delete[] targets;
+}
+
+// PATH CACHE: repeated dispatcher queries with and without the LRU cache
+
+void runPathCacheBenchmark(int nodes) {
+    const int HOT_PAIRS = 100;
+    const int QUERIES = 2000;
+    CityGraph* cityGraph = CityGraph::getInstance();
+    int side = buildGridCity(nodes, 42);
+    cityGraph->ensureCompactGraph();
+
+    string* srcIDs = new string[HOT_PAIRS];
+    string* destIDs = new string[HOT_PAIRS];
+    srand(7);
+    for (int i = 0; i < HOT_PAIRS; i++) {
+        srcIDs[i] = gridID(rand() % side, rand() % side);
+        destIDs[i] = gridID(rand() % side, rand() % side);
+    }
+
+    int maxPathLen = 4 * side + 10;
+    string* path = new string[maxPathLen];
+    int pathLen = 0;
+
+    cout << "\n=== Path cache: " << cityGraph->getLocationCount() << " nodes, " << QUERIES
+        << " queries over " << HOT_PAIRS << " pairs ===" << endl;
+
+    double uncachedMs = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        cityGraph->getPathCache().setCapacity(pass == 0 ? 0 : PATH_CACHE_DEFAULT_CAPACITY);
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        double checksum = 0;
+        for (int q = 0; q < QUERIES; q++) {
+            int pair = (q * 7919) % HOT_PAIRS;
+            checksum += cityGraph->findShortestPath(srcIDs[pair], destIDs[pair], path, pathLen, maxPathLen);
+        }
+        double ms = elapsedMs(start);
+        if (pass == 0) uncachedMs = ms;
+
+        cout << (pass == 0 ? "Without cache: " : "With cache:    ") << ms << " ms (checksum " << checksum << ")";
+        if (pass == 1) cout << "  speed-up x" << (uncachedMs / ms);
+        cout << endl;
+    }
+    cityGraph->getPathCache().displayStats("Cache");
+
+    // A road edit bumps the graph version, so every entry goes stale
+    cityGraph->connectLocations(gridID(0, 0), gridID(side - 1, side - 1), 0.001);
+    for (int i = 0; i < HOT_PAIRS; i++) {
+        cityGraph->findShortestPath(srcIDs[i], destIDs[i], path, pathLen, maxPathLen);
+    }
+    cityGraph->getPathCache().displayStats("After edit");
+
+    delete[] path;
+    delete[] srcIDs;
+    delete[] destIDs;
+}
+
+// LOCATION REMOVAL: decommissioning a whole sector
+
+void runRemovalBenchmark(int nodes) {
+    CityGraph* cityGraph = CityGraph::getInstance();
+    int side = buildGridCity(nodes, 42);
+
+    // A square block of about 500 locations in the middle of the grid
+    int block = 22;
+    if (block > side) block = side;
+    int first = (side - block) / 2;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    int removed = 0;
+    for (int r = first; r < first + block; r++) {
+        for (int c = first; c < first + block; c++) {
+            if (cityGraph->removeLocation(gridID(r, c))) removed++;
+        }
+    }
+    double ms = elapsedMs(start);
+
+    cityGraph->ensureCompactGraph();
+    cout << "\n=== Removal: " << removed << " of " << (side * side) << " locations ===" << endl;
+    cout << "Total: " << ms << " ms (" << (ms / removed) << " ms each), roads left: "
+        << (cityGraph->getCompactEdgeCount() / 2) << endl;
+}
+
+// ROUTING ENGINE: heap arity, and module networks against the old searches
+
+// Full single-source search with heap arity ARITY; returns the checksum of distances
+template <int ARITY>
+double timeArity(const CityCompactGraph& graph, const int sources[], int count, double& ms) {
+    CitySearchScratchT<ARITY> sc;
+    CitySettleAll goal;
+    double checksum = 0;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int q = 0; q < count; q++) {
+        cityShortestPaths(graph, goal, sources[q], sc);
+        for (int v = 0; v < graph.vertexCount(); v++) {
+            if (sc.isSettled(v)) checksum += sc.dist[v];
+        }
+    }
+    ms = elapsedMs(start) / count;
+    return checksum;
+}
+
+const string& adjID(AdjListNode* adj) { return adj->stopID; }
+const string& adjID(MallAdjNode* adj) { return adj->mallID; }
+const string& adjID(FacilityAdjNode* adj) { return adj->facilityID; }
+const string& edgeDestID(RoadEdge* edge) { return edge->destStopID; }
+const string& edgeDestID(MallEdge* edge) { return edge->destMallID; }
+const string& edgeDestID(FacilityEdge* edge) { return edge->destFacilityID; }
+
+// Grid network built from a module's own adjacency structs, both directions linked
+template <class AdjNode, class EdgeNode>
+AdjNode* buildModuleGrid(int side, unsigned int seed) {
+    srand(seed);
+    AdjNode** nodes = new AdjNode * [side * side];
+    AdjNode* head = nullptr;
+    for (int i = side * side - 1; i >= 0; i--) {
+        nodes[i] = new AdjNode("N" + intToString(i));
+        nodes[i]->next = head;
+        head = nodes[i];
+    }
+
+    for (int r = 0; r < side; r++) {
+        for (int c = 0; c < side; c++) {
+            for (int d = 0; d < 2; d++) {
+                int nr = r + d, nc = c + 1 - d;
+                if (nr >= side || nc >= side) continue;
+                AdjNode* a = nodes[r * side + c];
+                AdjNode* b = nodes[nr * side + nc];
+                double length = 1.0 + (rand() % 50) / 100.0;
+
+                EdgeNode* ab = new EdgeNode(adjID(b), length);
+                ab->destAdj = b;
+                ab->next = a->edgeHead;
+                a->edgeHead = ab;
+                EdgeNode* ba = new EdgeNode(adjID(a), length);
+                ba->destAdj = a;
+                ba->next = b->edgeHead;
+                b->edgeHead = ba;
+            }
+        }
+    }
+    delete[] nodes;
+    return head;
+}
+
+template <class AdjNode, class EdgeNode>
+void freeModuleGrid(AdjNode* head) {
+    while (head != nullptr) {
+        AdjNode* adj = head;
+        head = head->next;
+        while (adj->edgeHead != nullptr) {
+            EdgeNode* edge = adj->edgeHead;
+            adj->edgeHead = edge->next;
+            delete edge;
+        }
+        delete adj;
+    }
+}
+
+// The per-module search this engine replaced: a 500-slot binary heap of
+// IDs and a linear scan of the ID list for every pop and every edge
+struct LegacyHeapEntry {
+    string id;
+    double distance;
+};
+
+template <class AdjNode, class EdgeNode>
+double legacyModuleDijkstra(AdjNode* head, const string& srcID, const string& destID) {
+    const int MAX_IDS = 500;
+    static string ids[MAX_IDS];
+    static double distances[MAX_IDS];
+    static bool visited[MAX_IDS];
+    static LegacyHeapEntry heap[MAX_IDS];
+
+    int count = 0;
+    for (AdjNode* adj = head; adj != nullptr && count < MAX_IDS; adj = adj->next) {
+        ids[count] = adjID(adj);
+        distances[count] = DBL_MAX;
+        visited[count] = false;
+        count++;
+    }
+    for (int i = 0; i < count; i++) {
+        if (stringsEqualIgnoreCase(ids[i], srcID)) distances[i] = 0;
+    }
+
+    int size = 0;
+    heap[size].id = srcID;
+    heap[size++].distance = 0;
+
+    while (size > 0) {
+        LegacyHeapEntry top = heap[0];
+        heap[0] = heap[--size];
+        for (int i = 0; ; ) {
+            int smallest = i, left = 2 * i + 1, right = 2 * i + 2;
+            if (left < size && heap[left].distance < heap[smallest].distance) smallest = left;
+            if (right < size && heap[right].distance < heap[smallest].distance) smallest = right;
+            if (smallest == i) break;
+            LegacyHeapEntry temp = heap[i];
+            heap[i] = heap[smallest];
+            heap[smallest] = temp;
+            i = smallest;
+        }
+
+        int currentIdx = -1;
+        for (int i = 0; i < count; i++) {
+            if (stringsEqualIgnoreCase(ids[i], top.id)) {
+                currentIdx = i;
+                break;
+            }
+        }
+        if (currentIdx == -1 || visited[currentIdx]) continue;
+        visited[currentIdx] = true;
+
+        AdjNode* adj = head;
+        while (adj != nullptr && !stringsEqualIgnoreCase(adjID(adj), top.id)) adj = adj->next;
+        if (adj == nullptr) continue;
+
+        for (EdgeNode* edge = adj->edgeHead; edge != nullptr; edge = edge->next) {
+            int neighborIdx = -1;
+            for (int i = 0; i < count; i++) {
+                if (stringsEqualIgnoreCase(ids[i], edgeDestID(edge))) {
+                    neighborIdx = i;
+                    break;
+                }
+            }
+            if (neighborIdx == -1 || visited[neighborIdx]) continue;
+
+            double newDist = distances[currentIdx] + edge->distance;
+            if (newDist < distances[neighborIdx] && size < MAX_IDS) {
+                distances[neighborIdx] = newDist;
+                int i = size++;
+                heap[i].id = edgeDestID(edge);
+                heap[i].distance = newDist;
+                while (i > 0 && heap[i].distance < heap[(i - 1) / 2].distance) {
+                    LegacyHeapEntry temp = heap[i];
+                    heap[i] = heap[(i - 1) / 2];
+                    heap[(i - 1) / 2] = temp;
+                    i = (i - 1) / 2;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (stringsEqualIgnoreCase(ids[i], destID)) return distances[i];
+    }
+    return DBL_MAX;
+}
+
+// Old search vs the engine on one module's structs (side x side grid)
+template <class AdjNode, class EdgeNode>
+void compareModuleSearch(const string& module, int side) {
+    const int QUERIES = 200;
+    AdjNode* head = buildModuleGrid<AdjNode, EdgeNode>(side, 7);
+    int nodes = side * side;
+
+    srand(99);
+    int* sources = new int[QUERIES];
+    int* targets = new int[QUERIES];
+    for (int q = 0; q < QUERIES; q++) {
+        sources[q] = rand() % nodes;
+        targets[q] = rand() % nodes;
+    }
+
+    double* legacy = new double[QUERIES];
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int q = 0; q < QUERIES; q++) {
+        legacy[q] = legacyModuleDijkstra<AdjNode, EdgeNode>(head,
+            "N" + intToString(sources[q]), "N" + intToString(targets[q]));
+    }
+    double legacyMs = elapsedMs(start) / QUERIES;
+
+    // Same lookups the module code does: find both adjacency nodes, then search
+    int mismatches = 0;
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < QUERIES; q++) {
+        CityLinkedGraph<AdjNode, EdgeNode> graph(head);
+        CityUntilTarget goal(targets[q]);
+        CitySearchScratch& sc = getCitySearchScratch();
+        cityShortestPaths(graph, goal, sources[q], sc);
+        double d = sc.distanceTo(targets[q]);
+        if (d < legacy[q] - 1e-9 || d > legacy[q] + 1e-9) mismatches++;
+    }
+    double engineMs = elapsedMs(start) / QUERIES;
+
+    cout << left << setw(12) << module << setw(8) << nodes << right << fixed << setprecision(4)
+        << setw(14) << legacyMs << setw(14) << engineMs << setprecision(1) << setw(9)
+        << (legacyMs / engineMs) << "x" << setw(12) << mismatches << endl;
+    cout.unsetf(ios::fixed);
+    cout << setprecision(6);
+
+    delete[] sources;
+    delete[] targets;
+    delete[] legacy;
+    freeModuleGrid<AdjNode, EdgeNode>(head);
+}
+
+void runEngineBenchmark(int nodes) {
+    const int QUERIES = 10;
+    CityGraph* cityGraph = CityGraph::getInstance();
+    buildGridCity(nodes, 42);
+    cityGraph->ensureCompactGraph();
+    CityCompactGraph graph(cityGraph->getCompactOffsets(), cityGraph->getCompactTargets(),
+        cityGraph->getCompactWeights(), cityGraph->getLocationCount());
+
+    srand(17);
+    int sources[QUERIES];
+    for (int q = 0; q < QUERIES; q++) {
+        sources[q] = rand() % graph.vertexCount();
+    }
+
+    cout << "\n=== Routing engine: " << graph.vertexCount() << " locations, full searches ===" << endl;
+    cout << left << setw(10) << "Arity" << right << setw(14) << "ms/search" << setw(22) << "checksum" << endl;
+    double ms;
+    double sum2 = timeArity<2>(graph, sources, QUERIES, ms);
+    cout << left << setw(10) << 2 << right << setw(14) << ms << setw(22) << sum2 << endl;
+    double sum4 = timeArity<4>(graph, sources, QUERIES, ms);
+    cout << left << setw(10) << 4 << right << setw(14) << ms << setw(22) << sum4 << endl;
+    double sum8 = timeArity<8>(graph, sources, QUERIES, ms);
+    cout << left << setw(10) << 8 << right << setw(14) << ms << setw(22) << sum8 << endl;
+    cout << "Built with CITY_HEAP_ARITY = " << CITY_HEAP_ARITY << endl;
+}
+
+// Module searches are capped at 500 IDs by the old code, so they run once
+void runModuleEngineBenchmark() {
+    cout << "\n=== Module networks: old per-module search vs routing engine ===" << endl;
+    cout << left << setw(12) << "Module" << setw(8) << "Nodes" << right << setw(14) << "old ms/query"
+        << setw(14) << "new ms/query" << setw(10) << "speedup" << setw(12) << "mismatches" << endl;
+    compareModuleSearch<AdjListNode, RoadEdge>("Transport", 10);
+    compareModuleSearch<MallAdjNode, MallEdge>("Commercial", 10);
+    compareModuleSearch<FacilityAdjNode, FacilityEdge>("Facilities", 10);
+    compareModuleSearch<AdjListNode, RoadEdge>("Transport", 22);
+    compareModuleSearch<MallAdjNode, MallEdge>("Commercial", 22);
+    compareModuleSearch<FacilityAdjNode, FacilityEdge>("Facilities", 22);
+}
+
+// HOT SOURCES: maintained nearest-hospital tree vs recomputing after each edit
+
+void runHotSourceBenchmark(int nodes) {
+    const int EDITS = 2000;
+    const int QUERIES = 100000;
+    CityGraph* cityGraph = CityGraph::getInstance();
+    int side = buildGridCity(nodes, 42);
+
+    // Vertex array in index order, as the graph keeps it
+    int count = cityGraph->getLocationCount();
+    CityLocation** vertices = new CityLocation * [count];
+    for (int r = 0; r < side; r++) {
+        for (int c = 0; c < side; c++) {
+            CityLocation* loc = cityGraph->findLocationByID(gridID(r, c));
+            vertices[loc->index] = loc;
+        }
+    }
+
+    CityShortestPathTree* tree = cityGraph->registerHotSources("Benchmark Hospitals", LOC_HOSPITAL);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    tree->build(vertices, count);
+    double buildMs = elapsedMs(start);
+
+    // Close and reopen random roads, as operators do during the day
+    srand(5);
+    long long touchedBefore = tree->getTouchedCount();
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < EDITS; i++) {
+        int r = rand() % side, c = rand() % (side - 1);
+        string a = gridID(r, c), b = gridID(r, c + 1);
+        double length = 0.001 * (1.0 + (rand() % 50) / 100.0);
+        cityGraph->removeRoad(a, b);
+        cityGraph->connectLocations(a, b, length);
+    }
+    double editMs = elapsedMs(start) / (2 * EDITS);
+    double touchedPerEdit = (double)(tree->getTouchedCount() - touchedBefore) / (2 * EDITS);
+
+    // Check against a fresh multi-source search
+    CityShortestPathTree check("Check", LOC_HOSPITAL);
+    check.build(vertices, count);
+    int mismatches = 0;
+    for (int v = 0; v < count; v++) {
+        double a = tree->distanceFrom(vertices[v]), b = check.distanceFrom(vertices[v]);
+        if ((a == DBL_MAX) != (b == DBL_MAX) || (a != DBL_MAX && (a - b > 1e-12 || b - a > 1e-12))) mismatches++;
+    }
+
+    double sum = 0;
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < QUERIES; q++) {
+        sum += tree->distanceFrom(vertices[rand() % count]);
+    }
+    double queryUs = elapsedMs(start) * 1000.0 / QUERIES;
+
+    cout << "\n=== Nearest hospital tree: " << count << " locations, "
+        << tree->getSourceCount() << " hospitals ===" << endl;
+    cout << "Full build: " << buildMs << " ms" << endl;
+    cout << "Road edit: " << editMs << " ms (" << touchedPerEdit << " locations recomputed on average)" << endl;
+    cout << "Query: " << queryUs << " us, mismatches after " << (2 * EDITS) << " edits: " << mismatches
+        << " (checksum " << sum << ")" << endl;
+
+    delete[] vertices;
+}
+
+// K SHORTEST PATHS: Yen's alternates, spur searches on 1 .. all threads
+
+void runKShortestBenchmark(int nodes) {
+    const int QUERIES = 10;
+    const int K = 10;
+    CityGraph* cityGraph = CityGraph::getInstance();
+    CityThreadPool* pool = CityThreadPool::getInstance();
+    int side = buildGridCity(nodes, 42);
+    cityGraph->ensureCompactGraph();
+
+    string srcIDs[QUERIES], destIDs[QUERIES];
+    srand(11);
+    for (int q = 0; q < QUERIES; q++) {
+        srcIDs[q] = gridID(rand() % side, rand() % side);
+        destIDs[q] = gridID(rand() % side, rand() % side);
+    }
+
+    cout << "\n=== k shortest paths: k = " << K << ", " << QUERIES << " queries on "
+        << cityGraph->getLocationCount() << " nodes ===" << endl;
+
+    int hardware = pool->getThreadCount();
+    double baseChecksum = -1;
+    for (int threads = 1; ; threads = (threads * 2 < hardware) ? threads * 2 : hardware) {
+        pool->setThreadCount(threads);
+        CityRouteResult routes[K];
+        double checksum = 0;
+        int found = 0;
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (int q = 0; q < QUERIES; q++) {
+            int count = cityGraph->findKShortestPaths(srcIDs[q], destIDs[q], K, routes);
+            for (int i = 0; i < count; i++) checksum += routes[i].distance;
+            found += count;
+        }
+        double ms = elapsedMs(start);
+        if (baseChecksum < 0) baseChecksum = checksum;
+
+        cout << "Threads: " << setw(2) << threads << "  time: " << ms / QUERIES << " ms/query  routes: " << found
+            << "  checksum " << (checksum == baseChecksum ? "matches" : "DIFFERS") << endl;
+        if (threads == hardware) break;
+    }
+    pool->setThreadCount(hardware);
+}
+
+// DELTA-STEPPING: parallel one-to-all search at 1 .. 16 threads vs Dijkstra
+
+void runDeltaSteppingBenchmark(int nodes) {
+    const int SOURCES = 3;
+    CityGraph* cityGraph = CityGraph::getInstance();
+    CityThreadPool* pool = CityThreadPool::getInstance();
+    int side = buildGridCity(nodes, 42);
+    cityGraph->ensureCompactGraph();
+    int count = cityGraph->getLocationCount();
+
+    string sources[SOURCES];
+    srand(13);
+    for (int i = 0; i < SOURCES; i++) {
+        sources[i] = gridID(rand() % side, rand() % side);
+    }
+
+    double* expected = new double[(long long)SOURCES * count];
+    double* dist = new double[count];
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < SOURCES; i++) {
+        cityGraph->distancesFrom(sources[i], expected + (long long)i * count, SSSP_DIJKSTRA);
+    }
+    double dijkstraMs = elapsedMs(start) / SOURCES;
+
+    cout << "\n=== Delta-stepping: one-to-all on " << count << " nodes ===" << endl;
+    cout << "Dijkstra:        " << dijkstraMs << " ms" << endl;
+
+    // Fixed thread counts so results compare across machines
+    int hardware = pool->getThreadCount();
+    const int threadCounts[] = { 1, 2, 4, 8, 16 };
+    for (int t = 0; t < 5; t++) {
+        pool->setThreadCount(threadCounts[t]);
+        int mismatches = 0;
+
+        start = chrono::steady_clock::now();
+        for (int i = 0; i < SOURCES; i++) {
+            cityGraph->distancesFrom(sources[i], dist, SSSP_DELTA_STEPPING);
+            const double* want = expected + (long long)i * count;
+            for (int v = 0; v < count; v++) {
+                if (dist[v] != want[v]) mismatches++;
+            }
+        }
+        double ms = elapsedMs(start) / SOURCES;
+
+        cout << "Threads: " << setw(2) << threadCounts[t] << "      " << ms << " ms  (x"
+            << dijkstraMs / ms << " vs Dijkstra)  mismatches: " << mismatches << endl;
+    }
+
+    // Bucket width around the automatic choice, on every hardware thread
+    pool->setThreadCount(hardware);
+    cityGraph->distancesFrom(sources[0], dist, SSSP_DELTA_STEPPING);
+    double autoDelta = cityGraph->getLastDeltaStats().delta;
+    const double factors[] = { 0.25, 0.5, 1, 2, 4, 16 };
+    cout << "Bucket width (" << hardware << " threads):" << endl;
+    for (int f = 0; f < 6; f++) {
+        start = chrono::steady_clock::now();
+        cityGraph->distancesFrom(sources[0], dist, SSSP_DELTA_STEPPING, autoDelta * factors[f]);
+        double ms = elapsedMs(start);
+        CityDeltaStats stats = cityGraph->getLastDeltaStats();
+        cout << "  delta x" << setw(5) << factors[f] << (factors[f] == 1 ? " (auto)" : "       ") << "  " << ms << " ms  "
+            << stats.buckets << " buckets, " << stats.phases << " phases, " << stats.relaxations << " relaxations" << endl;
+    }
+
+    delete[] expected;
+    delete[] dist;
+}
+
+// COMPONENTS: route queries across a cut network, rejected by the labels
+
+void runComponentsBenchmark(int nodes) {
+    const int QUERIES = 200;
+    CityGraph* cityGraph = CityGraph::getInstance();
+    cityGraph->getPathCache().setCapacity(0);
+    int side = buildGridCity(nodes, 42);
+
+    // Cut the city in two along the middle column, plus some isolated sites
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int r = 0; r < side; r++) {
+        cityGraph->removeRoad(gridID(r, side / 2 - 1), gridID(r, side / 2));
+    }
+    for (int i = 0; i < 100; i++) {
+        cityGraph->addLocation("ISO" + intToString(i), "Isolated", LOC_MALL, 33.5, 73.0 + i * 0.001);
+    }
+    int components = cityGraph->getComponentCount();
+    double labelMs = elapsedMs(start);
+
+    srand(17);
+    int maxPathLen = 4 * side + 10;
+    string* path = new string[maxPathLen];
+    int pathLen = 0;
+    int unreachable = 0;
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < QUERIES; q++) {
+        string src = gridID(rand() % side, rand() % (side / 2));
+        string dest = gridID(rand() % side, side / 2 + rand() % (side - side / 2));
+        if (cityGraph->findShortestPath(src, dest, path, pathLen, maxPathLen) == DBL_MAX) unreachable++;
+    }
+    double rejectUs = elapsedMs(start) * 1000.0 / QUERIES;
+
+    // What each of those queries cost before: a search of the whole half
+    const int SEARCHES = 10;
+    cityGraph->ensureCompactGraph();
+    CityCompactGraph compact(cityGraph->getCompactOffsets(), cityGraph->getCompactTargets(),
+        cityGraph->getCompactWeights(), cityGraph->getLocationCount());
+    CitySearchScratch& sc = getCitySearchScratch();
+    CitySettleAll everything;
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < SEARCHES; q++) {
+        cityShortestPaths(compact, everything, cityGraph->getVertexIndex(gridID(q, 0)), sc);
+    }
+    double searchUs = elapsedMs(start) * 1000.0 / SEARCHES;
+
+    cout << "\n=== Components: " << cityGraph->getLocationCount() << " nodes, " << components << " components ===" << endl;
+    cout << "Relabel after " << side << " road removals: " << labelMs << " ms" << endl;
+    cout << "Unreachable query: " << rejectUs << " us (" << unreachable << "/" << QUERIES
+        << " rejected), exhaustive search: " << searchUs << " us" << endl;
+
+    delete[] path;
+    cityGraph->getPathCache().setCapacity(PATH_CACHE_DEFAULT_CAPACITY);
+}
+
+// ISOCHRONE: everything within a budget, single and batched
+
+void runIsochroneBenchmark(int nodes) {
+    const int ORIGINS = 1000;
+    CityGraph* cityGraph = CityGraph::getInstance();
+    int side = buildGridCity(nodes, 42);
+    cityGraph->ensureCompactGraph();
+
+    string* origins = new string[ORIGINS];
+    srand(19);
+    for (int i = 0; i < ORIGINS; i++) {
+        origins[i] = gridID(rand() % side, rand() % side);
+    }
+
+    cout << "\n=== Isochrones on " << cityGraph->getLocationCount() << " nodes ===" << endl;
+
+    // Budgets in grid spacings (about 1.25 street lengths each)
+    const double budgets[] = { 0.005, 0.02, 0.05 };
+    for (int b = 0; b < 3; b++) {
+        CityIsochrone area;
+        long long found = 0;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (int i = 0; i < 100; i++) {
+            found += cityGraph->findWithinDistance(origins[i], budgets[b], area);
+        }
+        double singleUs = elapsedMs(start) * 1000.0 / 100;
+
+        CityIsochrone* areas = new CityIsochrone[ORIGINS];
+        start = chrono::steady_clock::now();
+        cityGraph->findWithinDistanceBatch(origins, ORIGINS, budgets[b], areas);
+        double batchMs = elapsedMs(start);
+        delete[] areas;
+
+        cout << "Budget " << budgets[b] << ": " << (found / 100) << " locations on average, "
+            << singleUs << " us per origin, batch of " << ORIGINS << ": " << batchMs << " ms ("
+            << CityThreadPool::getInstance()->getThreadCount() << " threads)" << endl;
+    }
+
+    double* dist = new double[cityGraph->getLocationCount()];
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    cityGraph->distancesFrom(origins[0], dist);
+    cout << "Unbounded one-to-all search for comparison: " << elapsedMs(start) << " ms" << endl;
+
+    delete[] dist;
+    delete[] origins;
+}
+
+// TRAFFIC: time-dependent Dijkstra vs the static search
+
+void runTrafficBenchmark(int nodes) {
+    const int QUERIES = 20;
+    CityGraph* cityGraph = CityGraph::getInstance();
+    int side = buildGridCity(nodes, 42);
+
+    // Arterials (every 10th row and column) jam in the rush hours, side streets less so
+    CityTrafficTable* table = CityTrafficTable::getInstance();
+    const CityTrafficPattern* arterial = table->internProfile("06:00=60;08:00=15;10:00=50;17:00=15;19:00=60");
+    const CityTrafficPattern* street = table->internProfile("07:00=40;08:30=25;10:00=40");
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int r = 0; r < side; r++) {
+        for (int c = 0; c < side; c++) {
+            if (c + 1 < side) cityGraph->setRoadTraffic(gridID(r, c), gridID(r, c + 1), (r % 10 == 0) ? arterial : street);
+            if (r + 1 < side) cityGraph->setRoadTraffic(gridID(r, c), gridID(r + 1, c), (c % 10 == 0) ? arterial : street);
+        }
+    }
+    double assignMs = elapsedMs(start);
+
+    string* srcs = new string[QUERIES];
+    string* dests = new string[QUERIES];
+    srand(23);
+    for (int q = 0; q < QUERIES; q++) {
+        srcs[q] = gridID(rand() % side, rand() % side);
+        dests[q] = gridID(rand() % side, rand() % side);
+    }
+
+    int maxPathLen = 4 * side + 10;
+    string* path = new string[maxPathLen];
+    int pathLen = 0;
+    cityGraph->getPathCache().setCapacity(0);
+    cityGraph->ensureCompactGraph();
+
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < QUERIES; q++) {
+        cityGraph->findShortestPath(srcs[q], dests[q], path, pathLen, maxPathLen);
+    }
+    double staticMs = elapsedMs(start) / QUERIES;
+
+    cout << "\n=== Traffic: " << cityGraph->getLocationCount() << " nodes, "
+        << table->getPatternCount() << " shared profiles ===" << endl;
+    cout << "Profile assignment: " << assignMs << " ms, static Dijkstra: " << staticMs << " ms per query" << endl;
+
+    const int departures[] = { 6 * 60, 8 * 60 + 15, 12 * 60 };
+    for (int d = 0; d < 3; d++) {
+        double totalMinutes = 0;
+        start = chrono::steady_clock::now();
+        for (int q = 0; q < QUERIES; q++) {
+            totalMinutes += cityGraph->findEarliestArrival(srcs[q], dests[q], departures[d], path, pathLen, maxPathLen)
+                - departures[d];
+        }
+        cout << "Depart " << formatClockTime(departures[d]) << ": " << (elapsedMs(start) / QUERIES)
+            << " ms per query, average trip " << (totalMinutes / QUERIES) << " min" << endl;
+    }
+
+    delete[] path;
+    delete[] srcs;
+    delete[] dests;
+    cityGraph->getPathCache().setCapacity(PATH_CACHE_DEFAULT_CAPACITY);
+}
+
+// OVERLAY: what-if closures vs editing and reverting the live graph
+
+void runOverlayBenchmark(int nodes) {
+    const int QUERIES = 20;
+    CityGraph* cityGraph = CityGraph::getInstance();
+    int side = buildGridCity(nodes, 42);
+    cityGraph->getPathCache().setCapacity(0);
+    cityGraph->ensureCompactGraph();
+
+    string* srcs = new string[QUERIES];
+    string* dests = new string[QUERIES];
+    srand(29);
+    for (int q = 0; q < QUERIES; q++) {
+        srcs[q] = gridID(rand() % side, rand() % side);
+        dests[q] = gridID(rand() % side, rand() % side);
+    }
+    int maxPathLen = 4 * side + 10;
+    string* path = new string[maxPathLen];
+    int pathLen = 0;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int q = 0; q < QUERIES; q++) {
+        cityGraph->findShortestPath(srcs[q], dests[q], path, pathLen, maxPathLen);
+    }
+    double baseMs = elapsedMs(start) / QUERIES;
+
+    cout << "\n=== Overlay: " << cityGraph->getLocationCount() << " nodes ===" << endl;
+    cout << "Base Dijkstra: " << baseMs << " ms per query" << endl;
+
+    const int closureCounts[] = { 10, 100, 1000 };
+    for (int c = 0; c < 3; c++) {
+        int closures = closureCounts[c];
+        string* from = new string[closures];
+        string* to = new string[closures];
+        srand(31 + c);
+        for (int i = 0; i < closures; i++) {
+            int r = rand() % side, col = rand() % (side - 1);
+            from[i] = gridID(r, col);
+            to[i] = gridID(r, col + 1);
+        }
+
+        // Scenario as an overlay
+        start = chrono::steady_clock::now();
+        CityRoadOverlay scenario("bench");
+        for (int i = 0; i < closures; i++) scenario.closeRoad(from[i], to[i]);
+        double createUs = elapsedMs(start) * 1000.0;
+
+        start = chrono::steady_clock::now();
+        scenario.getUnresolvedCount();
+        double resolveUs = elapsedMs(start) * 1000.0;
+
+        double* after = new double[QUERIES];
+        start = chrono::steady_clock::now();
+        for (int q = 0; q < QUERIES; q++) {
+            after[q] = scenario.findShortestPath(srcs[q], dests[q], path, pathLen, maxPathLen);
+        }
+        double overlayMs = elapsedMs(start) / QUERIES;
+        int changed = 0;
+        for (int q = 0; q < QUERIES; q++) {
+            if (after[q] != cityGraph->findShortestPath(srcs[q], dests[q], path, pathLen, maxPathLen)) changed++;
+        }
+        delete[] after;
+
+        start = chrono::steady_clock::now();
+        CityOverlayImpact impact = scenario.compareNearest(LOC_HOSPITAL);
+        double reportMs = elapsedMs(start);
+
+        // The old way: edit the live graph, then put every road back
+        double* lengths = new double[closures];
+        start = chrono::steady_clock::now();
+        for (int i = 0; i < closures; i++) {
+            lengths[i] = -1;
+            CityLocation* a = cityGraph->findLocationByID(from[i]);
+            for (CityRoad* road = a->adj->roadHead; road != nullptr; road = road->next) {
+                if (road->destID == to[i]) lengths[i] = road->distance;
+            }
+            cityGraph->removeRoad(from[i], to[i]);
+        }
+        cityGraph->ensureCompactGraph();
+        for (int i = 0; i < closures; i++) {
+            if (lengths[i] >= 0) cityGraph->connectLocations(from[i], to[i], lengths[i]);
+        }
+        cityGraph->ensureCompactGraph();
+        double liveMs = elapsedMs(start);
+
+        cout << closures << " closures: overlay built in " << createUs << " us, resolved in " << resolveUs
+            << " us, " << overlayMs << " ms per query (" << changed << "/" << QUERIES << " routes changed), "
+            << "hospital report " << reportMs << " ms (" << impact.longer << " farther); "
+            << "edit + revert live graph: " << liveMs << " ms" << endl;
+
+        delete[] lengths;
+        delete[] from;
+        delete[] to;
+    }
+
+    delete[] path;
+    delete[] srcs;
+    delete[] dests;
+    cityGraph->getPathCache().setCapacity(PATH_CACHE_DEFAULT_CAPACITY);
+}
+
+// Write one synthetic city into synthetic_<citizens>/
+bool generateSyntheticCity(int citizens, unsigned long long seed, string& directory) {
+    directory = "synthetic_" + intToString(citizens);
+    if (!cityMakeDirectory(directory)) {
+        cout << "Cannot create " << directory << endl;
+        return false;
+    }
+    CityGenerator generator(CityGeneratorConfig(citizens, seed), directory);
+    return generator.generate();
+}
+
+void runGenerateBenchmark(int citizens, unsigned long long seed) {
+    cout << "\n=== Synthetic city: " << citizens << " citizens, seed " << seed << " ===" << endl;
+
+    string directory;
+    auto start = chrono::steady_clock::now();
+    if (!generateSyntheticCity(citizens, seed, directory)) return;
+    double ms = elapsedMs(start);
+
+    CityGeneratorConfig config(citizens, seed);
+    cout << "Wrote " << directory << "/: " << config.stops << " stops, " << config.buses << " buses, "
+        << config.hospitals << " hospitals, " << config.pharmacies << " pharmacies, " << config.schools
+        << " schools, " << config.malls << " malls (" << config.malls * config.productsPerMall << " products), "
+        << config.facilities << " facilities, " << citizens << " citizens in " << ms << " ms" << endl;
+}
+
+// Load-scaling benchmark: generate each scale, load it with the real module
+// loaders and time every loader plus a few key queries. The last column is
+// the growth exponent between the two largest scales (1 = linear, 2 = quadratic).
+// Returns false if any generated location failed to place.
+bool runLoadBenchmark(int scales[], int scaleCount) {
+    const int STAGES = 11;
+    const char* stageNames[STAGES] = { "generate CSVs (ms)", "transport load (ms)", "medical load (ms)",
+        "education load (ms)", "commercial load (ms)", "facilities load (ms)", "population load (ms)",
+        "location by ID (us)", "citizen by CNIC (us)", "stop-to-stop path (ms)", "nearest hospital (ms)" };
+    double times[STAGES][16];
+    int loaded[16], expected[16];
+    const int LOOKUPS = 1000;
+    const int ROUTES = 20;
+
+    for (int s = 0; s < scaleCount; s++) {
+        int citizens = scales[s];
+        cout << "Scale " << citizens << " citizens..." << endl;
+        CityRandom rng(7);
+        CityGeneratorConfig config(citizens, 42);
+
+        string directory;
+        auto start = chrono::steady_clock::now();
+        if (!generateSyntheticCity(citizens, 42, directory)) return false;
+        times[0][s] = elapsedMs(start);
+        if (!cityChangeDirectory(directory)) return false;
+
+        CityGraph* cityGraph = CityGraph::getInstance();
+        cityGraph->reset();
+        GlobalLocationManager::getInstance()->reset();
+
+        TransportSystem* transport = new TransportSystem();
+        MedicalSystem* medical = new MedicalSystem();
+        EducationSystem* education = new EducationSystem();
+        CommercialSystem* commercial = new CommercialSystem();
+        FacilitiesSystem* facilities = new FacilitiesSystem();
+        PopulationSystem* population = new PopulationSystem();
+
+        // The loaders report every row; keep the table readable
+        cout.setstate(ios::failbit);
+        start = chrono::steady_clock::now(); transport->loadFromFiles(); times[1][s] = elapsedMs(start);
+        start = chrono::steady_clock::now(); medical->loadFromFiles(); times[2][s] = elapsedMs(start);
+        start = chrono::steady_clock::now(); education->loadFromFile(); times[3][s] = elapsedMs(start);
+        start = chrono::steady_clock::now(); commercial->loadFromFiles(); times[4][s] = elapsedMs(start);
+        start = chrono::steady_clock::now(); facilities->loadFromFile(); times[5][s] = elapsedMs(start);
+        start = chrono::steady_clock::now(); population->loadFromFile(); times[6][s] = elapsedMs(start);
+        cout.clear();
+        cityChangeDirectory("..");
+
+        expected[s] = (int)(config.stops + config.hospitals + config.pharmacies + config.schools + config.malls + config.facilities);
+        loaded[s] = cityGraph->getLocationCount();
+
+        // Lookups by ID across every module's locations
+        string* ids = new string[LOOKUPS];
+        const char* prefixes[6] = { "ST", "H", "P", "S", "M", "F" };
+        long long counts[6] = { config.stops, config.hospitals, config.pharmacies, config.schools, config.malls, config.facilities };
+        for (int i = 0; i < LOOKUPS; i++) {
+            int kind = i % 6;
+            ids[i] = string(prefixes[kind]) + to_string(rng.below(counts[kind]));
+        }
+        start = chrono::steady_clock::now();
+        for (int i = 0; i < LOOKUPS; i++) {
+            cityGraph->findLocationByID(ids[i]);
+        }
+        times[7][s] = elapsedMs(start) * 1000.0 / LOOKUPS;
+
+        // Citizen lookups (CNICs follow the generator's numbering)
+        char cnic[GEN_CNIC_BUFFER];
+        for (int i = 0; i < LOOKUPS; i++) {
+            long long n = rng.below(citizens);
+            snprintf(cnic, sizeof(cnic), "%05d-%07lld-", 61101 + (int)(n / 10000000LL), n % 10000000LL);
+            ids[i] = cnic;
+        }
+        start = chrono::steady_clock::now();
+        for (int i = 0; i < LOOKUPS; i++) {
+            // The last digit is random; try them all like a partial-CNIC search would
+            for (int d = 0; d < 10; d++) {
+                if (population->findCitizen(ids[i] + (char)('0' + d)) != nullptr) break;
+            }
+        }
+        times[8][s] = elapsedMs(start) * 1000.0 / LOOKUPS;
+        delete[] ids;
+
+        const int maxPathLen = 100000;
+        string* path = new string[maxPathLen];
+        int pathLen = 0;
+        start = chrono::steady_clock::now();
+        for (int q = 0; q < ROUTES; q++) {
+            cityGraph->findShortestPath("ST" + to_string(rng.below(config.stops)), "ST" + to_string(rng.below(config.stops)),
+                path, pathLen, maxPathLen);
+        }
+        times[9][s] = elapsedMs(start) / ROUTES;
+
+        string destID;
+        start = chrono::steady_clock::now();
+        for (int q = 0; q < ROUTES; q++) {
+            cityGraph->findShortestPathToType("ST" + to_string(rng.below(config.stops)), LOC_HOSPITAL,
+                destID, path, pathLen, maxPathLen);
+        }
+        times[10][s] = elapsedMs(start) / ROUTES;
+        delete[] path;
+
+        delete transport;
+        delete medical;
+        delete education;
+        delete commercial;
+        delete facilities;
+        delete population;
+    }
+
+    cout << "\n=== Load scaling (seed 42) ===" << endl;
+    cout << left << setw(26) << "citizens";
+    for (int s = 0; s < scaleCount; s++) cout << right << setw(12) << scales[s];
+    if (scaleCount > 1) cout << right << setw(10) << "growth";
+    cout << endl;
+    for (int t = 0; t < STAGES; t++) {
+        cout << left << setw(26) << stageNames[t] << right << fixed << setprecision(2);
+        for (int s = 0; s < scaleCount; s++) cout << setw(12) << times[t][s];
+        if (scaleCount > 1) {
+            double a = times[t][scaleCount - 2], b = times[t][scaleCount - 1];
+            double ratio = (double)scales[scaleCount - 1] / scales[scaleCount - 2];
+            if (a > 0 && b > 0 && ratio > 1) cout << setw(10) << log(b / a) / log(ratio);
+        }
+        cout << endl;
+    }
+    cout << left << setw(26) << "locations placed" << right;
+    for (int s = 0; s < scaleCount; s++) cout << setw(12) << (to_string(loaded[s]) + "/" + to_string(expected[s]));
+    cout << endl;
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+
+    bool placed = true;
+    for (int s = 0; s < scaleCount; s++) {
+        if (loaded[s] != expected[s]) {
+            cout << "FAILED: " << scales[s] << " citizens placed " << loaded[s] << " of " << expected[s] << " locations" << endl;
+            placed = false;
+        }
+    }
+    return placed;
+}
+
+// Startup comparison: CSV import against saving and restoring a snapshot of
+// the same city, checking the restored city answers routes identically
+void runSnapshotBenchmark(int citizens) {
+    cout << "\n=== Snapshot startup: " << citizens << " citizens ===" << endl;
+    CityGeneratorConfig config(citizens, 42);
+    string directory;
+    if (!generateSyntheticCity(citizens, 42, directory)) return;
+    if (!cityChangeDirectory(directory)) return;
+
+    CityGraph* cityGraph = CityGraph::getInstance();
+    cityGraph->reset();
+    GlobalLocationManager::getInstance()->reset();
+
+    TransportSystem* transport = new TransportSystem();
+    MedicalSystem* medical = new MedicalSystem();
+    EducationSystem* education = new EducationSystem();
+    CommercialSystem* commercial = new CommercialSystem();
+    FacilitiesSystem* facilities = new FacilitiesSystem();
+    PopulationSystem* population = new PopulationSystem();
+
+    cout.setstate(ios::failbit);
+    auto start = chrono::steady_clock::now();
+    transport->loadFromFiles();
+    medical->loadFromFiles();
+    education->loadFromFile();
+    commercial->loadFromFiles();
+    facilities->loadFromFile();
+    population->loadFromFile();
+    double csvMs = elapsedMs(start);
+    cout.clear();
+
+    // Reference routes on the CSV-loaded city
+    const int ROUTES = 20;
+    const int maxPathLen = 100000;
+    string* path = new string[maxPathLen];
+    int pathLen = 0;
+    double before[ROUTES], after[ROUTES];
+    string from[ROUTES], to[ROUTES];
+    CityRandom rng(11);
+    for (int q = 0; q < ROUTES; q++) {
+        from[q] = "ST" + to_string(rng.below(config.stops));
+        to[q] = "ST" + to_string(rng.below(config.stops));
+        before[q] = cityGraph->findShortestPath(from[q], to[q], path, pathLen, maxPathLen);
+    }
+    int locations = cityGraph->getLocationCount();
+    int people = population->getCitizenCount();
+
+    CitySnapshotWriter out;
+    start = chrono::steady_clock::now();
+    bool saved = out.open(CITY_SNAPSHOT_FILE);
+    if (saved) {
+        writeTrafficSnapshot(out);
+        GlobalLocationManager::getInstance()->writeSnapshot(out);
+        cityGraph->writeSnapshot(out);
+        transport->writeSnapshot(out);
+        medical->writeSnapshot(out);
+        education->writeSnapshot(out);
+        commercial->writeSnapshot(out);
+        facilities->writeSnapshot(out);
+        population->writeSnapshot(out);
+        saved = out.finish();
+    }
+    double saveMs = elapsedMs(start);
+
+    delete transport;
+    delete medical;
+    delete education;
+    delete commercial;
+    delete facilities;
+    delete population;
+    cityGraph->reset();
+    GlobalLocationManager::getInstance()->reset();
+
+    transport = new TransportSystem();
+    medical = new MedicalSystem();
+    education = new EducationSystem();
+    commercial = new CommercialSystem();
+    facilities = new FacilitiesSystem();
+    population = new PopulationSystem();
+
+    cout.setstate(ios::failbit);
+    start = chrono::steady_clock::now();
+    CitySnapshotReader in;
+    CitySnapshotLinks links;
+    bool restored = saved && in.open(CITY_SNAPSHOT_FILE) &&
+        readTrafficSnapshot(in, links) &&
+        GlobalLocationManager::getInstance()->readSnapshot(in) &&
+        cityGraph->beginSnapshotRestore(in, links) &&
+        transport->readSnapshot(in, links) &&
+        medical->readSnapshot(in, links) &&
+        education->readSnapshot(in, links) &&
+        commercial->readSnapshot(in, links) &&
+        facilities->readSnapshot(in, links) &&
+        population->readSnapshot(in) &&
+        cityGraph->readSnapshot(in, links);
+    double restoreMs = elapsedMs(start);
+    cout.clear();
+
+    int mismatches = 0;
+    for (int q = 0; q < ROUTES; q++) {
+        after[q] = cityGraph->findShortestPath(from[q], to[q], path, pathLen, maxPathLen);
+        if (fabs(after[q] - before[q]) > 1e-9) mismatches++;
+    }
+    delete[] path;
+
+    cout << fixed << setprecision(2);
+    cout << "CSV import:       " << csvMs << " ms" << endl;
+    cout << "Snapshot save:    " << saveMs << " ms (" << out.getSize() / 1024 << " KB)" << endl;
+    if (restored) {
+        cout << "Snapshot restore: " << restoreMs << " ms (" << csvMs / restoreMs << "x faster)" << endl;
+    }
+    else {
+        cout << "Snapshot restore failed: " << in.getError() << endl;
+    }
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+    cout << "Locations: " << cityGraph->getLocationCount() << "/" << locations
+        << ", citizens: " << population->getCitizenCount() << "/" << people
+        << ", route mismatches: " << mismatches << "/" << ROUTES << endl;
+
+    in.close();
+    remove(CITY_SNAPSHOT_FILE.c_str());
+    cityChangeDirectory("..");
+
+    delete transport;
+    delete medical;
+    delete education;
+    delete commercial;
+    delete facilities;
+    delete population;
+}
+
+// Moving a bus stop re-measures its roads, so cached routes to it must go
+// stale in both the transport network and the city graph
+void runMovedStopCheck() {
+    const int ROUTES = 20;
+    CityGeneratorConfig config(1000, 42);
+    string directory;
+    if (!generateSyntheticCity(1000, 42, directory)) return;
+    if (!cityChangeDirectory(directory)) return;
+
+    CityGraph* cityGraph = CityGraph::getInstance();
+    cityGraph->reset();
+    GlobalLocationManager::getInstance()->reset();
+    TransportSystem* transport = new TransportSystem();
+    cout.setstate(ios::failbit);
+    transport->loadFromFiles();
+    cout.clear();
+    cityChangeDirectory("..");
+
+    const int maxPathLen = 1000;
+    string* path = new string[maxPathLen];
+    int pathLen = 0, explored = 0;
+    bool cached = false;
+
+    int checked = 0, unchanged = 0, stale = 0;
+    CityRandom rng(5);
+    for (int q = 0; q < ROUTES; q++) {
+        string from = "ST" + to_string(rng.below(config.stops));
+        string to = "ST" + to_string(rng.below(config.stops));
+        double busBefore = transport->findRoute(from, to, false, path, pathLen, maxPathLen, explored, cached);
+        double cityBefore = cityGraph->findShortestPath(from, to, path, pathLen, maxPathLen);
+        if (busBefore == DBL_MAX || cityBefore == DBL_MAX || pathLen < 2) continue;
+
+        // Pull the destination a little towards the origin's latitude
+        CityLocation* stop = cityGraph->findLocationByID(to);
+        CityLocation* origin = cityGraph->findLocationByID(from);
+        double lat = stop->lat + (origin->lat - stop->lat) * 0.1;
+        if (!transport->moveBusStop(to, lat, stop->lon)) continue;
+        checked++;
+
+        double busAfter = transport->findRoute(from, to, false, path, pathLen, maxPathLen, explored, cached);
+        double cityAfter = cityGraph->findShortestPath(from, to, path, pathLen, maxPathLen);
+        if (cached) stale++;
+        if (busAfter == busBefore || cityAfter == cityBefore) unchanged++;
+
+        // The answers now in the caches must match searches without them
+        transport->getPathCache().setCapacity(0);
+        cityGraph->getPathCache().setCapacity(0);
+        if (fabs(transport->findRoute(from, to, false, path, pathLen, maxPathLen, explored, cached) - busAfter) > 1e-9 ||
+            fabs(cityGraph->findShortestPath(from, to, path, pathLen, maxPathLen) - cityAfter) > 1e-9) {
+            stale++;
+        }
+        transport->getPathCache().setCapacity(PATH_CACHE_DEFAULT_CAPACITY);
+        cityGraph->getPathCache().setCapacity(PATH_CACHE_DEFAULT_CAPACITY);
+    }
+    delete[] path;
+    delete transport;
+
+    cout << "\n=== Moved stops: " << checked << " routes ===" << endl;
+    cout << "Unchanged lengths: " << unchanged << ", stale cached routes: " << stale << endl;
+}
+
+// The loaders' tokenizer before CsvReader, kept for comparison: builds each
+// token char by char and trims with substr
+int legacySplitString(const string& str, char delimiter, string outputArray[], int maxTokens) {
+    int count = 0;
+    string currentToken = "";
+
+    for (long long i = 0; i < (long long)str.length(); i++) {
+        if (str[i] == delimiter) {
+            if (count < maxTokens) {
+                while (!currentToken.empty() && currentToken[0] == ' ')
+                    currentToken = currentToken.substr(1);
+                while (!currentToken.empty() && currentToken[currentToken.length() - 1] == ' ')
+                    currentToken = currentToken.substr(0, currentToken.length() - 1);
+                outputArray[count++] = currentToken;
+                currentToken = "";
+            }
+        }
+        else {
+            currentToken += str[i];
+        }
+    }
+
+    if (count < maxTokens && !currentToken.empty()) {
+        while (!currentToken.empty() && (currentToken.back() == '\r' || currentToken.back() == '\n'))
+            currentToken = currentToken.substr(0, currentToken.length() - 1);
+        while (!currentToken.empty() && currentToken[0] == ' ')
+            currentToken = currentToken.substr(1);
+        while (!currentToken.empty() && currentToken[currentToken.length() - 1] == ' ')
+            currentToken = currentToken.substr(0, currentToken.length() - 1);
+        outputArray[count++] = currentToken;
+    }
+    return count;
+}
+
+// Tokenizer throughput on population.csv: the old getline/normalize/split/trim
+// path against CsvReader, both producing the seven field strings per row as
+// the loader needs them, and CsvReader with views only (no copies)
+void runCsvBenchmark(long long rows) {
+    cout << "\n=== CSV tokenizer: population.csv, " << rows << " rows ===" << endl;
+    string directory = "population_" + to_string(rows);
+    if (!cityMakeDirectory(directory)) {
+        cout << "Cannot create " << directory << endl;
+        return;
+    }
+    string file = directory + "/population.csv";
+    {
+        ifstream existing(file.c_str());
+        if (!existing.is_open()) {
+            auto start = chrono::steady_clock::now();
+            CityGenerator generator(CityGeneratorConfig(rows, 42), directory);
+            if (!generator.generatePopulation()) return;
+            cout << "Generated " << file << " in " << elapsedMs(start) << " ms" << endl;
+        }
+    }
+    ifstream sizeProbe(file.c_str(), ios::binary | ios::ate);
+    double megabytes = (double)sizeProbe.tellg() / (1024.0 * 1024.0);
+    sizeProbe.close();
+
+    // Legacy path (field lengths are summed so the work cannot be skipped)
+    long long legacyChars = 0, legacyRows = 0;
+    auto start = chrono::steady_clock::now();
+    {
+        ifstream in(file.c_str());
+        string line;
+        getline(in, line);
+        while (getline(in, line)) {
+            if (line.empty()) continue;
+            for (size_t i = 0; i < line.length(); i++) {
+                if (line[i] == '\t') line[i] = ',';
+            }
+            string parts[8];
+            int count = legacySplitString(line, ',', parts, 8);
+            if (count < 7) continue;
+            for (int f = 0; f < count; f++) legacyChars += trimString(parts[f]).length();
+            legacyRows++;
+        }
+    }
+    double legacyMs = elapsedMs(start);
+
+    long long readerChars = 0, readerRows = 0;
+    start = chrono::steady_clock::now();
+    {
+        CsvReader in(file);
+        in.readRow();
+        while (in.readRow()) {
+            int count = in.getFieldCount();
+            if (count < 7) continue;
+            for (int f = 0; f < count; f++) readerChars += in.getString(f).length();
+            readerRows++;
+        }
+    }
+    double readerMs = elapsedMs(start);
+
+    long long viewChars = 0;
+    start = chrono::steady_clock::now();
+    {
+        CsvReader in(file);
+        in.readRow();
+        while (in.readRow()) {
+            for (int f = 0; f < in.getFieldCount(); f++) viewChars += in.field(f).length;
+        }
+    }
+    double viewMs = elapsedMs(start);
+
+    cout << fixed << setprecision(1);
+    cout << left << setw(34) << "tokenizer" << right << setw(12) << "time (ms)" << setw(14) << "rows/s" << setw(10) << "MB/s" << endl;
+    cout << left << setw(34) << "getline + splitString (old)" << right << setw(12) << legacyMs
+        << setw(14) << (long long)(legacyRows * 1000.0 / legacyMs) << setw(10) << megabytes * 1000.0 / legacyMs << endl;
+    cout << left << setw(34) << "CsvReader, fields copied" << right << setw(12) << readerMs
+        << setw(14) << (long long)(readerRows * 1000.0 / readerMs) << setw(10) << megabytes * 1000.0 / readerMs << endl;
+    cout << left << setw(34) << "CsvReader, views only" << right << setw(12) << viewMs
+        << setw(14) << (long long)(readerRows * 1000.0 / viewMs) << setw(10) << megabytes * 1000.0 / viewMs << endl;
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+    cout << "Speedup (copied): " << legacyMs / readerMs << "x; rows " << readerRows << "/" << legacyRows
+        << ", field characters " << (readerChars == legacyChars && viewChars == legacyChars ? "match" : "DIFFER") << endl;
+}
+
+// stringToDouble before scanDouble, kept for comparison: one factor /= 10
+// per fraction digit, so 7-decimal coordinates pick up rounding error
+double legacyStringToDouble(const string& str) {
+    if (str.empty()) return 0.0;
+    double res = 0.0;
+    double factor = 1.0;
+    bool decimalFound = false;
+    int sign = 1;
+    long long i = 0;
+
+    while (i < (long long)str.length() && (str[i] == ' ' || str[i] == '\t')) i++;
+    if (i < (long long)str.length() && str[i] == '-') {
+        sign = -1;
+        i++;
+    }
+    else if (i < (long long)str.length() && str[i] == '+') {
+        i++;
+    }
+
+    for (; i < (long long)str.length(); i++) {
+        if (str[i] == '.') {
+            if (decimalFound) break;
+            decimalFound = true;
+            continue;
+        }
+        if (str[i] >= '0' && str[i] <= '9') {
+            if (decimalFound) {
+                factor /= 10.0;
+                res += (str[i] - '0') * factor;
+            }
+            else {
+                res = res * 10.0 + (str[i] - '0');
+            }
+        }
+        else {
+            break;
+        }
+    }
+    return res * sign;
+}
+
+// Coordinate parsing: legacy stringToDouble, parseDouble and strtod on the
+// same 7-decimal lat/lon strings (strtod is the correctly rounded reference),
+// then a "lat,lon" file read through CsvReader with each parser
+void runNumbersBenchmark(int count) {
+    cout << "\n=== Number parsing: " << count << " coordinates ===" << endl;
+    CityRandom rng(42);
+    string* text = new string[count];
+    char buffer[32];
+    for (int i = 0; i < count; i++) {
+        double value = (i % 2 == 0) ? 33.40 + rng.unit() * 0.35 : 72.80 + rng.unit() * 0.40;
+        snprintf(buffer, sizeof(buffer), "%.7f", value);
+        text[i] = buffer;
+    }
+
+    double* reference = new double[count];
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) reference[i] = strtod(text[i].c_str(), nullptr);
+    double strtodMs = elapsedMs(start);
+
+    double sum = 0;
+    int legacyInexact = 0;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) {
+        double v = legacyStringToDouble(text[i]);
+        if (v != reference[i]) legacyInexact++;
+        sum += v;
+    }
+    double legacyMs = elapsedMs(start);
+
+    int parsedInexact = 0, failed = 0;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) {
+        double v = 0;
+        if (!parseDouble(text[i].data(), text[i].data() + text[i].length(), v)) failed++;
+        if (v != reference[i]) parsedInexact++;
+        sum += v;
+    }
+    double parsedMs = elapsedMs(start);
+
+    cout << fixed << setprecision(1);
+    cout << left << setw(28) << "parser" << right << setw(12) << "ns/value" << setw(16) << "not exact" << endl;
+    cout << left << setw(28) << "stringToDouble (old)" << right << setw(12) << legacyMs * 1e6 / count << setw(16) << legacyInexact << endl;
+    cout << left << setw(28) << "parseDouble" << right << setw(12) << parsedMs * 1e6 / count << setw(16) << parsedInexact << endl;
+    cout << left << setw(28) << "strtod (reference)" << right << setw(12) << strtodMs * 1e6 / count << setw(16) << 0 << endl;
+    delete[] reference;
+
+    // File level: stops-style rows of "lat,lon"
+    string file = "coordinates_" + to_string(count) + ".csv";
+    {
+        ofstream out(file.c_str());
+        out << "Lat,Lon\n";
+        for (int i = 0; i + 1 < count; i += 2) out << text[i] << "," << text[i + 1] << "\n";
+    }
+    delete[] text;
+
+    start = chrono::steady_clock::now();
+    {
+        CsvReader in(file);
+        in.readRow();
+        while (in.readRow()) {
+            sum += legacyStringToDouble(in.getString(0)) + legacyStringToDouble(in.getString(1));
+        }
+    }
+    double legacyFileMs = elapsedMs(start);
+
+    start = chrono::steady_clock::now();
+    {
+        CsvReader in(file);
+        in.readRow();
+        double lat = 0, lon = 0;
+        while (in.readRow()) {
+            if (in.field(0).toDouble(lat) && in.field(1).toDouble(lon)) sum += lat + lon;
+        }
+    }
+    double parsedFileMs = elapsedMs(start);
+    remove(file.c_str());
+
+    cout << left << setw(28) << "coordinate file, old" << right << setw(12) << legacyFileMs << " ms" << endl;
+    cout << left << setw(28) << "coordinate file, new" << right << setw(12) << parsedFileMs << " ms ("
+        << legacyFileMs / parsedFileMs << "x)" << endl;
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+    cout << "Parse failures: " << failed << " (checksum " << (long long)sum << ")" << endl;
+}
+
+void benchLoadTransport(void* module) { ((TransportSystem*)module)->loadFromFiles(); }
+void benchLoadMedical(void* module) { ((MedicalSystem*)module)->loadFromFiles(); }
+void benchLoadEducation(void* module) { ((EducationSystem*)module)->loadFromFile(); }
+void benchLoadCommercial(void* module) { ((CommercialSystem*)module)->loadFromFiles(); }
+void benchLoadFacilities(void* module) { ((FacilitiesSystem*)module)->loadFromFile(); }
+void benchLoadPopulation(void* module) { ((PopulationSystem*)module)->loadFromFile(); }
+void benchBuildRouteIndex(void* hierarchy) { ((CityContractionHierarchy*)hierarchy)->ensureBuilt(); }
+
+// Whole-city CSV import: the six loaders one after another plus the route
+// hierarchy, against the staged pipeline loadAllData uses
+void runPipelineBenchmark(int citizens) {
+    cout << "\n=== Load pipeline: " << citizens << " citizens ===" << endl;
+    string directory;
+    if (!generateSyntheticCity(citizens, 42, directory)) return;
+    if (!cityChangeDirectory(directory)) return;
+
+    CityGraph* cityGraph = CityGraph::getInstance();
+    double sequentialMs = 0, pipelineMs = 0;
+    int locations[2], people[2];
+    const int STAGES = 6;
+    const char* titles[STAGES] = { "transport", "medical", "education", "commercial", "facilities", "population" };
+    double stageTimes[STAGES][3];
+    long long stageRows[STAGES];
+    double indexMs = 0;
+
+    for (int run = 0; run < 2; run++) {
+        cityGraph->reset();
+        GlobalLocationManager::getInstance()->reset();
+        remove(CH_CACHE_FILE.c_str());
+        TransportSystem* transport = new TransportSystem();
+        MedicalSystem* medical = new MedicalSystem();
+        EducationSystem* education = new EducationSystem();
+        CommercialSystem* commercial = new CommercialSystem();
+        FacilitiesSystem* facilities = new FacilitiesSystem();
+        PopulationSystem* population = new PopulationSystem();
+
+        cout.setstate(ios::failbit);
+        auto start = chrono::steady_clock::now();
+        if (run == 0) {
+            transport->loadFromFiles();
+            medical->loadFromFiles();
+            education->loadFromFile();
+            commercial->loadFromFiles();
+            facilities->loadFromFile();
+            population->loadFromFile();
+            CityContractionHierarchy::getInstance()->ensureBuilt();
+            sequentialMs = elapsedMs(start);
+        }
+        else {
+            const char* transportFiles[] = { "stops.csv", "busstops.csv", "roads.csv", "traffic.csv", "buses.csv" };
+            const char* medicalFiles[] = { "hospitals.csv", "pharmacies.csv" };
+            const char* educationFiles[] = { "schools.csv" };
+            const char* commercialFiles[] = { "malls.csv", "products.csv" };
+            const char* facilitiesFiles[] = { "facilities.csv" };
+            const char* populationFiles[] = { "population.csv" };
+
+            CityLoadPipeline pipeline;
+            pipeline.addStage("Transport Data", transportFiles, 5, benchLoadTransport, transport);
+            pipeline.addStage("Medical Data", medicalFiles, 2, benchLoadMedical, medical);
+            pipeline.addStage("Education Data", educationFiles, 1, benchLoadEducation, education);
+            pipeline.addStage("Commercial Data", commercialFiles, 2, benchLoadCommercial, commercial);
+            pipeline.addStage("Facilities Data", facilitiesFiles, 1, benchLoadFacilities, facilities);
+            pipeline.addStage("Population Data", populationFiles, 1, benchLoadPopulation, population);
+            pipeline.setIndexJob(benchBuildRouteIndex, CityContractionHierarchy::getInstance(), 5);
+            pipeline.start();
+            for (int i = 0; i < pipeline.getStageCount(); i++) pipeline.mergeStage(i);
+            pipeline.finish();
+            pipelineMs = elapsedMs(start);
+
+            for (int i = 0; i < STAGES; i++) {
+                CityLoadStage& stage = pipeline.getStage(i);
+                stageTimes[i][0] = stage.readMs;
+                stageTimes[i][1] = stage.parseMs;
+                stageTimes[i][2] = stage.mergeMs;
+                stageRows[i] = stage.rows;
+            }
+            indexMs = pipeline.getIndexMs();
+        }
+        cout.clear();
+
+        locations[run] = cityGraph->getLocationCount();
+        people[run] = population->getCitizenCount();
+        delete transport;
+        delete medical;
+        delete education;
+        delete commercial;
+        delete facilities;
+        delete population;
+    }
+    remove(CH_CACHE_FILE.c_str());
+    cityChangeDirectory("..");
+
+    cout << fixed << setprecision(2);
+    cout << left << setw(14) << "stage" << right << setw(12) << "rows" << setw(12) << "read ms"
+        << setw(12) << "parse ms" << setw(12) << "merge ms" << endl;
+    for (int i = 0; i < STAGES; i++) {
+        cout << left << setw(14) << titles[i] << right << setw(12) << stageRows[i] << setw(12) << stageTimes[i][0]
+            << setw(12) << stageTimes[i][1] << setw(12) << stageTimes[i][2] << endl;
+    }
+    cout << "Route hierarchy (during population merge): " << indexMs << " ms" << endl;
+    cout << "Sequential load: " << sequentialMs << " ms" << endl;
+    cout << "Pipeline load:   " << pipelineMs << " ms (" << sequentialMs / pipelineMs << "x)" << endl;
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+    cout << "Locations: " << locations[1] << "/" << locations[0] << ", citizens: " << people[1] << "/" << people[0] << endl;
+}
+
+// population.csv alone: the bulk ingestion an empty population gets against
+// the row-by-row loader, which is only run up to ROW_LIMIT citizens
+void runIngestBenchmark(int citizens) {
+    const int ROW_LIMIT = 1000000;
+    cout << "\n=== Population ingest: " << citizens << " citizens ===" << endl;
+    string directory = "population_" + intToString(citizens);
+    if (!cityMakeDirectory(directory)) {
+        cout << "Cannot create " << directory << endl;
+        return;
+    }
+    CityGenerator generator(CityGeneratorConfig(citizens, 42), directory);
+    auto start = chrono::steady_clock::now();
+    if (!generator.generatePopulation()) return;
+    double generateMs = elapsedMs(start);
+    if (!cityChangeDirectory(directory)) return;
+
+    PopulationSystem* bulk = new PopulationSystem();
+    cout.setstate(ios::failbit);
+    start = chrono::steady_clock::now();
+    bulk->loadFromFile();
+    double bulkMs = elapsedMs(start);
+    cout.clear();
+
+    double rowsMs = 0;
+    int rowCitizens = 0, mismatches = 0;
+    if (citizens <= ROW_LIMIT) {
+        PopulationSystem* rows = new PopulationSystem();
+        cout.setstate(ios::failbit);
+        start = chrono::steady_clock::now();
+        rows->loadRowsFromFile();
+        rowsMs = elapsedMs(start);
+        cout.clear();
+        rowCitizens = rows->getCitizenCount();
+
+        // Same citizens, same fields
+        CityRandom rng(5);
+        char cnic[GEN_CNIC_BUFFER];
+        for (int i = 0; i < 1000; i++) {
+            long long n = rng.below(citizens);
+            snprintf(cnic, sizeof(cnic), "%05d-%07lld-", 61101 + (int)(n / 10000000LL), n % 10000000LL);
+            for (int d = 0; d < 10; d++) {
+                string id = string(cnic) + (char)('0' + d);
+                Citizen* a = bulk->findCitizen(id);
+                Citizen* b = rows->findCitizen(id);
+                if ((a == nullptr) != (b == nullptr) || (a != nullptr && (a->name != b->name ||
+                    a->age != b->age || a->houseNumber != b->houseNumber))) {
+                    mismatches++;
+                }
+            }
+        }
+        delete rows;
+    }
+    cityChangeDirectory("..");
+
+    int bulkCitizens = bulk->getCitizenCount();
+    start = chrono::steady_clock::now();
+    delete bulk;
+    double freeMs = elapsedMs(start);
+
+    cout << fixed << setprecision(2);
+    cout << "Generate population.csv: " << generateMs << " ms" << endl;
+    cout << "Bulk ingest:             " << bulkMs << " ms (" << bulkCitizens << " citizens, "
+        << (bulkMs > 0 ? citizens / bulkMs * 1000.0 : 0) << " rows/s)" << endl;
+    if (citizens <= ROW_LIMIT) {
+        cout << "Row-by-row load:         " << rowsMs << " ms (" << rowCitizens << " citizens, "
+            << rowsMs / bulkMs << "x slower)" << endl;
+        cout << "Lookup mismatches:       " << mismatches << endl;
+    }
+    else {
+        cout << "Row-by-row load:         skipped above " << ROW_LIMIT << " citizens" << endl;
+    }
+    cout << "Free bulk population:    " << freeMs << " ms" << endl;
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+}
+
+// CitizenBTree built from sorted citizens by inserting them one at a time
+// (in order and shuffled) against bulk loading at a few fill factors
+void runBTreeBenchmark(int citizens) {
+    cout << "\n=== Citizen B-tree build: " << citizens << " citizens ===" << endl;
+    const char* sectors[6] = { "G-10", "F-7", "I-8", "E-11", "H-12", "G-6" };
+    Citizen* sorted = new Citizen[citizens];
+    char cnic[GEN_CNIC_BUFFER];
+    CityRandom rng(3);
+    for (int i = 0; i < citizens; i++) {
+        snprintf(cnic, sizeof(cnic), "%05d-%07d-%d", 61101 + i / 10000000, i % 10000000, (int)rng.below(10));
+        sorted[i] = Citizen(cnic, "Citizen " + intToString(i), 1 + (int)rng.below(90), (i % 2) ? "Male" : "Female",
+            sectors[rng.below(6)], intToString(1 + (int)rng.below(40)), intToString(1 + (int)rng.below(300)),
+            "Engineer", "0300-" + intToString(1000000 + i));
+    }
+    int* order = new int[citizens];
+    for (int i = 0; i < citizens; i++) order[i] = i;
+    for (int i = citizens - 1; i > 0; i--) {
+        int j = (int)rng.below(i + 1);
+        int t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+    const int LOOKUPS = 100000;
+    int* probes = new int[LOOKUPS];
+    for (int i = 0; i < LOOKUPS; i++) probes[i] = (int)rng.below(citizens);
+
+    const int METHODS = 5;
+    const char* names[METHODS] = { "insert, sorted order", "insert, random order", "bulk load, fill 1.0",
+        "bulk load, fill 0.7", "bulk load, fill 0.5" };
+    double fills[METHODS] = { 0, 0, 1.0, 0.7, 0.5 };
+
+    cout << left << setw(24) << "method" << right << setw(12) << "build ms" << setw(10) << "nodes"
+        << setw(8) << "height" << setw(11) << "keys/node" << setw(12) << "search us" << setw(8) << "valid" << endl;
+    cout << fixed << setprecision(2);
+    for (int m = 0; m < METHODS; m++) {
+        CitizenBTree* tree = new CitizenBTree();
+        auto start = chrono::steady_clock::now();
+        if (m == 0) {
+            for (int i = 0; i < citizens; i++) tree->insert(sorted[i]);
+        }
+        else if (m == 1) {
+            for (int i = 0; i < citizens; i++) tree->insert(sorted[order[i]]);
+        }
+        else {
+            tree->bulkLoad(sorted, citizens, fills[m]);
+        }
+        double buildMs = elapsedMs(start);
+
+        int found = 0;
+        start = chrono::steady_clock::now();
+        for (int i = 0; i < LOOKUPS; i++) {
+            if (tree->search(sorted[probes[i]].cnic) != nullptr) found++;
+        }
+        double searchUs = elapsedMs(start) * 1000.0 / LOOKUPS;
+
+        int nodes = tree->getNodeCount();
+        bool valid = tree->validate() && found == LOOKUPS && tree->getCitizenCount() == citizens;
+        cout << left << setw(24) << names[m] << right << setw(12) << buildMs << setw(10) << nodes
+            << setw(8) << tree->getTreeHeight() << setw(11) << (nodes > 0 ? (double)citizens / nodes : 0)
+            << setw(12) << searchUs << setw(8) << (valid ? "yes" : "NO") << endl;
+        delete tree;
+    }
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+
+    delete[] probes;
+    delete[] order;
+    delete[] sorted;
+}
+
+int main(int argc, char* argv[]) {
+    string suite = (argc > 1) ? argv[1] : "routing";
+
+    int sizes[16];
+    int sizeCount = 0;
+    for (int i = 2; i < argc && sizeCount < 16; i++) {
+        sizes[sizeCount++] = stringToInt(argv[i]);
+    }
+
+    if (suite == "routing") {
+        if (sizeCount == 0) {
+            sizes[0] = 10000;
+            sizes[1] = 100000;
+            sizes[2] = 1000000;
+            sizeCount = 3;
+        }
+        for (int i = 0; i < sizeCount; i++) {
+            runRoutingBenchmark(sizes[i]);
+        }
+    }
+    else if (suite == "ch") {
+        if (sizeCount == 0) {
+            sizes[0] = 10000;
+            sizes[1] = 20000;
+            sizeCount = 2;
+        }
+        for (int i = 0; i < sizeCount; i++) {
+            runCHBenchmark(sizes[i]);
+        }
+    }
+    else if (suite == "spatial") {
+        if (sizeCount == 0) {
+            sizes[0] = 10000;
+            sizes[1] = 100000;
+            sizes[2] = 1000000;
+            sizeCount = 3;
+        }
+        for (int i = 0; i < sizeCount; i++) {
+            runSpatialBenchmark(sizes[i]);
+        }
+    }
+    else if (suite == "locations") {
+        if (sizeCount == 0) {
+            sizes[0] = 10000;
+            sizes[1] = 200000;
+            sizeCount = 2;
+        }
+        for (int i = 0; i < sizeCount; i++) {
+            runLocationRegistryBenchmark(sizes[i]);
+        }
+    }
+    else if (suite == "matrix") {
+        int nodes = (sizeCount > 0) ? sizes[0] : 100000;
+        int size = (sizeCount > 1) ? sizes[1] : 2000;
+        runMatrixBenchmark(nodes, size);
+    }
+    else if (suite == "cache") {
+        if (sizeCount == 0) {
+            sizes[0] = 10000;
+            sizes[1] = 100000;
+            sizeCount = 2;
+        }
+        for (int i = 0; i < sizeCount; i++) {
+            runPathCacheBenchmark(sizes[i]);
+        }
+        runMovedStopCheck();
+    }
+    else if (suite == "remove") {
+        if (sizeCount == 0) {
+            sizes[0] = 10000;
+            sizes[1] = 100000;
+            sizes[2] = 1000000;
+            sizeCount = 3;
+        }
+        for (int i = 0; i < sizeCount; i++) {
+            runRemovalBenchmark(sizes[i]);
+        }
+    }
+    else if (suite == "engine") {
+        if (sizeCount == 0) {
+            sizes[0] = 100000;
+            sizes[1] = 1000000;
+            sizeCount = 2;
+        }
+        runModuleEngineBenchmark();
+        for (int i = 0; i < sizeCount; i++) {
+            runEngineBenchmark(sizes[i]);
+        }
+    }
+    else if (suite == "hot") {
+        if (sizeCount == 0) {
+            sizes[0] = 100000;
+            sizes[1] = 1000000;
+            sizeCount = 2;
+        }
+        for (int i = 0; i < sizeCount; i++) {
+            runHotSourceBenchmark(sizes[i]);
+        }
+    }
+    else if (suite == "yen") {
+        if (sizeCount == 0) {
+            sizes[0] = 10000;
+            sizes[1] = 50000;
+            sizeCount = 2;
+        }
+        for (int i = 0; i < sizeCount; i++) {
+            runKShortestBenchmark(sizes[i]);
+        }
+    }
+    else if (suite == "delta") {
+        if (sizeCount == 0) {
+            sizes[0] = 1000000;
+            sizeCount = 1;
+        }
+        for (int i = 0; i < sizeCount; i++) {
+            runDeltaSteppingBenchmark(sizes[i]);
+        }
+    }
+    else if (suite == "components") {
+        if (sizeCount == 0) {
+            sizes[0] = 100000;
+            sizes[1] = 1000000;
+            sizeCount = 2;
+        }
+        for (int i = 0; i < sizeCount; i++) {
+            runComponentsBenchmark(sizes[i]);
+        }
+    }
+    else if (suite == "isochrone") {
+        if (sizeCount == 0) {
+            sizes[0] = 1000000;
+            sizeCount = 1;
+        }
+        for (int i = 0; i < sizeCount; i++) {
+            runIsochroneBenchmark(sizes[i]);
+        }
+    }
+    else if (suite == "traffic") {
+        if (sizeCount == 0) {
+            sizes[0] = 100000;
+            sizes[1] = 1000000;
+            sizeCount = 2;
+        }
+        for (int i = 0; i < sizeCount; i++) {
+            runTrafficBenchmark(sizes[i]);
+        }
+    }
+    else if (suite == "overlay") {
+        if (sizeCount == 0) {
+            sizes[0] = 100000;
+            sizes[1] = 1000000;
+            sizeCount = 2;
+        }
+        for (int i = 0; i < sizeCount; i++) {
+            runOverlayBenchmark(sizes[i]);
+        }
+    }
+    else if (suite == "generate") {
+        int citizens = (sizeCount > 0) ? sizes[0] : 100000;
+        unsigned long long seed = (sizeCount > 1) ? (unsigned long long)sizes[1] : 42;
+        runGenerateBenchmark(citizens, seed);
+    }
+    else if (suite == "load") {
+        if (sizeCount == 0) {
+            sizes[0] = 1000;
+            sizes[1] = 10000;
+            sizes[2] = 100000;
+            sizeCount = 3;
+        }
+        if (!runLoadBenchmark(sizes, sizeCount)) return 1;
+    }
+    else if (suite == "csv") {
+        runCsvBenchmark(sizeCount > 0 ? sizes[0] : 10000000);
+    }
+    else if (suite == "numbers") {
+        runNumbersBenchmark(sizeCount > 0 ? sizes[0] : 10000000);
+    }
+    else if (suite == "snapshot") {
+        if (sizeCount == 0) {
+            sizes[0] = 10000;
+            sizes[1] = 100000;
+            sizeCount = 2;
+        }
+        for (int i = 0; i < sizeCount; i++) {
+            runSnapshotBenchmark(sizes[i]);
+        }
+    }
+    else if (suite == "pipeline") {
+        if (sizeCount == 0) {
+            sizes[0] = 10000;
+            sizes[1] = 100000;
+            sizeCount = 2;
+        }
+        for (int i = 0; i < sizeCount; i++) {
+            runPipelineBenchmark(sizes[i]);
+        }
+    }
+    else if (suite == "ingest") {
+        if (sizeCount == 0) {
+            sizes[0] = 100000;
+            sizes[1] = 1000000;
+            sizes[2] = 5000000;
+            sizeCount = 3;
+        }
+        for (int i = 0; i < sizeCount; i++) {
+            runIngestBenchmark(sizes[i]);
+        }
+    }
+    else if (suite == "btree") {
+        if (sizeCount == 0) {
+            sizes[0] = 100000;
+            sizes[1] = 1000000;
+            sizeCount = 2;
+        }
+        for (int i = 0; i < sizeCount; i++) {
+            runBTreeBenchmark(sizes[i]);
+        }
+    }
+    else {
+        cout << "Unknown benchmark '" << suite << "'. Available: routing, ch, spatial, locations, matrix, cache, remove, engine, hot, yen, delta, components, isochrone, traffic, overlay, generate, load, snapshot, csv, numbers, pipeline, ingest, btree" << endl;
+        return 1;
+    }
+    return 0;
+}
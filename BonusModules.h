@@ -365,6 +365,58 @@ public:
         cout << "+----------+------------------+-------+------+------------+" << endl;
     }
 
+    // Next few shuttles from the hub to each connected stop, with arrival
+    // times from the time-dependent road search (traffic profiles)
+    void viewShuttleTimetable() {
+        cout << "\n=== Shuttle Timetable (Traffic-Aware) ===" << endl;
+
+        string hubID = getStringInput("Enter Hub ID: ");
+        TransportHubNode* hub = findHubByID(hubID);
+        if (hub == nullptr) {
+            cout << "Error: Hub not found!" << endl;
+            return;
+        }
+
+        int from;
+        if (!parseClockTime(getStringInput("Show shuttles from (HH:MM): "), from)) {
+            cout << "Error: Enter the time as HH:MM (e.g. 08:15)." << endl;
+            return;
+        }
+
+        const int SHUTTLES_SHOWN = 4;
+        const int MAX_PATH = 500;
+        string path[MAX_PATH];
+        int pathLen = 0;
+        int connections = 0;
+
+        cout << "\n+----------+-------+-------+--------+" << endl;
+        cout << "| Stop     | Dep   | Arr   | Min    |" << endl;
+        cout << "+----------+-------+-------+--------+" << endl;
+        for (ConnectedStopNode* conn = connectionsHead; conn != nullptr; conn = conn->next) {
+            if (!stringsEqualIgnoreCase(conn->hubID, hub->hubID)) continue;
+            connections++;
+
+            // Shuttles leave on the hour and every shuttleFrequency minutes after
+            int depart = from + (conn->shuttleFrequency - from % conn->shuttleFrequency) % conn->shuttleFrequency;
+            for (int i = 0; i < SHUTTLES_SHOWN; i++, depart += conn->shuttleFrequency) {
+                double arrival = CityGraph::getInstance()->findEarliestArrival(hub->hubID, conn->stopID,
+                    depart, path, pathLen, MAX_PATH);
+                cout << "| " << left << setw(8) << conn->stopID << " | ";
+                cout << left << setw(5) << formatClockTime(depart) << " | ";
+                if (arrival == DBL_MAX) {
+                    cout << left << setw(5) << "--" << " | " << right << setw(6) << "--" << " |" << endl;
+                    break;
+                }
+                cout << left << setw(5) << formatClockTime(arrival) << " | ";
+                cout << right << setw(6) << fixed << setprecision(1) << (arrival - depart) << " |" << endl;
+            }
+        }
+        if (connections == 0) {
+            cout << "| No connected stops                |" << endl;
+        }
+        cout << "+----------+-------+-------+--------+" << endl;
+    }
+
     void displayAllHubs() {
         cout << "\n=== All Transport Hubs ===" << endl;
 
@@ -476,6 +528,114 @@ public:
         cout << "Loaded " << hubCount << " transport hubs." << endl;
     }
 
+    // SNAPSHOT
+
+    static void writeSchedule(CitySnapshotWriter& out, ScheduleEntry* head) {
+        int entries = 0;
+        for (ScheduleEntry* e = head; e != nullptr; e = e->next) entries++;
+        out.putInt(entries);
+        for (ScheduleEntry* e = head; e != nullptr; e = e->next) {
+            out.putString(e->vehicleID);
+            out.putString(e->destination);
+            out.putString(e->departureTime);
+            out.putString(e->arrivalTime);
+            out.putString(e->status);
+            out.putInt(e->platform);
+        }
+    }
+
+    static ScheduleEntry* readSchedule(CitySnapshotReader& in) {
+        ScheduleEntry* head = nullptr;
+        ScheduleEntry* tail = nullptr;
+        int entries = in.getCount();
+        for (int i = 0; i < entries && !in.hasFailed(); i++) {
+            string vehicle = in.getString();
+            string dest = in.getString();
+            string dep = in.getString();
+            string arr = in.getString();
+            string status = in.getString();
+            ScheduleEntry* e = new ScheduleEntry(vehicle, dest, dep, arr, in.getInt());
+            e->status = status;
+            if (tail == nullptr) head = e;
+            else tail->next = e;
+            tail = e;
+        }
+        return head;
+    }
+
+    // HUBS section: hubs with their schedules and the shuttle links to
+    // bus stops (the matching roads are stored with the graph)
+    void writeSnapshot(CitySnapshotWriter& out) {
+        CityGraph* cityGraph = CityGraph::getInstance();
+        out.beginSection("HUBS");
+        out.putInt(hubIDCounter);
+
+        out.putInt(hubCount);
+        for (TransportHubNode* hub = hubsHead; hub != nullptr; hub = hub->next) {
+            out.putString(hub->hubID);
+            out.putString(hub->name);
+            out.putInt(hub->type);
+            out.putString(hub->sector);
+            out.putDouble(hub->lat);
+            out.putDouble(hub->lon);
+            out.putInt(hub->totalPlatforms);
+            out.putBool(hub->isOperational);
+            out.putInt(cityGraph->getEntityVertex(hub->hubID, hub));
+            writeSchedule(out, hub->departuresHead);
+            writeSchedule(out, hub->arrivalsHead);
+        }
+
+        int connections = 0;
+        for (ConnectedStopNode* c = connectionsHead; c != nullptr; c = c->next) connections++;
+        out.putInt(connections);
+        for (ConnectedStopNode* c = connectionsHead; c != nullptr; c = c->next) {
+            out.putString(c->hubID);
+            out.putString(c->stopID);
+            out.putDouble(c->distance);
+            out.putInt(c->shuttleFrequency);
+        }
+        out.endSection();
+    }
+
+    bool readSnapshot(CitySnapshotReader& in, CitySnapshotLinks& links) {
+        if (hubsHead != nullptr || connectionsHead != nullptr) return false;
+        if (!in.beginSection("HUBS")) return false;
+        hubIDCounter = in.getInt();
+
+        int savedHubs = in.getCount();
+        TransportHubNode* hubTail = nullptr;
+        for (int i = 0; i < savedHubs && !in.hasFailed(); i++) {
+            string id = in.getString();
+            string name = in.getString();
+            int type = in.getInt();
+            string sector = in.getString();
+            double lat = in.getDouble();
+            double lon = in.getDouble();
+            TransportHubNode* hub = new TransportHubNode(id, name, type, sector, lat, lon, in.getInt());
+            hub->isOperational = in.getBool();
+            links.setEntity(in.getInt(), hub);
+            hub->departuresHead = readSchedule(in);
+            hub->arrivalsHead = readSchedule(in);
+            if (hubTail == nullptr) hubsHead = hub;
+            else hubTail->next = hub;
+            hubTail = hub;
+            hubCount++;
+        }
+
+        int savedConnections = in.getCount();
+        ConnectedStopNode* connTail = nullptr;
+        for (int i = 0; i < savedConnections && !in.hasFailed(); i++) {
+            string hubID = in.getString();
+            string stopID = in.getString();
+            double distance = in.getDouble();
+            ConnectedStopNode* conn = new ConnectedStopNode(hubID, stopID, distance, in.getInt());
+            if (connTail == nullptr) connectionsHead = conn;
+            else connTail->next = conn;
+            connTail = conn;
+        }
+        return !in.hasFailed();
+    }
+
     int getHubCount() { 
         return hubCount;
     }
@@ -555,6 +715,7 @@ public:
             cout << "6. View Hub Schedule" << endl;
             cout << "7. Display All Hubs" << endl;
             cout << "8. Find Nearest Hub" << endl;
+            cout << "9. Shuttle Timetable (Traffic-Aware)" << endl;
             cout << "0. Back" << endl;
 
             choice = getIntInput("Enter choice: ");
@@ -568,12 +729,25 @@ public:
             case 6: transportHubSystem.viewHubSchedule(); break;
             case 7: transportHubSystem.displayAllHubs(); break;
             case 8: transportHubSystem.findNearestHub(); break;
+            case 9: transportHubSystem.viewShuttleTimetable(); break;
             case 0: break;
             default: cout << "Invalid choice!" << endl;
             }
         } while (choice != 0);
     }
 
+    int getHubCount() {
+        return transportHubSystem.getHubCount();
+    }
+
+    void writeSnapshot(CitySnapshotWriter& out) {
+        transportHubSystem.writeSnapshot(out);
+    }
+
+    bool readSnapshot(CitySnapshotReader& in, CitySnapshotLinks& links) {
+        return transportHubSystem.readSnapshot(in, links);
+    }
+
     void run() {
         int choice;
         do {
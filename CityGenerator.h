@@ -0,0 +1,380 @@
+#pragma once
+#include "Utils.h"
+#include <fstream>
+#include <iomanip>
+#include <cerrno>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// SYNTHETIC CITY GENERATOR
+// Writes a consistent set of the CSV files the modules load (same headers
+// and field formats as the shipped samples) at any scale. 'citizens' sets
+// the size of population.csv; every other file is scaled from it, and all
+// cross references (roads and bus routes -> stops, products -> malls)
+// point at rows that exist. The same seed always gives the same files.
+//
+// Hospitals, schools, malls, pharmacies and facilities have no coordinates
+// in their files; the loaders place them from the sector name. Generated
+// rows use sectors the loaders do not know, so each row is placed from its
+// position in its file instead of all of a sector's rows landing on one
+// point. Every generated row places; the load suite checks it.
+
+const double GEN_MIN_LAT = 33.40;  // Stops stay below the loaders' fallback
+const double GEN_MAX_LAT = 33.69;  // placements, which start at 33.70
+const double GEN_MIN_LON = 72.80;
+const double GEN_MAX_LON = 73.20;
+
+// Room for "%05d-%07lld-%d" with any int and long long the compiler cannot
+// rule out, so snprintf never cuts a CNIC short
+const int GEN_CNIC_BUFFER = 48;
+
+struct CityGeneratorConfig {
+    long long citizens;
+    unsigned long long seed;
+
+    // Derived row counts (filled in by scaleFromCitizens)
+    long long stops;
+    long long buses;
+    long long hospitals;
+    long long pharmacies;
+    long long medicinesPerPharmacy;
+    long long schools;
+    long long malls;
+    long long productsPerMall;
+    long long facilities;
+
+    CityGeneratorConfig(long long citizenCount = 1000, unsigned long long s = 42)
+        : citizens(citizenCount), seed(s) {
+        scaleFromCitizens();
+    }
+
+    // Roughly the ratios of a real city: one stop per 20 people, one
+    // hospital per 2000, one school per 500, ...
+    void scaleFromCitizens() {
+        stops = atLeast(citizens / 20, 10);
+        buses = atLeast(stops / 10, 5);
+        hospitals = atLeast(citizens / 2000, 5);
+        pharmacies = atLeast(citizens / 1000, 5);
+        medicinesPerPharmacy = 5;
+        schools = atLeast(citizens / 500, 5);
+        malls = atLeast(citizens / 2000, 5);
+        productsPerMall = 20;
+        facilities = atLeast(citizens / 1000, 5);
+    }
+
+    static long long atLeast(long long value, long long minimum) {
+        return (value < minimum) ? minimum : value;
+    }
+};
+
+// Small, portable PRNG (SplitMix64): rand() differs between platforms,
+// this gives the same files everywhere for the same seed
+class CityRandom {
+private:
+    unsigned long long state;
+
+public:
+    CityRandom(unsigned long long seed) : state(seed) {}
+
+    unsigned long long next() {
+        unsigned long long z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, n)
+    long long below(long long n) { return (long long)(next() % (unsigned long long)n); }
+
+    // Uniform in [0, 1)
+    double unit() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+class CityGenerator {
+private:
+    CityGeneratorConfig config;
+    string directory;
+    long long stopSide;         // Stops sit on a stopSide x stopSide jittered grid
+    long long rowsWritten;
+
+    static const char* const FIRST_NAMES[];
+    static const char* const LAST_NAMES[];
+    static const char* const OCCUPATIONS[];
+    static const char* const SPECIALIZATIONS[];
+    static const char* const SUBJECTS[];
+    static const char* const MEDICINES[][2];
+    static const char* const PRODUCTS[][2];
+    static const char* const FACILITY_TYPES[];
+    static const char* const COMPANIES[];
+
+    string path(const string& file) {
+        return directory.empty() ? file : directory + "/" + file;
+    }
+
+    bool openFile(ofstream& out, const string& file, const string& header) {
+        out.open(path(file).c_str());
+        if (!out.is_open()) {
+            cout << "Error: cannot write " << path(file) << endl;
+            return false;
+        }
+        out << header << "\n";
+        return true;
+    }
+
+    // Sectors D-12 .. I-17: real-looking, but none has a fixed spot in the loaders
+    string sectorName(long long i) {
+        char letter = (char)('D' + (i / 6) % 6);
+        return string(1, letter) + "-" + intToString((int)(12 + i % 6));
+    }
+
+    string stopID(long long row, long long col) {
+        return "ST" + to_string(row * stopSide + col);
+    }
+
+    // Two quoted, comma separated picks from a list (tests embedded commas)
+    string quotedPair(const char* const list[], int size, CityRandom& rng) {
+        int a = (int)rng.below(size);
+        int b = (a + 1 + (int)rng.below(size - 1)) % size;
+        return string("\"") + list[a] + ", " + list[b] + "\"";
+    }
+
+    bool writeStops(CityRandom& rng) {
+        ofstream out;
+        if (!openFile(out, "stops.csv", "StopID,Name,Coordinates")) return false;
+        out << fixed << setprecision(6);
+
+        double latStep = (GEN_MAX_LAT - GEN_MIN_LAT) / stopSide;
+        double lonStep = (GEN_MAX_LON - GEN_MIN_LON) / stopSide;
+        long long written = 0;
+        for (long long r = 0; r < stopSide && written < config.stops; r++) {
+            for (long long c = 0; c < stopSide && written < config.stops; c++, written++) {
+                // Jitter stays inside a third of a cell, so stops never coincide
+                double lat = GEN_MIN_LAT + (r + 0.33 + rng.unit() / 3) * latStep;
+                double lon = GEN_MIN_LON + (c + 0.33 + rng.unit() / 3) * lonStep;
+                out << stopID(r, c) << "," << sectorName(r * stopSide + c) << " Stop " << written
+                    << ",\"" << lat << ", " << lon << "\"\n";
+            }
+        }
+        rowsWritten += written;
+        return true;
+    }
+
+    // Grid streets between neighboring stops (about 10% missing), and a
+    // rush-hour profile on every tenth row of them
+    bool writeRoads(CityRandom& rng) {
+        ofstream roads, traffic;
+        if (!openFile(roads, "roads.csv", "From,To,Distance")) return false;
+        if (!openFile(traffic, "traffic.csv", "From,To,Profile")) return false;
+        roads << fixed << setprecision(4);
+
+        for (long long v = 0; v < config.stops; v++) {
+            long long r = v / stopSide, c = v % stopSide;
+            for (int dir = 0; dir < 2; dir++) {
+                long long nr = r + dir, nc = c + 1 - dir;
+                if (nr >= stopSide || nc >= stopSide || nr * stopSide + nc >= config.stops) continue;
+                if (rng.below(10) == 0) continue;
+
+                // The loader measures the real distance; this column is informational
+                roads << stopID(r, c) << "," << stopID(nr, nc) << "," << (1.0 + rng.unit()) << "\n";
+                rowsWritten++;
+                if (r % 10 == 0 && dir == 0) {
+                    traffic << stopID(r, c) << "," << stopID(nr, nc) << ",\"06:30=40;08:00=15;10:00=40;17:00=15;19:00=40\"\n";
+                    rowsWritten++;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Each bus drives a random walk of 5-15 neighboring stops
+    bool writeBuses(CityRandom& rng) {
+        ofstream out;
+        if (!openFile(out, "buses.csv", "BusNo,Company,CurrentStop,Route")) return false;
+
+        for (long long b = 0; b < config.buses; b++) {
+            long long v = rng.below(config.stops);
+            int length = 5 + (int)rng.below(11);
+            string route = "";
+            string first = "";
+            for (int i = 0; i < length; i++) {
+                long long r = v / stopSide, c = v % stopSide;
+                string id = stopID(r, c);
+                if (i == 0) first = id;
+                else route += " > ";
+                route += id;
+
+                // Step to a random neighbor that exists (so no stop repeats back to back)
+                for (int attempt = 0; attempt < 8; attempt++) {
+                    long long next = -1;
+                    switch (rng.below(4)) {
+                    case 0: if (c + 1 < stopSide) next = v + 1; break;
+                    case 1: if (c > 0) next = v - 1; break;
+                    case 2: next = v + stopSide; break;
+                    default: next = v - stopSide; break;
+                    }
+                    if (next >= 0 && next < config.stops) {
+                        v = next;
+                        break;
+                    }
+                }
+            }
+            out << "B" << b << "," << COMPANIES[b % 4] << "," << first << "," << route << "\n";
+        }
+        rowsWritten += config.buses;
+        return true;
+    }
+
+    bool writeMedical(CityRandom& rng) {
+        ofstream hospitals, pharmacies;
+        if (!openFile(hospitals, "hospitals.csv", "HospitalID,Name,Sector,EmergencyBeds,Specialization")) return false;
+        for (long long i = 0; i < config.hospitals; i++) {
+            hospitals << "H" << i << "," << LAST_NAMES[i % 12] << " Hospital " << i << "," << sectorName(rng.below(36))
+                << "," << (5 + rng.below(60)) << "," << quotedPair(SPECIALIZATIONS, 8, rng) << "\n";
+        }
+        rowsWritten += config.hospitals;
+
+        if (!openFile(pharmacies, "pharmacies.csv", "PharmacyID,Name,Sector,MedicineName,Formula,Price")) return false;
+        for (long long i = 0; i < config.pharmacies; i++) {
+            string sector = sectorName(rng.below(36));
+            for (long long m = 0; m < config.medicinesPerPharmacy; m++) {
+                int med = (int)((i + m * 3) % 10);
+                pharmacies << "P" << i << "," << FIRST_NAMES[i % 12] << " Pharmacy " << i << "," << sector << ","
+                    << MEDICINES[med][0] << "," << MEDICINES[med][1] << "," << (20 + rng.below(500)) << "\n";
+            }
+        }
+        rowsWritten += config.pharmacies * config.medicinesPerPharmacy;
+        return true;
+    }
+
+    bool writeSchools(CityRandom& rng) {
+        ofstream out;
+        if (!openFile(out, "schools.csv", "SchoolID,Name,Sector,Rating,Subjects")) return false;
+        out << fixed << setprecision(1);
+        for (long long i = 0; i < config.schools; i++) {
+            out << "S" << i << "," << LAST_NAMES[i % 12] << " School " << i << "," << sectorName(rng.below(36))
+                << "," << (2.5 + rng.below(26) / 10.0) << "," << quotedPair(SUBJECTS, 8, rng) << "\n";
+        }
+        rowsWritten += config.schools;
+        return true;
+    }
+
+    bool writeCommercial(CityRandom& rng) {
+        ofstream malls, products;
+        if (!openFile(malls, "malls.csv", "MallID,Name,Sector,Open,Close")) return false;
+        for (long long i = 0; i < config.malls; i++) {
+            malls << "M" << i << "," << FIRST_NAMES[i % 12] << " Mall " << i << "," << sectorName(rng.below(36))
+                << "," << (9 + rng.below(3)) << ":00," << (20 + rng.below(4)) << ":00\n";
+        }
+        rowsWritten += config.malls;
+
+        if (!openFile(products, "products.csv", "MallID,ProductID,Name,Category,Price,Quantity")) return false;
+        for (long long i = 0; i < config.malls; i++) {
+            for (long long p = 0; p < config.productsPerMall; p++) {
+                int kind = (int)(p % 10);
+                products << "M" << i << ",PR" << (i * config.productsPerMall + p) << "," << PRODUCTS[kind][0] << " " << p
+                    << "," << PRODUCTS[kind][1] << "," << (100 + rng.below(10000)) << "," << rng.below(500) << "\n";
+            }
+        }
+        rowsWritten += config.malls * config.productsPerMall;
+        return true;
+    }
+
+    bool writeFacilities(CityRandom& rng) {
+        ofstream out;
+        if (!openFile(out, "facilities.csv", "ID,Name,Type,Sector,Timings,Rating")) return false;
+        for (long long i = 0; i < config.facilities; i++) {
+            const char* type = FACILITY_TYPES[i % 9];
+            out << "F" << i << "," << type << " " << i << "," << type << "," << sectorName(rng.below(36)) << ","
+                << ((i % 7 == 0) ? "24 Hours" : "9:00 AM-5:00 PM") << "," << (1 + rng.below(5)) << "\n";
+        }
+        rowsWritten += config.facilities;
+        return true;
+    }
+
+    // CNICs are unique by construction: region prefix + running number + gender digit
+    bool writePopulation(CityRandom& rng) {
+        ofstream out;
+        if (!openFile(out, "population.csv", "CNIC,Name,Age,Sector,Street,HouseNo,Occupation")) return false;
+
+        char cnic[GEN_CNIC_BUFFER];
+        for (long long i = 0; i < config.citizens; i++) {
+            int region = 61101 + (int)(i / 10000000LL);
+            snprintf(cnic, sizeof(cnic), "%05d-%07lld-%d", region, i % 10000000LL, (int)rng.below(10));
+            out << cnic << "," << FIRST_NAMES[rng.below(12)] << " " << LAST_NAMES[rng.below(12)] << ","
+                << (1 + rng.below(90)) << "," << sectorName(rng.below(36)) << "," << (1 + rng.below(40)) << ","
+                << (1 + rng.below(300)) << "," << OCCUPATIONS[rng.below(10)] << "\n";
+        }
+        rowsWritten += config.citizens;
+        return true;
+    }
+
+public:
+    // dir must exist ("" = current directory)
+    CityGenerator(const CityGeneratorConfig& c, const string& dir = "")
+        : config(c), directory(dir), stopSide(1), rowsWritten(0) {
+        while (stopSide * stopSide < config.stops) stopSide++;
+    }
+
+    // Writes every file; false if one could not be created
+    bool generate() {
+        rowsWritten = 0;
+        CityRandom rng(config.seed);
+        return writeStops(rng) && writeRoads(rng) && writeBuses(rng) && writeMedical(rng) &&
+            writeSchools(rng) && writeCommercial(rng) && writeFacilities(rng) && writePopulation(rng);
+    }
+
+    // Writes population.csv only, for the large ingestion benchmarks
+    bool generatePopulation() {
+        rowsWritten = 0;
+        CityRandom rng(config.seed);
+        return writePopulation(rng);
+    }
+
+    long long getRowsWritten() { return rowsWritten; }
+    const CityGeneratorConfig& getConfig() { return config; }
+};
+
+const char* const CityGenerator::FIRST_NAMES[] = { "Ahmed", "Fatima", "Ali", "Ayesha", "Hassan", "Zainab",
+    "Usman", "Maryam", "Bilal", "Sana", "Omar", "Hira" };
+const char* const CityGenerator::LAST_NAMES[] = { "Khan", "Ahmed", "Malik", "Qureshi", "Butt", "Chaudhry",
+    "Raza", "Sheikh", "Abbasi", "Hussain", "Mirza", "Siddiqui" };
+const char* const CityGenerator::OCCUPATIONS[] = { "Engineer", "Teacher", "Doctor", "Student", "Driver",
+    "Shopkeeper", "Nurse", "Accountant", "Retired", "Software Developer" };
+const char* const CityGenerator::SPECIALIZATIONS[] = { "General", "Cardiology", "Oncology", "Surgery",
+    "Pediatrics", "Neurology", "Orthopedics", "Gynecology" };
+const char* const CityGenerator::SUBJECTS[] = { "Math", "Physics", "English", "Urdu", "CS", "Chemistry",
+    "Biology", "Islamiat" };
+const char* const CityGenerator::MEDICINES[][2] = { { "Panadol", "Paracetamol" }, { "Augmentin", "Co-Amoxiclav" },
+    { "Brufen", "Ibuprofen" }, { "Flagyl", "Metronidazole" }, { "Disprin", "Aspirin" }, { "Ventolin", "Salbutamol" },
+    { "Zyrtec", "Cetirizine" }, { "Nexum", "Esomeprazole" }, { "Glucophage", "Metformin" }, { "Lipitor", "Atorvastatin" } };
+const char* const CityGenerator::PRODUCTS[][2] = { { "Shirt", "Clothing" }, { "Shoes", "Footwear" },
+    { "Phone", "Electronics" }, { "Laptop", "Electronics" }, { "Rice", "Grocery" }, { "Tea", "Grocery" },
+    { "Watch", "Accessories" }, { "Bag", "Accessories" }, { "Novel", "Books" }, { "Perfume", "Cosmetics" } };
+const char* const CityGenerator::FACILITY_TYPES[] = { "Park", "Library", "Community Center", "Sports Complex",
+    "Museum", "Playground", "Swimming Pool", "Gym", "Mosque" };
+const char* const CityGenerator::COMPANIES[] = { "MetroBus", "CapitalTrans", "GreenLine", "CityRide" };
+
+// Directory helpers for tools that generate into their own folder
+bool cityMakeDirectory(const string& dir) {
+#ifdef _WIN32
+    return _mkdir(dir.c_str()) == 0 || errno == EEXIST;
+#else
+    return mkdir(dir.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+bool cityChangeDirectory(const string& dir) {
+#ifdef _WIN32
+    return _chdir(dir.c_str()) == 0;
+#else
+    return chdir(dir.c_str()) == 0;
+#endif
+}
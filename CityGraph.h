@@ -1,5 +1,10 @@
 #pragma once
 #include "Utils.h"
+#include "SpatialIndex.h"
+#include "ThreadPool.h"
+#include "PathCache.h"
+#include "RoutingEngine.h"
+#include "CitySnapshot.h"
 #include <iostream>
 #include <string>
 #include <cfloat> 
@@ -15,6 +20,19 @@ const int LOC_MALL = 4;
 const int LOC_FACILITY = 5;
 const int LOC_HOUSE = 6;
 const int LOC_OTHER = 7;
+const int LOCATION_TYPE_COUNT = 8;
+
+// Side of a spatial index cell, in coordinate units (about 1 km)
+const double CITY_GRID_CELL_SIZE = 0.01;
+
+// Point-to-point routing modes for findShortestPath
+const int ROUTE_DIJKSTRA = 0;
+const int ROUTE_ASTAR = 1;      // A* with a straight-line lower bound
+const int ROUTE_ALT = 2;        // A* with landmark (ALT) lower bounds
+
+// One-to-all methods for distancesFrom
+const int SSSP_DIJKSTRA = 0;
+const int SSSP_DELTA_STEPPING = 1;  // Parallel, same distances as Dijkstra
 
 // Convert int type to string
 string locationTypeToString(int type) {
@@ -40,130 +58,661 @@ string locationTypeToString(int type) {
 
 
 // Structs 
+struct CityAdjNode;
+
 struct CityLocation {
     string id;
     string name;
     int type;       
     double lat, lon;
     void* entityPtr;
+    int index;          // Dense vertex index (0 .. locationCount-1) used by the compact graph
+    CityAdjNode* adj;   // This location's adjacency list entry
+    CityLocation* prev;
     CityLocation* next;
 
     CityLocation(const string& i, const string& n, int t, double la, double lo, void* ptr = nullptr)
-        : id(i), name(n), type(t), lat(la), lon(lo), entityPtr(ptr), next(nullptr) {
+        : id(i), name(n), type(t), lat(la), lon(lo), entityPtr(ptr), index(-1), adj(nullptr), prev(nullptr), next(nullptr) {
     }
 };
 
 
 struct CityRoad {
     string destID;
+    CityLocation* destLoc;  // Resolved destination, saves an ID lookup per edge
     double distance;
+    const CityTrafficPattern* traffic;  // Time-of-day speeds, nullptr = free flow
     CityRoad* next;
 
-    CityRoad(const string& dest, double dist) : destID(dest), distance(dist), next(nullptr) {}
+    CityRoad(const string& dest, double dist, CityLocation* loc = nullptr)
+        : destID(dest), destLoc(loc), distance(dist), traffic(nullptr), next(nullptr) {}
+};
+
+// ID index node (Hash Chain) for O(1) lookups by location ID
+struct CityIDHashNode {
+    CityLocation* loc;
+    CityIDHashNode* next;
+
+    CityIDHashNode(CityLocation* l) : loc(l), next(nullptr) {}
 };
 
 // Adjacency list node for city graph
 struct CityAdjNode {
     string locationID;
     CityRoad* roadHead;
+    CityAdjNode* prev;
     CityAdjNode* next;
 
-    CityAdjNode(const string& id) : locationID(id), roadHead(nullptr), next(nullptr) {}
+    CityAdjNode(const string& id) : locationID(id), roadHead(nullptr), prev(nullptr), next(nullptr) {}
 };
 
-// Min-heap node for Dijkstra
-struct CityDijkstraNode {
-    string locationID;
+// One result of a k-nearest-by-road query
+struct CityRouteResult {
+    string destID;
     double distance;
+    string* path;
+    int pathLen;
+
+    CityRouteResult() : destID(""), distance(DBL_MAX), path(nullptr), pathLen(0) {}
+    ~CityRouteResult() { delete[] path; }
+
+    CityRouteResult(const CityRouteResult&) = delete;
+    CityRouteResult& operator=(const CityRouteResult&) = delete;
+};
+
+// Origin x destination road distances from CityGraph::distanceMatrix
+struct CityDistanceMatrix {
+    int rows, cols;
+    double* distances;          // distances[r * cols + c], DBL_MAX if unreachable
+    CityRouteResult* routes;    // Same layout; only allocated when paths are requested
+
+    CityDistanceMatrix() : rows(0), cols(0), distances(nullptr), routes(nullptr) {}
+    ~CityDistanceMatrix() { clear(); }
+
+    CityDistanceMatrix(const CityDistanceMatrix&) = delete;
+    CityDistanceMatrix& operator=(const CityDistanceMatrix&) = delete;
+
+    double at(int r, int c) { return distances[r * cols + c]; }
+
+    void clear() {
+        delete[] distances;
+        delete[] routes;
+        distances = nullptr;
+        routes = nullptr;
+        rows = cols = 0;
+    }
 };
 
-// Min-heap for Dijkstra in city graph
-class CityDijkstraHeap {
+// Every location within a road-distance budget of one origin
+// (CityGraph::findWithinDistance), grouped by location type: the locations
+// of type t are ids[typeStart[t] .. typeStart[t+1]-1], nearest first
+struct CityIsochrone {
+    string originID;
+    double budget;
+    int count;
+    string* ids;
+    double* distances;
+    int typeStart[LOCATION_TYPE_COUNT + 1];
+
+    CityIsochrone() : originID(""), budget(0), count(0), ids(nullptr), distances(nullptr) {
+        for (int t = 0; t <= LOCATION_TYPE_COUNT; t++) typeStart[t] = 0;
+    }
+    ~CityIsochrone() { clear(); }
+
+    CityIsochrone(const CityIsochrone&) = delete;
+    CityIsochrone& operator=(const CityIsochrone&) = delete;
+
+    int countOfType(int type) { return typeStart[type + 1] - typeStart[type]; }
+
+    void clear() {
+        delete[] ids;
+        delete[] distances;
+        ids = nullptr;
+        distances = nullptr;
+        count = 0;
+        for (int t = 0; t <= LOCATION_TYPE_COUNT; t++) typeStart[t] = 0;
+    }
+};
+
+// DYNAMIC SHORTEST PATH TREE
+// Road distance from every location to the nearest "hot" source (all
+// hospitals, all fire stations, ...), kept current as roads open and close
+// instead of being recomputed per query (Ramalingam-Reps style):
+//  - a new road only pushes shorter distances outward from its endpoints
+//  - removing a road that is not a tree edge changes nothing
+//  - removing a tree edge resets just the subtree below it, reseeds it from
+//    its untouched neighbors and re-runs Dijkstra inside it
+// State is indexed by the graph's dense vertex index; parents and sources
+// are stored as locations so index moves on deletion stay O(1).
+class CityShortestPathTree {
 private:
-    static const int MAX_SIZE = 500;
-    CityDijkstraNode heap[MAX_SIZE];
-    int size;
+    string name;
+    int sourceType;
+    SpatialFilter sourceFilter;     // Optional extra test on matching locations
+    void* filterContext;
+
+    double* dist;                   // DBL_MAX = no source reachable
+    CityLocation** parent;          // Next location towards the source (nullptr at a source)
+    CityLocation** source;          // Nearest source
+    unsigned int* affectedStamp;    // Marks the subtree being rebuilt
+    unsigned int stamp;
+    int capacity;
+    int sourceCount;
+
+    CityIndexedHeap heap;
+    CityLocation** heapLocation;    // Heap works on indices; remember who they are
+    CityLocation** affected;        // Subtree buffer
+
+    long long updates;
+    long long touched;              // Vertices whose distance was recomputed
+
+    void grow(int n) {
+        if (n <= capacity) return;
+        int newCapacity = (capacity > 0) ? capacity : 64;
+        while (newCapacity < n) newCapacity *= 2;
+
+        double* newDist = new double[newCapacity];
+        CityLocation** newParent = new CityLocation * [newCapacity];
+        CityLocation** newSource = new CityLocation * [newCapacity];
+        unsigned int* newStamp = new unsigned int[newCapacity];
+        for (int i = 0; i < newCapacity; i++) {
+            newDist[i] = (i < capacity) ? dist[i] : DBL_MAX;
+            newParent[i] = (i < capacity) ? parent[i] : nullptr;
+            newSource[i] = (i < capacity) ? source[i] : nullptr;
+            newStamp[i] = (i < capacity) ? affectedStamp[i] : 0;
+        }
+        delete[] dist;
+        delete[] parent;
+        delete[] source;
+        delete[] affectedStamp;
+        delete[] heapLocation;
+        delete[] affected;
+        dist = newDist;
+        parent = newParent;
+        source = newSource;
+        affectedStamp = newStamp;
+        heapLocation = new CityLocation * [newCapacity];
+        affected = new CityLocation * [newCapacity];
+        capacity = newCapacity;
+        heap.reserve(newCapacity);
+    }
+
+    bool isSource(CityLocation* loc) {
+        return loc->type == sourceType && (sourceFilter == nullptr || sourceFilter(loc, filterContext));
+    }
 
-    void swap(int i, int j) {
-        CityDijkstraNode temp = heap[i];
-        heap[i] = heap[j];
-        heap[j] = temp;
+    void setLabel(CityLocation* loc, double d, CityLocation* from, CityLocation* src) {
+        dist[loc->index] = d;
+        parent[loc->index] = from;
+        source[loc->index] = src;
+        heapLocation[loc->index] = loc;
+        heap.insertOrDecrease(loc->index, d);
     }
 
-    void siftUp(int i) {
-        while (i > 0) {
-            int parent = (i - 1) / 2;
-            if (heap[i].distance < heap[parent].distance) {
-                swap(i, parent);
-                i = parent;
+    // Dijkstra from everything currently queued; only strict improvements spread
+    void propagate() {
+        while (!heap.isEmpty()) {
+            int u = heap.extractMin();
+            CityLocation* loc = heapLocation[u];
+            touched++;
+            if (loc->adj == nullptr) continue;
+
+            for (CityRoad* road = loc->adj->roadHead; road != nullptr; road = road->next) {
+                CityLocation* next = road->destLoc;
+                if (next == nullptr) continue;
+                double newDist = dist[u] + road->distance;
+                if (newDist < dist[next->index]) {
+                    setLabel(next, newDist, loc, source[u]);
+                }
             }
-            else break;
         }
     }
 
-    void siftDown(int i) {
-        while (true) {
-            int smallest = i;
-            int left = 2 * i + 1;
-            int right = 2 * i + 2;
+    // The tree edge into 'root' is gone: recompute root's whole subtree
+    void rebuildSubtree(CityLocation* root) {
+        stamp++;
+        if (stamp == 0) {
+            for (int i = 0; i < capacity; i++) affectedStamp[i] = 0;
+            stamp = 1;
+        }
 
-            if (left < size && heap[left].distance < heap[smallest].distance)
-                smallest = left;
-            if (right < size && heap[right].distance < heap[smallest].distance)
-                smallest = right;
+        // Collect the subtree; tree children are always road neighbors
+        int count = 0;
+        affected[count++] = root;
+        affectedStamp[root->index] = stamp;
+        for (int i = 0; i < count; i++) {
+            CityLocation* loc = affected[i];
+            if (loc->adj == nullptr) continue;
+            for (CityRoad* road = loc->adj->roadHead; road != nullptr; road = road->next) {
+                CityLocation* child = road->destLoc;
+                if (child != nullptr && parent[child->index] == loc && affectedStamp[child->index] != stamp) {
+                    affectedStamp[child->index] = stamp;
+                    affected[count++] = child;
+                }
+            }
+        }
 
-            if (smallest != i) {
-                swap(i, smallest);
-                i = smallest;
+        for (int i = 0; i < count; i++) {
+            int v = affected[i]->index;
+            dist[v] = DBL_MAX;
+            parent[v] = nullptr;
+            source[v] = nullptr;
+        }
+
+        // Best entry into the subtree from outside, then settle it
+        for (int i = 0; i < count; i++) {
+            CityLocation* loc = affected[i];
+            if (loc->adj == nullptr) continue;
+            for (CityRoad* road = loc->adj->roadHead; road != nullptr; road = road->next) {
+                CityLocation* next = road->destLoc;
+                if (next == nullptr || affectedStamp[next->index] == stamp) continue;
+                int w = next->index;
+                if (dist[w] != DBL_MAX && dist[w] + road->distance < dist[loc->index]) {
+                    setLabel(loc, dist[w] + road->distance, next, source[w]);
+                }
             }
-            else break;
         }
+        propagate();
     }
 
 public:
-    CityDijkstraHeap() : size(0) {}
+    CityShortestPathTree* next;
+
+    CityShortestPathTree(const string& n, int type, SpatialFilter filter = nullptr, void* context = nullptr)
+        : name(n), sourceType(type), sourceFilter(filter), filterContext(context), dist(nullptr),
+        parent(nullptr), source(nullptr), affectedStamp(nullptr), stamp(0), capacity(0), sourceCount(0),
+        heapLocation(nullptr), affected(nullptr), updates(0), touched(0), next(nullptr) {
+    }
+
+    ~CityShortestPathTree() {
+        delete[] dist;
+        delete[] parent;
+        delete[] source;
+        delete[] affectedStamp;
+        delete[] heapLocation;
+        delete[] affected;
+    }
+
+    CityShortestPathTree(const CityShortestPathTree&) = delete;
+    CityShortestPathTree& operator=(const CityShortestPathTree&) = delete;
+
+    // Full multi-source Dijkstra over vertices[0 .. count-1]
+    void build(CityLocation** vertices, int count) {
+        grow(count);
+        heap.clear();
+        sourceCount = 0;
+        for (int v = 0; v < count; v++) {
+            dist[v] = DBL_MAX;
+            parent[v] = nullptr;
+            source[v] = nullptr;
+        }
+        for (int v = 0; v < count; v++) {
+            if (isSource(vertices[v])) {
+                setLabel(vertices[v], 0, nullptr, vertices[v]);
+                sourceCount++;
+            }
+        }
+        propagate();
+    }
+
+    // Graph hooks, called by CityGraph after the change is made
+
+    void onLocationAdded(CityLocation* loc) {
+        grow(loc->index + 1);
+        dist[loc->index] = DBL_MAX;
+        parent[loc->index] = nullptr;
+        source[loc->index] = nullptr;
+        if (isSource(loc)) {
+            dist[loc->index] = 0;
+            source[loc->index] = loc;
+            sourceCount++;
+        }
+        updates++;
+    }
+
+    // loc has no roads left; 'moved' (or nullptr) takes over its index
+    void onLocationRemoved(CityLocation* loc, CityLocation* moved) {
+        if (source[loc->index] == loc) sourceCount--;
+        if (moved != nullptr) {
+            int from = moved->index;
+            dist[loc->index] = dist[from];
+            parent[loc->index] = parent[from];
+            source[loc->index] = source[from];
+        }
+        updates++;
+    }
 
-    bool isEmpty() { return size == 0; }
+    void onRoadAdded(CityLocation* a, CityLocation* b, double length) {
+        updates++;
+        if (dist[a->index] != DBL_MAX && dist[a->index] + length < dist[b->index]) {
+            setLabel(b, dist[a->index] + length, a, source[a->index]);
+        }
+        if (dist[b->index] != DBL_MAX && dist[b->index] + length < dist[a->index]) {
+            setLabel(a, dist[b->index] + length, b, source[b->index]);
+        }
+        propagate();
+    }
 
-    void insert(const string& id, double dist) {
-        if (size >= MAX_SIZE) return;
-        heap[size].locationID = id;
-        heap[size].distance = dist;
-        siftUp(size);
-        size++;
+    void onRoadRemoved(CityLocation* a, CityLocation* b) {
+        updates++;
+        if (parent[b->index] == a) rebuildSubtree(b);
+        else if (parent[a->index] == b) rebuildSubtree(a);
     }
 
-    CityDijkstraNode extractMin() {
-        CityDijkstraNode minNode = heap[0];
-        heap[0] = heap[size - 1];
-        size--;
-        if (size > 0) siftDown(0);
-        return minNode;
+    // Whatever the filter looks at (e.g. a facility's type) may have changed
+    void onSourceChanged(CityLocation* loc) {
+        bool wasSource = (source[loc->index] == loc);
+        bool nowSource = isSource(loc);
+        if (wasSource == nowSource) return;
+        updates++;
+
+        if (nowSource) {
+            sourceCount++;
+            setLabel(loc, 0, nullptr, loc);
+            propagate();
+        }
+        else {
+            // Everything that was routed to loc, loc included, finds a new source
+            sourceCount--;
+            rebuildSubtree(loc);
+        }
     }
 
-    void clear() { size = 0; }
+    // O(1) queries
+
+    double distanceFrom(CityLocation* loc) { return dist[loc->index]; }
+    CityLocation* nearestSource(CityLocation* loc) { return source[loc->index]; }
+
+    // Route from loc to its nearest source (loc first); returns stops written
+    int pathToSource(CityLocation* loc, string path[], int maxPathLen) {
+        if (dist[loc->index] == DBL_MAX) return 0;
+        int len = 0;
+        for (CityLocation* step = loc; step != nullptr && len < maxPathLen; step = parent[step->index]) {
+            path[len++] = step->id;
+        }
+        return len;
+    }
+
+    const string& getName() { return name; }
+    int getSourceCount() { return sourceCount; }
+    long long getUpdateCount() { return updates; }
+    long long getTouchedCount() { return touched; }
 };
 
 //City Graph class 
 // Singleton Class
+class CityGraph;
+
+// Shared, read-only state of one distanceMatrix call
+struct CityMatrixJob {
+    CityGraph* graph;
+    int* sourceVertex;          // -1 for unknown IDs
+    int* targetVertex;
+    int targetCount;
+    char* isTarget;             // isTarget[v] != 0 if v is one of the targets
+    int distinctTargets;
+    int* sourceComponent;       // Road network component of each source
+    int* distinctComponent;     // Component of each distinct target
+    CityDistanceMatrix* result;
+    bool withPaths;
+};
+
+struct CityIsochroneJob {
+    CityGraph* graph;
+    const string* origins;
+    double budget;
+    CityIsochrone* results;
+};
+
 class CityGraph {
 private:
     CityLocation* locationsHead;
     CityAdjNode* adjListHead;
     int locationCount;
 
+    // Dynamic hash table: location ID -> CityLocation (case insensitive)
+    CityIDHashNode** idTable;
+    int idTableSize;
+
+    // Dense vertex array: index -> CityLocation
+    CityLocation** vertices;
+    int vertexCapacity;
+
+    // Compact (CSR) copy of the road network, rebuilt lazily after edits.
+    // Neighbors of vertex v are csrTargets[csrOffsets[v] .. csrOffsets[v+1]-1]
+    int* csrOffsets;
+    int* csrTargets;
+    double* csrWeights;
+    const CityTrafficPattern** csrTraffic;
+    int csrEdgeCount;
+    bool csrDirty;
+
+    // Bumped on every location/road change so derived data can tell it is stale
+    unsigned int graphVersion;
+
+    // Largest factor k with k * straight-line distance <= road length on
+    // every edge, so k * calculateDistance() is a safe A* lower bound
+    double heuristicScale;
+
+    // ALT landmarks: landmarkDist[i * locationCount + v] = road distance
+    // from landmarks[i] to v (DBL_MAX if unreachable)
+    int landmarkCount;
+    int* landmarks;
+    double* landmarkDist;
+    unsigned int landmarkVersion;
+
+    // Spatial index, one grid per location type (items are CityLocation*)
+    SpatialGrid* typeGrids[LOCATION_TYPE_COUNT];
+
+    // Recent findShortestPath results, invalidated through graphVersion
+    CityPathCache pathCache;
+
+    // Incrementally maintained nearest-source trees (hospitals, fire stations, ...)
+    CityShortestPathTree* hotTreesHead;
+
+    CityDeltaStats lastDeltaStats;
+
+    // Connected components (union-find over vertex indices). Roads are only
+    // ever merged in; a removal marks the labels stale and the next query
+    // recomputes them from the adjacency lists.
+    int* componentParent;
+    int* componentSize;
+    int componentCount;
+    bool componentsDirty;
+    long long unreachableRejected;  // Route queries answered by the labels alone
+
     static CityGraph* instance;
 
-    CityGraph() : locationsHead(nullptr), adjListHead(nullptr), locationCount(0) {}
+    CityGraph() : locationsHead(nullptr), adjListHead(nullptr), locationCount(0),
+        idTableSize(64), vertexCapacity(64), csrOffsets(nullptr), csrTargets(nullptr),
+        csrWeights(nullptr), csrTraffic(nullptr), csrEdgeCount(0), csrDirty(true), graphVersion(0), heuristicScale(0),
+        landmarkCount(0), landmarks(nullptr), landmarkDist(nullptr), landmarkVersion(0), hotTreesHead(nullptr),
+        componentCount(0), componentsDirty(false), unreachableRejected(0) {
+        idTable = new CityIDHashNode * [idTableSize];
+        for (int i = 0; i < idTableSize; i++) {
+            idTable[i] = nullptr;
+        }
+        vertices = new CityLocation * [vertexCapacity];
+        componentParent = new int[vertexCapacity];
+        componentSize = new int[vertexCapacity];
+        for (int t = 0; t < LOCATION_TYPE_COUNT; t++) {
+            typeGrids[t] = new SpatialGrid(CITY_GRID_CELL_SIZE);
+        }
+    }
 
-    // Get adjacency node
-    CityAdjNode* getAdjNode(const string& id) {
-        CityAdjNode* current = adjListHead;
+    // Unknown types share the LOC_OTHER grid
+    SpatialGrid* gridForType(int type) {
+        if (type < 0 || type >= LOCATION_TYPE_COUNT) type = LOC_OTHER;
+        return typeGrids[type];
+    }
+
+    // ID INDEX (HASH TABLE)
+
+    int idHash(const string& id) {
+        return polynomialHash(id, idTableSize);
+    }
+
+    // Resize ID table when load factor exceeds 0.75
+    void resizeIDTable() {
+        int oldSize = idTableSize;
+        CityIDHashNode** oldTable = idTable;
+
+        idTableSize = oldSize * 2;
+        idTable = new CityIDHashNode * [idTableSize];
+        for (int i = 0; i < idTableSize; i++) {
+            idTable[i] = nullptr;
+        }
+
+        for (int i = 0; i < oldSize; i++) {
+            CityIDHashNode* current = oldTable[i];
+            while (current != nullptr) {
+                CityIDHashNode* next = current->next;
+                int newIdx = idHash(current->loc->id);
+                current->next = idTable[newIdx];
+                idTable[newIdx] = current;
+                current = next;
+            }
+        }
+        delete[] oldTable;
+    }
+
+    void addToIDTable(CityLocation* loc) {
+        if ((double)(locationCount + 1) / idTableSize > 0.75) {
+            resizeIDTable();
+        }
+        int idx = idHash(loc->id);
+        CityIDHashNode* newNode = new CityIDHashNode(loc);
+        newNode->next = idTable[idx];
+        idTable[idx] = newNode;
+    }
+
+    void removeFromIDTable(const string& id) {
+        int idx = idHash(id);
+        CityIDHashNode* current = idTable[idx];
+        CityIDHashNode* prev = nullptr;
         while (current != nullptr) {
-            if (stringsEqualIgnoreCase(current->locationID, id)) return current;
+            if (stringsEqualIgnoreCase(current->loc->id, id)) {
+                if (prev == nullptr) idTable[idx] = current->next;
+                else prev->next = current->next;
+                delete current;
+                return;
+            }
+            prev = current;
             current = current->next;
         }
-        return nullptr;
+    }
+
+    // DENSE VERTEX ARRAY
+
+    void appendVertex(CityLocation* loc) {
+        if (locationCount >= vertexCapacity) {
+            int newCapacity = vertexCapacity * 2;
+            CityLocation** newVertices = new CityLocation * [newCapacity];
+            for (int i = 0; i < locationCount; i++) {
+                newVertices[i] = vertices[i];
+            }
+            delete[] vertices;
+            vertices = newVertices;
+
+            int* newParent = new int[newCapacity];
+            int* newSize = new int[newCapacity];
+            for (int i = 0; i < locationCount; i++) {
+                newParent[i] = componentParent[i];
+                newSize[i] = componentSize[i];
+            }
+            delete[] componentParent;
+            delete[] componentSize;
+            componentParent = newParent;
+            componentSize = newSize;
+            vertexCapacity = newCapacity;
+        }
+        loc->index = locationCount;
+        vertices[locationCount] = loc;
+    }
+
+    // Keep indices dense: move the last vertex into the freed slot
+    void releaseVertex(CityLocation* loc) {
+        int idx = loc->index;
+        int last = locationCount - 1;
+        if (idx >= 0 && idx < last) {
+            vertices[idx] = vertices[last];
+            vertices[idx]->index = idx;
+        }
+        loc->index = -1;
+    }
+
+    void markGraphChanged() {
+        csrDirty = true;
+        graphVersion++;
+    }
+
+    // CONNECTED COMPONENTS (UNION-FIND)
+
+    // Root of v's component (path halving)
+    int findComponent(int v) {
+        while (componentParent[v] != v) {
+            componentParent[v] = componentParent[componentParent[v]];
+            v = componentParent[v];
+        }
+        return v;
+    }
+
+    // Union by size
+    void uniteComponents(int a, int b) {
+        a = findComponent(a);
+        b = findComponent(b);
+        if (a == b) return;
+        if (componentSize[a] < componentSize[b]) {
+            int temp = a;
+            a = b;
+            b = temp;
+        }
+        componentParent[b] = a;
+        componentSize[a] += componentSize[b];
+        componentCount--;
+    }
+
+    // Recompute the labels if a road or location was removed since the last query
+    void ensureComponents() {
+        if (!componentsDirty) return;
+        for (int v = 0; v < locationCount; v++) {
+            componentParent[v] = v;
+            componentSize[v] = 1;
+        }
+        componentCount = locationCount;
+        for (int v = 0; v < locationCount; v++) {
+            CityRoad* road = (vertices[v]->adj != nullptr) ? vertices[v]->adj->roadHead : nullptr;
+            for (; road != nullptr; road = road->next) {
+                if (road->destLoc != nullptr) uniteComponents(v, road->destLoc->index);
+            }
+        }
+        componentsDirty = false;
+    }
+
+    void freeLandmarks() {
+        delete[] landmarks;
+        delete[] landmarkDist;
+        landmarks = nullptr;
+        landmarkDist = nullptr;
+        landmarkCount = 0;
+    }
+
+    void freeCompactGraph() {
+        delete[] csrOffsets;
+        delete[] csrTargets;
+        delete[] csrWeights;
+        delete[] csrTraffic;
+        csrOffsets = nullptr;
+        csrTargets = nullptr;
+        csrWeights = nullptr;
+        csrTraffic = nullptr;
+        csrEdgeCount = 0;
+    }
+
+    // Get adjacency node
+    CityAdjNode* getAdjNode(const string& id) {
+        CityLocation* loc = findLocationByID(id);
+        return (loc != nullptr) ? loc->adj : nullptr;
     }
 
     // Get or create adjacency node
@@ -173,10 +722,32 @@ private:
 
         CityAdjNode* newNode = new CityAdjNode(id);
         newNode->next = adjListHead;
+        if (adjListHead != nullptr) adjListHead->prev = newNode;
         adjListHead = newNode;
+
+        CityLocation* loc = findLocationByID(id);
+        if (loc != nullptr) loc->adj = newNode;
         return newNode;
     }
 
+    // Unlink the first road from adj to destID; O(degree of adj)
+    bool removeRoadFrom(CityAdjNode* adj, const string& destID) {
+        if (adj == nullptr) return false;
+
+        CityRoad* prev = nullptr;
+        CityRoad* road = adj->roadHead;
+        while (road != nullptr && !stringsEqualIgnoreCase(road->destID, destID)) {
+            prev = road;
+            road = road->next;
+        }
+        if (road == nullptr) return false;
+
+        if (prev == nullptr) adj->roadHead = road->next;
+        else prev->next = road->next;
+        delete road;
+        return true;
+    }
+
     // Check if edge exists
     bool edgeExists(const string& from, const string& to) {
         CityAdjNode* adj = getAdjNode(from);
@@ -250,89 +821,98 @@ public:
 
         CityLocation* newLoc = new CityLocation(id, name, type, lat, lon, entityPtr);
         newLoc->next = locationsHead;
+        if (locationsHead != nullptr) locationsHead->prev = newLoc;
         locationsHead = newLoc;
+        addToIDTable(newLoc);
+        appendVertex(newLoc);
+        gridForType(type)->insert(lat, lon, newLoc);
+        componentParent[newLoc->index] = newLoc->index;
+        componentSize[newLoc->index] = 1;
         locationCount++;
+        if (!componentsDirty) componentCount++;
+        for (CityShortestPathTree* tree = hotTreesHead; tree != nullptr; tree = tree->next) {
+            tree->onLocationAdded(newLoc);
+        }
 
         // Create adjacency list entry
         getOrCreateAdjNode(id);
+        markGraphChanged();
 
         return true;
     }
 
+    // Every road is stored in both endpoints' lists and knows its
+    // destination, so removing a location only visits its neighbors:
+    // O(degree) instead of a pass over every adjacency list
     bool removeLocation(const string& id) {
-        if (locationsHead == nullptr) return false;
+        CityLocation* loc = findLocationByID(id);
+        if (loc == nullptr) return false;
 
-        // Remove all edges TO this location
-        CityAdjNode* adj = adjListHead;
-        while (adj != nullptr) {
-            removeRoad(adj->locationID, id);
-            adj = adj->next;
+        // Remove this location's adjacency list and the roads back to it
+        removeAdjNode(id);
+
+        // The last vertex takes over this one's index
+        CityLocation* moved = (loc->index < locationCount - 1) ? vertices[locationCount - 1] : nullptr;
+        for (CityShortestPathTree* tree = hotTreesHead; tree != nullptr; tree = tree->next) {
+            tree->onLocationRemoved(loc, moved);
         }
 
-        // Remove this location's adjacency list
-        removeAdjNode(id);
+        // Remove from ID index and dense vertex array
+        removeFromIDTable(id);
+        releaseVertex(loc);
+        gridForType(loc->type)->remove(loc->lat, loc->lon, loc);
+        componentsDirty = true;
+        markGraphChanged();
 
         // Remove from locations list
-        if (stringsEqualIgnoreCase(locationsHead->id, id)) {
-            CityLocation* temp = locationsHead;
-            locationsHead = locationsHead->next;
-            delete temp;
-            locationCount--;
-            return true;
-        }
+        if (loc->prev != nullptr) loc->prev->next = loc->next;
+        else locationsHead = loc->next;
+        if (loc->next != nullptr) loc->next->prev = loc->prev;
 
-        CityLocation* current = locationsHead;
-        while (current->next != nullptr) {
-            if (stringsEqualIgnoreCase(current->next->id, id)) {
-                CityLocation* temp = current->next;
-                current->next = current->next->next;
-                delete temp;
-                locationCount--;
-                return true;
-            }
-            current = current->next;
-        }
-        return false;
+        delete loc;
+        locationCount--;
+        return true;
     }
 
     void removeAdjNode(const string& id) {
-        if (adjListHead == nullptr) return;
-
-        if (stringsEqualIgnoreCase(adjListHead->locationID, id)) {
-            CityAdjNode* temp = adjListHead;
-            // Delete all roads first
-            while (temp->roadHead != nullptr) {
-                CityRoad* roadTemp = temp->roadHead;
-                temp->roadHead = temp->roadHead->next;
-                delete roadTemp;
+        CityLocation* loc = findLocationByID(id);
+        if (loc == nullptr || loc->adj == nullptr) return;
+        CityAdjNode* adj = loc->adj;
+
+        // Drop the reverse copy of each road from the neighbor's list, then the road
+        while (adj->roadHead != nullptr) {
+            CityRoad* road = adj->roadHead;
+            adj->roadHead = road->next;
+
+            CityLocation* otherLoc = road->destLoc;
+            CityAdjNode* other = (otherLoc != nullptr) ? otherLoc->adj : getAdjNode(road->destID);
+            if (other != nullptr && other != adj) {
+                removeRoadFrom(other, id);
             }
-            adjListHead = adjListHead->next;
-            delete temp;
-            return;
-        }
+            delete road;
 
-        CityAdjNode* current = adjListHead;
-        while (current->next != nullptr) {
-            if (stringsEqualIgnoreCase(current->next->locationID, id)) {
-                CityAdjNode* temp = current->next;
-                while (temp->roadHead != nullptr) {
-                    CityRoad* roadTemp = temp->roadHead;
-                    temp->roadHead = temp->roadHead->next;
-                    delete roadTemp;
+            if (otherLoc != nullptr) {
+                for (CityShortestPathTree* tree = hotTreesHead; tree != nullptr; tree = tree->next) {
+                    tree->onRoadRemoved(loc, otherLoc);
                 }
-                current->next = current->next->next;
-                delete temp;
-                return;
             }
-            current = current->next;
+            componentsDirty = true;
         }
+
+        if (adj->prev != nullptr) adj->prev->next = adj->next;
+        else adjListHead = adj->next;
+        if (adj->next != nullptr) adj->next->prev = adj->prev;
+
+        loc->adj = nullptr;
+        delete adj;
+        markGraphChanged();
     }
 
     CityLocation* findLocationByID(const string& id) {
-        CityLocation* current = locationsHead;
+        CityIDHashNode* current = idTable[idHash(id)];
         while (current != nullptr) {
-            if (stringsEqualIgnoreCase(current->id, id)) 
-                return current;
+            if (stringsEqualIgnoreCase(current->loc->id, id)) 
+                return current->loc;
             current = current->next;
         }
         return nullptr;
@@ -369,72 +949,317 @@ public:
 
         // Add bidirectional edges
         CityAdjNode* adj1 = getOrCreateAdjNode(id1);
-        CityRoad* road1 = new CityRoad(id2, distance);
+        CityRoad* road1 = new CityRoad(id2, distance, loc2);
         road1->next = adj1->roadHead;
         adj1->roadHead = road1;
 
         CityAdjNode* adj2 = getOrCreateAdjNode(id2);
-        CityRoad* road2 = new CityRoad(id1, distance);
+        CityRoad* road2 = new CityRoad(id1, distance, loc1);
         road2->next = adj2->roadHead;
         adj2->roadHead = road2;
 
+        for (CityShortestPathTree* tree = hotTreesHead; tree != nullptr; tree = tree->next) {
+            tree->onRoadAdded(loc1, loc2, distance);
+        }
+        if (!componentsDirty) uniteComponents(loc1->index, loc2->index);
+        markGraphChanged();
         return true;
     }
 
     bool removeRoad(const string& id1, const string& id2) {
-        bool removed = false;
-
-        // Remove from id1's adjacency list
-        CityAdjNode* adj1 = getAdjNode(id1);
-        if (adj1 != nullptr && adj1->roadHead != nullptr) {
-            if (stringsEqualIgnoreCase(adj1->roadHead->destID, id2)) {
-                CityRoad* temp = adj1->roadHead;
-                adj1->roadHead = adj1->roadHead->next;
-                delete temp;
-                removed = true;
-            }
-            else {
-                CityRoad* current = adj1->roadHead;
-                while (current->next != nullptr) {
-                    if (stringsEqualIgnoreCase(current->next->destID, id2)) {
-                        CityRoad* temp = current->next;
-                        current->next = current->next->next;
-                        delete temp;
-                        removed = true;
-                        break;
-                    }
-                    current = current->next;
+        // Remove from both adjacency lists (roads are undirected)
+        bool removed = removeRoadFrom(getAdjNode(id1), id2);
+        if (removeRoadFrom(getAdjNode(id2), id1)) removed = true;
+
+        if (removed) {
+            CityLocation* loc1 = findLocationByID(id1);
+            CityLocation* loc2 = findLocationByID(id2);
+            for (CityShortestPathTree* tree = hotTreesHead; tree != nullptr; tree = tree->next) {
+                tree->onRoadRemoved(loc1, loc2);
+            }
+            componentsDirty = true;
+            markGraphChanged();
+        }
+        return removed;
+    }
+
+    // Attach a time-of-day profile to both directions of a road (nullptr
+    // = free flow). Road lengths do not change, so distance-based caches
+    // and trees stay valid; only the compact copy has to pick it up.
+    bool setRoadTraffic(const string& id1, const string& id2, const CityTrafficPattern* traffic) {
+        bool found = false;
+        for (int dir = 0; dir < 2; dir++) {
+            CityAdjNode* adj = getAdjNode(dir == 0 ? id1 : id2);
+            const string& other = (dir == 0) ? id2 : id1;
+            for (CityRoad* road = (adj != nullptr) ? adj->roadHead : nullptr; road != nullptr; road = road->next) {
+                if (stringsEqualIgnoreCase(road->destID, other)) {
+                    road->traffic = traffic;
+                    found = true;
+                    break;
                 }
             }
         }
+        if (found) csrDirty = true;
+        return found;
+    }
 
-        // Remove from id2's adjacency list undirected
-        CityAdjNode* adj2 = getAdjNode(id2);
-        if (adj2 != nullptr && adj2->roadHead != nullptr) {
-            if (stringsEqualIgnoreCase(adj2->roadHead->destID, id1)) {
-                CityRoad* temp = adj2->roadHead;
-                adj2->roadHead = adj2->roadHead->next;
-                delete temp;
-                removed = true;
-            }
-            else {
-                CityRoad* current = adj2->roadHead;
-                while (current->next != nullptr) {
-                    if (stringsEqualIgnoreCase(current->next->destID, id1)) {
-                        CityRoad* temp = current->next;
-                        current->next = current->next->next;
-                        delete temp;
-                        removed = true;
-                        break;
+    // Move a location; every road at it is re-measured as the straight line
+    // to its other end, the way the transport network measures its roads
+    bool moveLocation(const string& id, double lat, double lon) {
+        CityLocation* loc = findLocationByID(id);
+        if (loc == nullptr) return false;
+
+        gridForType(loc->type)->remove(loc->lat, loc->lon, loc);
+        loc->lat = lat;
+        loc->lon = lon;
+        gridForType(loc->type)->insert(lat, lon, loc);
+
+        for (CityRoad* road = (loc->adj != nullptr) ? loc->adj->roadHead : nullptr; road != nullptr; road = road->next) {
+            CityLocation* other = road->destLoc;
+            if (other == nullptr) continue;
+            road->distance = calculateDistance(lat, lon, other->lat, other->lon);
+            for (CityRoad* back = (other->adj != nullptr) ? other->adj->roadHead : nullptr; back != nullptr; back = back->next) {
+                if (back->destLoc == loc) {
+                    back->distance = road->distance;
+                    break;
+                }
+            }
+            // Re-settle whatever hung off the old length, then relax the new one
+            for (CityShortestPathTree* tree = hotTreesHead; tree != nullptr; tree = tree->next) {
+                tree->onRoadRemoved(loc, other);
+                tree->onRoadAdded(loc, other, road->distance);
+            }
+        }
+        markGraphChanged();
+        return true;
+    }
+
+    // Connected Components
+
+    // O(1) (amortized) test whether any road route joins two locations
+    bool areConnected(const string& id1, const string& id2) {
+        int a = getVertexIndex(id1);
+        int b = getVertexIndex(id2);
+        if (a == -1 || b == -1) return false;
+        ensureComponents();
+        return findComponent(a) == findComponent(b);
+    }
+
+    int getComponentCount() {
+        ensureComponents();
+        return componentCount;
+    }
+
+    int getLargestComponentSize() {
+        ensureComponents();
+        int largest = 0;
+        for (int v = 0; v < locationCount; v++) {
+            if (componentParent[v] == v && componentSize[v] > largest) largest = componentSize[v];
+        }
+        return largest;
+    }
+
+    // histogram[b] = number of components with 10^b .. 10^(b+1)-1 locations;
+    // the last bucket takes everything bigger
+    void getComponentSizeHistogram(int histogram[], int bucketCount) {
+        ensureComponents();
+        for (int b = 0; b < bucketCount; b++) histogram[b] = 0;
+        for (int v = 0; v < locationCount; v++) {
+            if (componentParent[v] != v) continue;
+            int b = 0;
+            for (int size = componentSize[v]; size >= 10 && b < bucketCount - 1; size /= 10) b++;
+            histogram[b]++;
+        }
+    }
+
+    long long getUnreachableRejectedCount() { return unreachableRejected; }
+
+    // Hot Sources (dynamic shortest path trees)
+
+    // Keep the road distance from every location to the nearest location of
+    // 'type' (that also passes 'filter') current through every edit.
+    // Registering an existing name returns the tree already kept under it.
+    CityShortestPathTree* registerHotSources(const string& name, int type,
+        SpatialFilter filter = nullptr, void* context = nullptr) {
+        CityShortestPathTree* existing = findHotSourceTree(name);
+        if (existing != nullptr) return existing;
+
+        CityShortestPathTree* tree = new CityShortestPathTree(name, type, filter, context);
+        tree->build(vertices, locationCount);
+        tree->next = hotTreesHead;
+        hotTreesHead = tree;
+        return tree;
+    }
+
+    // Call after changing something a hot source filter depends on
+    void refreshHotSources(const string& id) {
+        CityLocation* loc = findLocationByID(id);
+        if (loc == nullptr) return;
+        for (CityShortestPathTree* tree = hotTreesHead; tree != nullptr; tree = tree->next) {
+            tree->onSourceChanged(loc);
+        }
+    }
+
+    CityShortestPathTree* findHotSourceTree(const string& name) {
+        for (CityShortestPathTree* tree = hotTreesHead; tree != nullptr; tree = tree->next) {
+            if (stringsEqualIgnoreCase(tree->getName(), name)) return tree;
+        }
+        return nullptr;
+    }
+
+    // First tree in the list, for iterating over all of them
+    CityShortestPathTree* getHotSourceTrees() { return hotTreesHead; }
+
+    // Road distance from a location to the nearest source of a hot tree,
+    // O(1) between edits. Fills the route (location first, source last).
+    double distanceToNearestHot(const string& treeName, const string& id, string& sourceID,
+        string path[], int& pathLen, int maxPathLen) {
+        sourceID = "";
+        pathLen = 0;
+        CityShortestPathTree* tree = findHotSourceTree(treeName);
+        CityLocation* loc = findLocationByID(id);
+        if (tree == nullptr || loc == nullptr) return DBL_MAX;
+
+        CityLocation* nearest = tree->nearestSource(loc);
+        if (nearest == nullptr) return DBL_MAX;
+        sourceID = nearest->id;
+        pathLen = tree->pathToSource(loc, path, maxPathLen);
+        return tree->distanceFrom(loc);
+    }
+
+    // Compact Graph (CSR)
+
+    // Rebuild the CSR arrays from the adjacency lists if the graph changed
+    void ensureCompactGraph() {
+        if (!csrDirty && csrOffsets != nullptr) return;
+        freeCompactGraph();
+
+        // Count degrees first so every vertex gets one contiguous slice
+        csrOffsets = new int[locationCount + 1];
+        csrOffsets[0] = 0;
+        for (int v = 0; v < locationCount; v++) {
+            int degree = 0;
+            CityRoad* road = (vertices[v]->adj != nullptr) ? vertices[v]->adj->roadHead : nullptr;
+            while (road != nullptr) {
+                if (road->destLoc != nullptr) degree++;
+                road = road->next;
+            }
+            csrOffsets[v + 1] = csrOffsets[v] + degree;
+        }
+
+        csrEdgeCount = csrOffsets[locationCount];
+        csrTargets = new int[csrEdgeCount > 0 ? csrEdgeCount : 1];
+        csrWeights = new double[csrEdgeCount > 0 ? csrEdgeCount : 1];
+        csrTraffic = new const CityTrafficPattern * [csrEdgeCount > 0 ? csrEdgeCount : 1];
+
+        heuristicScale = DBL_MAX;
+        for (int v = 0; v < locationCount; v++) {
+            int pos = csrOffsets[v];
+            CityRoad* road = (vertices[v]->adj != nullptr) ? vertices[v]->adj->roadHead : nullptr;
+            while (road != nullptr) {
+                if (road->destLoc != nullptr) {
+                    csrTargets[pos] = road->destLoc->index;
+                    csrWeights[pos] = road->distance;
+                    csrTraffic[pos] = road->traffic;
+                    pos++;
+
+                    double straight = calculateDistance(vertices[v]->lat, vertices[v]->lon,
+                        road->destLoc->lat, road->destLoc->lon);
+                    if (straight > 0 && road->distance / straight < heuristicScale) {
+                        heuristicScale = road->distance / straight;
                     }
-                    current = current->next;
                 }
+                road = road->next;
             }
         }
+        if (heuristicScale == DBL_MAX) heuristicScale = 0;
+        // Tiny safety margin so rounding never makes the bound exceed a road length
+        heuristicScale *= (1.0 - 1e-9);
+        csrDirty = false;
+    }
 
-        return removed;
+    // Landmarks (ALT)
+
+    // Pick landmarks by farthest-point selection and store their distances
+    // to every vertex. Called lazily by ROUTE_ALT queries after the graph changes.
+    void rebuildLandmarks(int count = 8) {
+        ensureCompactGraph();
+        freeLandmarks();
+        landmarkVersion = graphVersion;
+        if (locationCount == 0 || count <= 0) return;
+        if (count > locationCount) count = locationCount;
+
+        landmarks = new int[count];
+        landmarkDist = new double[(long long)count * locationCount];
+
+        // Distance from each vertex to its closest landmark so far
+        double* closest = new double[locationCount];
+        for (int v = 0; v < locationCount; v++) {
+            closest[v] = DBL_MAX;
+        }
+
+        CitySearchScratch& sc = getCitySearchScratch();
+        int next = 0;
+        for (int i = 0; i < count; i++) {
+            landmarks[i] = next;
+            landmarkCount++;
+            runDijkstra(next, -1, sc);
+
+            double* row = landmarkDist + (long long)i * locationCount;
+            for (int v = 0; v < locationCount; v++) {
+                row[v] = sc.isSettled(v) ? sc.dist[v] : DBL_MAX;
+                if (row[v] < closest[v]) closest[v] = row[v];
+            }
+
+            // Next landmark: farthest from all chosen ones; unreached
+            // vertices (other components) come first
+            int farthest = -1;
+            for (int v = 0; v < locationCount; v++) {
+                if (closest[v] > 0 && (farthest == -1 || closest[v] > closest[farthest])) {
+                    farthest = v;
+                }
+            }
+            if (farthest == -1) break;
+            next = farthest;
+        }
+
+        delete[] closest;
+    }
+
+    bool landmarksAreCurrent() {
+        return landmarkCount > 0 && landmarkVersion == graphVersion;
+    }
+
+    unsigned int getGraphVersion() { return graphVersion; }
+
+    // Vertices settled by this thread's last routing query
+    int getLastSettledCount() { return getCitySearchScratch().settledCount; }
+    CityPathCache& getPathCache() { return pathCache; }
+
+    // Vertex index of a location ID, or -1 if not in the graph
+    int getVertexIndex(const string& id) {
+        CityLocation* loc = findLocationByID(id);
+        return (loc != nullptr) ? loc->index : -1;
+    }
+
+    CityLocation* getVertex(int v) {
+        if (v < 0 || v >= locationCount) return nullptr;
+        return vertices[v];
+    }
+
+    // Vertex index of a location ID if that vertex stands for 'entity', else -1
+    int getEntityVertex(const string& id, void* entity) {
+        CityLocation* loc = findLocationByID(id);
+        return (loc != nullptr && loc->entityPtr == entity) ? loc->index : -1;
     }
 
+    // Raw CSR arrays; call ensureCompactGraph() first
+    const int* getCompactOffsets() { return csrOffsets; }
+    const int* getCompactTargets() { return csrTargets; }
+    const double* getCompactWeights() { return csrWeights; }
+    const CityTrafficPattern* const* getCompactTraffic() { return csrTraffic; }
+    int getCompactEdgeCount() { return csrEdgeCount; }
+
 
     // Subgraph Extraction
     // Changed: type is now int
@@ -451,23 +1276,18 @@ public:
     }
 
 
-    // Nearest Locations Queries
-    CityLocation* findNearestOfType(double userLat, double userLon, int type) {
-        CityLocation* nearest = nullptr;
-        double minDist = DBL_MAX;
+    // Nearest Locations Queries (straight-line, answered by the spatial grids)
 
-        CityLocation* current = locationsHead;
-        while (current != nullptr) {
-            if (current->type == type) {
-                double dist = calculateDistance(userLat, userLon, current->lat, current->lon);
-                if (dist < minDist) {
-                    minDist = dist;
-                    nearest = current;
-                }
-            }
-            current = current->next;
-        }
-        return nearest;
+    // Nearest location of a type; filter (optional) can reject candidates
+    CityLocation* findNearestOfType(double userLat, double userLon, int type,
+        SpatialFilter filter = nullptr, void* context = nullptr) {
+        double dist;
+        return (CityLocation*)gridForType(type)->nearest(userLat, userLon, dist, filter, context);
+    }
+
+    CityLocation* findNearestOfType(double userLat, double userLon, int type, double& outDistance,
+        SpatialFilter filter = nullptr, void* context = nullptr) {
+        return (CityLocation*)gridForType(type)->nearest(userLat, userLon, outDistance, filter, context);
     }
 
     CityLocation* findNearestOfTypeFromLocation(const string& srcID, int destType, double& outDistance) {
@@ -475,173 +1295,516 @@ public:
         CityLocation* srcLoc = findLocationByID(srcID);
         if (srcLoc == nullptr) return nullptr;
 
-        return findNearestOfType(srcLoc->lat, srcLoc->lon, destType);
+        return findNearestOfType(srcLoc->lat, srcLoc->lon, destType, outDistance);
+    }
+
+    // Up to k locations of a type, nearest first. Returns how many were found.
+    int findKNearestOfType(double userLat, double userLon, int type, int k,
+        CityLocation* results[], double distances[]) {
+        if (k <= 0) return 0;
+        SpatialHit* hits = new SpatialHit[k];
+        int count = gridForType(type)->kNearest(userLat, userLon, k, hits);
+        for (int i = 0; i < count; i++) {
+            results[i] = (CityLocation*)hits[i].item;
+            distances[i] = hits[i].distance;
+        }
+        delete[] hits;
+        return count;
+    }
+
+    // Locations within radius (type -1 = any type), in no particular order.
+    // At most maxCount are returned.
+    int findLocationsInRadius(double userLat, double userLon, double radius, int type,
+        CityLocation* results[], double distances[], int maxCount) {
+        if (maxCount <= 0) return 0;
+        SpatialHit* hits = new SpatialHit[maxCount];
+        int count = 0;
+
+        for (int t = 0; t < LOCATION_TYPE_COUNT && count < maxCount; t++) {
+            if (type != -1 && gridForType(type) != typeGrids[t]) continue;
+            count += typeGrids[t]->withinRadius(userLat, userLon, radius, hits + count, maxCount - count);
+        }
+
+        for (int i = 0; i < count; i++) {
+            results[i] = (CityLocation*)hits[i].item;
+            distances[i] = hits[i].distance;
+        }
+        delete[] hits;
+        return count;
     }
 
 
     // Dijkstra's Algorithm
-    double findShortestPath(const string& srcID, const string& destID,
-        string path[], int& pathLen, int maxPathLen) {
-        pathLen = 0;
 
-        CityLocation* srcLoc = findLocationByID(srcID);
-        CityLocation* destLoc = findLocationByID(destID);
+    // Routing engine view of the compact graph (call ensureCompactGraph first)
+    CityCompactGraph compactView() {
+        return CityCompactGraph(csrOffsets, csrTargets, csrWeights, locationCount, csrTraffic);
+    }
 
-        if (srcLoc == nullptr || destLoc == nullptr) {
-            return DBL_MAX;
+    // Goal for runDijkstra: stop at target, or after maxFound vertices of stopType
+    struct NearestOfTypeGoal {
+        CityLocation** vertices;
+        int target;
+        int stopType;
+        int* found;
+        int maxFound;
+        int foundCount;
+
+        bool onSettle(int u) {
+            if (u == target) return true;
+            if (stopType != -1 && vertices[u]->type == stopType) {
+                found[foundCount++] = u;
+                if (foundCount >= maxFound) return true;
+            }
+            return false;
+        }
+        double lowerBound(int) { return 0; }
+    };
+
+    // Goal for findWithinDistance: records vertices in settle order and
+    // stops at the first one past the budget
+    struct WithinBudgetGoal {
+        CitySearchScratch* sc;
+        double budget;
+        CityIntList* settled;
+
+        bool onSettle(int u) {
+            if (sc->dist[u] > budget) return true;
+            settled->push(u);
+            return false;
         }
+        double lowerBound(int) { return 0; }
+    };
+
+    // Goal for runAStar: stop at dest, keys ordered by the A* / ALT bound
+    struct LowerBoundGoal {
+        CityGraph* graph;
+        int dest;
+        int mode;
+
+        bool onSettle(int u) { return u == dest; }
+        double lowerBound(int v) { return graph->lowerBound(v, dest, mode); }
+    };
+
+    // Dijkstra over the compact graph from vertex src. Stops as soon as
+    // target is settled (pass -1 to settle everything reachable), or once
+    // maxFound vertices of stopType have been settled; those are recorded
+    // in found[] nearest first and their count is returned.
+    // Distances and predecessors are left in the scratch buffers.
+    int runDijkstra(int src, int target, CitySearchScratch& sc,
+        int stopType = -1, int found[] = nullptr, int maxFound = 0) {
+        NearestOfTypeGoal goal = { vertices, target, stopType, found, maxFound, 0 };
+        cityShortestPaths(compactView(), goal, src, sc);
+        return goal.foundCount;
+    }
 
-        // Initialize arrays
-        const int MAX_LOCATIONS = 500;
-        string locIDs[MAX_LOCATIONS];
-        double distances[MAX_LOCATIONS];
-        string previous[MAX_LOCATIONS];
-        bool visited[MAX_LOCATIONS];
-        int numLocs = 0;
+    // One-to-many Dijkstra: stops once targetCount vertices flagged in
+    // isTarget[] have been settled
+    void runDijkstraToTargets(int src, CitySearchScratch& sc, const char* isTarget, int targetCount) {
+        CityUntilTargets goal(isTarget, targetCount);
+        cityShortestPaths(compactView(), goal, src, sc);
+    }
 
-        // Collect all location IDs
-        CityLocation* current = locationsHead;
-        while (current != nullptr && numLocs < MAX_LOCATIONS) {
-            locIDs[numLocs] = current->id;
-            distances[numLocs] = DBL_MAX;
-            previous[numLocs] = "";
-            visited[numLocs] = false;
-            numLocs++;
-            current = current->next;
+    // Lower bound on the road distance from v to dest (DBL_MAX = unreachable)
+    double lowerBound(int v, int dest, int mode) {
+        if (mode == ROUTE_ASTAR) {
+            return heuristicScale * calculateDistance(vertices[v]->lat, vertices[v]->lon,
+                vertices[dest]->lat, vertices[dest]->lon);
         }
 
-        // Find source index
-        int srcIdx = -1;
-        for (int i = 0; i < numLocs; i++) {
-            if (stringsEqualIgnoreCase(locIDs[i], srcID)) {
-                srcIdx = i;
-                break;
+        // ALT: triangle inequality against every landmark
+        double best = 0;
+        for (int i = 0; i < landmarkCount; i++) {
+            const double* row = landmarkDist + (long long)i * locationCount;
+            double dv = row[v];
+            double dt = row[dest];
+            if (dv == DBL_MAX || dt == DBL_MAX) {
+                if (dv != dt) return DBL_MAX;  // v and dest are in different components
+                continue;
             }
+            double diff = (dt > dv) ? dt - dv : dv - dt;
+            if (diff > best) best = diff;
         }
-        if (srcIdx == -1) return DBL_MAX;
+        return best;
+    }
 
-        distances[srcIdx] = 0;
+    // A* / ALT search from src to dest; heap keys are distance + lower bound
+    void runAStar(int src, int dest, CitySearchScratch& sc, int mode) {
+        LowerBoundGoal goal = { this, dest, mode };
+        cityShortestPaths(compactView(), goal, src, sc);
+    }
 
-        // Dijkstra's algorithm
-        CityDijkstraHeap minHeap;
-        minHeap.insert(srcID, 0);
+    // Write the src -> dest path recorded in the scratch buffers into path[]
+    int copyPath(CitySearchScratch& sc, int dest, string path[], int maxPathLen) {
+        int hops = 0;
+        for (int v = dest; v != -1; v = sc.prev[v]) hops++;
 
-        while (!minHeap.isEmpty()) {
-            CityDijkstraNode minNode = minHeap.extractMin();
-            string currentID = minNode.locationID;
+        // Walk back from dest, keeping the first maxPathLen stops from the source
+        int pos = hops - 1;
+        for (int v = dest; v != -1; v = sc.prev[v], pos--) {
+            if (pos < maxPathLen) path[pos] = vertices[v]->id;
+        }
+        return (hops < maxPathLen) ? hops : maxPathLen;
+    }
 
-            int currentIdx = -1;
-            for (int i = 0; i < numLocs; i++) {
-                if (stringsEqualIgnoreCase(locIDs[i], currentID)) {
-                    currentIdx = i;
-                    break;
-                }
-            }
+    // mode: ROUTE_DIJKSTRA, ROUTE_ASTAR or ROUTE_ALT (all return the same distance)
+    double findShortestPath(const string& srcID, const string& destID,
+        string path[], int& pathLen, int maxPathLen, int mode = ROUTE_DIJKSTRA) {
+        pathLen = 0;
 
-            if (currentIdx == -1 || visited[currentIdx]) continue;
-            visited[currentIdx] = true;
-
-            // Process neighbors
-            CityAdjNode* adj = getAdjNode(currentID);
-            if (adj != nullptr) {
-                CityRoad* road = adj->roadHead;
-                while (road != nullptr) {
-                    int neighborIdx = -1;
-                    for (int i = 0; i < numLocs; i++) {
-                        if (stringsEqualIgnoreCase(locIDs[i], road->destID)) {
-                            neighborIdx = i;
-                            break;
-                        }
-                    }
+        int src = getVertexIndex(srcID);
+        int dest = getVertexIndex(destID);
+        if (src == -1 || dest == -1) {
+            return DBL_MAX;
+        }
 
-                    if (neighborIdx != -1 && !visited[neighborIdx]) {
-                        double newDist = distances[currentIdx] + road->distance;
-                        if (newDist < distances[neighborIdx]) {
-                            distances[neighborIdx] = newDist;
-                            previous[neighborIdx] = currentID;
-                            minHeap.insert(road->destID, newDist);
-                        }
-                    }
-                    road = road->next;
-                }
-            }
+        // Different components: no search needed to know there is no route
+        ensureComponents();
+        if (findComponent(src) != findComponent(dest)) {
+            unreachableRejected++;
+            return DBL_MAX;
+        }
+
+        double cached;
+        if (pathCache.lookup(srcID, destID, mode, graphVersion, cached, path, pathLen, maxPathLen)) {
+            return cached;
         }
 
-        // Find destination index
-        int destIdx = -1;
-        for (int i = 0; i < numLocs; i++) {
-            if (stringsEqualIgnoreCase(locIDs[i], destID)) {
-                destIdx = i;
-                break;
+        ensureCompactGraph();
+        CitySearchScratch& sc = getCitySearchScratch();
+        if (mode == ROUTE_DIJKSTRA) {
+            runDijkstra(src, dest, sc);
+        }
+        else {
+            if (mode == ROUTE_ALT && !landmarksAreCurrent()) {
+                rebuildLandmarks();
             }
+            runAStar(src, dest, sc, mode);
         }
 
-        if (destIdx == -1 || distances[destIdx] == DBL_MAX) {
+        if (!sc.isSettled(dest)) {
+            pathCache.store(srcID, destID, mode, graphVersion, DBL_MAX, path, 0);
             return DBL_MAX;
         }
 
-        // Reconstruct path use temporary array as stack
-        string tempPath[MAX_LOCATIONS];
-        int tempLen = 0;
-        string currentID = destID;
+        pathLen = copyPath(sc, dest, path, maxPathLen);
 
-        while (!currentID.empty() && tempLen < MAX_LOCATIONS) {
-            tempPath[tempLen++] = currentID;
-            int idx = -1;
-            for (int i = 0; i < numLocs; i++) {
-                if (stringsEqualIgnoreCase(locIDs[i], currentID)) {
-                    idx = i;
-                    break;
-                }
-            }
-            if (idx == -1) break;
-            currentID = previous[idx];
+        // Only complete routes are cached; a truncated one would be wrong
+        // for a later caller with a bigger buffer
+        int hops = 0;
+        for (int v = dest; v != -1; v = sc.prev[v]) hops++;
+        if (hops <= maxPathLen) {
+            pathCache.store(srcID, destID, mode, graphVersion, sc.dist[dest], path, pathLen);
         }
+        return sc.dist[dest];
+    }
 
-        // Reverse path
+    // Time-dependent earliest arrival: leave srcID at departMinute (minutes
+    // since midnight) and drive the fastest route under the road traffic
+    // profiles. Returns the arrival clock time, DBL_MAX if unreachable.
+    double findEarliestArrival(const string& srcID, const string& destID, double departMinute,
+        string path[], int& pathLen, int maxPathLen) {
         pathLen = 0;
-        for (int i = tempLen - 1; i >= 0 && pathLen < maxPathLen; i--) {
-            path[pathLen++] = tempPath[i];
+
+        int src = getVertexIndex(srcID);
+        int dest = getVertexIndex(destID);
+        if (src == -1 || dest == -1) {
+            return DBL_MAX;
+        }
+
+        ensureComponents();
+        if (findComponent(src) != findComponent(dest)) {
+            unreachableRejected++;
+            return DBL_MAX;
         }
 
-        return distances[destIdx];
+        ensureCompactGraph();
+        CitySearchScratch& sc = getCitySearchScratch();
+        CityTimeDependentWeight weight = { departMinute };
+        CityUntilTarget goal(dest);
+        cityShortestPaths(compactView(), weight, goal, src, sc);
+
+        if (!sc.isSettled(dest)) return DBL_MAX;
+        pathLen = copyPath(sc, dest, path, maxPathLen);
+        return departMinute + sc.dist[dest];
     }
 
-    // Find shortest path to nearest location of a specific type
+    // Find shortest path to nearest location of a specific type.
+    // One Dijkstra that stops at the first settled vertex of destType.
     double findShortestPathToType(const string& srcID, int destType,
         string& destID, string path[], int& pathLen, int maxPathLen) {
-        double minTotalDist = DBL_MAX;
-        string bestDestID = "";
-        string bestPath[100];
-        int bestPathLen = 0;
+        destID = "";
+        pathLen = 0;
 
-        // Try all locations of the target type
-        CityLocation* current = locationsHead;
-        while (current != nullptr) {
-            if (current->type == destType) {
-                string tempPath[100];
-                int tempPathLen = 0;
-                double dist = findShortestPath(srcID, current->id, tempPath, tempPathLen, 100);
-
-                if (dist < minTotalDist) {
-                    minTotalDist = dist;
-                    bestDestID = current->id;
-                    bestPathLen = tempPathLen;
-                    for (int i = 0; i < tempPathLen && i < 100; i++) {
-                        bestPath[i] = tempPath[i];
-                    }
-                }
+        int src = getVertexIndex(srcID);
+        if (src == -1) return DBL_MAX;
+
+        ensureCompactGraph();
+        CitySearchScratch& sc = getCitySearchScratch();
+        int nearest = -1;
+        if (runDijkstra(src, -1, sc, destType, &nearest, 1) == 0) {
+            return DBL_MAX;
+        }
+
+        destID = vertices[nearest]->id;
+        pathLen = copyPath(sc, nearest, path, maxPathLen);
+        return sc.dist[nearest];
+    }
+
+    // k nearest locations of destType by road distance, nearest first.
+    // results[] must hold k entries; returns how many were found.
+    int findKNearestByRoad(const string& srcID, int destType, int k, CityRouteResult results[]) {
+        int src = getVertexIndex(srcID);
+        if (src == -1 || k <= 0) return 0;
+
+        ensureCompactGraph();
+        CitySearchScratch& sc = getCitySearchScratch();
+        int* found = new int[k];
+        int count = runDijkstra(src, -1, sc, destType, found, k);
+
+        for (int i = 0; i < count; i++) {
+            int v = found[i];
+            int hops = 0;
+            for (int p = v; p != -1; p = sc.prev[p]) hops++;
+
+            results[i].destID = vertices[v]->id;
+            results[i].distance = sc.dist[v];
+            delete[] results[i].path;
+            results[i].path = new string[hops];
+            results[i].pathLen = copyPath(sc, v, results[i].path, hops);
+        }
+
+        delete[] found;
+        return count;
+    }
+
+    // Up to k alternate routes from srcID to destID, shortest first, none
+    // visiting a location twice (Yen's k shortest paths). results[] must
+    // hold k entries; returns how many routes exist.
+    int findKShortestPaths(const string& srcID, const string& destID, int k, CityRouteResult results[]) {
+        int src = getVertexIndex(srcID);
+        int dest = getVertexIndex(destID);
+        if (src == -1 || dest == -1 || k <= 0) return 0;
+
+        ensureComponents();
+        if (findComponent(src) != findComponent(dest)) {
+            unreachableRejected++;
+            return 0;
+        }
+
+        ensureCompactGraph();
+        CityRankedPath* ranked = new CityRankedPath[k];
+        int count = cityKShortestPaths(compactView(), src, dest, k, ranked);
+
+        for (int i = 0; i < count; i++) {
+            results[i].destID = vertices[dest]->id;
+            results[i].distance = ranked[i].length;
+            delete[] results[i].path;
+            results[i].path = new string[ranked[i].count];
+            results[i].pathLen = ranked[i].count;
+            for (int j = 0; j < ranked[i].count; j++) {
+                results[i].path[j] = vertices[ranked[i].vertices[j]]->id;
             }
-            current = current->next;
         }
 
-        destID = bestDestID;
-        pathLen = 0;
-        for (int i = 0; i < bestPathLen && i < maxPathLen; i++) {
-            path[pathLen++] = bestPath[i];
+        delete[] ranked;
+        return count;
+    }
+
+
+    // Road distance from srcID to every location: dist[v] for vertex index v
+    // (see getVertex), DBL_MAX if unreachable. dist[] must hold
+    // getLocationCount() entries. SSSP_DELTA_STEPPING spreads the search
+    // over the thread pool; delta <= 0 picks the bucket width from the road
+    // lengths. Returns the number of locations reached.
+    int distancesFrom(const string& srcID, double dist[], int method = SSSP_DIJKSTRA, double delta = 0) {
+        int src = getVertexIndex(srcID);
+        if (src == -1) return 0;
+        ensureCompactGraph();
+
+        if (method == SSSP_DELTA_STEPPING) {
+            lastDeltaStats = cityDeltaStepping(compactView(), src, dist, delta);
+        }
+        else {
+            CitySearchScratch& sc = getCitySearchScratch();
+            runDijkstra(src, -1, sc);
+            for (int v = 0; v < locationCount; v++) {
+                dist[v] = sc.isSettled(v) ? sc.dist[v] : DBL_MAX;
+            }
         }
 
-        return minTotalDist;
+        int reached = 0;
+        for (int v = 0; v < locationCount; v++) {
+            if (dist[v] != DBL_MAX) reached++;
+        }
+        return reached;
+    }
+
+    // Buckets, phases and relaxations of the last delta-stepping search
+    CityDeltaStats getLastDeltaStats() { return lastDeltaStats; }
+
+    // Every location within 'budget' road distance of originID (the origin
+    // itself excluded), grouped by type and nearest first within a type.
+    // The search stops at the first location past the budget, so its cost
+    // depends on the size of the area, not of the city. Returns the count.
+    int findWithinDistance(const string& originID, double budget, CityIsochrone& result) {
+        ensureCompactGraph();
+        return boundedSearch(originID, budget, result);
+    }
+
+    // findWithinDistance for many origins at once, spread over the thread
+    // pool; results[] must hold originCount entries
+    void findWithinDistanceBatch(const string origins[], int originCount, double budget, CityIsochrone results[]) {
+        if (originCount <= 0) return;
+        ensureCompactGraph();
+
+        CityIsochroneJob job = { this, origins, budget, results };
+        CityThreadPool::getInstance()->parallelFor(originCount, withinDistanceTask, &job);
+    }
+
+    // Thread pool task: one origin of findWithinDistanceBatch
+    static void withinDistanceTask(void* arg, int index) {
+        CityIsochroneJob* job = (CityIsochroneJob*)arg;
+        job->graph->boundedSearch(job->origins[index], job->budget, job->results[index]);
+    }
+
+    // Bounded Dijkstra behind findWithinDistance; only reads the compact graph
+    int boundedSearch(const string& originID, double budget, CityIsochrone& result) {
+        result.clear();
+        result.originID = originID;
+        result.budget = budget;
+
+        int src = getVertexIndex(originID);
+        if (src == -1 || budget < 0) return 0;
+
+        static thread_local CityIntList settled;
+        settled.size = 0;
+        CitySearchScratch& sc = getCitySearchScratch();
+        WithinBudgetGoal goal = { &sc, budget, &settled };
+        cityShortestPaths(compactView(), goal, src, sc);
+
+        // Counting sort by type; settle order keeps each type nearest first
+        int found = settled.size - 1;   // Minus the origin
+        result.count = found;
+        result.ids = new string[found > 0 ? found : 1];
+        result.distances = new double[found > 0 ? found : 1];
+        for (int i = 1; i < settled.size; i++) {
+            int type = vertices[settled.items[i]]->type;
+            if (type < 0 || type >= LOCATION_TYPE_COUNT) type = LOC_OTHER;
+            result.typeStart[type + 1]++;
+        }
+        for (int t = 0; t < LOCATION_TYPE_COUNT; t++) {
+            result.typeStart[t + 1] += result.typeStart[t];
+        }
+        int next[LOCATION_TYPE_COUNT];
+        for (int t = 0; t < LOCATION_TYPE_COUNT; t++) next[t] = result.typeStart[t];
+        for (int i = 1; i < settled.size; i++) {
+            int v = settled.items[i];
+            int type = vertices[v]->type;
+            if (type < 0 || type >= LOCATION_TYPE_COUNT) type = LOC_OTHER;
+            result.ids[next[type]] = vertices[v]->id;
+            result.distances[next[type]] = sc.dist[v];
+            next[type]++;
+        }
+        return found;
+    }
+
+    // Thread pool task: fills row 'row' of the matrix with one search
+    static void distanceMatrixRow(void* arg, int row) {
+        CityMatrixJob* job = (CityMatrixJob*)arg;
+        CityGraph* graph = job->graph;
+        CityDistanceMatrix* result = job->result;
+        double* rowDist = result->distances + (long long)row * job->targetCount;
+
+        // Only targets in the source's component can ever be settled
+        int src = job->sourceVertex[row];
+        int reachable = 0;
+        if (src != -1) {
+            for (int i = 0; i < job->distinctTargets; i++) {
+                if (job->distinctComponent[i] == job->sourceComponent[row]) reachable++;
+            }
+        }
+        if (reachable == 0) {
+            for (int c = 0; c < job->targetCount; c++) rowDist[c] = DBL_MAX;
+            return;
+        }
+
+        CitySearchScratch& sc = getCitySearchScratch();
+        graph->runDijkstraToTargets(src, sc, job->isTarget, reachable);
+
+        for (int c = 0; c < job->targetCount; c++) {
+            int t = job->targetVertex[c];
+            rowDist[c] = (t != -1 && sc.isSettled(t)) ? sc.dist[t] : DBL_MAX;
+
+            if (job->withPaths && rowDist[c] != DBL_MAX) {
+                CityRouteResult& route = result->routes[(long long)row * job->targetCount + c];
+                int hops = 0;
+                for (int p = t; p != -1; p = sc.prev[p]) hops++;
+
+                route.destID = graph->vertices[t]->id;
+                route.distance = rowDist[c];
+                route.path = new string[hops];
+                route.pathLen = graph->copyPath(sc, t, route.path, hops);
+            }
+        }
+    }
+
+    // Road distance from every source to every target, one one-to-many
+    // search per source spread over the thread pool. Unknown IDs and
+    // unreachable pairs get DBL_MAX. With withPaths, result.routes holds
+    // the route of every reachable pair as well.
+    void distanceMatrix(const string sources[], int sourceCount, const string targets[], int targetCount,
+        CityDistanceMatrix& result, bool withPaths = false) {
+        result.clear();
+        if (sourceCount <= 0 || targetCount <= 0) return;
+
+        // The searches only read the compact graph and component labels,
+        // so bring both up to date first
+        ensureCompactGraph();
+        ensureComponents();
+
+        result.rows = sourceCount;
+        result.cols = targetCount;
+        result.distances = new double[(long long)sourceCount * targetCount];
+        if (withPaths) {
+            result.routes = new CityRouteResult[(long long)sourceCount * targetCount];
+        }
+
+        CityMatrixJob job;
+        job.graph = this;
+        job.sourceVertex = new int[sourceCount];
+        job.targetVertex = new int[targetCount];
+        job.targetCount = targetCount;
+        job.isTarget = new char[locationCount > 0 ? locationCount : 1];
+        job.distinctTargets = 0;
+        job.sourceComponent = new int[sourceCount];
+        job.distinctComponent = new int[targetCount];
+        job.result = &result;
+        job.withPaths = withPaths;
+
+        for (int v = 0; v < locationCount; v++) {
+            job.isTarget[v] = 0;
+        }
+        for (int i = 0; i < sourceCount; i++) {
+            job.sourceVertex[i] = getVertexIndex(sources[i]);
+            job.sourceComponent[i] = (job.sourceVertex[i] != -1) ? findComponent(job.sourceVertex[i]) : -1;
+        }
+        for (int i = 0; i < targetCount; i++) {
+            int t = getVertexIndex(targets[i]);
+            job.targetVertex[i] = t;
+            if (t != -1 && !job.isTarget[t]) {
+                job.isTarget[t] = 1;
+                job.distinctComponent[job.distinctTargets++] = findComponent(t);
+            }
+        }
+
+        CityThreadPool::getInstance()->parallelFor(sourceCount, distanceMatrixRow, &job);
+
+        delete[] job.sourceVertex;
+        delete[] job.targetVertex;
+        delete[] job.isTarget;
+        delete[] job.sourceComponent;
+        delete[] job.distinctComponent;
     }
 
 
@@ -698,16 +1861,124 @@ public:
 
     int getLocationCount() { return locationCount; }
 
-    // Destructor
-    ~CityGraph() {
-        // Clean up locations
+    // SNAPSHOT
+
+    // GRAPH section: every vertex in index order, then each vertex's road
+    // list (in list order) as flat arrays that are read in place
+    void writeSnapshot(CitySnapshotWriter& out) {
+        out.beginSection("GRAPH");
+        out.putInt(locationCount);
+        for (int v = 0; v < locationCount; v++) {
+            CityLocation* loc = vertices[v];
+            out.putString(loc->id);
+            out.putString(loc->name);
+            out.putInt(loc->type);
+            out.putDouble(loc->lat);
+            out.putDouble(loc->lon);
+        }
+
+        int* degree = new int[locationCount > 0 ? locationCount : 1];
+        int roadCount = 0;
+        for (int v = 0; v < locationCount; v++) {
+            degree[v] = 0;
+            CityRoad* road = (vertices[v]->adj != nullptr) ? vertices[v]->adj->roadHead : nullptr;
+            for (; road != nullptr; road = road->next) {
+                if (road->destLoc != nullptr) degree[v]++;
+            }
+            roadCount += degree[v];
+        }
+
+        int* targets = new int[roadCount > 0 ? roadCount : 1];
+        double* lengths = new double[roadCount > 0 ? roadCount : 1];
+        int* traffic = new int[roadCount > 0 ? roadCount : 1];
+        int e = 0;
+        for (int v = 0; v < locationCount; v++) {
+            CityRoad* road = (vertices[v]->adj != nullptr) ? vertices[v]->adj->roadHead : nullptr;
+            for (; road != nullptr; road = road->next) {
+                if (road->destLoc == nullptr) continue;
+                targets[e] = road->destLoc->index;
+                lengths[e] = road->distance;
+                traffic[e] = (road->traffic != nullptr) ? road->traffic->id : -1;
+                e++;
+            }
+        }
+
+        out.putInt(roadCount);
+        out.putArray(degree, sizeof(int) * locationCount);
+        out.putArray(targets, sizeof(int) * roadCount);
+        out.putArray(lengths, sizeof(double) * roadCount);
+        out.putArray(traffic, sizeof(int) * roadCount);
+        out.endSection();
+
+        delete[] degree;
+        delete[] targets;
+        delete[] lengths;
+        delete[] traffic;
+    }
+
+    // First restore step: size the vertex links before the modules
+    // restore the objects behind the vertices
+    bool beginSnapshotRestore(CitySnapshotReader& in, CitySnapshotLinks& links) {
+        if (locationCount != 0 || !in.beginSection("GRAPH")) return false;
+        links.vertexCount = in.getCount();
+        links.vertexEntity = new void* [links.vertexCount > 0 ? links.vertexCount : 1];
+        for (int v = 0; v < links.vertexCount; v++) links.vertexEntity[v] = nullptr;
+        return !in.hasFailed();
+    }
+
+    // Last restore step: vertices get their original indices (so the route
+    // hierarchy cache still matches) and every road list its original order
+    bool readSnapshot(CitySnapshotReader& in, CitySnapshotLinks& links) {
+        if (locationCount != 0 || !in.beginSection("GRAPH")) return false;
+        int count = in.getCount();
+        for (int v = 0; v < count && !in.hasFailed(); v++) {
+            string id = in.getString();
+            string name = in.getString();
+            int type = in.getInt();
+            double lat = in.getDouble();
+            double lon = in.getDouble();
+            if (!addLocation(id, name, type, lat, lon, links.entity(v))) return false;
+        }
+
+        int roadCount = in.getCount();
+        const int* degree = (const int*)in.getArray(sizeof(int) * count);
+        const int* targets = (const int*)in.getArray(sizeof(int) * roadCount);
+        const double* lengths = (const double*)in.getArray(sizeof(double) * roadCount);
+        const int* traffic = (const int*)in.getArray(sizeof(int) * roadCount);
+        if (in.hasFailed()) return false;
+
+        int e = 0;
+        for (int v = 0; v < count; v++) {
+            CityRoad* tail = nullptr;
+            for (int i = 0; i < degree[v]; i++, e++) {
+                if (e >= roadCount || targets[e] < 0 || targets[e] >= count) return false;
+                CityLocation* dest = vertices[targets[e]];
+                CityRoad* road = new CityRoad(dest->id, lengths[e], dest);
+                road->traffic = links.pattern(traffic[e]);
+                if (tail == nullptr) vertices[v]->adj->roadHead = road;
+                else tail->next = road;
+                tail = road;
+            }
+        }
+        // Degrees must account for every road record
+        if (e != roadCount) return false;
+
+        componentsDirty = true;
+        for (CityShortestPathTree* tree = hotTreesHead; tree != nullptr; tree = tree->next) {
+            tree->build(vertices, locationCount);
+        }
+        markGraphChanged();
+        return true;
+    }
+
+    // Removes all locations and roads
+    void reset() {
         while (locationsHead != nullptr) {
             CityLocation* temp = locationsHead;
             locationsHead = locationsHead->next;
             delete temp;
         }
 
-        // Clean up adjacency list
         while (adjListHead != nullptr) {
             CityAdjNode* adjTemp = adjListHead;
             adjListHead = adjListHead->next;
@@ -718,6 +1989,46 @@ public:
             }
             delete adjTemp;
         }
+
+        for (int i = 0; i < idTableSize; i++) {
+            while (idTable[i] != nullptr) {
+                CityIDHashNode* temp = idTable[i];
+                idTable[i] = idTable[i]->next;
+                delete temp;
+            }
+        }
+
+        for (int t = 0; t < LOCATION_TYPE_COUNT; t++) {
+            typeGrids[t]->clear();
+        }
+        pathCache.clear();
+
+        locationCount = 0;
+        componentCount = 0;
+        componentsDirty = false;
+        freeCompactGraph();
+        freeLandmarks();
+        for (CityShortestPathTree* tree = hotTreesHead; tree != nullptr; tree = tree->next) {
+            tree->build(vertices, 0);
+        }
+        markGraphChanged();
+    }
+
+    // Destructor
+    ~CityGraph() {
+        reset();
+        while (hotTreesHead != nullptr) {
+            CityShortestPathTree* temp = hotTreesHead;
+            hotTreesHead = hotTreesHead->next;
+            delete temp;
+        }
+        delete[] idTable;
+        delete[] vertices;
+        delete[] componentParent;
+        delete[] componentSize;
+        for (int t = 0; t < LOCATION_TYPE_COUNT; t++) {
+            delete typeGrids[t];
+        }
     }
 };
 
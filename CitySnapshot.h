@@ -0,0 +1,508 @@
+#pragma once
+#include "Utils.h"
+#include "TrafficProfile.h"
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <sys/stat.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// BINARY CITY SNAPSHOT
+// The whole city state (locations, graph, every module) in one binary file
+// that is memory-mapped on startup instead of re-parsing the CSVs. Layout:
+//
+//   header     magic "CITYSNAP", format version, byte order mark,
+//              section count, directory offset, file size, checksum,
+//              size and modification time of every source CSV file
+//   sections   one per module, each starting on an 8-byte boundary
+//   directory  tag + offset + length of every section
+//
+// Inside a section, values are stored in host byte order: ints, doubles,
+// and strings as a length followed by the bytes. Arrays are 8-byte aligned
+// so they can be used in place straight from the mapping. Structures made
+// of pointers (linked lists, trees, hash chains) are rebuilt from the
+// records, but without text parsing, duplicate scans or coordinate checks:
+// the snapshot was taken from a state that already passed them.
+//
+// Bump CITY_SNAPSHOT_VERSION whenever a section's record layout changes;
+// older files are then rejected and the CSV import is used instead. So is
+// a snapshot whose CSV files were edited, added or deleted since it was
+// saved.
+
+const string CITY_SNAPSHOT_FILE = "city_state.snap";
+const unsigned int CITY_SNAPSHOT_VERSION = 2;
+const unsigned int CITY_SNAPSHOT_BYTE_ORDER = 0x01020304;
+const int SNAPSHOT_MAX_SECTIONS = 16;
+const int SNAPSHOT_TAG_LENGTH = 8;
+const size_t SNAPSHOT_BUFFER_SIZE = 1 << 20;
+
+// The files the CSV import reads
+const char* const CITY_SOURCE_FILES[] = {
+    "stops.csv", "busstops.csv", "roads.csv", "traffic.csv", "buses.csv",
+    "hospitals.csv", "pharmacies.csv", "schools.csv", "malls.csv", "products.csv",
+    "facilities.csv", "population.csv"
+};
+const int CITY_SOURCE_FILE_COUNT = 12;
+
+// Size and modification time of a source file; size -1 if it is missing
+struct CitySourceStamp {
+    long long size;
+    long long modified;
+};
+
+CitySourceStamp citySourceStamp(const char* filename) {
+    CitySourceStamp stamp;
+    struct stat info;
+    if (stat(filename, &info) != 0) {
+        stamp.size = -1;
+        stamp.modified = 0;
+    }
+    else {
+        stamp.size = (long long)info.st_size;
+        stamp.modified = (long long)info.st_mtime;
+    }
+    return stamp;
+}
+
+struct CitySnapshotHeader {
+    char magic[8];
+    unsigned int version;
+    unsigned int byteOrder;
+    unsigned int sectionCount;
+    unsigned int reserved;
+    unsigned long long directoryOffset;
+    unsigned long long fileSize;
+    unsigned long long checksum;    // Over everything after the header
+    CitySourceStamp sources[CITY_SOURCE_FILE_COUNT];   // As of the save, by CITY_SOURCE_FILES
+};
+
+struct CitySnapshotSection {
+    char tag[SNAPSHOT_TAG_LENGTH];
+    unsigned long long offset;
+    unsigned long long length;
+};
+
+// Checksum of a byte range, 8 bytes at a time (a truncated or corrupted
+// file must be rejected before any module state is touched)
+unsigned long long snapshotChecksum(const char* data, size_t length, unsigned long long h = 1469598103934665603ULL) {
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        unsigned long long word;
+        memcpy(&word, data + i, 8);
+        h = (h ^ word) * 1099511628211ULL;
+        h ^= h >> 29;
+    }
+    for (; i < length; i++) {
+        h = (h ^ (unsigned char)data[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+// Cross-references while a snapshot is restored: modules restore their
+// objects first and record which graph vertex each one belongs to, then
+// the graph section re-creates the vertices in their original order
+struct CitySnapshotLinks {
+    void** vertexEntity;
+    int vertexCount;
+    const CityTrafficPattern** traffic;     // Patterns by their id in the file
+    int trafficCount;
+
+    CitySnapshotLinks() : vertexEntity(nullptr), vertexCount(0), traffic(nullptr), trafficCount(0) {}
+    ~CitySnapshotLinks() {
+        delete[] vertexEntity;
+        delete[] traffic;
+    }
+
+    void setEntity(int vertex, void* entity) {
+        if (vertex >= 0 && vertex < vertexCount) vertexEntity[vertex] = entity;
+    }
+
+    void* entity(int vertex) {
+        return (vertex >= 0 && vertex < vertexCount) ? vertexEntity[vertex] : nullptr;
+    }
+
+    const CityTrafficPattern* pattern(int id) {
+        return (id >= 0 && id < trafficCount) ? traffic[id] : nullptr;
+    }
+};
+
+// Streams a snapshot to disk. Everything goes to a temporary file that
+// replaces the old snapshot only once it is complete, so a crash while
+// saving never leaves a half-written snapshot behind.
+class CitySnapshotWriter {
+private:
+    ofstream file;
+    string filename;
+    string tempName;
+    char* buffer;
+    size_t used;
+    unsigned long long position;
+    unsigned long long checksum;
+    bool failed;
+
+    CitySnapshotSection sections[SNAPSHOT_MAX_SECTIONS];
+    int sectionCount;
+
+    void flush() {
+        if (used == 0) return;
+        checksum = snapshotChecksum(buffer, used, checksum);
+        file.write(buffer, used);
+        if (!file) failed = true;
+        used = 0;
+    }
+
+    void putRaw(const void* data, size_t bytes) {
+        const char* p = (const char*)data;
+        while (bytes > 0) {
+            if (used == SNAPSHOT_BUFFER_SIZE) flush();
+            size_t chunk = SNAPSHOT_BUFFER_SIZE - used;
+            if (chunk > bytes) chunk = bytes;
+            memcpy(buffer + used, p, chunk);
+            used += chunk;
+            position += chunk;
+            p += chunk;
+            bytes -= chunk;
+        }
+    }
+
+    void align() {
+        static const char zeros[8] = { 0 };
+        if (position % 8 != 0) putRaw(zeros, (size_t)(8 - position % 8));
+    }
+
+public:
+    CitySnapshotWriter() : buffer(nullptr), used(0), position(0), checksum(0), failed(false), sectionCount(0) {}
+
+    ~CitySnapshotWriter() {
+        delete[] buffer;
+        if (file.is_open()) {
+            file.close();
+            remove(tempName.c_str());
+        }
+    }
+
+    bool open(const string& name = CITY_SNAPSHOT_FILE) {
+        filename = name;
+        tempName = name + ".tmp";
+        file.open(tempName.c_str(), ios::binary | ios::trunc);
+        if (!file.is_open()) return false;
+
+        buffer = new char[SNAPSHOT_BUFFER_SIZE];
+        CitySnapshotHeader header;
+        memset(&header, 0, sizeof(header));
+        file.write((const char*)&header, sizeof(header));   // Rewritten by finish()
+        position = sizeof(header);
+        checksum = 1469598103934665603ULL;
+        return true;
+    }
+
+    void beginSection(const char* tag) {
+        if (sectionCount == SNAPSHOT_MAX_SECTIONS) {
+            failed = true;
+            return;
+        }
+        align();
+        CitySnapshotSection& section = sections[sectionCount];
+        memset(section.tag, 0, SNAPSHOT_TAG_LENGTH);
+        strncpy(section.tag, tag, SNAPSHOT_TAG_LENGTH);
+        section.offset = position;
+        section.length = 0;
+    }
+
+    void endSection() {
+        if (sectionCount == SNAPSHOT_MAX_SECTIONS) return;
+        sections[sectionCount].length = position - sections[sectionCount].offset;
+        sectionCount++;
+    }
+
+    void putInt(int value) { putRaw(&value, sizeof(value)); }
+    void putLong(long long value) { putRaw(&value, sizeof(value)); }
+    void putDouble(double value) { putRaw(&value, sizeof(value)); }
+    void putBool(bool value) {
+        unsigned char b = value ? 1 : 0;
+        putRaw(&b, 1);
+    }
+    void putString(const string& value) {
+        putInt((int)value.length());
+        putRaw(value.data(), value.length());
+    }
+
+    // Raw array, 8-byte aligned so the reader can use it in place
+    void putArray(const void* data, size_t bytes) {
+        align();
+        putRaw(data, bytes);
+    }
+
+    // Write the directory and header, then move the file into place
+    bool finish() {
+        align();
+        unsigned long long directoryOffset = position;
+        putRaw(sections, sizeof(CitySnapshotSection) * sectionCount);
+        flush();
+
+        CitySnapshotHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, "CITYSNAP", 8);
+        header.version = CITY_SNAPSHOT_VERSION;
+        header.byteOrder = CITY_SNAPSHOT_BYTE_ORDER;
+        header.sectionCount = sectionCount;
+        header.directoryOffset = directoryOffset;
+        header.fileSize = position;
+        header.checksum = checksum;
+        for (int i = 0; i < CITY_SOURCE_FILE_COUNT; i++) {
+            header.sources[i] = citySourceStamp(CITY_SOURCE_FILES[i]);
+        }
+        file.seekp(0);
+        file.write((const char*)&header, sizeof(header));
+        file.close();
+        if (failed || !file) {
+            remove(tempName.c_str());
+            return false;
+        }
+
+        // rename() does not replace an existing file on every platform
+        remove(filename.c_str());
+        return rename(tempName.c_str(), filename.c_str()) == 0;
+    }
+
+    unsigned long long getSize() { return position; }
+};
+
+// Maps a snapshot read-only and hands out its values. Every read is
+// bounds-checked against the current section; a failed read returns an
+// empty value and latches failed().
+class CitySnapshotReader {
+private:
+    const char* base;
+    size_t size;
+#ifdef _WIN32
+    char* ownedData;
+#else
+    int fd;
+#endif
+    const CitySnapshotHeader* header;
+    const CitySnapshotSection* sections;
+    const char* cursor;
+    const char* sectionEnd;
+    bool failed;
+    string error;
+
+    bool take(void* out, size_t bytes) {
+        if (failed || (size_t)(sectionEnd - cursor) < bytes) {
+            failed = true;
+            memset(out, 0, bytes);
+            return false;
+        }
+        memcpy(out, cursor, bytes);
+        cursor += bytes;
+        return true;
+    }
+
+    bool mapFile(const string& filename) {
+#ifdef _WIN32
+        // No mmap here: one read into memory, then the same code path
+        ifstream file(filename.c_str(), ios::binary | ios::ate);
+        if (!file.is_open()) return false;
+        size = (size_t)file.tellg();
+        ownedData = new char[size > 0 ? size : 1];
+        file.seekg(0);
+        file.read(ownedData, size);
+        if (!file) return false;
+        base = ownedData;
+        return true;
+#else
+        fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0) return false;
+        size = (size_t)info.st_size;
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) return false;
+        madvise(mapping, size, MADV_SEQUENTIAL);
+        base = (const char*)mapping;
+        return true;
+#endif
+    }
+
+public:
+    CitySnapshotReader() : base(nullptr), size(0),
+#ifdef _WIN32
+        ownedData(nullptr),
+#else
+        fd(-1),
+#endif
+        header(nullptr), sections(nullptr), cursor(nullptr), sectionEnd(nullptr), failed(false) {
+    }
+
+    ~CitySnapshotReader() { close(); }
+
+    // Map and validate the file; on false, getError() says why
+    bool open(const string& filename = CITY_SNAPSHOT_FILE) {
+        close();
+        if (!mapFile(filename)) {
+            error = "cannot read " + filename;
+            close();
+            return false;
+        }
+        if (size < sizeof(CitySnapshotHeader)) {
+            error = "file too short";
+            close();
+            return false;
+        }
+
+        header = (const CitySnapshotHeader*)base;
+        if (memcmp(header->magic, "CITYSNAP", 8) != 0) error = "not a city snapshot";
+        else if (header->byteOrder != CITY_SNAPSHOT_BYTE_ORDER) error = "written on a machine with another byte order";
+        else if (header->version != CITY_SNAPSHOT_VERSION) {
+            error = "format version " + intToString((int)header->version) + ", this build reads version " +
+                intToString((int)CITY_SNAPSHOT_VERSION);
+        }
+        else if (header->fileSize != size) error = "file is truncated";
+        else if (header->sectionCount > (unsigned int)SNAPSHOT_MAX_SECTIONS ||
+            header->directoryOffset < sizeof(CitySnapshotHeader) || header->directoryOffset > size ||
+            header->directoryOffset % 8 != 0 ||
+            header->sectionCount * sizeof(CitySnapshotSection) > size - header->directoryOffset) {
+            // The checksum does not cover the header, so its offsets are
+            // checked without any sum that could wrap around
+            error = "damaged section directory";
+        }
+        else if (snapshotChecksum(base + sizeof(CitySnapshotHeader), size - sizeof(CitySnapshotHeader)) != header->checksum) {
+            error = "checksum mismatch";
+        }
+        for (int i = 0; i < CITY_SOURCE_FILE_COUNT && error.empty(); i++) {
+            CitySourceStamp now = citySourceStamp(CITY_SOURCE_FILES[i]);
+            if (now.size != header->sources[i].size || now.modified != header->sources[i].modified) {
+                error = string(CITY_SOURCE_FILES[i]) + " changed since the snapshot was saved";
+            }
+        }
+        if (!error.empty()) {
+            close();
+            return false;
+        }
+
+        sections = (const CitySnapshotSection*)(base + header->directoryOffset);
+        for (unsigned int i = 0; i < header->sectionCount; i++) {
+            if (sections[i].offset > size || sections[i].offset % 8 != 0 ||
+                sections[i].length > size - sections[i].offset) {
+                error = "damaged section directory";
+                close();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        delete[] ownedData;
+        ownedData = nullptr;
+#else
+        if (base != nullptr) munmap((void*)base, size);
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+#endif
+        base = nullptr;
+        header = nullptr;
+        sections = nullptr;
+        cursor = sectionEnd = nullptr;
+        size = 0;
+    }
+
+    bool hasSection(const char* tag) {
+        if (header == nullptr) return false;
+        for (unsigned int i = 0; i < header->sectionCount; i++) {
+            if (strncmp(sections[i].tag, tag, SNAPSHOT_TAG_LENGTH) == 0) return true;
+        }
+        return false;
+    }
+
+    // Position at the start of a section; false if the file has none
+    bool beginSection(const char* tag) {
+        failed = false;
+        if (header == nullptr) return false;
+        for (unsigned int i = 0; i < header->sectionCount; i++) {
+            if (strncmp(sections[i].tag, tag, SNAPSHOT_TAG_LENGTH) == 0) {
+                cursor = base + sections[i].offset;
+                sectionEnd = cursor + sections[i].length;
+                return true;
+            }
+        }
+        error = string("missing section ") + tag;
+        return false;
+    }
+
+    int getInt() { int v; take(&v, sizeof(v)); return v; }
+    long long getLong() { long long v; take(&v, sizeof(v)); return v; }
+    double getDouble() { double v; take(&v, sizeof(v)); return v; }
+    bool getBool() { unsigned char b; take(&b, 1); return b != 0; }
+
+    string getString() {
+        int length = getInt();
+        if (failed || length < 0 || (size_t)(sectionEnd - cursor) < (size_t)length) {
+            failed = true;
+            return "";
+        }
+        string value(cursor, (size_t)length);
+        cursor += length;
+        return value;
+    }
+
+    // Element count of a following list; anything that could not fit in
+    // the rest of the section (at least one byte per element) is damage
+    int getCount() {
+        int count = getInt();
+        if (count < 0 || (size_t)count > (size_t)(sectionEnd - cursor)) {
+            failed = true;
+            return 0;
+        }
+        return count;
+    }
+
+    // Pointer into the mapping for an array written with putArray
+    const void* getArray(size_t bytes) {
+        size_t offset = (size_t)(cursor - base);
+        if (offset % 8 != 0) cursor += 8 - offset % 8;
+        if (failed || cursor > sectionEnd || (size_t)(sectionEnd - cursor) < bytes) {
+            failed = true;
+            return nullptr;
+        }
+        const void* data = cursor;
+        cursor += bytes;
+        return data;
+    }
+
+    bool hasFailed() { return failed; }
+    const string& getError() { return error; }
+    size_t getSize() { return size; }
+};
+
+// TRAFFIC section: every interned profile, referenced elsewhere by its id
+void writeTrafficSnapshot(CitySnapshotWriter& out) {
+    CityTrafficTable* table = CityTrafficTable::getInstance();
+    out.beginSection("TRAFFIC");
+    out.putInt(table->getPatternCount());
+    for (int i = 0; i < table->getPatternCount(); i++) {
+        out.putString(table->getPattern(i)->key);
+    }
+    out.endSection();
+}
+
+bool readTrafficSnapshot(CitySnapshotReader& in, CitySnapshotLinks& links) {
+    if (!in.beginSection("TRAFFIC")) return false;
+    int count = in.getCount();
+    links.traffic = new const CityTrafficPattern * [count > 0 ? count : 1];
+    links.trafficCount = count;
+    for (int i = 0; i < count; i++) {
+        links.traffic[i] = CityTrafficTable::getInstance()->internProfile(in.getString());
+    }
+    return !in.hasFailed();
+}
@@ -3,6 +3,7 @@
 #include "Utils.h"
 #include "GlobalLocationManager.h"
 #include "CityGraph.h"
+#include "PathCache.h"
 
 
 struct ProductNode {
@@ -31,12 +32,15 @@ struct ProductHashNode {
 };
 
 
+struct MallAdjNode;
+
 struct MallEdge {
     string destMallID;
     double distance;
+    MallAdjNode* destAdj;   // Destination's adjacency list, to reach the reverse edge
     MallEdge* next;
 
-    MallEdge(const string& dest, double dist) : destMallID(dest), distance(dist), next(nullptr) {}
+    MallEdge(const string& dest, double dist) : destMallID(dest), distance(dist), destAdj(nullptr), next(nullptr) {}
 };
 
 
@@ -44,8 +48,9 @@ struct MallAdjNode {
     string mallID;
     MallEdge* edgeHead;
     MallAdjNode* next;
+    int routeIndex;     // Vertex number in the current routing search
 
-    MallAdjNode(const string& id) : mallID(id), edgeHead(nullptr), next(nullptr) {}
+    MallAdjNode(const string& id) : mallID(id), edgeHead(nullptr), next(nullptr), routeIndex(-1) {}
 };
 
 
@@ -73,79 +78,8 @@ struct MallNode {
 
 
 
-struct CommercialDijkstraNode {
-    string mallID;
-    double distance;
-};
-
-class CommercialDijkstraHeap {
-private:
-    static const int MAX_SIZE = 500;
-    CommercialDijkstraNode heap[MAX_SIZE];
-    int size;
-
-    void swap(int i, int j) {
-        CommercialDijkstraNode temp = heap[i];
-        heap[i] = heap[j];
-        heap[j] = temp;
-    }
-
-    void siftUp(int i) {
-        while (i > 0) {
-            int parent = (i - 1) / 2;
-            if (heap[i].distance < heap[parent].distance) {
-                swap(i, parent);
-                i = parent;
-            }
-            else break;
-        }
-    }
-
-    void siftDown(int i) {
-        while (true) {
-            int smallest = i;
-            int left = 2 * i + 1;
-            int right = 2 * i + 2;
-
-            if (left < size && heap[left].distance < heap[smallest].distance)
-                smallest = left;
-            if (right < size && heap[right].distance < heap[smallest].distance)
-                smallest = right;
-
-            if (smallest != i) {
-                swap(i, smallest);
-                i = smallest;
-            }
-            else break;
-        }
-    }
-
-public:
-    CommercialDijkstraHeap() : size(0) {}
-
-    bool isEmpty() { 
-        return size == 0; 
-    }
-
-    void insert(const string& id, double dist) {
-        if (size >= MAX_SIZE)
-            return;
-        heap[size].mallID = id;
-        heap[size].distance = dist;
-        siftUp(size);
-        size++;
-    }
-
-    CommercialDijkstraNode extractMin() {
-        CommercialDijkstraNode minNode = heap[0];
-        heap[0] = heap[size - 1];
-        size--;
-        if (size > 0) siftDown(0);
-        return minNode;
-    }
-
-    void clear() { size = 0; }
-};
+// Routing engine view of the delivery network
+typedef CityLinkedGraph<MallAdjNode, MallEdge> MallDeliveryGraph;
 
 
 class ProductHashTable {
@@ -314,6 +248,12 @@ private:
     int mallIDCounter;
     int productIDCounter;
 
+    // Bumped on every delivery network change; keys the shortest path cache
+    unsigned int graphVersion;
+    CityPathCache pathCache;
+
+    void markGraphChanged() { graphVersion++; }
+
 
 
     int productTableHash(const string& name) {
@@ -358,6 +298,7 @@ private:
         MallAdjNode* newNode = new MallAdjNode(mallID);
         newNode->next = adjListHead;
         adjListHead = newNode;
+        markGraphChanged();
         return newNode;
     }
 
@@ -377,6 +318,7 @@ private:
     void removeEdgeFromAdjList(MallAdjNode* adj, const string& destID) {
         if (adj == nullptr || adj->edgeHead == nullptr)
             return;
+        markGraphChanged();
 
         while (adj->edgeHead != nullptr &&
             stringsEqualIgnoreCase(adj->edgeHead->destMallID, destID)) {
@@ -404,6 +346,7 @@ private:
     void removeAdjListEntry(const string& mallID) {
         if (adjListHead == nullptr)
             return;
+        markGraphChanged();
 
         if (stringsEqualIgnoreCase(adjListHead->mallID, mallID)) {
             MallAdjNode* temp = adjListHead;
@@ -509,7 +452,7 @@ private:
 
 public:
     CommercialSystem() : mallsHead(nullptr), adjListHead(nullptr), mallCount(0),
-        mallIDCounter(1), productIDCounter(1) {
+        mallIDCounter(1), productIDCounter(1), graphVersion(0) {
     }
     void registerMall() {
         cout << "\n=== Register New Mall ===" << endl;
@@ -581,11 +524,15 @@ public:
 
         string mallID = mall->mallID;
 
-        // Remove all edges TO this mall
-        MallAdjNode* adj = adjListHead;
-        while (adj != nullptr) {
-            removeEdgeFromAdjList(adj, mallID);
-            adj = adj->next;
+        // Remove all edges TO this mall. Routes are stored both ways, so only
+        // this mall's neighbors can hold one
+        MallAdjNode* ownAdj = getAdjList(mallID);
+        if (ownAdj != nullptr) {
+            MallEdge* edge = ownAdj->edgeHead;
+            while (edge != nullptr) {
+                if (edge->destAdj != ownAdj) removeEdgeFromAdjList(edge->destAdj, mallID);
+                edge = edge->next;
+            }
         }
 
         // Remove this mall's adjacency list
@@ -726,6 +673,9 @@ public:
         MallEdge* edge2 = new MallEdge(mall1->mallID, distance);
         edge2->next = adj2->edgeHead;
         adj2->edgeHead = edge2;
+        edge1->destAdj = adj2;
+        edge2->destAdj = adj1;
+        markGraphChanged();
 
         cout << "Connected '" << mall1->name << "' <--> '" << mall2->name
             << "' (Distance: " << distance << " units)" << endl;
@@ -1001,18 +951,10 @@ public:
         double userLat = getDoubleInput("Enter your Latitude: ");
         double userLon = getDoubleInput("Enter your Longitude: ");
 
-        MallNode* nearest = nullptr;
+        // Answered by the city graph's spatial index instead of a full scan
         double minDist = DBL_MAX;
-
-        MallNode* current = mallsHead;
-        while (current != nullptr) {
-            double dist = calculateDistance(userLat, userLon, current->lat, current->lon);
-            if (dist < minDist) {
-                minDist = dist;
-                nearest = current;
-            }
-            current = current->next;
-        }
+        CityLocation* loc = CityGraph::getInstance()->findNearestOfType(userLat, userLon, LOC_MALL, minDist);
+        MallNode* nearest = (loc != nullptr) ? (MallNode*)loc->entityPtr : nullptr;
 
         if (nearest != nullptr) {
             cout << "\n=== Nearest Mall ===" << endl;
@@ -1094,135 +1036,68 @@ public:
 
 
         const int MAX_MALLS = 500;
-        string mallIDs[MAX_MALLS];
-        double distances[MAX_MALLS];
-        string previous[MAX_MALLS];
-        bool visited[MAX_MALLS];
-        int numMalls = 0;
-
-        // Collect all mall IDs
-        MallNode* current = mallsHead;
-        while (current != nullptr && numMalls < MAX_MALLS) {
-            mallIDs[numMalls] = current->mallID;
-            distances[numMalls] = DBL_MAX;
-            previous[numMalls] = "";
-            visited[numMalls] = false;
-            numMalls++;
-            current = current->next;
-        }
-
-
-        int srcIdx = -1;
-        for (int i = 0; i < numMalls; i++) {
-            if (stringsEqualIgnoreCase(mallIDs[i], srcMall->mallID)) {
-                srcIdx = i;
-                break;
-            }
-        }
-        if (srcIdx == -1) {
-            cout << " Source mall not in graph!" << endl;
-            return;
-        }
-
-        distances[srcIdx] = 0;
-
-        // Dijkstras algaram
-        CommercialDijkstraHeap minHeap;
-        minHeap.insert(srcMall->mallID, 0);
-
-        while (!minHeap.isEmpty()) {
-            CommercialDijkstraNode minNode = minHeap.extractMin();
-            string currentID = minNode.mallID;
-
-            int currentIdx = -1;
-            for (int i = 0; i < numMalls; i++) {
-                if (stringsEqualIgnoreCase(mallIDs[i], currentID)) {
-                    currentIdx = i;
-                    break;
-                }
-            }
-
-            if (currentIdx == -1 || visited[currentIdx])
-                continue;
-            visited[currentIdx] = true;
-
-            // Process neighbors
-            MallAdjNode* adj = getAdjList(currentID);
-            if (adj != nullptr) {
-                MallEdge* edge = adj->edgeHead;
-                while (edge != nullptr) {
-                    int neighborIdx = -1;
-                    for (int i = 0; i < numMalls; i++) {
-                        if (stringsEqualIgnoreCase(mallIDs[i], edge->destMallID)) {
-                            neighborIdx = i;
-                            break;
-                        }
-                    }
-
-                    if (neighborIdx != -1 && !visited[neighborIdx]) {
-                        double newDist = distances[currentIdx] + edge->distance;
-                        if (newDist < distances[neighborIdx]) {
-                            distances[neighborIdx] = newDist;
-                            previous[neighborIdx] = currentID;
-                            minHeap.insert(edge->destMallID, newDist);
-                        }
+        string path[MAX_MALLS];
+        int pathLen = 0;
+        double totalDistance = DBL_MAX;
+
+        // Repeated queries are answered from the cache until the network changes
+        bool cached = pathCache.lookup(srcMall->mallID, destMall->mallID, 0, graphVersion,
+            totalDistance, path, pathLen, MAX_MALLS);
+
+        if (!cached) {
+            MallAdjNode* srcAdj = getAdjList(srcMall->mallID);
+            MallAdjNode* destAdj = getAdjList(destMall->mallID);
+
+            if (srcAdj != nullptr && destAdj != nullptr) {
+                MallDeliveryGraph roads(adjListHead);
+                CityUntilTarget goal(destAdj->routeIndex);
+                CitySearchScratch& sc = getCitySearchScratch();
+                cityShortestPaths(roads, goal, srcAdj->routeIndex, sc);
+
+                int dest = destAdj->routeIndex;
+                if (sc.isSettled(dest)) {
+                    totalDistance = sc.dist[dest];
+
+                    // Walk back from the destination, keeping the first MAX_MALLS malls
+                    int hops = sc.hopsTo(dest);
+                    pathLen = (hops < MAX_MALLS) ? hops : MAX_MALLS;
+                    int pos = hops - 1;
+                    for (int v = dest; v != -1; v = sc.prev[v], pos--) {
+                        if (pos < MAX_MALLS) path[pos] = roads.node(v)->mallID;
                     }
-                    edge = edge->next;
                 }
             }
-        }
 
-        // Find destination index
-        int destIdx = -1;
-        for (int i = 0; i < numMalls; i++) {
-            if (stringsEqualIgnoreCase(mallIDs[i], destMall->mallID)) {
-                destIdx = i;
-                break;
-            }
+            pathCache.store(srcMall->mallID, destMall->mallID, 0, graphVersion, totalDistance, path, pathLen);
         }
 
-        if (destIdx == -1 || distances[destIdx] == DBL_MAX) {
+        if (totalDistance == DBL_MAX) {
             cout << "\nNo delivery path exists between '" << srcMall->name
                 << "' and '" << destMall->name << "'!" << endl;
             cout << "Tip: Make sure the malls are connected via 'Connect Malls' option." << endl;
             return;
         }
 
-        // Reconstruct path
-        string path[MAX_MALLS];
-        int pathLen = 0;
-        string currentID = destMall->mallID;
-
-        while (!currentID.empty() && pathLen < MAX_MALLS) {
-            path[pathLen++] = currentID;
-            int idx = -1;
-            for (int i = 0; i < numMalls; i++) {
-                if (stringsEqualIgnoreCase(mallIDs[i], currentID)) {
-                    idx = i;
-                    break;
-                }
-            }
-            if (idx == -1) break;
-            currentID = previous[idx];
-        }
-
         // Display path
         cout << "\n=== Shortest Delivery Path Found ===" << endl;
         cout << "From: " << srcMall->name << endl;
         cout << "To: " << destMall->name << endl;
-        cout << "Total Distance: " << distances[destIdx] << " units" << endl;
+        cout << "Total Distance: " << totalDistance << " units" << (cached ? " (cached result)" : "") << endl;
         cout << "\nPath: ";
 
-        for (int i = pathLen - 1; i >= 0; i--) {
+        for (int i = 0; i < pathLen; i++) {
             MallNode* mall = findMallByID(path[i]);
             if (mall != nullptr) {
                 cout << mall->name;
-                if (i > 0) cout << " -> ";
+                if (i < pathLen - 1) cout << " -> ";
             }
         }
         cout << endl;
     }
 
+    // Shortest path cache statistics (for the system statistics screen)
+    CityPathCache& getPathCache() { return pathCache; }
+
 
 
     void displayAllMalls() {
@@ -1428,32 +1303,19 @@ public:
     void loadFromFiles() {
         GlobalLocationManager* locMgr = GlobalLocationManager::getInstance();
 
-        auto normalizeSeparators = [](string& s) {
-            for (size_t i = 0; i < s.length(); i++) {
-                if (s[i] == '\t') s[i] = ',';
-            }
-            };
-
         // Load malls
-        ifstream mallFile("malls.csv");
-        if (mallFile.is_open()) {
-            string line;
-            getline(mallFile, line); // Skip header
+        CsvReader mallFile("malls.csv");
+        if (mallFile.isOpen()) {
+            mallFile.readRow(); // Skip header
             int loadedCount = 0;
 
-            while (getline(mallFile, line)) {
-                if (line.empty()) continue;
-                normalizeSeparators(line);
-
-                string parts[6];
-                int count = splitString(line, ',', parts, 6);
-
-                if (count >= 5) {
-                    string id = trimString(parts[0]);
-                    string name = trimString(parts[1]);
-                    string sector = trimString(parts[2]);
-                    string openTime = trimString(parts[3]);
-                    string closeTime = trimString(parts[4]);
+            while (mallFile.readRow()) {
+                if (mallFile.getFieldCount() >= 5) {
+                    string id = mallFile.getString(0);
+                    string name = mallFile.getString(1);
+                    string sector = mallFile.getString(2);
+                    string openTime = mallFile.getString(3);
+                    string closeTime = mallFile.getString(4);
 
                     if (findMallByID(id) != nullptr || findMallByName(name) != nullptr) {
                         continue;
@@ -1502,27 +1364,24 @@ public:
         }
 
         // Load products
-        ifstream prodFile("products.csv");
-        if (prodFile.is_open()) {
-            string line;
-            getline(prodFile, line);
+        CsvReader prodFile("products.csv");
+        if (prodFile.isOpen()) {
+            prodFile.readRow();
             int loadedCount = 0;
 
-            while (getline(prodFile, line)) {
-                if (line.empty())
-                    continue;
-                normalizeSeparators(line);
-
-                string parts[6];
-                int count = splitString(line, ',', parts, 6);
+            int badRows = 0;
 
-                if (count >= 6) {
-                    string mallID = trimString(parts[0]);
-                    string prodID = trimString(parts[1]);
-                    string prodName = trimString(parts[2]);
-                    string category = trimString(parts[3]);
-                    int price = stringToInt(trimString(parts[4]));
-                    int quantity = stringToInt(trimString(parts[5]));
+            while (prodFile.readRow()) {
+                if (prodFile.getFieldCount() >= 6) {
+                    int price, quantity;
+                    if (!prodFile.field(4).toInt(price) || !prodFile.field(5).toInt(quantity)) {
+                        badRows++;
+                        continue;
+                    }
+                    string mallID = prodFile.getString(0);
+                    string prodID = prodFile.getString(1);
+                    string prodName = prodFile.getString(2);
+                    string category = prodFile.getString(3);
 
                     MallNode* mall = findMallByID(mallID);
                     if (mall == nullptr) continue;
@@ -1541,6 +1400,9 @@ public:
             }
             prodFile.close();
             cout << "Loaded " << loadedCount << " products from file." << endl;
+            if (badRows > 0) {
+                cout << "Skipped " << badRows << " products with an invalid price or quantity." << endl;
+            }
         }
         else {
             cout << "Warning: products.csv not found." << endl;
@@ -1548,6 +1410,133 @@ public:
     }
 
 
+    // SNAPSHOT
+
+    // COMMERCL section: malls with their product tables bucket by bucket,
+    // then the delivery road lists; the product index is rebuilt
+    void writeSnapshot(CitySnapshotWriter& out) {
+        CityGraph* cityGraph = CityGraph::getInstance();
+        out.beginSection("COMMERCL");
+        out.putInt(mallIDCounter);
+        out.putInt(productIDCounter);
+
+        out.putInt(mallCount);
+        for (MallNode* mall = mallsHead; mall != nullptr; mall = mall->next) {
+            out.putString(mall->mallID);
+            out.putString(mall->name);
+            out.putString(mall->sector);
+            out.putDouble(mall->lat);
+            out.putDouble(mall->lon);
+            out.putString(mall->openingTime);
+            out.putString(mall->closingTime);
+            out.putInt(cityGraph->getEntityVertex(mall->mallID, mall));
+
+            for (int b = 0; b < MallNode::PRODUCT_TABLE_SIZE; b++) {
+                int chain = 0;
+                for (ProductNode* p = mall->productTable[b]; p != nullptr; p = p->next) chain++;
+                out.putInt(chain);
+                for (ProductNode* p = mall->productTable[b]; p != nullptr; p = p->next) {
+                    out.putString(p->productID);
+                    out.putString(p->name);
+                    out.putString(p->category);
+                    out.putInt(p->price);
+                    out.putInt(p->quantity);
+                }
+            }
+        }
+
+        // Edges refer to their destination's list by position
+        int adjCount = 0;
+        for (MallAdjNode* adj = adjListHead; adj != nullptr; adj = adj->next) {
+            adj->routeIndex = adjCount++;
+        }
+        out.putInt(adjCount);
+        for (MallAdjNode* adj = adjListHead; adj != nullptr; adj = adj->next) {
+            out.putString(adj->mallID);
+            int edgeCount = 0;
+            for (MallEdge* edge = adj->edgeHead; edge != nullptr; edge = edge->next) edgeCount++;
+            out.putInt(edgeCount);
+            for (MallEdge* edge = adj->edgeHead; edge != nullptr; edge = edge->next) {
+                out.putString(edge->destMallID);
+                out.putDouble(edge->distance);
+                out.putInt((edge->destAdj != nullptr) ? edge->destAdj->routeIndex : -1);
+            }
+        }
+        for (MallAdjNode* adj = adjListHead; adj != nullptr; adj = adj->next) {
+            adj->routeIndex = -1;
+        }
+        out.endSection();
+    }
+
+    bool readSnapshot(CitySnapshotReader& in, CitySnapshotLinks& links) {
+        if (mallsHead != nullptr || adjListHead != nullptr) return false;
+        if (!in.beginSection("COMMERCL")) return false;
+        mallIDCounter = in.getInt();
+        productIDCounter = in.getInt();
+
+        int savedMalls = in.getCount();
+        MallNode* mallTail = nullptr;
+        for (int i = 0; i < savedMalls && !in.hasFailed(); i++) {
+            string id = in.getString();
+            string name = in.getString();
+            string sector = in.getString();
+            double lat = in.getDouble();
+            double lon = in.getDouble();
+            string open = in.getString();
+            MallNode* mall = new MallNode(id, name, sector, lat, lon, open, in.getString());
+            if (mallTail == nullptr) mallsHead = mall;
+            else mallTail->next = mall;
+            mallTail = mall;
+            mallCount++;
+            links.setEntity(in.getInt(), mall);
+
+            for (int b = 0; b < MallNode::PRODUCT_TABLE_SIZE && !in.hasFailed(); b++) {
+                int chain = in.getCount();
+                ProductNode* productTail = nullptr;
+                for (int k = 0; k < chain && !in.hasFailed(); k++) {
+                    string productID = in.getString();
+                    string productName = in.getString();
+                    string category = in.getString();
+                    int price = in.getInt();
+                    ProductNode* product = new ProductNode(productID, productName, category, price, in.getInt());
+                    if (productTail == nullptr) mall->productTable[b] = product;
+                    else productTail->next = product;
+                    productTail = product;
+                    mall->productCount++;
+                    productHash.insert(productName, id, product);
+                }
+            }
+        }
+
+        // Lists are created up front so edges can point at later ones
+        int adjCount = in.getCount();
+        MallAdjNode** adjs = new MallAdjNode * [adjCount > 0 ? adjCount : 1];
+        for (int i = 0; i < adjCount; i++) {
+            adjs[i] = new MallAdjNode("");
+            if (i == 0) adjListHead = adjs[i];
+            else adjs[i - 1]->next = adjs[i];
+        }
+        for (int i = 0; i < adjCount && !in.hasFailed(); i++) {
+            MallAdjNode* adj = adjs[i];
+            adj->mallID = in.getString();
+            int edgeCount = in.getCount();
+            MallEdge* edgeTail = nullptr;
+            for (int e = 0; e < edgeCount && !in.hasFailed(); e++) {
+                string dest = in.getString();
+                MallEdge* edge = new MallEdge(dest, in.getDouble());
+                int target = in.getInt();
+                if (target >= 0 && target < adjCount) edge->destAdj = adjs[target];
+                if (edgeTail == nullptr) adj->edgeHead = edge;
+                else edgeTail->next = edge;
+                edgeTail = edge;
+            }
+        }
+        delete[] adjs;
+
+        markGraphChanged();
+        return !in.hasFailed();
+    }
+
     int getMallCount() {
         return mallCount;
     }
@@ -0,0 +1,672 @@
+#pragma once
+#include "Utils.h"
+#include "CityGraph.h"
+#include <cstring>
+
+// CONTRACTION HIERARCHIES
+// Preprocessing over the city graph for fast repeated point-to-point routing.
+// Vertices are contracted one by one (least important first); whenever a
+// contraction would break a shortest path, a shortcut edge is added. Queries
+// then run a bidirectional Dijkstra that only climbs to higher-ranked
+// vertices, and shortcuts are unpacked back into real roads.
+// The hierarchy is saved to disk so restarts on an unchanged graph skip
+// preprocessing, and it rebuilds itself when the road network changes.
+
+const string CH_CACHE_FILE = "city_graph.ch";
+
+// Edge in the contraction working graph (middle = bypassed vertex, -1 = real road)
+struct CHEdge {
+    int to;
+    double weight;
+    int middle;
+};
+
+class CityContractionHierarchy {
+private:
+    // Witness searches give up after this many settled vertices or edges
+    // on a path (fewer when only estimating importance); giving up just
+    // costs an extra shortcut
+    static const int WITNESS_SETTLE_LIMIT = 500;
+    static const int WITNESS_HOP_LIMIT = 5;
+    static const int SIMULATE_SETTLE_LIMIT = 100;
+    static const int SIMULATE_HOP_LIMIT = 3;
+
+    CityGraph* graph;
+    int vertexCount;
+    unsigned int builtVersion;
+    bool built;
+    bool fromCache;         // Loaded from the cache file rather than contracted
+    int shortcutCount;
+
+    int* rank;              // Contraction order of each vertex
+
+    // Upward graph (edges to higher-ranked vertices), CSR layout
+    int* upOffsets;
+    int* upTargets;
+    double* upWeights;
+    int* upMiddle;
+    int upEdgeCount;
+
+    // Contraction working graph: per-vertex dynamic edge arrays
+    CHEdge** workAdj;
+    int* workDegree;
+    int* workCapacity;
+    bool* contracted;
+    int* contractedNeighbors;
+    int* witnessHops;       // Edges on the witness path to each settled vertex
+    int* witnessTarget;     // == witnessRound for the neighbors still to reach
+    int witnessRound;
+    CitySearchScratch witness;
+
+    // Unpacked path buffer
+    int* pathBuffer;
+
+    static CityContractionHierarchy* instance;
+
+    CityContractionHierarchy() : graph(CityGraph::getInstance()), vertexCount(0), builtVersion(0),
+        built(false), fromCache(false), shortcutCount(0), rank(nullptr), upOffsets(nullptr), upTargets(nullptr),
+        upWeights(nullptr), upMiddle(nullptr), upEdgeCount(0), workAdj(nullptr), workDegree(nullptr),
+        workCapacity(nullptr), contracted(nullptr), contractedNeighbors(nullptr), witnessHops(nullptr),
+        witnessTarget(nullptr), witnessRound(0), pathBuffer(nullptr) {
+    }
+
+    void freeHierarchy() {
+        delete[] rank;
+        delete[] upOffsets;
+        delete[] upTargets;
+        delete[] upWeights;
+        delete[] upMiddle;
+        delete[] pathBuffer;
+        rank = nullptr;
+        upOffsets = nullptr;
+        upTargets = nullptr;
+        upWeights = nullptr;
+        upMiddle = nullptr;
+        pathBuffer = nullptr;
+        upEdgeCount = 0;
+        shortcutCount = 0;
+        built = false;
+    }
+
+    void freeWorkGraph() {
+        if (workAdj != nullptr) {
+            for (int v = 0; v < vertexCount; v++) {
+                delete[] workAdj[v];
+            }
+        }
+        delete[] workAdj;
+        delete[] workDegree;
+        delete[] workCapacity;
+        delete[] contracted;
+        delete[] contractedNeighbors;
+        delete[] witnessHops;
+        delete[] witnessTarget;
+        workAdj = nullptr;
+        workDegree = nullptr;
+        workCapacity = nullptr;
+        contracted = nullptr;
+        contractedNeighbors = nullptr;
+        witnessHops = nullptr;
+        witnessTarget = nullptr;
+    }
+
+    // WORKING GRAPH
+
+    void appendWorkEdge(int from, int to, double weight, int middle) {
+        if (workDegree[from] >= workCapacity[from]) {
+            int newCapacity = (workCapacity[from] > 0) ? workCapacity[from] * 2 : 4;
+            CHEdge* newEdges = new CHEdge[newCapacity];
+            for (int i = 0; i < workDegree[from]; i++) {
+                newEdges[i] = workAdj[from][i];
+            }
+            delete[] workAdj[from];
+            workAdj[from] = newEdges;
+            workCapacity[from] = newCapacity;
+        }
+        CHEdge& edge = workAdj[from][workDegree[from]++];
+        edge.to = to;
+        edge.weight = weight;
+        edge.middle = middle;
+    }
+
+    void removeWorkEdge(int from, int to) {
+        for (int i = 0; i < workDegree[from]; i++) {
+            if (workAdj[from][i].to == to) {
+                workAdj[from][i] = workAdj[from][--workDegree[from]];
+                return;
+            }
+        }
+    }
+
+    // Add or shorten the undirected edge u - w
+    void addShortcut(int u, int w, double weight, int middle) {
+        for (int i = 0; i < workDegree[u]; i++) {
+            if (workAdj[u][i].to == w) {
+                if (weight < workAdj[u][i].weight) {
+                    workAdj[u][i].weight = weight;
+                    workAdj[u][i].middle = middle;
+                    for (int j = 0; j < workDegree[w]; j++) {
+                        if (workAdj[w][j].to == u) {
+                            workAdj[w][j].weight = weight;
+                            workAdj[w][j].middle = middle;
+                        }
+                    }
+                }
+                return;
+            }
+        }
+        appendWorkEdge(u, w, weight, middle);
+        appendWorkEdge(w, u, weight, middle);
+        shortcutCount++;
+    }
+
+    void buildWorkGraph() {
+        graph->ensureCompactGraph();
+        const int* offsets = graph->getCompactOffsets();
+        const int* targets = graph->getCompactTargets();
+        const double* weights = graph->getCompactWeights();
+
+        workAdj = new CHEdge * [vertexCount];
+        workDegree = new int[vertexCount];
+        workCapacity = new int[vertexCount];
+        contracted = new bool[vertexCount];
+        contractedNeighbors = new int[vertexCount];
+        witnessHops = new int[vertexCount];
+        witnessTarget = new int[vertexCount];
+        witnessRound = 0;
+
+        for (int v = 0; v < vertexCount; v++) {
+            int degree = offsets[v + 1] - offsets[v];
+            workAdj[v] = (degree > 0) ? new CHEdge[degree] : nullptr;
+            workDegree[v] = 0;
+            workCapacity[v] = degree;
+            contracted[v] = false;
+            contractedNeighbors[v] = 0;
+            witnessTarget[v] = 0;
+        }
+
+        for (int v = 0; v < vertexCount; v++) {
+            for (int e = offsets[v]; e < offsets[v + 1]; e++) {
+                if (targets[e] != v) appendWorkEdge(v, targets[e], weights[e], -1);
+            }
+        }
+    }
+
+    // Routing engine view of the working graph, hiding 'via' and contracted
+    // vertices, and the edges out of vertices already hopLimit edges away
+    struct WitnessGraph {
+        typedef const CHEdge* Edge;
+
+        CHEdge** adj;
+        int* degree;
+        bool* contracted;
+        int* hops;
+        int via;
+        int count;
+        int hopLimit;
+
+        int vertexCount() const { return count; }
+        Edge firstEdge(int u) const { return adj[u]; }
+        Edge endEdge(int u) const { return (hops[u] < hopLimit) ? adj[u] + degree[u] : adj[u]; }
+        Edge nextEdge(Edge e) const { return e + 1; }
+        int edgeTarget(Edge e) const { return (e->to == via || contracted[e->to]) ? -1 : e->to; }
+        double edgeLength(Edge e) const { return e->weight; }
+    };
+
+    // Stops once every target is settled, past maxDist or after settleLimit
+    // relaxed vertices; records the hop count of each settled vertex for
+    // the graph view
+    struct WitnessGoal {
+        CitySearchScratch* sc;
+        int* hops;
+        int* target;
+        int round;
+        int targetsLeft;
+        double maxDist;
+        int settleLimit;
+        int settled;
+
+        bool onSettle(int u) {
+            if (sc->dist[u] > maxDist || settled >= settleLimit) return true;
+            if (target[u] == round && --targetsLeft == 0) return true;
+            hops[u] = (sc->prev[u] == -1) ? 0 : hops[sc->prev[u]] + 1;
+            settled++;
+            return false;
+        }
+        double lowerBound(int) { return 0; }
+    };
+
+    // Shortest distance from 'from' to the targets of the current round
+    // without going through 'via', limited to maxDist, a number of settled
+    // vertices and of edges per path
+    void witnessSearch(int from, int via, int targets, double maxDist, int settleLimit, int hopLimit) {
+        WitnessGraph view = { workAdj, workDegree, contracted, witnessHops, via, vertexCount, hopLimit };
+        WitnessGoal goal = { &witness, witnessHops, witnessTarget, witnessRound, targets, maxDist, settleLimit, 0 };
+        cityShortestPaths(view, goal, from, witness);
+    }
+
+    // Contract v (or only count the shortcuts it would need when simulating)
+    int contractVertex(int v, bool simulate) {
+        int needed = 0;
+        CHEdge* edges = workAdj[v];
+        int degree = workDegree[v];
+
+        for (int i = 0; i < degree; i++) {
+            int u = edges[i].to;
+            if (contracted[u]) continue;
+
+            // Each unordered pair is handled once, from its lower-indexed end,
+            // so the search from u only has to reach the higher-indexed ones
+            witnessRound++;
+            int targets = 0;
+            double maxDist = 0;
+            for (int j = 0; j < degree; j++) {
+                int w = edges[j].to;
+                if (j == i || contracted[w] || w <= u) continue;
+                if (witnessTarget[w] != witnessRound) {
+                    witnessTarget[w] = witnessRound;
+                    targets++;
+                }
+                if (edges[i].weight + edges[j].weight > maxDist) maxDist = edges[i].weight + edges[j].weight;
+            }
+            if (targets == 0) continue;
+
+            if (simulate) witnessSearch(u, v, targets, maxDist, SIMULATE_SETTLE_LIMIT, SIMULATE_HOP_LIMIT);
+            else witnessSearch(u, v, targets, maxDist, WITNESS_SETTLE_LIMIT, WITNESS_HOP_LIMIT);
+
+            for (int j = 0; j < degree; j++) {
+                int w = edges[j].to;
+                if (j == i || contracted[w] || w <= u) continue;
+
+                double viaDist = edges[i].weight + edges[j].weight;
+                if (witness.distanceTo(w) > viaDist) {
+                    needed++;
+                    if (!simulate) addShortcut(u, w, viaDist, v);
+                }
+            }
+        }
+        return needed;
+    }
+
+    // Importance used for ordering: edge difference plus contracted neighbors
+    double priorityOf(int v) {
+        int activeDegree = 0;
+        for (int i = 0; i < workDegree[v]; i++) {
+            if (!contracted[workAdj[v][i].to]) activeDegree++;
+        }
+        return contractVertex(v, true) - activeDegree + contractedNeighbors[v];
+    }
+
+    // Turn the contracted working graph into the upward CSR arrays
+    void buildUpwardGraph() {
+        upOffsets = new int[vertexCount + 1];
+        upOffsets[0] = 0;
+        for (int v = 0; v < vertexCount; v++) {
+            int count = 0;
+            for (int i = 0; i < workDegree[v]; i++) {
+                if (rank[workAdj[v][i].to] > rank[v]) count++;
+            }
+            upOffsets[v + 1] = upOffsets[v] + count;
+        }
+
+        upEdgeCount = upOffsets[vertexCount];
+        upTargets = new int[upEdgeCount > 0 ? upEdgeCount : 1];
+        upWeights = new double[upEdgeCount > 0 ? upEdgeCount : 1];
+        upMiddle = new int[upEdgeCount > 0 ? upEdgeCount : 1];
+
+        for (int v = 0; v < vertexCount; v++) {
+            int pos = upOffsets[v];
+            for (int i = 0; i < workDegree[v]; i++) {
+                const CHEdge& edge = workAdj[v][i];
+                if (rank[edge.to] > rank[v]) {
+                    upTargets[pos] = edge.to;
+                    upWeights[pos] = edge.weight;
+                    upMiddle[pos] = edge.middle;
+                    pos++;
+                }
+            }
+        }
+    }
+
+    // SERIALIZATION
+
+    // Fingerprint of the vertex IDs and roads the hierarchy was built from
+    unsigned long long graphSignature() {
+        graph->ensureCompactGraph();
+        const int* offsets = graph->getCompactOffsets();
+        const int* targets = graph->getCompactTargets();
+        const double* weights = graph->getCompactWeights();
+        int count = graph->getLocationCount();
+
+        unsigned long long h = 1469598103934665603ULL;
+        for (int v = 0; v < count; v++) {
+            const string& id = graph->getVertex(v)->id;
+            for (size_t i = 0; i < id.length(); i++) {
+                char c = id[i];
+                if (c >= 'A' && c <= 'Z') c += 32;
+                h = (h ^ (unsigned char)c) * 1099511628211ULL;
+            }
+            h = (h ^ 0xFF) * 1099511628211ULL;
+            for (int e = offsets[v]; e < offsets[v + 1]; e++) {
+                unsigned long long bits = 0;
+                double w = weights[e];
+                memcpy(&bits, &w, sizeof(double));
+                h = (h ^ (unsigned long long)targets[e]) * 1099511628211ULL;
+                h = (h ^ bits) * 1099511628211ULL;
+            }
+        }
+        return h;
+    }
+
+    bool loadFromFile(const string& filename, unsigned long long signature) {
+        ifstream file(filename.c_str(), ios::binary | ios::ate);
+        if (!file.is_open()) return false;
+        long long fileSize = (long long)file.tellg();
+        file.seekg(0);
+
+        char magic[8];
+        unsigned long long fileSignature = 0;
+        int fileVertices = 0;
+        int fileEdges = 0;
+        int fileShortcuts = 0;
+        file.read(magic, 8);
+        file.read((char*)&fileSignature, sizeof(fileSignature));
+        file.read((char*)&fileVertices, sizeof(int));
+        file.read((char*)&fileEdges, sizeof(int));
+        file.read((char*)&fileShortcuts, sizeof(int));
+
+        if (!file || memcmp(magic, "CITYCH01", 8) != 0 || fileSignature != signature ||
+            fileVertices != vertexCount || fileEdges < 0) {
+            return false;
+        }
+
+        // The arrays must fill the rest of the file exactly
+        long long expectedSize = 8 + sizeof(unsigned long long) + 3 * sizeof(int) +
+            (long long)sizeof(int) * (2LL * vertexCount + 1) +
+            (long long)(2 * sizeof(int) + sizeof(double)) * fileEdges;
+        if (fileSize != expectedSize) return false;
+
+        freeHierarchy();
+        upEdgeCount = fileEdges;
+        shortcutCount = fileShortcuts;
+        rank = new int[vertexCount > 0 ? vertexCount : 1];
+        upOffsets = new int[vertexCount + 1];
+        upTargets = new int[upEdgeCount > 0 ? upEdgeCount : 1];
+        upWeights = new double[upEdgeCount > 0 ? upEdgeCount : 1];
+        upMiddle = new int[upEdgeCount > 0 ? upEdgeCount : 1];
+
+        file.read((char*)rank, sizeof(int) * vertexCount);
+        file.read((char*)upOffsets, sizeof(int) * (vertexCount + 1));
+        file.read((char*)upTargets, sizeof(int) * upEdgeCount);
+        file.read((char*)upWeights, sizeof(double) * upEdgeCount);
+        file.read((char*)upMiddle, sizeof(int) * upEdgeCount);
+
+        if (!file || !isValidHierarchy()) {
+            freeHierarchy();
+            return false;
+        }
+        return true;
+    }
+
+    // A loaded file must describe a hierarchy over this graph: a rank
+    // permutation, offsets running from 0 to the edge count, targets and
+    // bypassed vertices that exist, and every edge leading upward (queries
+    // and path unpacking rely on that to terminate)
+    bool isValidHierarchy() {
+        if (shortcutCount < 0 || shortcutCount > upEdgeCount || upOffsets[0] != 0 ||
+            upOffsets[vertexCount] != upEdgeCount) {
+            return false;
+        }
+
+        bool* seen = new bool[vertexCount > 0 ? vertexCount : 1];
+        for (int v = 0; v < vertexCount; v++) seen[v] = false;
+        bool valid = true;
+        for (int v = 0; v < vertexCount && valid; v++) {
+            if (rank[v] < 0 || rank[v] >= vertexCount || seen[rank[v]]) valid = false;
+            else seen[rank[v]] = true;
+        }
+        delete[] seen;
+
+        for (int v = 0; v < vertexCount && valid; v++) {
+            if (upOffsets[v + 1] < upOffsets[v] || upOffsets[v + 1] > upEdgeCount) {
+                valid = false;
+                break;
+            }
+            for (int e = upOffsets[v]; e < upOffsets[v + 1]; e++) {
+                int to = upTargets[e];
+                int middle = upMiddle[e];
+                if (to < 0 || to >= vertexCount || rank[to] <= rank[v] || !(upWeights[e] >= 0) ||
+                    (middle != -1 && (middle < 0 || middle >= vertexCount || rank[middle] >= rank[v]))) {
+                    valid = false;
+                    break;
+                }
+            }
+        }
+        return valid;
+    }
+
+    // PATH UNPACKING
+
+    // Append the real vertices of up-edge a-b (excluding a) to pathBuffer.
+    // False if that would take the path past vertexCount vertices, which
+    // only shortcuts that do not add up (a damaged cache file) can do.
+    bool unpackEdge(int a, int b, int& len) {
+        int low = (rank[a] < rank[b]) ? a : b;
+        int high = (low == a) ? b : a;
+
+        int middle = -1;
+        double best = DBL_MAX;
+        for (int e = upOffsets[low]; e < upOffsets[low + 1]; e++) {
+            if (upTargets[e] == high && upWeights[e] < best) {
+                best = upWeights[e];
+                middle = upMiddle[e];
+            }
+        }
+
+        if (middle == -1) {
+            if (len >= vertexCount) return false;
+            pathBuffer[len++] = b;
+            return true;
+        }
+        return unpackEdge(a, middle, len) && unpackEdge(middle, b, len);
+    }
+
+public:
+    static CityContractionHierarchy* getInstance() {
+        if (instance == nullptr) {
+            instance = new CityContractionHierarchy();
+        }
+        return instance;
+    }
+
+    // Contract the whole graph
+    void build() {
+        freeHierarchy();
+        vertexCount = graph->getLocationCount();
+        buildWorkGraph();
+        rank = new int[vertexCount > 0 ? vertexCount : 1];
+
+        // Priority queue over importance (edge difference plus contracted
+        // neighbors). Contractions make the keys of vertices around them
+        // stale, so the minimum is re-scored when it comes up, and goes back
+        // into the queue if it is no longer the least important
+        CityIndexedHeap queue;
+        queue.reserve(vertexCount);
+        for (int v = 0; v < vertexCount; v++) {
+            queue.insertOrDecrease(v, priorityOf(v));
+        }
+
+        int order = 0;
+        while (!queue.isEmpty()) {
+            int v = queue.extractMin();
+            double priority = priorityOf(v);
+            if (!queue.isEmpty() && priority > queue.minKey()) {
+                queue.insertOrDecrease(v, priority);
+                continue;
+            }
+
+            contractVertex(v, false);
+            contracted[v] = true;
+            rank[v] = order++;
+
+            // Neighbors lose their edge to v (v keeps its own list, which now
+            // only leads upward); their keys are fixed up when they come up
+            for (int i = 0; i < workDegree[v]; i++) {
+                int u = workAdj[v][i].to;
+                if (contracted[u]) continue;
+                removeWorkEdge(u, v);
+                contractedNeighbors[u]++;
+            }
+        }
+
+        buildUpwardGraph();
+        freeWorkGraph();
+
+        pathBuffer = new int[vertexCount > 0 ? vertexCount : 1];
+        builtVersion = graph->getGraphVersion();
+        built = true;
+        fromCache = false;
+    }
+
+    // Write the hierarchy so an unchanged graph can skip build() after a restart
+    bool saveToFile(const string& filename = CH_CACHE_FILE) {
+        if (!built) return false;
+        ofstream file(filename.c_str(), ios::binary);
+        if (!file.is_open()) return false;
+
+        unsigned long long signature = graphSignature();
+        file.write("CITYCH01", 8);
+        file.write((const char*)&signature, sizeof(signature));
+        file.write((const char*)&vertexCount, sizeof(int));
+        file.write((const char*)&upEdgeCount, sizeof(int));
+        file.write((const char*)&shortcutCount, sizeof(int));
+        file.write((const char*)rank, sizeof(int) * vertexCount);
+        file.write((const char*)upOffsets, sizeof(int) * (vertexCount + 1));
+        file.write((const char*)upTargets, sizeof(int) * upEdgeCount);
+        file.write((const char*)upWeights, sizeof(double) * upEdgeCount);
+        file.write((const char*)upMiddle, sizeof(int) * upEdgeCount);
+        return (bool)file;
+    }
+
+    // True when roads or locations changed since the hierarchy was built
+    bool isStale() {
+        return !built || builtVersion != graph->getGraphVersion();
+    }
+
+    // Rebuild trigger: reuse the cache file if it matches the current graph,
+    // otherwise contract again and refresh the cache
+    void ensureBuilt(const string& cacheFile = CH_CACHE_FILE) {
+        if (!isStale()) return;
+
+        vertexCount = graph->getLocationCount();
+        if (loadFromFile(cacheFile, graphSignature())) {
+            pathBuffer = new int[vertexCount > 0 ? vertexCount : 1];
+            builtVersion = graph->getGraphVersion();
+            built = true;
+            fromCache = true;
+            return;
+        }
+
+        build();
+        saveToFile(cacheFile);
+    }
+
+    // Same contract as CityGraph::findShortestPath
+    double findShortestPath(const string& srcID, const string& destID,
+        string path[], int& pathLen, int maxPathLen) {
+        pathLen = 0;
+        ensureBuilt();
+
+        int src = graph->getVertexIndex(srcID);
+        int dest = graph->getVertexIndex(destID);
+        if (src == -1 || dest == -1) return DBL_MAX;
+        if (!graph->areConnected(srcID, destID)) return DBL_MAX;
+
+        static thread_local CitySearchScratch forward;
+        static thread_local CitySearchScratch backward;
+        forward.prepare(vertexCount);
+        backward.prepare(vertexCount);
+        forward.reach(src, 0, -1);
+        forward.heap.insertOrDecrease(src, 0);
+        backward.reach(dest, 0, -1);
+        backward.heap.insertOrDecrease(dest, 0);
+
+        double best = DBL_MAX;
+        int meet = -1;
+
+        while (true) {
+            double fMin = forward.heap.isEmpty() ? DBL_MAX : forward.heap.minKey();
+            double bMin = backward.heap.isEmpty() ? DBL_MAX : backward.heap.minKey();
+            if (fMin >= best && bMin >= best) break;
+            if (fMin == DBL_MAX && bMin == DBL_MAX) break;
+
+            bool goForward = (fMin <= bMin);
+            CitySearchScratch& sc = goForward ? forward : backward;
+            CitySearchScratch& other = goForward ? backward : forward;
+
+            int u = sc.heap.extractMin();
+            sc.settle(u);
+            if (other.isReached(u) && sc.dist[u] + other.dist[u] < best) {
+                best = sc.dist[u] + other.dist[u];
+                meet = u;
+            }
+
+            for (int e = upOffsets[u]; e < upOffsets[u + 1]; e++) {
+                int v = upTargets[e];
+                double newDist = sc.dist[u] + upWeights[e];
+                if (newDist < sc.distanceTo(v)) {
+                    sc.reach(v, newDist, u);
+                    sc.heap.insertOrDecrease(v, newDist);
+                    if (other.isReached(v) && newDist + other.dist[v] < best) {
+                        best = newDist + other.dist[v];
+                        meet = v;
+                    }
+                }
+            }
+        }
+
+        if (meet == -1) return DBL_MAX;
+
+        // Up-path src -> meet, reversed out of the predecessor chain
+        int upLen = 0;
+        for (int v = meet; v != -1; v = forward.prev[v]) upLen++;
+        int* upPath = new int[upLen];
+        int pos = upLen - 1;
+        for (int v = meet; v != -1; v = forward.prev[v]) upPath[pos--] = v;
+
+        int len = 0;
+        bool unpacked = true;
+        pathBuffer[len++] = src;
+        for (int i = 0; unpacked && i + 1 < upLen; i++) {
+            unpacked = unpackEdge(upPath[i], upPath[i + 1], len);
+        }
+        for (int v = meet; unpacked && backward.prev[v] != -1; v = backward.prev[v]) {
+            unpacked = unpackEdge(v, backward.prev[v], len);
+        }
+        delete[] upPath;
+
+        if (!unpacked) {
+            // A cached hierarchy can pass isValidHierarchy() and still hold
+            // shortcuts that do not add up; contract again and retry once
+            if (!fromCache) return DBL_MAX;
+            build();
+            saveToFile();
+            return findShortestPath(srcID, destID, path, pathLen, maxPathLen);
+        }
+
+        for (int i = 0; i < len && i < maxPathLen; i++) {
+            path[pathLen++] = graph->getVertex(pathBuffer[i])->id;
+        }
+        return best;
+    }
+
+    int getShortcutCount() { return shortcutCount; }
+    bool isBuilt() { return built; }
+
+    ~CityContractionHierarchy() {
+        freeWorkGraph();
+        freeHierarchy();
+    }
+};
+
+CityContractionHierarchy* CityContractionHierarchy::instance = nullptr;
@@ -1481,18 +1481,10 @@ public:
         double userLat = getDoubleInput("Enter your Latitude: ");
         double userLon = getDoubleInput("Enter your Longitude: ");
 
-        SchoolNode* nearest = nullptr;
+        // Answered by the city graph's spatial index instead of a full scan
         double minDist = DBL_MAX;
-
-        SchoolNode* current = schoolsHead;
-        while (current != nullptr) {
-            double dist = calculateDistance(userLat, userLon, current->lat, current->lon);
-            if (dist < minDist) {
-                minDist = dist;
-                nearest = current;
-            }
-            current = current->next;
-        }
+        CityLocation* loc = CityGraph::getInstance()->findNearestOfType(userLat, userLon, LOC_SCHOOL, minDist);
+        SchoolNode* nearest = (loc != nullptr) ? (SchoolNode*)loc->entityPtr : nullptr;
 
         if (nearest != nullptr) {
             cout << "\n=== Nearest School ===" << endl;
@@ -1808,57 +1800,36 @@ public:
 
 
     void loadFromFile() {
-        ifstream file("schools.csv");
-        if (!file.is_open()) {
+        CsvReader file("schools.csv");
+        if (!file.isOpen()) {
             cout << "Warning: 'schools.csv' not found. Starting with empty database." << endl;
             return;
         }
 
-        string line;
-        getline(file, line);
+        file.readRow();
 
         GlobalLocationManager* locMgr = GlobalLocationManager::getInstance();
         int loadedCount = 0;
+        int badRows = 0;
 
-        while (getline(file, line)) {
-            if (line.empty())
-                continue;
-
-            // Normalize separators
-            for (size_t i = 0; i < line.length(); i++) {
-                if (line[i] == '\t') line[i] = ',';
-            }
-
-            string parts[6];
-            int count = splitString(line, ',', parts, 5);
+        while (file.readRow()) {
+            int count = file.getFieldCount();
 
             if (count >= 5) {
-                string id = trimString(parts[0]);
-                string name = trimString(parts[1]);
-                string sector = trimString(parts[2]);
-                double rating = stringToDouble(trimString(parts[3]));
-
-                // Remaining part is subjects 
-                string subjects = "";
-                size_t pos = 0;
-                int commaCount = 0;
-                for (size_t i = 0; i < line.length(); i++) {
-                    if (line[i] == ',') {
-                        commaCount++;
-                        if (commaCount == 4) {
-                            subjects = line.substr(i + 1);
-                            break;
-                        }
-                    }
-                }
-                subjects = trimString(subjects);
-
-                // Remove surrounding quotes from subjects
-                if (!subjects.empty() && subjects[0] == '"') {
-                    subjects = subjects.substr(1);
+                double rating;
+                if (!file.field(3).toDouble(rating)) {
+                    badRows++;
+                    continue;
                 }
-                if (!subjects.empty() && subjects[subjects.length() - 1] == '"') {
-                    subjects = subjects.substr(0, subjects.length() - 1);
+                string id = file.getString(0);
+                string name = file.getString(1);
+                string sector = file.getString(2);
+
+                // Subjects are one quoted field, or the rest of the row unquoted
+                // (rejoined as "Math, Physics" like the quoted form)
+                string subjects = file.getString(4);
+                for (int i = 5; i < count; i++) {
+                    subjects += ", " + file.getString(i);
                 }
 
                 if (findSchoolByID(id) != nullptr || findSchoolByName(name) != nullptr) {
@@ -1922,9 +1893,137 @@ public:
 
         file.close();
         cout << "Loaded " << loadedCount << " schools from file." << endl;
-    }
+        if (badRows > 0) {
+            cout << "Skipped " << badRows << " schools with an invalid rating." << endl;
+        }
+    }
+
+
+
+    // SNAPSHOT
+
+    // EDUCATN section: schools with their departments, sections, students
+    // and teachers; the subject index and ranking heap are rebuilt
+    void writeSnapshot(CitySnapshotWriter& out) {
+        CityGraph* cityGraph = CityGraph::getInstance();
+        out.beginSection("EDUCATN");
+        out.putInt(manualIDCounter);
+
+        out.putInt(schoolCount);
+        for (SchoolNode* school = schoolsHead; school != nullptr; school = school->next) {
+            out.putString(school->schoolID);
+            out.putString(school->name);
+            out.putString(school->sector);
+            out.putDouble(school->lat);
+            out.putDouble(school->lon);
+            out.putDouble(school->rating);
+            out.putString(school->subjects);
+            out.putInt(cityGraph->getEntityVertex(school->schoolID, school));
+
+            int depts = 0;
+            for (DeptNode* dept = school->deptHead; dept != nullptr; dept = dept->next) depts++;
+            out.putInt(depts);
+            for (DeptNode* dept = school->deptHead; dept != nullptr; dept = dept->next) {
+                out.putString(dept->deptName);
+
+                int sections = 0;
+                for (SectionNode* sec = dept->sectionHead; sec != nullptr; sec = sec->next) sections++;
+                out.putInt(sections);
+                for (SectionNode* sec = dept->sectionHead; sec != nullptr; sec = sec->next) {
+                    out.putString(sec->sectionName);
+                    int students = 0;
+                    for (StudentNode* stu = sec->studentHead; stu != nullptr; stu = stu->next) students++;
+                    out.putInt(students);
+                    for (StudentNode* stu = sec->studentHead; stu != nullptr; stu = stu->next) {
+                        out.putString(stu->name);
+                        out.putInt(stu->rollNumber);
+                        out.putString(stu->contactNumber);
+                    }
+                }
 
+                int teachers = 0;
+                for (TeacherNode* t = dept->teacherHead; t != nullptr; t = t->next) teachers++;
+                out.putInt(teachers);
+                for (TeacherNode* t = dept->teacherHead; t != nullptr; t = t->next) {
+                    out.putString(t->name);
+                    out.putInt(t->empID);
+                    out.putString(t->designation);
+                    out.putString(t->subject);
+                }
+            }
+        }
+        out.endSection();
+    }
+
+    bool readSnapshot(CitySnapshotReader& in, CitySnapshotLinks& links) {
+        if (schoolsHead != nullptr || !in.beginSection("EDUCATN")) return false;
+        manualIDCounter = in.getInt();
+
+        int savedSchools = in.getCount();
+        SchoolNode* schoolTail = nullptr;
+        for (int i = 0; i < savedSchools && !in.hasFailed(); i++) {
+            string id = in.getString();
+            string name = in.getString();
+            string sector = in.getString();
+            double lat = in.getDouble();
+            double lon = in.getDouble();
+            double rating = in.getDouble();
+            SchoolNode* school = new SchoolNode(id, name, sector, lat, lon, rating, in.getString());
+            if (schoolTail == nullptr) schoolsHead = school;
+            else schoolTail->next = school;
+            schoolTail = school;
+            schoolCount++;
+            rankingHeap.insert(school);
+            processSubjects(school->subjects, school);
+            links.setEntity(in.getInt(), school);
+
+            int depts = in.getCount();
+            DeptNode* deptTail = nullptr;
+            for (int d = 0; d < depts && !in.hasFailed(); d++) {
+                DeptNode* dept = new DeptNode(in.getString());
+                if (deptTail == nullptr) school->deptHead = dept;
+                else deptTail->next = dept;
+                deptTail = dept;
+                school->deptCount++;
+
+                int sections = in.getCount();
+                SectionNode* secTail = nullptr;
+                for (int c = 0; c < sections && !in.hasFailed(); c++) {
+                    SectionNode* sec = new SectionNode(in.getString());
+                    if (secTail == nullptr) dept->sectionHead = sec;
+                    else secTail->next = sec;
+                    secTail = sec;
+                    dept->sectionCount++;
+
+                    int students = in.getCount();
+                    StudentNode* stuTail = nullptr;
+                    for (int k = 0; k < students && !in.hasFailed(); k++) {
+                        string stuName = in.getString();
+                        int roll = in.getInt();
+                        StudentNode* stu = new StudentNode(stuName, roll, in.getString());
+                        if (stuTail == nullptr) sec->studentHead = stu;
+                        else stuTail->next = stu;
+                        stuTail = stu;
+                        sec->studentCount++;
+                    }
+                }
 
+                int teachers = in.getCount();
+                TeacherNode* teacherTail = nullptr;
+                for (int t = 0; t < teachers && !in.hasFailed(); t++) {
+                    string teacherName = in.getString();
+                    int empID = in.getInt();
+                    string designation = in.getString();
+                    TeacherNode* teacher = new TeacherNode(teacherName, empID, designation, in.getString());
+                    if (teacherTail == nullptr) dept->teacherHead = teacher;
+                    else teacherTail->next = teacher;
+                    teacherTail = teacher;
+                    dept->teacherCount++;
+                }
+            }
+        }
+        return !in.hasFailed();
+    }
 
     int getSchoolCount() {
         return schoolCount;
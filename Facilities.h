@@ -105,14 +105,17 @@ struct AmenityNode {
 };
 
 // Facility Edge Graph Edge for connections
+struct FacilityAdjNode;
+
 struct FacilityEdge {
     string destFacilityID;
     double distance;
     string connectionType; // e.g., "Walking Path", "Road", "Bicycle Lane"
+    FacilityAdjNode* destAdj;   // Destination's adjacency list, to reach the reverse edge
     FacilityEdge* next;
 
     FacilityEdge(const string& dest, double dist, const string& connType = "Road")
-        : destFacilityID(dest), distance(dist), connectionType(connType), next(nullptr) {
+        : destFacilityID(dest), distance(dist), connectionType(connType), destAdj(nullptr), next(nullptr) {
     }
 };
 
@@ -122,8 +125,9 @@ struct FacilityAdjNode {
     string facilityID;
     FacilityEdge* edgeHead;
     FacilityAdjNode* next;
+    int routeIndex;     // Vertex number in the current routing search
 
-    FacilityAdjNode(const string& id) : facilityID(id), edgeHead(nullptr), next(nullptr) {}
+    FacilityAdjNode(const string& id) : facilityID(id), edgeHead(nullptr), next(nullptr), routeIndex(-1) {}
 };
 
 
@@ -148,6 +152,15 @@ struct FacilityNode {
     }
 };
 
+// Spatial index filter: accepts facilities whose type equals *(int*)context
+bool facilityTypeFilter(void* item, void* context) {
+    FacilityNode* facility = (FacilityNode*)((CityLocation*)item)->entityPtr;
+    return facility != nullptr && facility->type == *(int*)context;
+}
+
+// Name of the city graph's maintained fire station tree
+const string HOT_FIRE_STATIONS = "Fire Stations";
+
 
 // Hash Node for Facility Type Search 
 struct FacilityHashNode {
@@ -161,78 +174,8 @@ struct FacilityHashNode {
 };
 
 
-// MIN HEAP FOR DIJKSTRA'S ALGORITHM
-struct FacilityDijkstraNode {
-    string facilityID;
-    double distance;
-};
-
-class FacilityDijkstraHeap {
-private:
-    static const int MAX_SIZE = 500;
-    FacilityDijkstraNode heap[MAX_SIZE];
-    int size;
-
-    void swap(int i, int j) {
-        FacilityDijkstraNode temp = heap[i];
-        heap[i] = heap[j];
-        heap[j] = temp;
-    }
-
-    void siftUp(int i) {
-        while (i > 0) {
-            int parent = (i - 1) / 2;
-            if (heap[i].distance < heap[parent].distance) {
-                swap(i, parent);
-                i = parent;
-            }
-            else break;
-        }
-    }
-
-    void siftDown(int i) {
-        while (true) {
-            int smallest = i;
-            int left = 2 * i + 1;
-            int right = 2 * i + 2;
-
-            if (left < size && heap[left].distance < heap[smallest].distance)
-                smallest = left;
-            if (right < size && heap[right].distance < heap[smallest].distance)
-                smallest = right;
-
-            if (smallest != i) {
-                swap(i, smallest);
-                i = smallest;
-            }
-            else break;
-        }
-    }
-
-public:
-    FacilityDijkstraHeap() : size(0) {}
-
-    bool isEmpty() { return size == 0; }
-
-    void insert(const string& id, double dist) {
-        if (size >= MAX_SIZE) return;
-        heap[size].facilityID = id;
-        heap[size].distance = dist;
-        siftUp(size);
-        size++;
-    }
-
-    FacilityDijkstraNode extractMin() {
-        FacilityDijkstraNode minNode = heap[0];
-        heap[0] = heap[size - 1];
-        size--;
-        if (size > 0)
-            siftDown(0);
-        return minNode;
-    }
-
-    void clear() { size = 0; }
-};
+// Routing engine view of the facility network
+typedef CityLinkedGraph<FacilityAdjNode, FacilityEdge> FacilityRoadGraph;
 
 // FACILITY TYPE HASH TABLE (Separate Chaining)
 class FacilityTypeHashTable {
@@ -543,6 +486,10 @@ private:
 
 public:
     FacilitiesSystem() : facilitiesHead(nullptr), adjListHead(nullptr), facilityCount(0), facilityIDCounter(1) {
+        // Road distance to the nearest fire station stays current through road edits
+        static int fireStationType = FACILITY_FIRE_STATION;
+        CityGraph::getInstance()->registerHotSources(HOT_FIRE_STATIONS, LOC_FACILITY,
+            facilityTypeFilter, &fireStationType);
     }
 
 
@@ -629,10 +576,15 @@ public:
 
         string facilityID = facility->facilityID;
 
-        FacilityAdjNode* adj = adjListHead;
-        while (adj != nullptr) {
-            removeEdgeFromAdjList(adj, facilityID);
-            adj = adj->next;
+        // Remove all edges TO this facility. Paths are stored both ways, so
+        // only this facility's neighbors can hold one
+        FacilityAdjNode* ownAdj = getAdjList(facilityID);
+        if (ownAdj != nullptr) {
+            FacilityEdge* edge = ownAdj->edgeHead;
+            while (edge != nullptr) {
+                if (edge->destAdj != ownAdj) removeEdgeFromAdjList(edge->destAdj, facilityID);
+                edge = edge->next;
+            }
         }
 
         // Remove this facility's adjacency list
@@ -719,6 +671,7 @@ public:
                 typeHash.remove(facility); // Remove from old type bucket
                 facility->type = selectFacilityType();
                 typeHash.insert(facility->type, facility); // Add to new type bucket
+                CityGraph::getInstance()->refreshHotSources(facility->facilityID);
             }
         }
 
@@ -814,6 +767,8 @@ public:
         FacilityEdge* edge2 = new FacilityEdge(facility1->facilityID, distance, connectionType);
         edge2->next = adj2->edgeHead;
         adj2->edgeHead = edge2;
+        edge1->destAdj = adj2;
+        edge2->destAdj = adj1;
 
         cout << "Connected '" << facility1->name << "' <--> '" << facility2->name << "'" << endl;
         cout << "Connection Type: " << connectionType << " | Distance: " << distance << " units" << endl;
@@ -1058,20 +1013,11 @@ public:
         double userLat = getDoubleInput("Enter your Latitude: ");
         double userLon = getDoubleInput("Enter your Longitude: ");
 
-        FacilityNode* nearest = nullptr;
+        // Answered by the city graph's spatial index instead of a full scan
         double minDist = DBL_MAX;
-
-        FacilityNode* current = facilitiesHead;
-        while (current != nullptr) {
-            if (!filterByType || current->type == searchType) {
-                double dist = calculateDistance(userLat, userLon, current->lat, current->lon);
-                if (dist < minDist) {
-                    minDist = dist;
-                    nearest = current;
-                }
-            }
-            current = current->next;
-        }
+        CityLocation* loc = CityGraph::getInstance()->findNearestOfType(userLat, userLon, LOC_FACILITY, minDist,
+            filterByType ? facilityTypeFilter : nullptr, &searchType);
+        FacilityNode* nearest = (loc != nullptr) ? (FacilityNode*)loc->entityPtr : nullptr;
 
         if (nearest != nullptr) {
             cout << "\n=== Nearest " << (filterByType ? facilityTypeToString(searchType) : "Facility") << " ===" << endl;
@@ -1091,6 +1037,42 @@ public:
         }
     }
 
+    // Answered from the city graph's maintained tree, no search per query
+    void findNearestFireStationByRoad() {
+        cout << "\n=== Nearest Fire Station by Road ===" << endl;
+
+        CityGraph* cityGraph = CityGraph::getInstance();
+        string srcID = getStringInput("Enter your Location ID (e.g., Stop1): ");
+        CityLocation* srcLoc = cityGraph->findLocationByID(srcID);
+        if (srcLoc == nullptr) {
+            cout << "Error: Location '" << srcID << "' not found in city graph!" << endl;
+            return;
+        }
+
+        const int MAX_PATH = 500;
+        string path[MAX_PATH];
+        int pathLen = 0;
+        string stationID;
+        double distance = cityGraph->distanceToNearestHot(HOT_FIRE_STATIONS, srcID, stationID,
+            path, pathLen, MAX_PATH);
+
+        if (distance == DBL_MAX) {
+            cout << "No fire station is reachable by road from '" << srcLoc->name << "'." << endl;
+            return;
+        }
+
+        FacilityNode* station = findFacilityByID(stationID);
+        cout << "Fire Station: " << (station ? station->name : stationID) << endl;
+        cout << "Road Distance: " << distance << " units" << endl;
+        cout << "Route: ";
+        for (int i = 0; i < pathLen; i++) {
+            CityLocation* stop = cityGraph->findLocationByID(path[i]);
+            if (i > 0) cout << " -> ";
+            cout << (stop ? stop->name : path[i]);
+        }
+        cout << endl;
+    }
+
     void findFacilityWithAmenity() {
         cout << "\n=== Find Facility with Specific Amenity ===" << endl;
 
@@ -1156,124 +1138,38 @@ public:
             return;
         }
 
-        // Initialize arrays
-        const int MAX_FACILITIES = 500;
-        string facilityIDs[MAX_FACILITIES];
-        double distances[MAX_FACILITIES];
-        string previous[MAX_FACILITIES];
-        bool visited[MAX_FACILITIES];
-        int numFacilities = 0;
-
-        // Collect all facility IDs
-        FacilityNode* current = facilitiesHead;
-        while (current != nullptr && numFacilities < MAX_FACILITIES) {
-            facilityIDs[numFacilities] = current->facilityID;
-            distances[numFacilities] = DBL_MAX;
-            previous[numFacilities] = "";
-            visited[numFacilities] = false;
-            numFacilities++;
-            current = current->next;
-        }
-
-        // Find source index
-        int srcIdx = -1;
-        for (int i = 0; i < numFacilities; i++) {
-            if (stringsEqualIgnoreCase(facilityIDs[i], srcFacility->facilityID)) {
-                srcIdx = i;
-                break;
-            }
-        }
-        if (srcIdx == -1) {
-            cout << "Error: Source facility not in graph!" << endl;
-            return;
-        }
-
-        distances[srcIdx] = 0;
-
-        // Dijkstra's algorithm
-        FacilityDijkstraHeap minHeap;
-        minHeap.insert(srcFacility->facilityID, 0);
+        FacilityAdjNode* srcAdj = getAdjList(srcFacility->facilityID);
+        FacilityAdjNode* destAdj = getAdjList(destFacility->facilityID);
 
-        while (!minHeap.isEmpty()) {
-            FacilityDijkstraNode minNode = minHeap.extractMin();
-            string currentID = minNode.facilityID;
-
-            int currentIdx = -1;
-            for (int i = 0; i < numFacilities; i++) {
-                if (stringsEqualIgnoreCase(facilityIDs[i], currentID)) {
-                    currentIdx = i;
-                    break;
-                }
-            }
-
-            if (currentIdx == -1 || visited[currentIdx]) continue;
-            visited[currentIdx] = true;
-
-            // Process neighbors
-            FacilityAdjNode* adj = getAdjList(currentID);
-            if (adj != nullptr) {
-                FacilityEdge* edge = adj->edgeHead;
-                while (edge != nullptr) {
-                    int neighborIdx = -1;
-                    for (int i = 0; i < numFacilities; i++) {
-                        if (stringsEqualIgnoreCase(facilityIDs[i], edge->destFacilityID)) {
-                            neighborIdx = i;
-                            break;
-                        }
-                    }
-
-                    if (neighborIdx != -1 && !visited[neighborIdx]) {
-                        double newDist = distances[currentIdx] + edge->distance;
-                        if (newDist < distances[neighborIdx]) {
-                            distances[neighborIdx] = newDist;
-                            previous[neighborIdx] = currentID;
-                            minHeap.insert(edge->destFacilityID, newDist);
-                        }
-                    }
-                    edge = edge->next;
-                }
-            }
+        FacilityRoadGraph roads(adjListHead);
+        CitySearchScratch& sc = getCitySearchScratch();
+        int dest = -1;
+        if (srcAdj != nullptr && destAdj != nullptr) {
+            CityUntilTarget goal(destAdj->routeIndex);
+            cityShortestPaths(roads, goal, srcAdj->routeIndex, sc);
+            if (sc.isSettled(destAdj->routeIndex)) dest = destAdj->routeIndex;
         }
 
-        // Find destination index
-        int destIdx = -1;
-        for (int i = 0; i < numFacilities; i++) {
-            if (stringsEqualIgnoreCase(facilityIDs[i], destFacility->facilityID)) {
-                destIdx = i;
-                break;
-            }
-        }
-
-        if (destIdx == -1 || distances[destIdx] == DBL_MAX) {
+        if (dest == -1) {
             cout << "\nNo path exists between '" << srcFacility->name
                 << "' and '" << destFacility->name << "'!" << endl;
             cout << "Tip: Make sure the facilities are connected." << endl;
             return;
         }
 
-        // Reconstruct path
+        // Reconstruct path (destination first)
+        const int MAX_FACILITIES = 500;
         string path[MAX_FACILITIES];
         int pathLen = 0;
-        string currentID = destFacility->facilityID;
-
-        while (!currentID.empty() && pathLen < MAX_FACILITIES) {
-            path[pathLen++] = currentID;
-            int idx = -1;
-            for (int i = 0; i < numFacilities; i++) {
-                if (stringsEqualIgnoreCase(facilityIDs[i], currentID)) {
-                    idx = i;
-                    break;
-                }
-            }
-            if (idx == -1) break;
-            currentID = previous[idx];
+        for (int v = dest; v != -1 && pathLen < MAX_FACILITIES; v = sc.prev[v]) {
+            path[pathLen++] = roads.node(v)->facilityID;
         }
 
         // Display path
         cout << "\n=== Shortest Path Found ===" << endl;
         cout << "From: " << srcFacility->name << endl;
         cout << "To: " << destFacility->name << endl;
-        cout << "Total Distance: " << distances[destIdx] << " units" << endl;
+        cout << "Total Distance: " << sc.dist[dest] << " units" << endl;
         cout << "\nPath: ";
 
         for (int i = pathLen - 1; i >= 0; i--) {
@@ -1458,34 +1354,25 @@ public:
     void loadFromFile() {
         GlobalLocationManager* locMgr = GlobalLocationManager::getInstance();
 
-        ifstream file("facilities.csv");
-        if (!file.is_open()) {
+        CsvReader file("facilities.csv");
+        if (!file.isOpen()) {
             cout << "Warning: facilities.csv not found." << endl;
             return;
         }
 
-        string line;
-        getline(file, line); // Skip header
+        file.readRow(); // Skip header
         int loadedCount = 0;
+        int fallbackSlot = 0;   // Next spot on the unknown-sector diagonal
 
-        while (getline(file, line)) {
-            if (line.empty())
-                continue;
-
-            // Normalize separators
-            for (size_t i = 0; i < line.length(); i++) {
-                if (line[i] == '\t') line[i] = ',';
-            }
-
-            string parts[7];
-            int count = splitString(line, ',', parts, 7);
+        while (file.readRow()) {
+            int count = file.getFieldCount();
 
             if (count >= 5) {
-                string id = trimString(parts[0]);
-                string name = trimString(parts[1]);
-                string typeStr = trimString(parts[2]);
-                string sector = trimString(parts[3]);
-                string timings = trimString(parts[4]);
+                string id = file.getString(0);
+                string name = file.getString(1);
+                string typeStr = file.getString(2);
+                string sector = file.getString(3);
+                string timings = file.getString(4);
 
                 if (findFacilityByID(id) != nullptr || findFacilityByName(name) != nullptr) {
                     continue;
@@ -1515,8 +1402,22 @@ public:
                 else if (sector == "G-9") { lat = 33.700 + facilityOffset; lon = 73.030 + facilityOffset; }
                 else if (sector == "E-7") { lat = 33.740 + facilityOffset; lon = 73.060 + facilityOffset; }
                 else {
-                    lat = 33.700 + (loadedCount * 0.004) + facilityOffset;
-                    lon = 73.000 + (loadedCount * 0.004) + facilityOffset;
+                    // Schools and malls use the same diagonal; step past the
+                    // slots they hold instead of retrying one taken spot
+                    if (fallbackSlot < loadedCount) fallbackSlot = loadedCount;
+                    string occupiedBy;
+                    while (true) {
+                        lat = 33.700 + (fallbackSlot * 0.004) + facilityOffset;
+                        lon = 73.000 + (fallbackSlot * 0.004) + facilityOffset;
+                        if (!locMgr->isLocationOccupied(lat, lon, occupiedBy)) break;
+                        if (!locMgr->isLocationOccupied(lat + 0.001, lon + 0.001, occupiedBy)) {
+                            lat += 0.001;
+                            lon += 0.001;
+                            break;
+                        }
+                        fallbackSlot++;
+                    }
+                    fallbackSlot++;
                 }
 
                 if (!locMgr->registerLocation(lat, lon, "Facility", name)) {
@@ -1531,8 +1432,9 @@ public:
                     lat, lon, openTime, closeTime, is24Hours);
 
                 // Parse rating if available
-                if (count >= 6 && !parts[5].empty()) {
-                    newFacility->rating = stringToDouble(trimString(parts[5]));
+                // Optional; an unreadable rating keeps the default
+                if (count >= 6) {
+                    file.field(5).toDouble(newFacility->rating);
                 }
 
                 newFacility->next = facilitiesHead;
@@ -1553,6 +1455,128 @@ public:
         cout << "Loaded " << loadedCount << " facilities from file." << endl;
     }
 
+    // SNAPSHOT
+
+    // FACILITY section: facilities with their amenities, then the road
+    // lists between facilities; the type index is rebuilt
+    void writeSnapshot(CitySnapshotWriter& out) {
+        CityGraph* cityGraph = CityGraph::getInstance();
+        out.beginSection("FACILITY");
+        out.putInt(facilityIDCounter);
+
+        out.putInt(facilityCount);
+        for (FacilityNode* f = facilitiesHead; f != nullptr; f = f->next) {
+            out.putString(f->facilityID);
+            out.putString(f->name);
+            out.putInt(f->type);
+            out.putString(f->sector);
+            out.putDouble(f->lat);
+            out.putDouble(f->lon);
+            out.putString(f->openingTime);
+            out.putString(f->closingTime);
+            out.putBool(f->isOpen24Hours);
+            out.putDouble(f->rating);
+            out.putInt(cityGraph->getEntityVertex(f->facilityID, f));
+
+            int amenities = 0;
+            for (AmenityNode* a = f->amenityHead; a != nullptr; a = a->next) amenities++;
+            out.putInt(amenities);
+            for (AmenityNode* a = f->amenityHead; a != nullptr; a = a->next) {
+                out.putString(a->name);
+                out.putBool(a->available);
+            }
+        }
+
+        // Edges refer to their destination's list by position
+        int adjCount = 0;
+        for (FacilityAdjNode* adj = adjListHead; adj != nullptr; adj = adj->next) {
+            adj->routeIndex = adjCount++;
+        }
+        out.putInt(adjCount);
+        for (FacilityAdjNode* adj = adjListHead; adj != nullptr; adj = adj->next) {
+            out.putString(adj->facilityID);
+            int edgeCount = 0;
+            for (FacilityEdge* edge = adj->edgeHead; edge != nullptr; edge = edge->next) edgeCount++;
+            out.putInt(edgeCount);
+            for (FacilityEdge* edge = adj->edgeHead; edge != nullptr; edge = edge->next) {
+                out.putString(edge->destFacilityID);
+                out.putDouble(edge->distance);
+                out.putString(edge->connectionType);
+                out.putInt((edge->destAdj != nullptr) ? edge->destAdj->routeIndex : -1);
+            }
+        }
+        for (FacilityAdjNode* adj = adjListHead; adj != nullptr; adj = adj->next) {
+            adj->routeIndex = -1;
+        }
+        out.endSection();
+    }
+
+    bool readSnapshot(CitySnapshotReader& in, CitySnapshotLinks& links) {
+        if (facilitiesHead != nullptr || adjListHead != nullptr) return false;
+        if (!in.beginSection("FACILITY")) return false;
+        facilityIDCounter = in.getInt();
+
+        int savedFacilities = in.getCount();
+        FacilityNode* facilityTail = nullptr;
+        for (int i = 0; i < savedFacilities && !in.hasFailed(); i++) {
+            string id = in.getString();
+            string name = in.getString();
+            int type = in.getInt();
+            string sector = in.getString();
+            double lat = in.getDouble();
+            double lon = in.getDouble();
+            string open = in.getString();
+            string close = in.getString();
+            bool is24 = in.getBool();
+            FacilityNode* f = new FacilityNode(id, name, type, sector, lat, lon, open, close, is24);
+            f->rating = in.getDouble();
+            if (facilityTail == nullptr) facilitiesHead = f;
+            else facilityTail->next = f;
+            facilityTail = f;
+            facilityCount++;
+            typeHash.insert(type, f);
+            links.setEntity(in.getInt(), f);
+
+            int amenities = in.getCount();
+            AmenityNode* amenityTail = nullptr;
+            for (int k = 0; k < amenities && !in.hasFailed(); k++) {
+                string amenityName = in.getString();
+                AmenityNode* amenity = new AmenityNode(amenityName, in.getBool());
+                if (amenityTail == nullptr) f->amenityHead = amenity;
+                else amenityTail->next = amenity;
+                amenityTail = amenity;
+                f->amenityCount++;
+            }
+        }
+
+        // Lists are created up front so edges can point at later ones
+        int adjCount = in.getCount();
+        FacilityAdjNode** adjs = new FacilityAdjNode * [adjCount > 0 ? adjCount : 1];
+        for (int i = 0; i < adjCount; i++) {
+            adjs[i] = new FacilityAdjNode("");
+            if (i == 0) adjListHead = adjs[i];
+            else adjs[i - 1]->next = adjs[i];
+        }
+        for (int i = 0; i < adjCount && !in.hasFailed(); i++) {
+            FacilityAdjNode* adj = adjs[i];
+            adj->facilityID = in.getString();
+            int edgeCount = in.getCount();
+            FacilityEdge* edgeTail = nullptr;
+            for (int e = 0; e < edgeCount && !in.hasFailed(); e++) {
+                string dest = in.getString();
+                double distance = in.getDouble();
+                FacilityEdge* edge = new FacilityEdge(dest, distance, in.getString());
+                int target = in.getInt();
+                if (target >= 0 && target < adjCount) edge->destAdj = adjs[target];
+                if (edgeTail == nullptr) adj->edgeHead = edge;
+                else edgeTail->next = edge;
+                edgeTail = edge;
+            }
+        }
+        delete[] adjs;
+        return !in.hasFailed();
+    }
+
     // Getters
 
     int getFacilityCount() {
@@ -1,5 +1,7 @@
 #pragma once
 #include "Utils.h"
+#include "SpatialIndex.h"
+#include "CitySnapshot.h"
 
 // GLOBAL LOCATION MANAGER
 
@@ -8,20 +10,33 @@ struct LocationNode {
     double lon;
     string entityType;  // "Hospital", "School", "Mall", "Facility", "BusStop"
     string entityName;
+    LocationNode* prev;
     LocationNode* next;
 
     LocationNode(double la, double lo, const string& type, const string& name)
-        : lat(la), lon(lo), entityType(type), entityName(name), next(nullptr) {
+        : lat(la), lon(lo), entityType(type), entityName(name), prev(nullptr), next(nullptr) {
     }
 };
 
 class GlobalLocationManager {
 private:
     LocationNode* head;
+    int locationCount;
+
+    // Spatial hash over the registered nodes. Cells are one match epsilon
+    // wide, so any clash with a point lies in its own or a neighbor cell.
+    SpatialGrid occupancy;
+
     static GlobalLocationManager* instance;
 
     // Singleton Class
-    GlobalLocationManager() : head(nullptr) {}
+    GlobalLocationManager() : head(nullptr), locationCount(0), occupancy(LOCATION_MATCH_EPSILON) {}
+
+    void unlinkNode(LocationNode* node) {
+        if (node->prev != nullptr) node->prev->next = node->next;
+        else head = node->next;
+        if (node->next != nullptr) node->next->prev = node->prev;
+    }
 
 public:
    
@@ -34,6 +49,8 @@ public:
             delete temp;
         }
         head = nullptr;
+        locationCount = 0;
+        occupancy.clear();
     }
     static GlobalLocationManager* getInstance() {
         if (instance == nullptr) {
@@ -44,15 +61,11 @@ public:
 
     // Checks that location occupied or not 
     bool isLocationOccupied(double lat, double lon, string& occupiedBy) {
-        LocationNode* current = head;
-        while (current != nullptr) {
-            if (coordinatesMatch(current->lat, current->lon, lat, lon)) {
-                occupiedBy = current->entityType + ": " + current->entityName;
-                return true;
-            }
-            current = current->next;
-        }
-        return false;
+        LocationNode* match = (LocationNode*)occupancy.findMatch(lat, lon, LOCATION_MATCH_EPSILON);
+        if (match == nullptr) return false;
+
+        occupiedBy = match->entityType + ": " + match->entityName;
+        return true;
     }
 
     // Register new Location
@@ -65,43 +78,62 @@ public:
 
         LocationNode* newNode = new LocationNode(lat, lon, entityType, entityName);
         newNode->next = head;
+        if (head != nullptr) head->prev = newNode;
         head = newNode;
+        locationCount++;
+        occupancy.insert(lat, lon, newNode);
         return true;
     }
 
     // Removes the Location
     bool removeLocation(double lat, double lon) {
-        if (head == nullptr) return false;
-
-        if (coordinatesMatch(head->lat, head->lon, lat, lon)) {
-            LocationNode* temp = head;
-            head = head->next;
-            delete temp;
-            return true;
-        }
+        LocationNode* match = (LocationNode*)occupancy.findMatch(lat, lon, LOCATION_MATCH_EPSILON);
+        if (match == nullptr) return false;
 
-        LocationNode* current = head;
-        while (current->next != nullptr) {
-            if (coordinatesMatch(current->next->lat, current->next->lon, lat, lon)) {
-                LocationNode* temp = current->next;
-                current->next = current->next->next;
-                delete temp;
-                return true;
-            }
-            current = current->next;
-        }
-        return false;
+        occupancy.remove(match->lat, match->lon, match);
+        unlinkNode(match);
+        delete match;
+        locationCount--;
+        return true;
     }
 
     // Tells how many locations are there
     int getLocationCount() {
-        int count = 0;
-        LocationNode* current = head;
-        while (current != nullptr) {
-            count++;
-            current = current->next;
+        return locationCount;
+    }
+
+    // LOCATIONS snapshot section, in list order
+    void writeSnapshot(CitySnapshotWriter& out) {
+        out.beginSection("LOCATNS");
+        out.putInt(locationCount);
+        for (LocationNode* current = head; current != nullptr; current = current->next) {
+            out.putDouble(current->lat);
+            out.putDouble(current->lon);
+            out.putString(current->entityType);
+            out.putString(current->entityName);
+        }
+        out.endSection();
+    }
+
+    // Restore into an empty manager; the saved points were already
+    // checked against each other, so no occupancy test is needed
+    bool readSnapshot(CitySnapshotReader& in) {
+        if (head != nullptr || !in.beginSection("LOCATNS")) return false;
+        int count = in.getCount();
+        LocationNode* tail = nullptr;
+        for (int i = 0; i < count && !in.hasFailed(); i++) {
+            double lat = in.getDouble();
+            double lon = in.getDouble();
+            string type = in.getString();
+            LocationNode* node = new LocationNode(lat, lon, type, in.getString());
+            node->prev = tail;
+            if (tail == nullptr) head = node;
+            else tail->next = node;
+            tail = node;
+            locationCount++;
+            occupancy.insert(lat, lon, node);
         }
-        return count;
+        return !in.hasFailed();
     }
 
     // Displays all the locations 
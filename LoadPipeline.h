@@ -0,0 +1,243 @@
+#pragma once
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "Utils.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// PARALLEL LOAD PIPELINE
+// Loads the modules in three stages. Read pulls every CSV file of a module
+// into memory (the files of one module are read at the same time), parse
+// tokenizes them in chunks on the thread pool, and merge runs the module's
+// own loader over the prefetched rows. A background thread reads and parses
+// the modules in order while the caller merges the ones that are ready, so
+// later modules are already in memory when their turn comes.
+//
+// Merging is the only stage that touches shared state, and it runs on the
+// calling thread, one module at a time in the order the stages were added.
+// GlobalLocationManager and CityGraph therefore keep a single writer and
+// location conflicts resolve exactly as in a sequential load. A loader
+// that opens another stage's file waits for that file alone to be ready.
+// An optional index job (the route hierarchy) starts on its own thread once
+// the stages it depends on are merged, overlapping the merges that follow.
+
+const int CITY_LOAD_MAX_STAGES = 8;
+const int CITY_LOAD_MAX_FILES = 8;
+
+typedef void (*CityLoadFunc)(void* context);
+
+struct CityLoadStage {
+    string title;
+    string files[CITY_LOAD_MAX_FILES];
+    int fileCount;
+    CityLoadFunc merge;
+    void* context;
+
+    CsvTable* tables[CITY_LOAD_MAX_FILES];
+    bool ready;         // Read and parsed (guarded by the pipeline lock)
+
+    // Per-stage timings and sizes
+    double readMs;
+    double parseMs;
+    double mergeMs;
+    long long bytes;
+    long long rows;
+    int chunks;
+
+    CityLoadStage() : fileCount(0), merge(nullptr), context(nullptr), ready(false),
+        readMs(0), parseMs(0), mergeMs(0), bytes(0), rows(0), chunks(0) {
+        for (int i = 0; i < CITY_LOAD_MAX_FILES; i++) tables[i] = nullptr;
+    }
+};
+
+// Chunks of one stage, flattened for parallelFor
+struct CityTokenizeJob {
+    CsvTable** tables;
+    int* chunks;
+};
+
+class CityLoadPipeline {
+private:
+    CityLoadStage stages[CITY_LOAD_MAX_STAGES];
+    int stageCount;
+
+    CityLoadFunc indexJob;
+    void* indexContext;
+    int indexAfter;         // Start the index job once this many stages merged
+    double indexMs;
+
+    thread prefetcher;
+    thread indexer;
+    mutex lock;
+    condition_variable stageReady;
+
+    static double elapsedSince(chrono::steady_clock::time_point start) {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+
+    static void readTask(void* arg, int index) {
+        CityLoadStage* stage = (CityLoadStage*)arg;
+        stage->tables[index]->read();
+    }
+
+    static void tokenizeTask(void* arg, int index) {
+        CityTokenizeJob* job = (CityTokenizeJob*)arg;
+        job->tables[index]->tokenizeChunk(job->chunks[index]);
+    }
+
+    // Read, then parse, one stage after the other (background thread)
+    void prefetchAll() {
+        CityThreadPool* pool = CityThreadPool::getInstance();
+        for (int s = 0; s < stageCount; s++) {
+            CityLoadStage& stage = stages[s];
+
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            pool->parallelFor(stage.fileCount, readTask, &stage);
+            stage.readMs = elapsedSince(start);
+
+            start = chrono::steady_clock::now();
+            int total = 0;
+            for (int f = 0; f < stage.fileCount; f++) {
+                if (stage.tables[f]->isFound()) {
+                    stage.bytes += stage.tables[f]->getSize();
+                    total += stage.tables[f]->splitChunks();
+                }
+            }
+            CityTokenizeJob job;
+            job.tables = new CsvTable*[total > 0 ? total : 1];
+            job.chunks = new int[total > 0 ? total : 1];
+            int n = 0;
+            for (int f = 0; f < stage.fileCount; f++) {
+                if (!stage.tables[f]->isFound()) continue;
+                for (int c = 0; c < stage.tables[f]->getChunkCount(); c++) {
+                    job.tables[n] = stage.tables[f];
+                    job.chunks[n] = c;
+                    n++;
+                }
+            }
+            pool->parallelFor(total, tokenizeTask, &job);
+            delete[] job.tables;
+            delete[] job.chunks;
+            for (int f = 0; f < stage.fileCount; f++) {
+                if (!stage.tables[f]->isFound()) continue;
+                stage.tables[f]->finishChunks();
+                stage.rows += stage.tables[f]->getRowCount();
+            }
+            stage.chunks = total;
+            stage.parseMs = elapsedSince(start);
+
+            // Tables first: a loader of an earlier stage may be waiting for one
+            CsvPrefetchCache* cache = CsvPrefetchCache::getInstance();
+            for (int f = 0; f < stage.fileCount; f++) cache->markReady(stage.tables[f]);
+
+            lock_guard<mutex> guard(lock);
+            stage.ready = true;
+            stageReady.notify_all();
+        }
+    }
+
+    void runIndexJob() {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        indexJob(indexContext);
+        indexMs = elapsedSince(start);
+    }
+
+public:
+    CityLoadPipeline() : stageCount(0), indexJob(nullptr), indexContext(nullptr), indexAfter(0), indexMs(0) {}
+
+    CityLoadPipeline(const CityLoadPipeline&) = delete;
+    CityLoadPipeline& operator=(const CityLoadPipeline&) = delete;
+
+    // Files are the names the module's loader opens; missing ones are fine
+    void addStage(const string& title, const char* const files[], int fileCount, CityLoadFunc merge, void* context) {
+        if (stageCount >= CITY_LOAD_MAX_STAGES) return;
+        CityLoadStage& stage = stages[stageCount++];
+        stage.title = title;
+        stage.fileCount = (fileCount < CITY_LOAD_MAX_FILES) ? fileCount : CITY_LOAD_MAX_FILES;
+        for (int i = 0; i < stage.fileCount; i++) stage.files[i] = files[i];
+        stage.merge = merge;
+        stage.context = context;
+    }
+
+    // Run job on its own thread once the first 'afterStages' stages are
+    // merged. It must not touch what the later stages' loaders change, nor
+    // print or create singletons: whatever it works on is created by the
+    // caller and passed as context, and the caller reports its results
+    // after finish().
+    void setIndexJob(CityLoadFunc job, void* context, int afterStages) {
+        indexJob = job;
+        indexContext = context;
+        indexAfter = afterStages;
+    }
+
+    // Registers the prefetch tables and starts reading in the background
+    void start() {
+        CsvPrefetchCache* cache = CsvPrefetchCache::getInstance();
+        for (int s = 0; s < stageCount; s++) {
+            for (int f = 0; f < stages[s].fileCount; f++) {
+                stages[s].tables[f] = new CsvTable(stages[s].files[f]);
+                cache->add(stages[s].tables[f]);
+            }
+        }
+        prefetcher = thread(&CityLoadPipeline::prefetchAll, this);
+        if (indexJob != nullptr && indexAfter <= 0) {
+            indexer = thread(&CityLoadPipeline::runIndexJob, this);
+        }
+    }
+
+    // Waits for stage s to be read and parsed, then runs its loader on the
+    // calling thread and frees its text. Stages must be merged in order.
+    void mergeStage(int s) {
+        CityLoadStage& stage = stages[s];
+        {
+            unique_lock<mutex> guard(lock);
+            while (!stage.ready) {
+                stageReady.wait(guard);
+            }
+        }
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        stage.merge(stage.context);
+        stage.mergeMs = elapsedSince(start);
+
+        // The prefetcher never touches the cache list, only the tables in it
+        for (int f = 0; f < stage.fileCount; f++) {
+            delete stage.tables[f];
+            stage.tables[f] = nullptr;
+        }
+        CsvPrefetchCache* cache = CsvPrefetchCache::getInstance();
+        cache->clear();
+        for (int t = s + 1; t < stageCount; t++) {
+            for (int f = 0; f < stages[t].fileCount; f++) cache->add(stages[t].tables[f]);
+        }
+
+        if (indexJob != nullptr && s + 1 == indexAfter) {
+            indexer = thread(&CityLoadPipeline::runIndexJob, this);
+        }
+    }
+
+    // Waits for the background threads
+    void finish() {
+        if (prefetcher.joinable()) prefetcher.join();
+        if (indexer.joinable()) indexer.join();
+        CsvPrefetchCache::getInstance()->clear();
+        for (int s = 0; s < stageCount; s++) {
+            for (int f = 0; f < stages[s].fileCount; f++) {
+                delete stages[s].tables[f];
+                stages[s].tables[f] = nullptr;
+            }
+        }
+    }
+
+    int getStageCount() { return stageCount; }
+    CityLoadStage& getStage(int s) { return stages[s]; }
+    double getIndexMs() { return indexMs; }
+
+    ~CityLoadPipeline() {
+        finish();
+    }
+};
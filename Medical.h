@@ -292,6 +292,9 @@ public:
     int getCapacity() { return capacity; }
 };
 
+// Name of the city graph's maintained hospital tree
+const string HOT_HOSPITALS = "Hospitals";
+
 // Medical system manager 
 
 class MedicalSystem {
@@ -365,6 +368,8 @@ private:
 public:
 
     MedicalSystem() : hospitalsHead(nullptr), pharmaciesHead(nullptr), hospitalCount(0), pharmacyCount(0), hospitalIDCounter(1), pharmacyIDCounter(1) {
+        // Road distance to the nearest hospital stays current through road edits
+        CityGraph::getInstance()->registerHotSources(HOT_HOSPITALS, LOC_HOSPITAL);
     }
 
 
@@ -681,18 +686,10 @@ public:
         double userLat = getDoubleInput("Enter your Latitude: ");
         double userLon = getDoubleInput("Enter your Longitude: ");
 
-        HospitalNode* nearest = nullptr;
+        // Answered by the city graph's spatial index instead of a full scan
         double minDist = DBL_MAX;
-
-        HospitalNode* current = hospitalsHead;
-        while (current != nullptr) {
-            double dist = calculateDistance(userLat, userLon, current->lat, current->lon);
-            if (dist < minDist) {
-                minDist = dist;
-                nearest = current;
-            }
-            current = current->next;
-        }
+        CityLocation* loc = CityGraph::getInstance()->findNearestOfType(userLat, userLon, LOC_HOSPITAL, minDist);
+        HospitalNode* nearest = (loc != nullptr) ? (HospitalNode*)loc->entityPtr : nullptr;
 
         if (nearest != nullptr) {
             cout << "\n=== Nearest Hospital ===" << endl;
@@ -704,6 +701,77 @@ public:
         }
     }
 
+    // Nearest hospitals by road distance from any location in the city graph
+    void findNearestHospitalsByRoad() {
+        cout << "\n=== Find Nearest Hospitals by Road ===" << endl;
+
+        if (hospitalsHead == nullptr) {
+            cout << "No hospitals registered." << endl;
+            return;
+        }
+
+        CityGraph* cityGraph = CityGraph::getInstance();
+        string srcID = getStringInput("Enter your Location ID (e.g., Stop1): ");
+        CityLocation* srcLoc = cityGraph->findLocationByID(srcID);
+        if (srcLoc == nullptr) {
+            cout << "Error: Location '" << srcID << "' not found in city graph!" << endl;
+            return;
+        }
+
+        int k = getIntInput("How many hospitals to list? ");
+        if (k <= 0) k = 1;
+        if (k > hospitalCount) k = hospitalCount;
+
+        CityRouteResult* results = new CityRouteResult[k];
+        int found = 0;
+        if (k == 1) {
+            // The nearest one is kept up to date by the city graph, no search needed
+            const int MAX_PATH = 500;
+            string* path = new string[MAX_PATH];
+            int pathLen = 0;
+            string hospitalID;
+            double distance = cityGraph->distanceToNearestHot(HOT_HOSPITALS, srcID, hospitalID,
+                path, pathLen, MAX_PATH);
+            if (distance != DBL_MAX) {
+                // Stored from the location towards the hospital, which is the route
+                results[0].destID = hospitalID;
+                results[0].distance = distance;
+                results[0].path = path;
+                results[0].pathLen = pathLen;
+                found = 1;
+            }
+            else {
+                delete[] path;
+            }
+        }
+        else {
+            found = cityGraph->findKNearestByRoad(srcID, LOC_HOSPITAL, k, results);
+        }
+
+        if (found == 0) {
+            cout << "No hospital is reachable by road from '" << srcLoc->name << "'." << endl;
+        }
+        for (int i = 0; i < found; i++) {
+            CityLocation* loc = cityGraph->findLocationByID(results[i].destID);
+            HospitalNode* hospital = (loc != nullptr) ? (HospitalNode*)loc->entityPtr : nullptr;
+
+            cout << "\n" << (i + 1) << ". " << (hospital ? hospital->name : results[i].destID) << endl;
+            if (hospital != nullptr) {
+                cout << "   Emergency Beds: " << hospital->emergencyBeds << endl;
+            }
+            cout << "   Road Distance: " << results[i].distance << " units" << endl;
+            cout << "   Route: ";
+            for (int j = 0; j < results[i].pathLen; j++) {
+                CityLocation* stop = cityGraph->findLocationByID(results[i].path[j]);
+                if (j > 0) cout << " -> ";
+                cout << (stop ? stop->name : results[i].path[j]);
+            }
+            cout << endl;
+        }
+
+        delete[] results;
+    }
+
 // Pharmacy Operations 
 
     void registerPharmacy() {
@@ -1089,54 +1157,32 @@ public:
     void loadFromFiles() {
         GlobalLocationManager* locMgr = GlobalLocationManager::getInstance();
 
-        auto normalizeSeparators = [](string& s) {
-            for (size_t i = 0; i < s.length(); i++) {
-                if (s[i] == '\t') s[i] = ',';
-            }
-            };
-
-        auto stripQuotes = [](string& s) {
-            s = trimString(s);
-            if (!s.empty() && s[0] == '"') s = s.substr(1);
-            if (!s.empty() && s[s.length() - 1] == '"') s = s.substr(0, s.length() - 1);
-            };
-
         // Load hospitals
-        ifstream hospFile("hospitals.csv");
-        if (hospFile.is_open()) {
-            string line;
-            getline(hospFile, line);
+        CsvReader hospFile("hospitals.csv");
+        if (hospFile.isOpen()) {
+            hospFile.readRow();
             int loadedCount = 0;
 
-            while (getline(hospFile, line)) {
-                if (line.empty()) continue;
-                normalizeSeparators(line);
+            int badRows = 0;
 
-                string parts[6];
-                int count = splitString(line, ',', parts, 6);
+            while (hospFile.readRow()) {
+                int count = hospFile.getFieldCount();
 
                 if (count >= 5) {
-                    string id = trimString(parts[0]);
-                    string name = trimString(parts[1]);
-                    string sector = trimString(parts[2]);
-                    int beds = stringToInt(trimString(parts[3]));
-
-                    string spec = trimString(parts[4]);
-                    if (count == 6 && !parts[5].empty()) {
-                        string part4 = trimString(parts[4]);
-                        string part5 = trimString(parts[5]);
-
-                        if (!part4.empty() && part4[0] == '"') {
-                            part4 = part4.substr(1);
-                        }
-                        if (!part5.empty() && part5[part5.length() - 1] == '"') {
-                            part5 = part5.substr(0, part5.length() - 1);
-                        }
-
-                        spec = part4 + ", " + part5;
+                    int beds;
+                    if (!hospFile.field(3).toInt(beds)) {
+                        badRows++;
+                        continue;
                     }
-                    else {
-                        stripQuotes(spec);
+                    string id = hospFile.getString(0);
+                    string name = hospFile.getString(1);
+                    string sector = hospFile.getString(2);
+
+                    // "Cardiology, Neurology" arrives as one quoted field; an
+                    // unquoted second specialization is kept as before
+                    string spec = hospFile.getString(4);
+                    if (count == 6 && !hospFile.field(5).empty()) {
+                        spec += ", " + hospFile.getString(5);
                     }
 
                     if (findHospitalByID(id) != nullptr || findHospitalByName(name) != nullptr) {
@@ -1199,32 +1245,34 @@ public:
             }
             hospFile.close();
             cout << "Loaded " << loadedCount << " hospitals from file." << endl;
+            if (badRows > 0) {
+                cout << "Skipped " << badRows << " hospitals with an invalid bed count." << endl;
+            }
         }
         else {
             cout << "Warning: hospitals.csv not found." << endl;
         }
 
         // Load pharmacies
-        ifstream pharmFile("pharmacies.csv");
-        if (pharmFile.is_open()) {
-            string line;
-            getline(pharmFile, line);
+        CsvReader pharmFile("pharmacies.csv");
+        if (pharmFile.isOpen()) {
+            pharmFile.readRow();
             int loadedCount = 0;
 
-            while (getline(pharmFile, line)) {
-                if (line.empty()) continue;
-                normalizeSeparators(line);
-
-                string parts[6];
-                int count = splitString(line, ',', parts, 6);
+            int badRows = 0;
 
-                if (count >= 6) {
-                    string id = trimString(parts[0]);
-                    string name = trimString(parts[1]);
-                    string sector = trimString(parts[2]);
-                    string medName = trimString(parts[3]);
-                    string formula = trimString(parts[4]);
-                    int price = stringToInt(trimString(parts[5]));
+            while (pharmFile.readRow()) {
+                if (pharmFile.getFieldCount() >= 6) {
+                    int price;
+                    if (!pharmFile.field(5).toInt(price)) {
+                        badRows++;
+                        continue;
+                    }
+                    string id = pharmFile.getString(0);
+                    string name = pharmFile.getString(1);
+                    string sector = pharmFile.getString(2);
+                    string medName = pharmFile.getString(3);
+                    string formula = pharmFile.getString(4);
 
                     PharmacyNode* pharmacy = findPharmacyByID(id);
                     if (pharmacy == nullptr) {
@@ -1283,12 +1331,145 @@ public:
             }
             pharmFile.close();
             cout << "Loaded " << loadedCount << " pharmacies from file." << endl;
+            if (badRows > 0) {
+                cout << "Skipped " << badRows << " medicines with an invalid price." << endl;
+            }
         }
         else {
             cout << "Warning: pharmacies.csv not found." << endl;
         }
     }
 
+    // SNAPSHOT
+
+    // MEDICAL section: hospitals with their doctors, pharmacies with their
+    // medicine tables bucket by bucket (so lookups find them unchanged)
+    void writeSnapshot(CitySnapshotWriter& out) {
+        CityGraph* cityGraph = CityGraph::getInstance();
+        out.beginSection("MEDICAL");
+        out.putInt(hospitalIDCounter);
+        out.putInt(pharmacyIDCounter);
+
+        out.putInt(hospitalCount);
+        for (HospitalNode* h = hospitalsHead; h != nullptr; h = h->next) {
+            out.putString(h->hospitalID);
+            out.putString(h->name);
+            out.putString(h->sector);
+            out.putDouble(h->lat);
+            out.putDouble(h->lon);
+            out.putInt(h->emergencyBeds);
+            out.putString(h->specialization);
+            out.putInt(cityGraph->getEntityVertex(h->hospitalID, h));
+
+            int doctors = 0;
+            for (DoctorNode* d = h->doctorHead; d != nullptr; d = d->next) doctors++;
+            out.putInt(doctors);
+            for (DoctorNode* d = h->doctorHead; d != nullptr; d = d->next) {
+                out.putString(d->name);
+                out.putString(d->specialization);
+                out.putInt(d->empID);
+            }
+        }
+
+        out.putInt(pharmacyCount);
+        for (PharmacyNode* p = pharmaciesHead; p != nullptr; p = p->next) {
+            out.putString(p->pharmacyID);
+            out.putString(p->name);
+            out.putString(p->sector);
+            out.putDouble(p->lat);
+            out.putDouble(p->lon);
+            out.putInt(cityGraph->getEntityVertex(p->pharmacyID, p));
+
+            out.putInt(p->medTableSize);
+            for (int b = 0; b < p->medTableSize; b++) {
+                int chain = 0;
+                for (MedicineNode* m = p->medTable[b]; m != nullptr; m = m->next) chain++;
+                out.putInt(chain);
+                for (MedicineNode* m = p->medTable[b]; m != nullptr; m = m->next) {
+                    out.putString(m->name);
+                    out.putString(m->formula);
+                    out.putInt(m->price);
+                }
+            }
+        }
+        out.endSection();
+    }
+
+    bool readSnapshot(CitySnapshotReader& in, CitySnapshotLinks& links) {
+        if (hospitalsHead != nullptr || pharmaciesHead != nullptr) return false;
+        if (!in.beginSection("MEDICAL")) return false;
+        hospitalIDCounter = in.getInt();
+        pharmacyIDCounter = in.getInt();
+
+        int savedHospitals = in.getCount();
+        HospitalNode* hospitalTail = nullptr;
+        for (int i = 0; i < savedHospitals && !in.hasFailed(); i++) {
+            string id = in.getString();
+            string name = in.getString();
+            string sector = in.getString();
+            double lat = in.getDouble();
+            double lon = in.getDouble();
+            int beds = in.getInt();
+            HospitalNode* h = new HospitalNode(id, name, sector, lat, lon, beds, in.getString());
+            if (hospitalTail == nullptr) hospitalsHead = h;
+            else hospitalTail->next = h;
+            hospitalTail = h;
+            hospitalCount++;
+            bedHeap.insert(h);
+            links.setEntity(in.getInt(), h);
+
+            int doctors = in.getCount();
+            DoctorNode* doctorTail = nullptr;
+            for (int d = 0; d < doctors && !in.hasFailed(); d++) {
+                string docName = in.getString();
+                string spec = in.getString();
+                DoctorNode* doc = new DoctorNode(docName, spec, in.getInt());
+                if (doctorTail == nullptr) h->doctorHead = doc;
+                else doctorTail->next = doc;
+                doctorTail = doc;
+            }
+        }
+
+        int savedPharmacies = in.getCount();
+        PharmacyNode* pharmacyTail = nullptr;
+        for (int i = 0; i < savedPharmacies && !in.hasFailed(); i++) {
+            string id = in.getString();
+            string name = in.getString();
+            string sector = in.getString();
+            double lat = in.getDouble();
+            double lon = in.getDouble();
+            PharmacyNode* p = new PharmacyNode(id, name, sector, lat, lon);
+            if (pharmacyTail == nullptr) pharmaciesHead = p;
+            else pharmacyTail->next = p;
+            pharmacyTail = p;
+            pharmacyCount++;
+            links.setEntity(in.getInt(), p);
+
+            int tableSize = in.getCount();
+            if (tableSize <= 0) return false;
+            if (tableSize != p->medTableSize) {
+                delete[] p->medTable;
+                p->medTableSize = tableSize;
+                p->medTable = new MedicineNode * [tableSize];
+                for (int b = 0; b < tableSize; b++) p->medTable[b] = nullptr;
+            }
+            for (int b = 0; b < tableSize && !in.hasFailed(); b++) {
+                int chain = in.getCount();
+                MedicineNode* medTail = nullptr;
+                for (int m = 0; m < chain && !in.hasFailed(); m++) {
+                    string medName = in.getString();
+                    string formula = in.getString();
+                    MedicineNode* med = new MedicineNode(medName, formula, in.getInt());
+                    if (medTail == nullptr) p->medTable[b] = med;
+                    else medTail->next = med;
+                    medTail = med;
+                    p->medicineCount++;
+                }
+            }
+        }
+        return !in.hasFailed();
+    }
+
     // Getters
 
     int getHospitalCount() {
@@ -0,0 +1,210 @@
+#pragma once
+#include "Utils.h"
+#include <mutex>
+
+using namespace std;
+
+// SHORTEST PATH RESULT CACHE
+// Bounded LRU cache of (source, destination, mode) -> distance + path.
+// Every entry remembers the graph version it was computed on; a lookup
+// with a newer version treats it as a miss and drops it, so callers only
+// have to bump their version counter whenever the graph changes.
+
+const int PATH_CACHE_DEFAULT_CAPACITY = 1024;
+
+struct PathCacheEntry {
+    string key;             // lowercased "src|dest|mode"
+    unsigned int version;
+    double distance;
+    string* path;
+    int pathLen;
+
+    PathCacheEntry* hashNext;   // Bucket chain
+    PathCacheEntry* prev;       // Recency list, most recent first
+    PathCacheEntry* next;
+
+    PathCacheEntry(const string& k) : key(k), version(0), distance(DBL_MAX), path(nullptr), pathLen(0),
+        hashNext(nullptr), prev(nullptr), next(nullptr) {}
+    ~PathCacheEntry() { delete[] path; }
+};
+
+class CityPathCache {
+private:
+    PathCacheEntry** table;
+    int tableSize;
+    int capacity;
+    int size;
+    PathCacheEntry* newest;
+    PathCacheEntry* oldest;
+
+    long long hits;
+    long long misses;
+    long long staleDrops;
+
+    mutex lock;
+
+    string makeKey(const string& src, const string& dest, int mode) {
+        return toLowerStr(src) + "|" + toLowerStr(dest) + "|" + intToString(mode);
+    }
+
+    PathCacheEntry* findEntry(const string& key) {
+        PathCacheEntry* current = table[polynomialHash(key, tableSize)];
+        while (current != nullptr) {
+            if (current->key == key) return current;
+            current = current->hashNext;
+        }
+        return nullptr;
+    }
+
+    void unlinkRecency(PathCacheEntry* entry) {
+        if (entry->prev != nullptr) entry->prev->next = entry->next;
+        else newest = entry->next;
+        if (entry->next != nullptr) entry->next->prev = entry->prev;
+        else oldest = entry->prev;
+        entry->prev = entry->next = nullptr;
+    }
+
+    void pushNewest(PathCacheEntry* entry) {
+        entry->prev = nullptr;
+        entry->next = newest;
+        if (newest != nullptr) newest->prev = entry;
+        newest = entry;
+        if (oldest == nullptr) oldest = entry;
+    }
+
+    void removeEntry(PathCacheEntry* entry) {
+        int index = polynomialHash(entry->key, tableSize);
+        if (table[index] == entry) {
+            table[index] = entry->hashNext;
+        }
+        else {
+            PathCacheEntry* current = table[index];
+            while (current->hashNext != entry) {
+                current = current->hashNext;
+            }
+            current->hashNext = entry->hashNext;
+        }
+        unlinkRecency(entry);
+        delete entry;
+        size--;
+    }
+
+public:
+    CityPathCache(int cap = PATH_CACHE_DEFAULT_CAPACITY) : capacity(cap), size(0), newest(nullptr),
+        oldest(nullptr), hits(0), misses(0), staleDrops(0) {
+        // Keep the chains short: about one entry per bucket when full
+        tableSize = 64;
+        while (tableSize < capacity) tableSize *= 2;
+        table = new PathCacheEntry * [tableSize];
+        for (int i = 0; i < tableSize; i++) {
+            table[i] = nullptr;
+        }
+    }
+
+    CityPathCache(const CityPathCache&) = delete;
+    CityPathCache& operator=(const CityPathCache&) = delete;
+
+    // On a hit copies the first maxPathLen stops of the cached route into path[]
+    bool lookup(const string& src, const string& dest, int mode, unsigned int version,
+        double& distance, string path[], int& pathLen, int maxPathLen) {
+        if (capacity <= 0) return false;
+        lock_guard<mutex> guard(lock);
+
+        PathCacheEntry* entry = findEntry(makeKey(src, dest, mode));
+        if (entry != nullptr && entry->version != version) {
+            removeEntry(entry);
+            staleDrops++;
+            entry = nullptr;
+        }
+        if (entry == nullptr) {
+            misses++;
+            return false;
+        }
+
+        hits++;
+        unlinkRecency(entry);
+        pushNewest(entry);
+
+        distance = entry->distance;
+        pathLen = (entry->pathLen < maxPathLen) ? entry->pathLen : maxPathLen;
+        for (int i = 0; i < pathLen; i++) {
+            path[i] = entry->path[i];
+        }
+        return true;
+    }
+
+    // Remember a result (distance DBL_MAX = no route), evicting the least
+    // recently used entry when full
+    void store(const string& src, const string& dest, int mode, unsigned int version,
+        double distance, const string path[], int pathLen) {
+        if (capacity <= 0) return;
+        lock_guard<mutex> guard(lock);
+
+        string key = makeKey(src, dest, mode);
+        PathCacheEntry* entry = findEntry(key);
+        if (entry != nullptr) {
+            removeEntry(entry);
+        }
+        if (size >= capacity) {
+            removeEntry(oldest);
+        }
+
+        entry = new PathCacheEntry(key);
+        entry->version = version;
+        entry->distance = distance;
+        entry->pathLen = pathLen;
+        entry->path = new string[pathLen > 0 ? pathLen : 1];
+        for (int i = 0; i < pathLen; i++) {
+            entry->path[i] = path[i];
+        }
+
+        int index = polynomialHash(key, tableSize);
+        entry->hashNext = table[index];
+        table[index] = entry;
+        pushNewest(entry);
+        size++;
+    }
+
+    void clear() {
+        lock_guard<mutex> guard(lock);
+        while (newest != nullptr) {
+            PathCacheEntry* temp = newest;
+            newest = newest->next;
+            delete temp;
+        }
+        oldest = nullptr;
+        for (int i = 0; i < tableSize; i++) {
+            table[i] = nullptr;
+        }
+        size = 0;
+    }
+
+    // 0 disables caching
+    void setCapacity(int cap) {
+        clear();
+        lock_guard<mutex> guard(lock);
+        capacity = cap;
+    }
+
+    long long getHits() { return hits; }
+    long long getMisses() { return misses; }
+    long long getStaleDrops() { return staleDrops; }
+    int getSize() { return size; }
+    int getCapacity() { return capacity; }
+
+    double getHitRate() {
+        long long total = hits + misses;
+        return (total == 0) ? 0.0 : 100.0 * hits / total;
+    }
+
+    void displayStats(const string& title) {
+        cout << title << ": " << hits << " hits, " << misses << " misses ("
+            << getHitRate() << "% hit rate), " << size << "/" << capacity << " entries, "
+            << staleDrops << " invalidated" << endl;
+    }
+
+    ~CityPathCache() {
+        clear();
+        delete[] table;
+    }
+};
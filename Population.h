@@ -48,36 +48,83 @@ struct CNICHashEntry {
     string sector;
     string street;
     string house;
+    unsigned int hash;
     CNICHashEntry* next;
 
     CNICHashEntry(const string& c, Citizen* ptr, const string& sec,
         const string& str, const string& h)
-        : cnic(c), citizenPtr(ptr), sector(sec), street(str), house(h), next(nullptr) {
+        : cnic(c), citizenPtr(ptr), sector(sec), street(str), house(h), hash(0), next(nullptr) {
     }
 };
 
 class CNICHashTable {
 private:
-    static const int TABLE_SIZE = 500;
-    CNICHashEntry* table[TABLE_SIZE];
+    static const int INITIAL_SIZE = 500;
+    CNICHashEntry** table;
+    int tableSize;
     int count;
 
-    int hashFunc(const string& cnic) {
-        return polynomialHash(cnic, TABLE_SIZE);
+    // FNV-1a over the CNIC; entries keep it so growing never rehashes text
+    static unsigned int hashKey(const string& cnic) {
+        unsigned int hash = 2166136261u;
+        for (size_t i = 0; i < cnic.length(); i++) {
+            hash = (hash ^ (unsigned char)cnic[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    int hashFunc(unsigned int hash) {
+        return (int)(hash % (unsigned int)tableSize);
+    }
+
+    void resize(int newSize) {
+        CNICHashEntry** old = table;
+        int oldSize = tableSize;
+        tableSize = newSize;
+        table = new CNICHashEntry*[tableSize];
+        for (int i = 0; i < tableSize; i++) {
+            table[i] = nullptr;
+        }
+        for (int i = 0; i < oldSize; i++) {
+            while (old[i] != nullptr) {
+                CNICHashEntry* entry = old[i];
+                old[i] = entry->next;
+                int idx = hashFunc(entry->hash);
+                entry->next = table[idx];
+                table[idx] = entry;
+            }
+        }
+        delete[] old;
+    }
+
+    // Doubles the bucket array once chains average more than two entries
+    void growIfNeeded() {
+        if (count > tableSize * 2) resize(tableSize * 2);
+    }
+
+    void link(CNICHashEntry* entry) {
+        int idx = hashFunc(entry->hash);
+        entry->next = table[idx];
+        table[idx] = entry;
+        count++;
+        growIfNeeded();
     }
 
 public:
-    CNICHashTable() : count(0) {
-        for (int i = 0; i < TABLE_SIZE; i++) {
+    CNICHashTable() : table(new CNICHashEntry*[INITIAL_SIZE]), tableSize(INITIAL_SIZE), count(0) {
+        for (int i = 0; i < tableSize; i++) {
             table[i] = nullptr;
         }
     }
 
+    CNICHashTable(const CNICHashTable&) = delete;
+    CNICHashTable& operator=(const CNICHashTable&) = delete;
+
     void insert(const string& cnic, Citizen* citizen, const string& sector,
         const string& street, const string& house) {
-        int idx = hashFunc(cnic);
+        unsigned int hash = hashKey(cnic);
 
-        CNICHashEntry* current = table[idx];
+        CNICHashEntry* current = table[hashFunc(hash)];
         while (current != nullptr) {
             if (current->cnic == cnic) {
                 current->citizenPtr = citizen;
@@ -90,13 +137,25 @@ public:
         }
 
         CNICHashEntry* newEntry = new CNICHashEntry(cnic, citizen, sector, street, house);
-        newEntry->next = table[idx];
-        table[idx] = newEntry;
-        count++;
+        newEntry->hash = hash;
+        link(newEntry);
+    }
+
+    // For CNICs already known to be unique (e.g. read back from the B-tree)
+    void insertUnique(const string& cnic, Citizen* citizen, const string& sector,
+        const string& street, const string& house) {
+        CNICHashEntry* newEntry = new CNICHashEntry(cnic, citizen, sector, street, house);
+        newEntry->hash = hashKey(cnic);
+        link(newEntry);
+    }
+
+    // Sizes the buckets for 'expected' entries up front (bulk loads)
+    void reserve(int expected) {
+        if (expected > tableSize) resize(expected);
     }
 
     CNICHashEntry* search(const string& cnic) {
-        int idx = hashFunc(cnic);
+        int idx = hashFunc(hashKey(cnic));
         CNICHashEntry* current = table[idx];
         while (current != nullptr) {
             if (current->cnic == cnic)
@@ -107,7 +166,7 @@ public:
     }
 
     bool remove(const string& cnic) {
-        int idx = hashFunc(cnic);
+        int idx = hashFunc(hashKey(cnic));
 
         if (table[idx] == nullptr)
             return false;
@@ -144,7 +203,7 @@ public:
 
     void getCitizensBySector(const string& sector, Citizen** results, int& resultCount, int maxResults) {
         resultCount = 0;
-        for (int i = 0; i < TABLE_SIZE && resultCount < maxResults; i++) {
+        for (int i = 0; i < tableSize && resultCount < maxResults; i++) {
             CNICHashEntry* current = table[i];
             while (current != nullptr && resultCount < maxResults) {
                 if (stringsEqualIgnoreCase(current->sector, sector) && current->citizenPtr != nullptr) {
@@ -158,7 +217,7 @@ public:
     void getCitizensByStreet(const string& sector, const string& street,
         Citizen** results, int& resultCount, int maxResults) {
         resultCount = 0;
-        for (int i = 0; i < TABLE_SIZE && resultCount < maxResults; i++) {
+        for (int i = 0; i < tableSize && resultCount < maxResults; i++) {
             CNICHashEntry* current = table[i];
             while (current != nullptr && resultCount < maxResults) {
                 if (stringsEqualIgnoreCase(current->sector, sector) &&
@@ -174,7 +233,7 @@ public:
     void getCitizensByHouse(const string& sector, const string& street, const string& house,
         Citizen** results, int& resultCount, int maxResults) {
         resultCount = 0;
-        for (int i = 0; i < TABLE_SIZE && resultCount < maxResults; i++) {
+        for (int i = 0; i < tableSize && resultCount < maxResults; i++) {
             CNICHashEntry* current = table[i];
             while (current != nullptr && resultCount < maxResults) {
                 if (stringsEqualIgnoreCase(current->sector, sector) &&
@@ -189,13 +248,14 @@ public:
     }
 
     ~CNICHashTable() {
-        for (int i = 0; i < TABLE_SIZE; i++) {
+        for (int i = 0; i < tableSize; i++) {
             while (table[i] != nullptr) {
                 CNICHashEntry* temp = table[i];
                 table[i] = table[i]->next;
                 delete temp;
             }
         }
+        delete[] table;
     }
 };
 
@@ -226,75 +286,204 @@ struct HierarchyNode {
     }
 };
 
-class HierarchyTree {
+// Finds a child by type and ID (ignoring case) without walking the sibling
+// list; sectors are indexed under a null parent
+struct HierarchyIndexEntry {
+    HierarchyNode* parent;
+    HierarchyNode* node;
+    unsigned int hash;
+    HierarchyIndexEntry* next;
+};
+
+class HierarchyIndex {
 private:
-    HierarchyNode* root;
+    HierarchyIndexEntry** buckets;
+    int bucketCount;    // Power of two
+    int count;
 
-    HierarchyNode* findOrCreateSector(const string& sectorID, const string& sectorName) {
-        if (root == nullptr) {
-            root = new HierarchyNode(sectorID, sectorName, NODE_SECTOR);
-            return root;
+    static unsigned int hashKey(HierarchyNode* parent, int type, const string& id) {
+        unsigned int hash = 2166136261u ^ (unsigned int)type;
+        for (size_t i = 0; i < id.length(); i++) {
+            char c = id[i];
+            if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+            hash = (hash ^ (unsigned char)c) * 16777619u;
+        }
+        unsigned long long p = (unsigned long long)(size_t)parent;
+        return hash ^ (unsigned int)(p ^ (p >> 32)) * 2654435761u;
+    }
+
+    void grow() {
+        int newCount = bucketCount * 2;
+        HierarchyIndexEntry** grown = new HierarchyIndexEntry*[newCount];
+        for (int i = 0; i < newCount; i++) grown[i] = nullptr;
+        for (int i = 0; i < bucketCount; i++) {
+            while (buckets[i] != nullptr) {
+                HierarchyIndexEntry* entry = buckets[i];
+                buckets[i] = entry->next;
+                int idx = (int)(entry->hash & (unsigned int)(newCount - 1));
+                entry->next = grown[idx];
+                grown[idx] = entry;
+            }
         }
+        delete[] buckets;
+        buckets = grown;
+        bucketCount = newCount;
+    }
 
-        HierarchyNode* current = root;
-        while (current != nullptr) {
-            if (current->type == NODE_SECTOR && stringsEqualIgnoreCase(current->id, sectorID)) {
-                return current;
+public:
+    HierarchyIndex() : buckets(new HierarchyIndexEntry*[64]), bucketCount(64), count(0) {
+        for (int i = 0; i < bucketCount; i++) buckets[i] = nullptr;
+    }
+
+    HierarchyIndex(const HierarchyIndex&) = delete;
+    HierarchyIndex& operator=(const HierarchyIndex&) = delete;
+
+    HierarchyNode* find(HierarchyNode* parent, int type, const string& id) {
+        unsigned int hash = hashKey(parent, type, id);
+        for (HierarchyIndexEntry* entry = buckets[hash & (unsigned int)(bucketCount - 1)]; entry != nullptr; entry = entry->next) {
+            if (entry->hash == hash && entry->parent == parent && entry->node->type == type &&
+                stringsEqualIgnoreCase(entry->node->id, id)) {
+                return entry->node;
             }
-            current = current->nextSibling;
         }
+        return nullptr;
+    }
+
+    // Keeps the first node added for a key, like the sibling scans it replaces
+    void add(HierarchyNode* parent, HierarchyNode* node) {
+        if (find(parent, node->type, node->id) != nullptr) return;
+        if (count >= bucketCount) grow();
+        HierarchyIndexEntry* entry = new HierarchyIndexEntry;
+        entry->parent = parent;
+        entry->node = node;
+        entry->hash = hashKey(parent, node->type, node->id);
+        int idx = (int)(entry->hash & (unsigned int)(bucketCount - 1));
+        entry->next = buckets[idx];
+        buckets[idx] = entry;
+        count++;
+    }
+
+    void clear() {
+        for (int i = 0; i < bucketCount; i++) {
+            while (buckets[i] != nullptr) {
+                HierarchyIndexEntry* entry = buckets[i];
+                buckets[i] = entry->next;
+                delete entry;
+            }
+        }
+        count = 0;
+    }
+
+    ~HierarchyIndex() {
+        clear();
+        delete[] buckets;
+    }
+};
+
+// Family node of one (sector, street, house) during a bulk insert
+struct HouseholdSlot {
+    unsigned int hash;
+    Citizen* first;         // The household's first citizen, compared against
+    HierarchyNode* family;  // nullptr while the slot is free
+};
+
+class HierarchyTree {
+private:
+    HierarchyNode* root;
+    HierarchyIndex index;
+
+    HierarchyNode* findOrCreateSector(const string& sectorID, const string& sectorName) {
+        HierarchyNode* found = index.find(nullptr, NODE_SECTOR, sectorID);
+        if (found != nullptr) return found;
 
         HierarchyNode* newSector = new HierarchyNode(sectorID, sectorName, NODE_SECTOR);
         newSector->nextSibling = root;
         root = newSector;
+        index.add(nullptr, newSector);
         return newSector;
     }
 
     HierarchyNode* findOrCreateStreet(HierarchyNode* sector, const string& streetID, const string& streetName) {
-        HierarchyNode* current = sector->firstChild;
-        while (current != nullptr) {
-            if (current->type == NODE_STREET && stringsEqualIgnoreCase(current->id, streetID)) {
-                return current;
-            }
-            current = current->nextSibling;
-        }
+        HierarchyNode* found = index.find(sector, NODE_STREET, streetID);
+        if (found != nullptr) return found;
 
         HierarchyNode* newStreet = new HierarchyNode(streetID, streetName, NODE_STREET);
         newStreet->nextSibling = sector->firstChild;
         sector->firstChild = newStreet;
+        index.add(sector, newStreet);
         return newStreet;
     }
 
     HierarchyNode* findOrCreateHouse(HierarchyNode* street, const string& houseID, const string& houseName) {
-        HierarchyNode* current = street->firstChild;
-        while (current != nullptr) {
-            if (current->type == NODE_HOUSE && stringsEqualIgnoreCase(current->id, houseID)) {
-                return current;
-            }
-            current = current->nextSibling;
-        }
+        HierarchyNode* found = index.find(street, NODE_HOUSE, houseID);
+        if (found != nullptr) return found;
 
         HierarchyNode* newHouse = new HierarchyNode(houseID, houseName, NODE_HOUSE);
         newHouse->nextSibling = street->firstChild;
         street->firstChild = newHouse;
+        index.add(street, newHouse);
         return newHouse;
     }
 
     HierarchyNode* findOrCreateFamily(HierarchyNode* house, const string& familyID) {
-        HierarchyNode* current = house->firstChild;
-        while (current != nullptr) {
-            if (current->type == NODE_FAMILY && stringsEqualIgnoreCase(current->id, familyID)) {
-                return current;
-            }
-            current = current->nextSibling;
-        }
+        HierarchyNode* found = index.find(house, NODE_FAMILY, familyID);
+        if (found != nullptr) return found;
 
         HierarchyNode* newFamily = new HierarchyNode(familyID, "Family", NODE_FAMILY);
         newFamily->nextSibling = house->firstChild;
         house->firstChild = newFamily;
+        index.add(house, newFamily);
         return newFamily;
     }
 
+    HierarchyNode* findOrCreateFamilyOf(Citizen* citizen) {
+        string sectorID = citizen->sector;
+        string streetID = sectorID + "-ST" + citizen->streetNumber;
+        string houseID = streetID + "-H" + citizen->houseNumber;
+        string familyID = houseID + "-FAM";
+
+        HierarchyNode* sector = findOrCreateSector(sectorID, citizen->sector);
+        HierarchyNode* street = findOrCreateStreet(sector, streetID, "Street " + citizen->streetNumber);
+        HierarchyNode* house = findOrCreateHouse(street, houseID, "House " + citizen->houseNumber);
+        return findOrCreateFamily(house, familyID);
+    }
+
+    // Same (sector, street, house) ignoring case, i.e. the same family node
+    static unsigned int householdHash(Citizen* citizen) {
+        const string* parts[3] = { &citizen->sector, &citizen->streetNumber, &citizen->houseNumber };
+        unsigned int hash = 2166136261u;
+        for (int p = 0; p < 3; p++) {
+            for (size_t i = 0; i < parts[p]->length(); i++) {
+                char c = (*parts[p])[i];
+                if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+                hash = (hash ^ (unsigned char)c) * 16777619u;
+            }
+            hash = (hash ^ 0xffu) * 16777619u;
+        }
+        return hash;
+    }
+
+    static bool sameHousehold(Citizen* a, Citizen* b) {
+        return stringsEqualIgnoreCase(a->sector, b->sector) &&
+            stringsEqualIgnoreCase(a->streetNumber, b->streetNumber) &&
+            stringsEqualIgnoreCase(a->houseNumber, b->houseNumber);
+    }
+
+    static void growHouseholds(HouseholdSlot*& slots, int& slotCount) {
+        int newCount = slotCount * 2;
+        HouseholdSlot* grown = new HouseholdSlot[newCount];
+        for (int i = 0; i < newCount; i++) grown[i].family = nullptr;
+        for (int i = 0; i < slotCount; i++) {
+            if (slots[i].family == nullptr) continue;
+            int s = (int)(slots[i].hash & (unsigned int)(newCount - 1));
+            while (grown[s].family != nullptr) s = (s + 1) & (newCount - 1);
+            grown[s] = slots[i];
+        }
+        delete[] slots;
+        slots = grown;
+        slotCount = newCount;
+    }
+
     void addCitizenToFamily(HierarchyNode* family, Citizen* citizen) {
         FamilyMember* newMember = new FamilyMember(citizen);
         newMember->next = family->familyMembers;
@@ -357,6 +546,67 @@ private:
         delete node;
     }
 
+    // Sibling list followed by each sibling's children, depth first
+    void writeNodes(CitySnapshotWriter& out, HierarchyNode* first) {
+        int siblings = 0;
+        for (HierarchyNode* node = first; node != nullptr; node = node->nextSibling) siblings++;
+        out.putInt(siblings);
+
+        for (HierarchyNode* node = first; node != nullptr; node = node->nextSibling) {
+            out.putString(node->id);
+            out.putString(node->name);
+            out.putInt(node->type);
+
+            int members = 0;
+            for (FamilyMember* m = node->familyMembers; m != nullptr; m = m->next) members++;
+            out.putInt(members);
+            for (FamilyMember* m = node->familyMembers; m != nullptr; m = m->next) {
+                out.putString(m->citizen->cnic);
+            }
+            writeNodes(out, node->firstChild);
+        }
+    }
+
+    static Citizen* findInSorted(Citizen** sorted, int count, const string& cnic) {
+        int lo = 0, hi = count - 1;
+        while (lo <= hi) {
+            int mid = lo + (hi - lo) / 2;
+            int cmp = sorted[mid]->cnic.compare(cnic);
+            if (cmp == 0) return sorted[mid];
+            if (cmp < 0) lo = mid + 1;
+            else hi = mid - 1;
+        }
+        return nullptr;
+    }
+
+    HierarchyNode* readNodes(CitySnapshotReader& in, Citizen** sorted, int count, HierarchyNode* parent) {
+        HierarchyNode* first = nullptr;
+        HierarchyNode* tail = nullptr;
+        int siblings = in.getCount();
+        for (int i = 0; i < siblings && !in.hasFailed(); i++) {
+            string id = in.getString();
+            string name = in.getString();
+            HierarchyNode* node = new HierarchyNode(id, name, in.getInt());
+            if (tail == nullptr) first = node;
+            else tail->nextSibling = node;
+            tail = node;
+            index.add(parent, node);
+
+            int members = in.getCount();
+            FamilyMember* memberTail = nullptr;
+            for (int m = 0; m < members && !in.hasFailed(); m++) {
+                Citizen* citizen = findInSorted(sorted, count, in.getString());
+                if (citizen == nullptr) continue;
+                FamilyMember* member = new FamilyMember(citizen);
+                if (memberTail == nullptr) node->familyMembers = member;
+                else memberTail->next = member;
+                memberTail = member;
+            }
+            node->firstChild = readNodes(in, sorted, count, node);
+        }
+        return first;
+    }
+
     void displayTreeRecursive(HierarchyNode* node, int level, const string& prefix) {
         if (node == nullptr) return;
 
@@ -402,18 +652,50 @@ public:
 
     void insertCitizen(Citizen* citizen) {
         if (citizen == nullptr) return;
+        addCitizenToFamily(findOrCreateFamilyOf(citizen), citizen);
+    }
 
-        string sectorID = citizen->sector;
-        string streetID = sectorID + "-ST" + citizen->streetNumber;
-        string houseID = streetID + "-H" + citizen->houseNumber;
-        string familyID = houseID + "-FAM";
+    // insertCitizen for each citizen, in order. Houses usually have several
+    // residents, so families are cached by household and only the first
+    // resident of each builds IDs and walks the index.
+    void insertCitizens(Citizen** citizens, int count) {
+        int slotCount = 1024, used = 0;
+        HouseholdSlot* slots = new HouseholdSlot[slotCount];
+        for (int i = 0; i < slotCount; i++) slots[i].family = nullptr;
 
-        HierarchyNode* sector = findOrCreateSector(sectorID, citizen->sector);
-        HierarchyNode* street = findOrCreateStreet(sector, streetID, "Street " + citizen->streetNumber);
-        HierarchyNode* house = findOrCreateHouse(street, houseID, "House " + citizen->houseNumber);
-        HierarchyNode* family = findOrCreateFamily(house, familyID);
+        for (int i = 0; i < count; i++) {
+            Citizen* citizen = citizens[i];
+            if (citizen == nullptr) continue;
+
+            unsigned int hash = householdHash(citizen);
+            int s = (int)(hash & (unsigned int)(slotCount - 1));
+            while (slots[s].family != nullptr &&
+                !(slots[s].hash == hash && sameHousehold(slots[s].first, citizen))) {
+                s = (s + 1) & (slotCount - 1);
+            }
+            HierarchyNode* family = slots[s].family;
+            if (family == nullptr) {
+                family = findOrCreateFamilyOf(citizen);
+                slots[s].hash = hash;
+                slots[s].first = citizen;
+                slots[s].family = family;
+                if (++used * 2 > slotCount) growHouseholds(slots, slotCount);
+            }
+            addCitizenToFamily(family, citizen);
+        }
+        delete[] slots;
+    }
+
+    void writeSnapshot(CitySnapshotWriter& out) {
+        writeNodes(out, root);
+    }
 
-        addCitizenToFamily(family, citizen);
+    // Rebuilds the tree node by node in its saved sibling order. Members
+    // are resolved against the citizens sorted by CNIC.
+    bool readSnapshot(CitySnapshotReader& in, Citizen** sorted, int count) {
+        if (root != nullptr) return false;
+        root = readNodes(in, sorted, count, nullptr);
+        return !in.hasFailed();
     }
 
     void removeCitizen(const string& cnic) {
@@ -470,6 +752,12 @@ const int B_TREE_ORDER = 6;
 const int MAX_KEYS = B_TREE_ORDER - 1;       // 5
 const int MIN_KEYS = (B_TREE_ORDER - 1) / 2; // 2
 
+// Called for each citizen by CitizenBTree::forEachCitizen
+typedef void (*CitizenVisitor)(Citizen* citizen, void* context);
+
+// Fills slot with the citizen at position 'index' of a bulk load's sorted input
+typedef void (*CitizenSource)(Citizen& slot, int index, void* context);
+
 struct BTreeNode {
     Citizen keys[MAX_KEYS];
     BTreeNode* children[B_TREE_ORDER];
@@ -925,6 +1213,22 @@ private:
         }
     }
 
+    void visitNode(BTreeNode* node, CitizenVisitor visit, void* context) {
+        if (node == nullptr)
+            return;
+
+        for (int i = 0; i < node->keyCount; i++) {
+            if (!node->isLeaf) {
+                visitNode(node->children[i], visit, context);
+            }
+            visit(&node->keys[i], context);
+        }
+
+        if (!node->isLeaf) {
+            visitNode(node->children[node->keyCount], visit, context);
+        }
+    }
+
     void displayNode(BTreeNode* node, int level) {
         if (node == nullptr)
             return;
@@ -978,11 +1282,40 @@ private:
         return 1 + getHeight(node->children[0]);
     }
 
+    // BULK LOADING
+
+    // Nodes for one level of a bulk load holding 'keys' keys, each node
+    // about 'target' keys; the keys between nodes move up a level
+    static int bulkNodeCount(int keys, int target) {
+        int nodes = (keys + 1 + target) / (target + 1);
+        int most = (keys + 1) / (MIN_KEYS + 1);
+        if (nodes > most) nodes = most;
+        if (nodes < 1) nodes = 1;
+        return nodes;
+    }
+
+    // Keys per node for a fill factor (share of MAX_KEYS), at least MIN_KEYS
+    static int bulkTarget(double fillFactor) {
+        int target = (int)(fillFactor * MAX_KEYS + 0.5);
+        if (target < MIN_KEYS) target = MIN_KEYS;
+        if (target > MAX_KEYS) target = MAX_KEYS;
+        return target;
+    }
+
+    // CitizenSource over a sorted Citizen array
+    static void copyCitizen(Citizen& slot, int index, void* context) {
+        slot = ((const Citizen*)context)[index];
+    }
+
     // VALIDATION FUNCTION 
 
-    bool validateNode(BTreeNode* node, bool isRoot, string& error) {
+    // lower and upper (nullptr = unbounded) are the separators around the
+    // node in its parent; leafDepth is set by the first leaf reached
+    bool validateNode(BTreeNode* node, bool isRoot, int depth, int& leafDepth,
+        const string* lower, const string* upper, int& keys, string& error) {
         if (node == nullptr)
             return true;
+        keys += node->keyCount;
 
         // Check key count bounds
         if (!isRoot && node->keyCount < MIN_KEYS) {
@@ -1002,16 +1335,38 @@ private:
             }
         }
 
+        // Check keys lie between the parent's separators
+        if (node->keyCount > 0) {
+            if (lower != nullptr && compareCNIC(*lower, node->keys[0].cnic) >= 0) {
+                error = "Key " + node->keys[0].cnic + " not above its parent separator";
+                return false;
+            }
+            if (upper != nullptr && compareCNIC(node->keys[node->keyCount - 1].cnic, *upper) >= 0) {
+                error = "Key " + node->keys[node->keyCount - 1].cnic + " not below its parent separator";
+                return false;
+            }
+        }
+
+        // Check every leaf is at the same depth
+        if (node->isLeaf) {
+            if (leafDepth < 0) leafDepth = depth;
+            if (depth != leafDepth) {
+                error = "Leaves at different depths (" + intToString(depth) + " and " + intToString(leafDepth) + ")";
+                return false;
+            }
+            return true;
+        }
+
         // Recursively validate children
-        if (!node->isLeaf) {
-            for (int i = 0; i <= node->keyCount; i++) {
-                if (node->children[i] == nullptr) {
-                    error = "Non-leaf node has null child";
-                    return false;
-                }
-                if (!validateNode(node->children[i], false, error)) {
-                    return false;
-                }
+        for (int i = 0; i <= node->keyCount; i++) {
+            if (node->children[i] == nullptr) {
+                error = "Non-leaf node has null child";
+                return false;
+            }
+            const string* childLower = (i > 0) ? &node->keys[i - 1].cnic : lower;
+            const string* childUpper = (i < node->keyCount) ? &node->keys[i].cnic : upper;
+            if (!validateNode(node->children[i], false, depth + 1, leafDepth, childLower, childUpper, keys, error)) {
+                return false;
             }
         }
 
@@ -1059,6 +1414,87 @@ public:
 
 
 
+    // Builds the tree bottom-up from 'count' citizens in increasing CNIC
+    // order, without splits. The shape is laid out first: the leaves take
+    // the keys left to right, one key between neighbouring leaves goes up
+    // to their parent level, and so on until one node is left. Keys are
+    // spread evenly over each level, about fillFactor * MAX_KEYS per node
+    // and never fewer than MIN_KEYS; below 1 leaves room for inserts
+    // before nodes split. source then fills the slots in sorted order
+    // (index 0, 1, 2, ...), so it may stream. placed[i], if given, receives
+    // the address of the citizen at sorted position i. Only on an empty tree.
+    bool bulkLoad(int count, CitizenSource source, void* context, Citizen** placed = nullptr,
+        double fillFactor = 1.0) {
+        if (root != nullptr)
+            return false;
+        if (count <= 0)
+            return true;
+
+        int target = bulkTarget(fillFactor);
+        Citizen** slots = (placed != nullptr) ? placed : new Citizen*[count];
+
+        // Sorted positions of the keys still to place, level by level
+        int* positions = new int[count];
+        for (int i = 0; i < count; i++) {
+            positions[i] = i;
+        }
+        int keys = count;
+        BTreeNode** below = nullptr;
+
+        while (true) {
+            int nodes = bulkNodeCount(keys, target);
+            int stored = keys - (nodes - 1);
+            BTreeNode** level = new BTreeNode*[nodes];
+            int* up = new int[nodes > 1 ? nodes - 1 : 1];
+            int k = 0, child = 0;
+
+            for (int j = 0; j < nodes; j++) {
+                BTreeNode* node = new BTreeNode(below == nullptr);
+                nodeCount++;
+                int take = stored / nodes + (j < stored % nodes ? 1 : 0);
+                for (int t = 0; t < take; t++) {
+                    slots[positions[k++]] = &node->keys[t];
+                }
+                node->keyCount = take;
+                if (below != nullptr) {
+                    for (int c = 0; c <= take; c++) {
+                        node->children[c] = below[child++];
+                    }
+                }
+                level[j] = node;
+                if (j + 1 < nodes) up[j] = positions[k++];
+            }
+
+            delete[] below;
+            delete[] positions;
+            below = level;
+            positions = up;
+            keys = nodes - 1;
+            if (nodes == 1) break;
+        }
+
+        root = below[0];
+        delete[] below;
+        delete[] positions;
+        citizenCount = count;
+
+        for (int i = 0; i < count; i++) {
+            source(*slots[i], i, context);
+        }
+        if (slots != placed) delete[] slots;
+        return true;
+    }
+
+    // Same from an array sorted by CNIC; false (tree untouched) if the
+    // CNICs are not strictly increasing
+    bool bulkLoad(const Citizen sorted[], int count, double fillFactor = 1.0) {
+        for (int i = 1; i < count; i++) {
+            if (compareCNIC(sorted[i - 1].cnic, sorted[i].cnic) >= 0)
+                return false;
+        }
+        return bulkLoad(count, copyCitizen, (void*)sorted, nullptr, fillFactor);
+    }
+
     bool remove(const string& cnic) {
         if (root == nullptr)
             return false;
@@ -1119,6 +1555,11 @@ public:
         inorderTraversal(root, results, count, maxCount);
     }
 
+    // Every citizen in CNIC order, without copying them out
+    void forEachCitizen(CitizenVisitor visit, void* context) {
+        visitNode(root, visit, context);
+    }
+
     void displayTree() {
         cout << "\n=== B-Tree Structure ===" << endl;
         if (root == nullptr) {
@@ -1132,7 +1573,12 @@ public:
         if (root == nullptr)
             return true;
         string error;
-        bool isValid = validateNode(root, true, error);
+        int leafDepth = -1, keys = 0;
+        bool isValid = validateNode(root, true, 0, leafDepth, nullptr, nullptr, keys, error);
+        if (isValid && keys != citizenCount) {
+            error = "Tree holds " + intToString(keys) + " keys but counts " + intToString(citizenCount);
+            isValid = false;
+        }
         if (!isValid) {
             cout << "B-Tree INVALID: " << error << endl;
         }
@@ -1149,11 +1595,179 @@ public:
         return getHeight(root);
     }
 
+    // Drop every node and citizen, leaving an empty tree
+    void clear() {
+        deleteTree(root);
+        root = nullptr;
+        nodeCount = 0;
+        citizenCount = 0;
+    }
+
     ~CitizenBTree() {
         deleteTree(root);
     }
 };
 
+// BULK INGESTION
+// population.csv into an empty population. The file is mapped and cut into
+// chunks at line ends; chunks are tokenized and turned into rows on the
+// thread pool, the rows are sorted by CNIC (a stable merge sort, sorted
+// piece by piece in parallel), and the B-tree is built bottom-up from them.
+// Skipped rows, duplicates (the first row wins) and the messages are the
+// same as loading row by row.
+
+// One accepted row; the text fields point into the mapped file
+struct CitizenRow {
+    char cnic[16];
+    int age;
+    int rank;       // Position among the unique sorted CNICs, -1 if a duplicate
+    CsvField name;
+    CsvField sector;
+    CsvField street;
+    CsvField house;
+    CsvField occupation;
+    CsvField phone;
+};
+
+struct CitizenRowChunk {
+    CitizenRow* rows;
+    int count;
+    int errors;
+
+    CitizenRowChunk() : rows(nullptr), count(0), errors(0) {}
+    ~CitizenRowChunk() { delete[] rows; }
+};
+
+struct CitizenIngestJob {
+    CsvTable* table;
+    CitizenRowChunk* chunks;
+    int headerChunk;        // Chunk whose first row is the header
+
+    // Sorting
+    CitizenRow** items;
+    CitizenRow** scratch;
+    int* pieceBounds;
+    int pieceCount;
+    int width;
+};
+
+// "12345-1234567-1" from a field with exactly 13 digits, like formatCNIC
+bool formatCNICField(const CsvField& field, char out[16]) {
+    int digits = 0;
+    char raw[13];
+    for (int i = 0; i < field.length; i++) {
+        char c = field.data[i];
+        if (c >= '0' && c <= '9') {
+            if (digits == 13) return false;
+            raw[digits++] = c;
+        }
+    }
+    if (digits != 13) return false;
+    memcpy(out, raw, 5);
+    out[5] = '-';
+    memcpy(out + 6, raw + 5, 7);
+    out[13] = '-';
+    out[14] = raw[12];
+    out[15] = '\0';
+    return true;
+}
+
+bool citizenRowBefore(const CitizenRow* a, const CitizenRow* b) {
+    return memcmp(a->cnic, b->cnic, 15) < 0;
+}
+
+// Stable merge of items[lo, mid) and items[mid, hi) through scratch
+void mergeCitizenRows(CitizenRow** items, CitizenRow** scratch, int lo, int mid, int hi) {
+    if (lo >= mid || mid >= hi || !citizenRowBefore(items[mid], items[mid - 1])) return;
+    int a = lo, b = mid, out = lo;
+    while (a < mid && b < hi) {
+        scratch[out++] = citizenRowBefore(items[b], items[a]) ? items[b++] : items[a++];
+    }
+    while (a < mid) scratch[out++] = items[a++];
+    while (b < hi) scratch[out++] = items[b++];
+    memcpy(items + lo, scratch + lo, sizeof(CitizenRow*) * (hi - lo));
+}
+
+void sortCitizenRows(CitizenRow** items, CitizenRow** scratch, int lo, int hi) {
+    if (hi - lo < 16) {
+        // Insertion sort for short runs
+        for (int i = lo + 1; i < hi; i++) {
+            CitizenRow* row = items[i];
+            int j = i - 1;
+            while (j >= lo && citizenRowBefore(row, items[j])) {
+                items[j + 1] = items[j];
+                j--;
+            }
+            items[j + 1] = row;
+        }
+        return;
+    }
+    int mid = lo + (hi - lo) / 2;
+    sortCitizenRows(items, scratch, lo, mid);
+    sortCitizenRows(items, scratch, mid, hi);
+    mergeCitizenRows(items, scratch, lo, mid, hi);
+}
+
+// Thread pool task: one chunk of the table into CitizenRows
+void convertCitizenChunk(void* arg, int c) {
+    CitizenIngestJob* job = (CitizenIngestJob*)arg;
+    if (!job->table->isTokenized(c)) job->table->tokenizeChunk(c);
+    CsvTableChunk& chunk = job->table->getChunk(c);
+    CitizenRowChunk& out = job->chunks[c];
+    out.rows = new CitizenRow[chunk.rowCount > 0 ? chunk.rowCount : 1];
+
+    for (int r = (c == job->headerChunk) ? 1 : 0; r < chunk.rowCount; r++) {
+        CsvTableRow& row = chunk.rows[r];
+        if (row.fieldCount < 7) continue;
+        CsvField* fields = chunk.fields + row.firstField;
+
+        CitizenRow& citizen = out.rows[out.count];
+        if (!fields[2].toInt(citizen.age) || !formatCNICField(fields[0], citizen.cnic)) {
+            out.errors++;
+            continue;
+        }
+        citizen.rank = -1;
+        citizen.name = fields[1];
+        citizen.sector = fields[3];
+        citizen.street = fields[4];
+        citizen.house = fields[5];
+        citizen.occupation = fields[6];
+        citizen.phone = (row.fieldCount > 7) ? fields[7] : CsvField();
+        out.count++;
+    }
+    job->table->releaseChunk(c);
+}
+
+void sortCitizenPiece(void* arg, int p) {
+    CitizenIngestJob* job = (CitizenIngestJob*)arg;
+    sortCitizenRows(job->items, job->scratch, job->pieceBounds[p], job->pieceBounds[p + 1]);
+}
+
+// Merges pieces [2*i*width, (2*i+1)*width) and the next 'width' pieces
+void mergeCitizenPieces(void* arg, int i) {
+    CitizenIngestJob* job = (CitizenIngestJob*)arg;
+    int first = 2 * i * job->width;
+    int middle = first + job->width;
+    int last = middle + job->width;
+    if (middle > job->pieceCount) middle = job->pieceCount;
+    if (last > job->pieceCount) last = job->pieceCount;
+    mergeCitizenRows(job->items, job->scratch, job->pieceBounds[first], job->pieceBounds[middle], job->pieceBounds[last]);
+}
+
+// CitizenSource over the unique sorted rows
+void citizenFromRow(Citizen& slot, int index, void* context) {
+    CitizenRow* row = ((CitizenRow**)context)[index];
+    slot.cnic.assign(row->cnic, 15);
+    slot.name.assign(row->name.data, row->name.length);
+    slot.age = row->age;
+    slot.gender = ((row->cnic[14] - '0') % 2 == 0) ? "Female" : "Male";
+    slot.sector.assign(row->sector.data, row->sector.length);
+    slot.streetNumber.assign(row->street.data, row->street.length);
+    slot.houseNumber.assign(row->house.data, row->house.length);
+    slot.occupation.assign(row->occupation.data, row->occupation.length);
+    slot.phoneNumber.assign(row->phone.data, row->phone.length);
+}
+
 // POPULATION SYSTEM MANAGER
 
 class PopulationSystem {
@@ -1847,39 +2461,142 @@ public:
         }
     }
 
+    // Bulk path for an empty population; see BULK INGESTION above
+    void ingestFile() {
+        CsvTable* table = CsvPrefetchCache::getInstance()->find("population.csv");
+        CsvTable ownTable("population.csv");
+        CityThreadPool* pool = CityThreadPool::getInstance();
+        CitizenIngestJob job;
+
+        if (table == nullptr) {
+            // Not prefetched by the load pipeline: map it here and tokenize
+            // each chunk as it is converted
+            table = &ownTable;
+            if (table->read()) table->splitChunks();
+        }
+        if (!table->isFound()) {
+            cout << "Warning: population.csv not found." << endl;
+            return;
+        }
+
+        int chunkCount = table->getChunkCount();
+        job.table = table;
+        job.chunks = new CitizenRowChunk[chunkCount > 0 ? chunkCount : 1];
+        job.headerChunk = -1;
+        for (int c = 0; c < chunkCount && job.headerChunk < 0; c++) {
+            if (!table->isTokenized(c)) table->tokenizeChunk(c);
+            if (table->getChunk(c).rowCount > 0) job.headerChunk = c;
+        }
+        pool->parallelFor(chunkCount, convertCitizenChunk, &job);
+
+        int total = 0, errorCount = 0;
+        for (int c = 0; c < chunkCount; c++) {
+            total += job.chunks[c].count;
+            errorCount += job.chunks[c].errors;
+        }
+
+        // File order, then sorted by CNIC in pieces and merged pairwise
+        job.items = new CitizenRow*[total > 0 ? total : 1];
+        job.scratch = new CitizenRow*[total > 0 ? total : 1];
+        int n = 0;
+        for (int c = 0; c < chunkCount; c++) {
+            for (int r = 0; r < job.chunks[c].count; r++) {
+                job.items[n++] = &job.chunks[c].rows[r];
+            }
+        }
+        job.pieceCount = pool->getThreadCount() * 4;
+        if (job.pieceCount > total / 1024 + 1) job.pieceCount = total / 1024 + 1;
+        job.pieceBounds = new int[job.pieceCount + 1];
+        for (int p = 0; p <= job.pieceCount; p++) {
+            job.pieceBounds[p] = (int)((long long)total * p / job.pieceCount);
+        }
+        pool->parallelFor(job.pieceCount, sortCitizenPiece, &job);
+        for (job.width = 1; job.width < job.pieceCount; job.width *= 2) {
+            pool->parallelFor((job.pieceCount + 2 * job.width - 1) / (2 * job.width), mergeCitizenPieces, &job);
+        }
+        delete[] job.pieceBounds;
+
+        // Equal CNICs are adjacent and in file order: keep the first of each
+        int unique = 0, duplicateCount = 0;
+        for (int i = 0; i < total; i++) {
+            if (unique > 0 && memcmp(job.items[i]->cnic, job.scratch[unique - 1]->cnic, 15) == 0) {
+                duplicateCount++;
+                continue;
+            }
+            job.items[i]->rank = unique;
+            job.scratch[unique++] = job.items[i];
+        }
+
+        delete[] job.items;
+        Citizen** placed = new Citizen*[unique > 0 ? unique : 1];
+        bTree.bulkLoad(unique, citizenFromRow, job.scratch, placed);
+        delete[] job.scratch;
+
+        // Hash table in CNIC order (as a snapshot restore links it), the
+        // hierarchy in file order as the row-by-row load builds it
+        hashTable.reserve(unique);
+        for (int i = 0; i < unique; i++) {
+            Citizen* citizen = placed[i];
+            hashTable.insertUnique(citizen->cnic, citizen, citizen->sector, citizen->streetNumber, citizen->houseNumber);
+        }
+        Citizen** fileOrder = new Citizen*[unique > 0 ? unique : 1];
+        int ordered = 0;
+        for (int c = 0; c < chunkCount; c++) {
+            for (int r = 0; r < job.chunks[c].count; r++) {
+                if (job.chunks[c].rows[r].rank >= 0) fileOrder[ordered++] = placed[job.chunks[c].rows[r].rank];
+            }
+        }
+        delete[] placed;
+        delete[] job.chunks;
+        hierarchyTree.insertCitizens(fileOrder, ordered);
+        delete[] fileOrder;
+
+        cout << "Loaded " << unique << " citizens from file." << endl;
+        if (duplicateCount > 0) {
+            cout << "Skipped " << duplicateCount << " duplicate CNICs." << endl;
+        }
+        if (errorCount > 0) {
+            cout << "Skipped " << errorCount << " invalid entries." << endl;
+        }
+    }
+
     void loadFromFile() {
-        ifstream file("population.csv");
-        if (!file.is_open()) {
+        if (bTree.getCitizenCount() == 0 && hashTable.getCount() == 0) {
+            ingestFile();
+            return;
+        }
+        loadRowsFromFile();
+    }
+
+    // One row at a time into whatever is already loaded
+    void loadRowsFromFile() {
+        CsvReader file("population.csv");
+        if (!file.isOpen()) {
             cout << "Warning: population.csv not found." << endl;
             return;
         }
 
-        string line;
-        getline(file, line);
+        file.readRow();
         int loadedCount = 0;
         int duplicateCount = 0;
         int errorCount = 0;
 
-        while (getline(file, line)) {
-            if (line.empty())
-                continue;
-
-            for (size_t i = 0; i < line.length(); i++) {
-                if (line[i] == '\t') line[i] = ',';
-            }
-
-            string parts[8];
-            int count = splitString(line, ',', parts, 8);
+        while (file.readRow()) {
+            int count = file.getFieldCount();
 
             if (count >= 7) {
-                string cnic = formatCNIC(trimString(parts[0]));
-                string name = trimString(parts[1]);
-                int age = stringToInt(trimString(parts[2]));
-                string sector = trimString(parts[3]);
-                string street = trimString(parts[4]);
-                string house = trimString(parts[5]);
-                string occupation = trimString(parts[6]);
-                string phone = (count >= 8) ? trimString(parts[7]) : "";
+                int age;
+                if (!file.field(2).toInt(age)) {
+                    errorCount++;
+                    continue;
+                }
+                string cnic = formatCNIC(file.getString(0));
+                string name = file.getString(1);
+                string sector = file.getString(3);
+                string street = file.getString(4);
+                string house = file.getString(5);
+                string occupation = file.getString(6);
+                string phone = file.getString(7);
 
                 if (!isValidCNICFormat(cnic)) {
                     errorCount++;
@@ -1915,6 +2632,88 @@ public:
         }
     }
 
+    // SNAPSHOT
+
+    static void writeCitizen(Citizen* citizen, void* context) {
+        CitySnapshotWriter* out = (CitySnapshotWriter*)context;
+        out->putString(citizen->cnic);
+        out->putString(citizen->name);
+        out->putInt(citizen->age);
+        out->putString(citizen->gender);
+        out->putString(citizen->sector);
+        out->putString(citizen->streetNumber);
+        out->putString(citizen->houseNumber);
+        out->putString(citizen->occupation);
+        out->putString(citizen->phoneNumber);
+    }
+
+    // Saved citizens streamed into a bulk load, checking they really come
+    // in increasing CNIC order
+    struct CitizenStream {
+        CitySnapshotReader* in;
+        string last;
+        bool ordered;
+    };
+
+    static void readCitizen(Citizen& slot, int index, void* context) {
+        CitizenStream* stream = (CitizenStream*)context;
+        CitySnapshotReader& in = *stream->in;
+        slot.cnic = in.getString();
+        if (index > 0 && slot.cnic <= stream->last) stream->ordered = false;
+        stream->last = slot.cnic;
+        slot.name = in.getString();
+        slot.age = in.getInt();
+        slot.gender = in.getString();
+        slot.sector = in.getString();
+        slot.streetNumber = in.getString();
+        slot.houseNumber = in.getString();
+        slot.occupation = in.getString();
+        slot.phoneNumber = in.getString();
+    }
+
+    // POPULATN section: citizens in CNIC order, then the sector/street/house
+    // hierarchy as it stands (so it is rebuilt without any searching)
+    void writeSnapshot(CitySnapshotWriter& out) {
+        out.beginSection("POPULATN");
+        out.putInt(bTree.getCitizenCount());
+        bTree.forEachCitizen(writeCitizen, &out);
+        hierarchyTree.writeSnapshot(out);
+        out.endSection();
+    }
+
+    bool readSnapshot(CitySnapshotReader& in) {
+        if (bTree.getCitizenCount() != 0 || !in.beginSection("POPULATN")) return false;
+
+        // Saved in CNIC order, so the tree is bulk loaded straight from the file
+        int saved = in.getCount();
+        Citizen** sorted = new Citizen*[saved > 0 ? saved : 1];
+        CitizenStream stream;
+        stream.in = &in;
+        stream.ordered = true;
+        bTree.bulkLoad(saved, readCitizen, &stream, sorted);
+        if (in.hasFailed() || !stream.ordered) {
+            // Nothing half-read may stay searchable
+            bTree.clear();
+            delete[] sorted;
+            return false;
+        }
+
+        hashTable.reserve(saved);
+        for (int i = 0; i < saved; i++) {
+            Citizen* citizen = sorted[i];
+            hashTable.insertUnique(citizen->cnic, citizen, citizen->sector, citizen->streetNumber, citizen->houseNumber);
+        }
+        bool ok = hierarchyTree.readSnapshot(in, sorted, saved);
+
+        delete[] sorted;
+        return ok;
+    }
+
+    // Non-interactive lookup by CNIC (nullptr if not registered)
+    Citizen* findCitizen(const string& cnic) {
+        return bTree.search(cnic);
+    }
+
     int getCitizenCount() {
 
         return bTree.getCitizenCount();
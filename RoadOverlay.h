@@ -0,0 +1,501 @@
+#pragma once
+#include "Utils.h"
+#include "CityGraph.h"
+#include "RoutingEngine.h"
+#include <cfloat>
+#include <cmath>
+
+using namespace std;
+
+// WHAT-IF ROAD OVERLAYS
+// A scenario (roads closed for an event, a temporary bypass, a slow detour)
+// recorded on top of the live CityGraph without ever writing to it. The
+// overlay keeps only its own change list: creating one is O(1) and every
+// edit O(1). Before the first query the changes are resolved against the
+// base's compact graph in O(changes x degree); after that routing sees the
+// base edges with the overrides applied plus the added roads. If the base
+// changes (its graphVersion moves on) the list is simply resolved again.
+
+const int OVERLAY_CLOSE_ROAD = 0;
+const int OVERLAY_ADD_ROAD = 1;
+const int OVERLAY_SET_LENGTH = 2;
+
+struct CityOverlayChange {
+    int kind;
+    string id1;
+    string id2;
+    double distance;
+    CityOverlayChange* next;
+
+    CityOverlayChange(int k, const string& a, const string& b, double d)
+        : kind(k), id1(a), id2(b), distance(d), next(nullptr) {}
+};
+
+// Open-addressing hash map from non-negative ints (vertex or edge indices)
+template <class Value>
+class CityIntMap {
+private:
+    int* keys;          // -1 = empty slot
+    Value* values;
+    int capacity;       // Power of two
+    int size;
+
+    int slotOf(int key) const {
+        unsigned int h = (unsigned int)key * 2654435761u;
+        return (int)(h & (unsigned int)(capacity - 1));
+    }
+
+    void grow() {
+        int* oldKeys = keys;
+        Value* oldValues = values;
+        int oldCapacity = capacity;
+
+        capacity *= 2;
+        keys = new int[capacity];
+        values = new Value[capacity];
+        for (int i = 0; i < capacity; i++) keys[i] = -1;
+        size = 0;
+        for (int i = 0; i < oldCapacity; i++) {
+            if (oldKeys[i] != -1) set(oldKeys[i], oldValues[i]);
+        }
+        delete[] oldKeys;
+        delete[] oldValues;
+    }
+
+public:
+    CityIntMap() : capacity(16), size(0) {
+        keys = new int[capacity];
+        values = new Value[capacity];
+        for (int i = 0; i < capacity; i++) keys[i] = -1;
+    }
+
+    ~CityIntMap() {
+        delete[] keys;
+        delete[] values;
+    }
+
+    CityIntMap(const CityIntMap&) = delete;
+    CityIntMap& operator=(const CityIntMap&) = delete;
+
+    // nullptr if key is absent
+    const Value* find(int key) const {
+        if (size == 0) return nullptr;
+        for (int i = slotOf(key);; i = (i + 1) & (capacity - 1)) {
+            if (keys[i] == key) return &values[i];
+            if (keys[i] == -1) return nullptr;
+        }
+    }
+
+    void set(int key, const Value& value) {
+        if ((size + 1) * 2 > capacity) grow();
+        int i = slotOf(key);
+        while (keys[i] != -1 && keys[i] != key) i = (i + 1) & (capacity - 1);
+        if (keys[i] == -1) {
+            keys[i] = key;
+            size++;
+        }
+        values[i] = value;
+    }
+
+    void clear() {
+        for (int i = 0; i < capacity; i++) keys[i] = -1;
+        size = 0;
+    }
+
+    int getSize() const { return size; }
+};
+
+// A road that exists only in the overlay (one direction)
+struct CityAddedRoad {
+    int target;
+    double length;      // DBL_MAX once closed again
+    int next;           // Next added road from the same vertex, -1 at the end
+};
+
+// Resolved overrides, indexed like the base compact graph
+struct CityOverlayEdges {
+    CityIntMap<double> changedLength;   // Base edge -> new length (DBL_MAX = closed)
+    CityIntMap<int> addedHead;          // Vertex -> its first added road
+    CityAddedRoad* added;
+    int addedCount;
+    int addedCapacity;
+
+    CityOverlayEdges() : added(nullptr), addedCount(0), addedCapacity(0) {}
+    ~CityOverlayEdges() { delete[] added; }
+
+    CityOverlayEdges(const CityOverlayEdges&) = delete;
+    CityOverlayEdges& operator=(const CityOverlayEdges&) = delete;
+
+    void clear() {
+        changedLength.clear();
+        addedHead.clear();
+        addedCount = 0;
+    }
+
+    void addRoad(int from, int to, double length) {
+        if (addedCount == addedCapacity) {
+            int newCapacity = (addedCapacity > 0) ? addedCapacity * 2 : 16;
+            CityAddedRoad* grown = new CityAddedRoad[newCapacity];
+            for (int i = 0; i < addedCount; i++) grown[i] = added[i];
+            delete[] added;
+            added = grown;
+            addedCapacity = newCapacity;
+        }
+        const int* head = addedHead.find(from);
+        added[addedCount].target = to;
+        added[addedCount].length = length;
+        added[addedCount].next = (head != nullptr) ? *head : -1;
+        addedHead.set(from, addedCount);
+        addedCount++;
+    }
+};
+
+// Routing engine view of base + overlay. Edge handles are base edge
+// indices (>= 0), then the vertex's added roads encoded as -(i + 2);
+// -1 ends the list.
+struct CityOverlayGraph {
+    struct Edge {
+        int index;
+        int vertex;
+
+        bool operator==(const Edge& other) const { return index == other.index; }
+        bool operator!=(const Edge& other) const { return index != other.index; }
+    };
+
+    CityCompactGraph base;
+    const CityOverlayEdges* edges;
+
+    CityOverlayGraph(const CityCompactGraph& g, const CityOverlayEdges* e) : base(g), edges(e) {}
+
+    Edge addedStart(int u) const {
+        const int* head = edges->addedHead.find(u);
+        Edge e = { (head != nullptr) ? -(*head + 2) : -1, u };
+        return e;
+    }
+
+    int vertexCount() const { return base.vertexCount(); }
+
+    Edge firstEdge(int u) const {
+        if (base.firstEdge(u) == base.endEdge(u)) return addedStart(u);
+        Edge e = { base.firstEdge(u), u };
+        return e;
+    }
+
+    Edge endEdge(int u) const {
+        Edge e = { -1, u };
+        return e;
+    }
+
+    Edge nextEdge(Edge e) const {
+        if (e.index >= 0) {
+            if (e.index + 1 < base.endEdge(e.vertex)) {
+                e.index++;
+                return e;
+            }
+            return addedStart(e.vertex);
+        }
+        int next = edges->added[-e.index - 2].next;
+        e.index = (next != -1) ? -(next + 2) : -1;
+        return e;
+    }
+
+    int edgeTarget(Edge e) const {
+        if (e.index >= 0) {
+            const double* length = edges->changedLength.find(e.index);
+            return (length != nullptr && *length == DBL_MAX) ? -1 : base.edgeTarget(e.index);
+        }
+        const CityAddedRoad& road = edges->added[-e.index - 2];
+        return (road.length == DBL_MAX) ? -1 : road.target;
+    }
+
+    double edgeLength(Edge e) const {
+        if (e.index >= 0) {
+            const double* length = edges->changedLength.find(e.index);
+            return (length != nullptr) ? *length : base.edgeLength(e.index);
+        }
+        return edges->added[-e.index - 2].length;
+    }
+
+    const CityTrafficPattern* edgeTraffic(Edge e) const {
+        return (e.index >= 0) ? base.edgeTraffic(e.index) : nullptr;
+    }
+};
+
+// How one overlay moves every location's distance to its nearest facility of a type
+struct CityOverlayImpact {
+    int facilityType;
+    int facilityCount;
+    int servedBefore;       // Locations that could reach a facility in the base
+    int longer;             // Now farther from their nearest facility
+    int shorter;
+    int cutOff;             // Could reach one before, cannot now
+    double totalIncrease;   // Summed over 'longer'
+    double maxIncrease;
+    string worstID;         // Location with the largest increase
+
+    CityOverlayImpact() : facilityType(-1), facilityCount(0), servedBefore(0), longer(0), shorter(0),
+        cutOff(0), totalIncrease(0), maxIncrease(0), worstID("") {}
+};
+
+class CityRoadOverlay {
+private:
+    CityGraph* base;
+    string name;
+
+    CityOverlayChange* changesHead;     // In the order they were made
+    CityOverlayChange* changesTail;
+    int changeCount;
+
+    CityOverlayEdges edges;
+    unsigned int resolvedVersion;
+    bool resolved;
+    int unresolved;                     // Changes naming a road or location that is not there
+
+    // Base edge u -> v, or -1
+    int findBaseEdge(int u, int v) {
+        const int* offsets = base->getCompactOffsets();
+        const int* targets = base->getCompactTargets();
+        for (int e = offsets[u]; e < offsets[u + 1]; e++) {
+            if (targets[e] == v) return e;
+        }
+        return -1;
+    }
+
+    // Added road u -> v, or -1
+    int findAddedRoad(int u, int v) {
+        const int* head = edges.addedHead.find(u);
+        for (int i = (head != nullptr) ? *head : -1; i != -1; i = edges.added[i].next) {
+            if (edges.added[i].target == v) return i;
+        }
+        return -1;
+    }
+
+    // Give the road u -> v a new length (DBL_MAX closes it); adds the road
+    // if 'create' is set and it does not exist yet. False if nothing matched.
+    // A negative length keeps a base road's own length (reopening it) and
+    // makes any other road a straight line.
+    bool applyDirected(int u, int v, double length, bool create) {
+        int e = findBaseEdge(u, v);
+        if (e != -1) {
+            edges.changedLength.set(e, (length < 0) ? base->getCompactWeights()[e] : length);
+            return true;
+        }
+        if (length < 0) {
+            CityLocation* a = base->getVertex(u);
+            CityLocation* b = base->getVertex(v);
+            length = calculateDistance(a->lat, a->lon, b->lat, b->lon);
+        }
+        int i = findAddedRoad(u, v);
+        if (i != -1) {
+            edges.added[i].length = length;
+            return true;
+        }
+        if (!create) return false;
+        edges.addRoad(u, v, length);
+        return true;
+    }
+
+    // Replay the change list against the current base compact graph
+    void resolve() {
+        base->ensureCompactGraph();
+        if (resolved && resolvedVersion == base->getGraphVersion()) return;
+
+        edges.clear();
+        unresolved = 0;
+        for (CityOverlayChange* change = changesHead; change != nullptr; change = change->next) {
+            int u = base->getVertexIndex(change->id1);
+            int v = base->getVertexIndex(change->id2);
+            if (u == -1 || v == -1) {
+                unresolved++;
+                continue;
+            }
+
+            double length = change->distance;
+            if (change->kind == OVERLAY_CLOSE_ROAD) length = DBL_MAX;
+
+            bool create = (change->kind == OVERLAY_ADD_ROAD);
+            bool applied = applyDirected(u, v, length, create);
+            if (applyDirected(v, u, length, create)) applied = true;
+            if (!applied) unresolved++;
+        }
+        resolvedVersion = base->getGraphVersion();
+        resolved = true;
+    }
+
+    void record(int kind, const string& id1, const string& id2, double distance) {
+        CityOverlayChange* change = new CityOverlayChange(kind, id1, id2, distance);
+        if (changesTail == nullptr) changesHead = change;
+        else changesTail->next = change;
+        changesTail = change;
+        changeCount++;
+        resolved = false;
+    }
+
+    bool bothExist(const string& id1, const string& id2) {
+        return !stringsEqualIgnoreCase(id1, id2) && base->findLocationByID(id1) != nullptr &&
+            base->findLocationByID(id2) != nullptr;
+    }
+
+    // Vertex indices of every location of a type; returns how many
+    int collectType(int type, int out[]) {
+        int count = 0;
+        for (int v = 0; v < base->getLocationCount(); v++) {
+            if (base->getVertex(v)->type == type) out[count++] = v;
+        }
+        return count;
+    }
+
+public:
+    CityRoadOverlay(const string& n, CityGraph* g = CityGraph::getInstance())
+        : base(g), name(n), changesHead(nullptr), changesTail(nullptr), changeCount(0),
+        resolvedVersion(0), resolved(false), unresolved(0) {
+    }
+
+    ~CityRoadOverlay() { clearChanges(); }
+
+    CityRoadOverlay(const CityRoadOverlay&) = delete;
+    CityRoadOverlay& operator=(const CityRoadOverlay&) = delete;
+
+    // Changes (later ones win over earlier ones on the same road)
+
+    bool closeRoad(const string& id1, const string& id2) {
+        if (!bothExist(id1, id2)) return false;
+        record(OVERLAY_CLOSE_ROAD, id1, id2, DBL_MAX);
+        return true;
+    }
+
+    // Opens a road (or reopens a closed one); distance < 0 = the road's own
+    // length if the base graph has it, else a straight line
+    bool addRoad(const string& id1, const string& id2, double distance = -1) {
+        if (!bothExist(id1, id2)) return false;
+        record(OVERLAY_ADD_ROAD, id1, id2, distance);
+        return true;
+    }
+
+    bool setRoadLength(const string& id1, const string& id2, double distance) {
+        if (distance < 0 || !bothExist(id1, id2)) return false;
+        record(OVERLAY_SET_LENGTH, id1, id2, distance);
+        return true;
+    }
+
+    void clearChanges() {
+        while (changesHead != nullptr) {
+            CityOverlayChange* next = changesHead->next;
+            delete changesHead;
+            changesHead = next;
+        }
+        changesTail = nullptr;
+        changeCount = 0;
+        resolved = false;
+    }
+
+    // Routing
+
+    // Routing engine view; valid until the base graph or the overlay changes
+    CityOverlayGraph view() {
+        resolve();
+        CityCompactGraph compact(base->getCompactOffsets(), base->getCompactTargets(),
+            base->getCompactWeights(), base->getLocationCount(), base->getCompactTraffic());
+        return CityOverlayGraph(compact, &edges);
+    }
+
+    // Same contract as CityGraph::findShortestPath (plain Dijkstra: the
+    // base's A* scale and landmarks do not hold once roads are added)
+    double findShortestPath(const string& srcID, const string& destID,
+        string path[], int& pathLen, int maxPathLen) {
+        pathLen = 0;
+        int src = base->getVertexIndex(srcID);
+        int dest = base->getVertexIndex(destID);
+        if (src == -1 || dest == -1) return DBL_MAX;
+
+        CityOverlayGraph graph = view();
+        CitySearchScratch& sc = getCitySearchScratch();
+        CityUntilTarget goal(dest);
+        cityShortestPaths(graph, goal, src, sc);
+        if (!sc.isSettled(dest)) return DBL_MAX;
+
+        int hops = sc.hopsTo(dest);
+        pathLen = (hops < maxPathLen) ? hops : maxPathLen;
+        int pos = hops - 1;
+        for (int v = dest; v != -1; v = sc.prev[v], pos--) {
+            if (pos < maxPathLen) path[pos] = base->getVertex(v)->id;
+        }
+        return sc.dist[dest];
+    }
+
+    // dist[v] for every vertex index v (DBL_MAX = unreachable)
+    void distancesFrom(const string& srcID, double dist[]) {
+        int n = base->getLocationCount();
+        for (int v = 0; v < n; v++) dist[v] = DBL_MAX;
+        int src = base->getVertexIndex(srcID);
+        if (src == -1) return;
+
+        CityOverlayGraph graph = view();
+        CitySearchScratch& sc = getCitySearchScratch();
+        CitySettleAll goal;
+        cityShortestPaths(graph, goal, src, sc);
+        for (int v = 0; v < n; v++) {
+            if (sc.isSettled(v)) dist[v] = sc.dist[v];
+        }
+    }
+
+    // Comparison with the base
+
+    // Nearest-facility distance of every location, before and after.
+    // Two multi-source searches (base, then overlay): O(graph).
+    CityOverlayImpact compareNearest(int facilityType) {
+        CityOverlayImpact impact;
+        impact.facilityType = facilityType;
+
+        CityOverlayGraph graph = view();
+        int n = graph.vertexCount();
+        int* sources = new int[n > 0 ? n : 1];
+        impact.facilityCount = collectType(facilityType, sources);
+
+        CitySearchScratch& sc = getCitySearchScratch();
+        CitySettleAll goal;
+        double* before = new double[n > 0 ? n : 1];
+        cityShortestPathsFromMany(graph.base, CityEdgeLength(), goal, sources, impact.facilityCount, sc);
+        for (int v = 0; v < n; v++) before[v] = sc.isSettled(v) ? sc.dist[v] : DBL_MAX;
+
+        cityShortestPathsFromMany(graph, CityEdgeLength(), goal, sources, impact.facilityCount, sc);
+        for (int v = 0; v < n; v++) {
+            double after = sc.isSettled(v) ? sc.dist[v] : DBL_MAX;
+            if (before[v] != DBL_MAX) impact.servedBefore++;
+            if (after == before[v]) continue;
+            if (after != DBL_MAX && before[v] != DBL_MAX && fabs(after - before[v]) <= 1e-9 * (1 + before[v])) {
+                continue;  // Same distance, summed along a different tie
+            }
+
+            if (after == DBL_MAX) {
+                impact.cutOff++;
+            }
+            else if (before[v] == DBL_MAX || after < before[v]) {
+                impact.shorter++;
+            }
+            else {
+                double increase = after - before[v];
+                impact.longer++;
+                impact.totalIncrease += increase;
+                if (increase > impact.maxIncrease) {
+                    impact.maxIncrease = increase;
+                    impact.worstID = base->getVertex(v)->id;
+                }
+            }
+        }
+
+        delete[] sources;
+        delete[] before;
+        return impact;
+    }
+
+    const string& getName() { return name; }
+    int getChangeCount() { return changeCount; }
+    CityOverlayChange* getChanges() { return changesHead; }
+
+    // Changes that matched no road or location at the last resolve
+    int getUnresolvedCount() {
+        resolve();
+        return unresolved;
+    }
+};
@@ -0,0 +1,1033 @@
+#pragma once
+#include "Utils.h"
+#include "ThreadPool.h"
+#include "TrafficProfile.h"
+#include <cfloat>
+#include <atomic>
+
+using namespace std;
+
+// SHARED ROUTING ENGINE
+// One Dijkstra / A* kernel used by every module. The search is a template
+// over three small policies, so each module gets its own inlined hot loop:
+//
+//   Graph   - how to walk the network (vertex count and outgoing edges)
+//   Weight  - what an edge costs when entered at a given distance
+//   Goal    - when to stop, and an optional A* lower bound
+//
+// The heap arity is a compile-time constant; build with
+// -DCITY_HEAP_ARITY=2 (or 8, ...) to try another one.
+
+#ifndef CITY_HEAP_ARITY
+#define CITY_HEAP_ARITY 4
+#endif
+
+// Indexed d-ary min-heap over vertex indices for Dijkstra.
+// position[] gives O(1) lookup of a vertex's heap slot, so a shorter
+// distance is a decrease-key instead of a duplicate insert.
+template <int ARITY>
+class CityDAryHeap {
+private:
+    static_assert(ARITY >= 2, "heap arity must be at least 2");
+
+    int* heap;        // heap slot -> vertex
+    int* position;    // vertex -> heap slot (-1 if not in heap)
+    double* keys;     // vertex -> key
+    int size;
+    int capacity;
+
+    void place(int slot, int v) {
+        heap[slot] = v;
+        position[v] = slot;
+    }
+
+    void siftUp(int i) {
+        int v = heap[i];
+        double key = keys[v];
+        while (i > 0) {
+            int parent = (i - 1) / ARITY;
+            if (key < keys[heap[parent]]) {
+                place(i, heap[parent]);
+                i = parent;
+            }
+            else break;
+        }
+        place(i, v);
+    }
+
+    void siftDown(int i) {
+        int v = heap[i];
+        double key = keys[v];
+        while (true) {
+            int first = ARITY * i + 1;
+            if (first >= size) break;
+            int last = (first + ARITY < size) ? first + ARITY : size;
+
+            int smallest = first;
+            double smallestKey = keys[heap[first]];
+            for (int c = first + 1; c < last; c++) {
+                double childKey = keys[heap[c]];
+                if (childKey < smallestKey) {
+                    smallest = c;
+                    smallestKey = childKey;
+                }
+            }
+
+            if (smallestKey < key) {
+                place(i, heap[smallest]);
+                i = smallest;
+            }
+            else break;
+        }
+        place(i, v);
+    }
+
+public:
+    CityDAryHeap() : heap(nullptr), position(nullptr), keys(nullptr), size(0), capacity(0) {}
+
+    ~CityDAryHeap() {
+        delete[] heap;
+        delete[] position;
+        delete[] keys;
+    }
+
+    CityDAryHeap(const CityDAryHeap&) = delete;
+    CityDAryHeap& operator=(const CityDAryHeap&) = delete;
+
+    // Make room for vertices 0 .. n-1 (only grows)
+    void reserve(int n) {
+        if (n <= capacity) return;
+        int newCapacity = (capacity > 0) ? capacity : 64;
+        while (newCapacity < n) newCapacity *= 2;
+
+        delete[] heap;
+        delete[] position;
+        delete[] keys;
+        heap = new int[newCapacity];
+        position = new int[newCapacity];
+        keys = new double[newCapacity];
+        for (int i = 0; i < newCapacity; i++) {
+            position[i] = -1;
+        }
+        capacity = newCapacity;
+        size = 0;
+    }
+
+    bool isEmpty() { return size == 0; }
+
+    bool contains(int v) { return position[v] != -1; }
+
+    // Insert v, or lower its key if it is already queued
+    void insertOrDecrease(int v, double key) {
+        if (position[v] == -1) {
+            keys[v] = key;
+            place(size, v);
+            size++;
+            siftUp(size - 1);
+        }
+        else if (key < keys[v]) {
+            keys[v] = key;
+            siftUp(position[v]);
+        }
+    }
+
+    // Set v's key to any value (insert if absent)
+    void update(int v, double key) {
+        if (position[v] == -1 || key < keys[v]) {
+            insertOrDecrease(v, key);
+        }
+        else if (key > keys[v]) {
+            keys[v] = key;
+            siftDown(position[v]);
+        }
+    }
+
+    double minKey() { return keys[heap[0]]; }
+
+    int extractMin() {
+        int minVertex = heap[0];
+        position[minVertex] = -1;
+        size--;
+        if (size > 0) {
+            place(0, heap[size]);
+            siftDown(0);
+        }
+        return minVertex;
+    }
+
+    // Empty the heap, leaving positions ready for the next search
+    void clear() {
+        for (int i = 0; i < size; i++) {
+            position[heap[i]] = -1;
+        }
+        size = 0;
+    }
+};
+
+// Per-thread Dijkstra working arrays, reused between queries.
+// Stamps mark which entries belong to the current search, so starting
+// a new query is O(1) instead of resetting every vertex.
+template <int ARITY>
+struct CitySearchScratchT {
+    double* dist;
+    int* prev;
+    unsigned int* reachedStamp;
+    unsigned int* settledStamp;
+    unsigned int stamp;
+    int capacity;
+    int settledCount;   // Vertices settled by the last search
+    CityDAryHeap<ARITY> heap;
+
+    CitySearchScratchT() : dist(nullptr), prev(nullptr), reachedStamp(nullptr),
+        settledStamp(nullptr), stamp(0), capacity(0), settledCount(0) {
+    }
+
+    ~CitySearchScratchT() {
+        delete[] dist;
+        delete[] prev;
+        delete[] reachedStamp;
+        delete[] settledStamp;
+    }
+
+    CitySearchScratchT(const CitySearchScratchT&) = delete;
+    CitySearchScratchT& operator=(const CitySearchScratchT&) = delete;
+
+    // Start a new search over n vertices
+    void prepare(int n) {
+        if (n > capacity) {
+            int newCapacity = (capacity > 0) ? capacity : 64;
+            while (newCapacity < n) newCapacity *= 2;
+
+            delete[] dist;
+            delete[] prev;
+            delete[] reachedStamp;
+            delete[] settledStamp;
+            dist = new double[newCapacity];
+            prev = new int[newCapacity];
+            reachedStamp = new unsigned int[newCapacity];
+            settledStamp = new unsigned int[newCapacity];
+            for (int i = 0; i < newCapacity; i++) {
+                reachedStamp[i] = 0;
+                settledStamp[i] = 0;
+            }
+            capacity = newCapacity;
+            stamp = 0;
+        }
+        heap.reserve(n);
+        heap.clear();
+        settledCount = 0;
+
+        stamp++;
+        if (stamp == 0) {
+            // Counter wrapped, old stamps could look current
+            for (int i = 0; i < capacity; i++) {
+                reachedStamp[i] = 0;
+                settledStamp[i] = 0;
+            }
+            stamp = 1;
+        }
+    }
+
+    bool isReached(int v) { return reachedStamp[v] == stamp; }
+    bool isSettled(int v) { return settledStamp[v] == stamp; }
+    void settle(int v) {
+        settledStamp[v] = stamp;
+        settledCount++;
+    }
+
+    double distanceTo(int v) { return isReached(v) ? dist[v] : DBL_MAX; }
+
+    void reach(int v, double d, int from) {
+        reachedStamp[v] = stamp;
+        dist[v] = d;
+        prev[v] = from;
+    }
+
+    // Number of vertices on the recorded src -> v path (0 if v was not reached)
+    int hopsTo(int v) {
+        if (!isReached(v)) return 0;
+        int hops = 0;
+        for (; v != -1; v = prev[v]) hops++;
+        return hops;
+    }
+};
+
+typedef CityDAryHeap<CITY_HEAP_ARITY> CityIndexedHeap;
+typedef CitySearchScratchT<CITY_HEAP_ARITY> CitySearchScratch;
+
+// Scratch buffers owned by the calling thread
+CitySearchScratch& getCitySearchScratch() {
+    static thread_local CitySearchScratch scratch;
+    return scratch;
+}
+
+// Per-thread set of marked vertices; clearing it is O(1) like the scratch
+struct CityVertexMarks {
+    unsigned int* markStamp;
+    unsigned int stamp;
+    int capacity;
+
+    CityVertexMarks() : markStamp(nullptr), stamp(0), capacity(0) {}
+    ~CityVertexMarks() { delete[] markStamp; }
+
+    CityVertexMarks(const CityVertexMarks&) = delete;
+    CityVertexMarks& operator=(const CityVertexMarks&) = delete;
+
+    // Unmark everything, making room for vertices 0 .. n-1
+    void prepare(int n) {
+        if (n > capacity) {
+            int newCapacity = (capacity > 0) ? capacity : 64;
+            while (newCapacity < n) newCapacity *= 2;
+            delete[] markStamp;
+            markStamp = new unsigned int[newCapacity];
+            for (int i = 0; i < newCapacity; i++) {
+                markStamp[i] = 0;
+            }
+            capacity = newCapacity;
+            stamp = 0;
+        }
+
+        stamp++;
+        if (stamp == 0) {
+            for (int i = 0; i < capacity; i++) {
+                markStamp[i] = 0;
+            }
+            stamp = 1;
+        }
+    }
+
+    void mark(int v) { markStamp[v] = stamp; }
+    bool isMarked(int v) const { return markStamp[v] == stamp; }
+};
+
+CityVertexMarks& getCityVertexMarks() {
+    static thread_local CityVertexMarks marks;
+    return marks;
+}
+
+
+// GRAPH-ACCESS POLICIES
+// A graph policy provides:
+//   typedef ... Edge;                 edge handle
+//   int vertexCount()
+//   Edge firstEdge(int u), Edge endEdge(int u), Edge nextEdge(Edge e)
+//   int edgeTarget(Edge e)            -1 to skip the edge
+//   double edgeLength(Edge e)
+//   const CityTrafficPattern* edgeTraffic(Edge e)   only for time-dependent weights
+
+// Compact (CSR) arrays: neighbors of v are targets[offsets[v] .. offsets[v+1]-1]
+struct CityCompactGraph {
+    typedef int Edge;
+
+    const int* offsets;
+    const int* targets;
+    const double* weights;
+    const CityTrafficPattern* const* traffic;   // Optional, parallel to targets
+    int count;
+
+    CityCompactGraph(const int* o, const int* t, const double* w, int n,
+        const CityTrafficPattern* const* tr = nullptr)
+        : offsets(o), targets(t), weights(w), traffic(tr), count(n) {
+    }
+
+    int vertexCount() const { return count; }
+    Edge firstEdge(int u) const { return offsets[u]; }
+    Edge endEdge(int u) const { return offsets[u + 1]; }
+    Edge nextEdge(Edge e) const { return e + 1; }
+    int edgeTarget(Edge e) const { return targets[e]; }
+    double edgeLength(Edge e) const { return weights[e]; }
+    const CityTrafficPattern* edgeTraffic(Edge e) const { return (traffic != nullptr) ? traffic[e] : nullptr; }
+};
+
+// A module's own linked adjacency lists. AdjNode needs edgeHead, next and
+// routeIndex; EdgeNode needs distance, destAdj and next (and traffic for
+// time-dependent weights). The nodes are
+// numbered once when the view is made, so every relaxation is O(1)
+// instead of a scan over the module's ID list.
+template <class AdjNode, class EdgeNode>
+class CityLinkedGraph {
+private:
+    AdjNode** nodes;
+    int count;
+
+public:
+    typedef EdgeNode* Edge;
+
+    CityLinkedGraph(AdjNode* head) : nodes(nullptr), count(0) {
+        for (AdjNode* adj = head; adj != nullptr; adj = adj->next) count++;
+        nodes = new AdjNode * [count > 0 ? count : 1];
+        int index = 0;
+        for (AdjNode* adj = head; adj != nullptr; adj = adj->next) {
+            adj->routeIndex = index;
+            nodes[index++] = adj;
+        }
+    }
+
+    ~CityLinkedGraph() { delete[] nodes; }
+
+    CityLinkedGraph(const CityLinkedGraph&) = delete;
+    CityLinkedGraph& operator=(const CityLinkedGraph&) = delete;
+
+    AdjNode* node(int v) const { return nodes[v]; }
+
+    int vertexCount() const { return count; }
+    Edge firstEdge(int u) const { return nodes[u]->edgeHead; }
+    Edge endEdge(int) const { return nullptr; }
+    Edge nextEdge(Edge e) const { return e->next; }
+    int edgeTarget(Edge e) const { return (e->destAdj != nullptr) ? e->destAdj->routeIndex : -1; }
+    double edgeLength(Edge e) const { return e->distance; }
+    const CityTrafficPattern* edgeTraffic(Edge e) const { return e->traffic; }
+};
+
+
+// WEIGHT POLICIES
+// cost(graph, edge, distance at the tail); DBL_MAX closes the edge
+
+struct CityEdgeLength {
+    template <class Graph>
+    double operator()(const Graph& graph, typename Graph::Edge e, double) const {
+        return graph.edgeLength(e);
+    }
+};
+
+// Minutes to drive the edge when leaving the source at departMinute
+// (clock time) and reaching the tail du minutes later. With this weight
+// the kernel is the time-dependent Dijkstra: sc.dist[] holds minutes
+// after departure, which is exact as long as the profiles are FIFO.
+struct CityTimeDependentWeight {
+    double departMinute;
+
+    template <class Graph>
+    double operator()(const Graph& graph, typename Graph::Edge e, double du) const {
+        const CityTrafficPattern* traffic = graph.edgeTraffic(e);
+        if (traffic == nullptr) return freeFlowMinutes(graph.edgeLength(e));
+        return traffic->travelMinutes(graph.edgeLength(e), departMinute + du);
+    }
+};
+
+
+// GOAL POLICIES
+// onSettle(u) returns true to end the search once u is settled;
+// lowerBound(v) is 0 for plain Dijkstra, an A* estimate otherwise
+// (DBL_MAX = v cannot reach the goal, so it is never queued)
+
+// Settle everything reachable
+struct CitySettleAll {
+    bool onSettle(int) { return false; }
+    double lowerBound(int) { return 0; }
+};
+
+// Stop once one vertex is settled
+struct CityUntilTarget {
+    int target;
+    CityUntilTarget(int t) : target(t) {}
+    bool onSettle(int u) { return u == target; }
+    double lowerBound(int) { return 0; }
+};
+
+// Stop once 'count' vertices flagged in isTarget[] are settled
+struct CityUntilTargets {
+    const char* isTarget;
+    int count;
+    int settled;
+    CityUntilTargets(const char* flags, int n) : isTarget(flags), count(n), settled(0) {}
+    bool onSettle(int u) { return isTarget[u] && ++settled >= count; }
+    double lowerBound(int) { return 0; }
+};
+
+
+// THE KERNEL
+// Settle vertices from whatever is already queued in sc.heap.
+// Heap keys are distance + goal.lowerBound(), so a Goal with a bound turns
+// this into A*.
+template <class Graph, class Weight, class Goal, class Scratch>
+void citySearchFromQueued(const Graph& graph, const Weight& weight, Goal& goal, Scratch& sc) {
+    while (!sc.heap.isEmpty()) {
+        int u = sc.heap.extractMin();
+        sc.settle(u);
+        if (goal.onSettle(u)) break;
+
+        double du = sc.dist[u];
+        typename Graph::Edge end = graph.endEdge(u);
+        for (typename Graph::Edge e = graph.firstEdge(u); e != end; e = graph.nextEdge(e)) {
+            int v = graph.edgeTarget(e);
+            if (v < 0 || sc.isSettled(v)) continue;
+
+            double cost = weight(graph, e, du);
+            if (cost == DBL_MAX) continue;
+
+            double newDist = du + cost;
+            if (newDist < sc.distanceTo(v)) {
+                double hv = goal.lowerBound(v);
+                if (hv == DBL_MAX) continue;
+                sc.reach(v, newDist, u);
+                sc.heap.insertOrDecrease(v, newDist + hv);
+            }
+        }
+    }
+}
+
+// Shortest paths from src; distances and predecessors are left in sc
+template <class Graph, class Weight, class Goal, class Scratch>
+void cityShortestPaths(const Graph& graph, const Weight& weight, Goal& goal, int src, Scratch& sc) {
+    sc.prepare(graph.vertexCount());
+    double h = goal.lowerBound(src);
+    if (h == DBL_MAX) return;
+
+    sc.reach(src, 0, -1);
+    sc.heap.insertOrDecrease(src, h);
+    citySearchFromQueued(graph, weight, goal, sc);
+}
+
+// Several sources at once, all at distance 0: sc.dist[v] is the distance
+// from v's nearest source (following sc.prev back ends at that source)
+template <class Graph, class Weight, class Goal, class Scratch>
+void cityShortestPathsFromMany(const Graph& graph, const Weight& weight, Goal& goal,
+    const int sources[], int sourceCount, Scratch& sc) {
+    sc.prepare(graph.vertexCount());
+    for (int i = 0; i < sourceCount; i++) {
+        int src = sources[i];
+        double h = goal.lowerBound(src);
+        if (h == DBL_MAX || sc.distanceTo(src) == 0) continue;
+        sc.reach(src, 0, -1);
+        sc.heap.insertOrDecrease(src, h);
+    }
+    citySearchFromQueued(graph, weight, goal, sc);
+}
+
+// Same, costing every edge at its plain length
+template <class Graph, class Goal, class Scratch>
+void cityShortestPaths(const Graph& graph, Goal& goal, int src, Scratch& sc) {
+    cityShortestPaths(graph, CityEdgeLength(), goal, src, sc);
+}
+
+
+
+// K SHORTEST LOOPLESS PATHS (Yen)
+// The i-th path is found by deviating from an earlier one: for every
+// "spur" vertex along the previous path, keep its prefix (the root),
+// forbid the root's vertices and every next hop already taken by a found
+// path with that root, and search spur -> dest. The best of all
+// candidates found so far becomes the next path.
+// Candidates are kept between iterations, and (Lawler's rule) a path only
+// spawns spurs from its own deviation point onward: the roots before it
+// were already expanded when its parent path was. The spur searches of one
+// iteration are independent and run on the thread pool.
+
+// One ranked path: vertex indices from source to target
+struct CityRankedPath {
+    int* vertices;
+    double* prefix;     // prefix[i] = length of the path up to vertices[i]
+    int count;
+    double length;
+    int deviation;      // First vertex where it left the path it was derived from
+
+    CityRankedPath() : vertices(nullptr), prefix(nullptr), count(0), length(DBL_MAX), deviation(0) {}
+    ~CityRankedPath() { clear(); }
+
+    CityRankedPath(const CityRankedPath&) = delete;
+    CityRankedPath& operator=(const CityRankedPath&) = delete;
+
+    void allocate(int n) {
+        clear();
+        vertices = new int[n];
+        prefix = new double[n];
+        count = n;
+    }
+
+    void clear() {
+        delete[] vertices;
+        delete[] prefix;
+        vertices = nullptr;
+        prefix = nullptr;
+        count = 0;
+        length = DBL_MAX;
+        deviation = 0;
+    }
+
+    // Move other's path into this one, leaving other empty
+    void take(CityRankedPath& other) {
+        clear();
+        vertices = other.vertices;
+        prefix = other.prefix;
+        count = other.count;
+        length = other.length;
+        deviation = other.deviation;
+        other.vertices = nullptr;
+        other.prefix = nullptr;
+        other.count = 0;
+        other.length = DBL_MAX;
+    }
+
+    bool sameVertices(const CityRankedPath& other) const {
+        if (count != other.count) return false;
+        for (int i = 0; i < count; i++) {
+            if (vertices[i] != other.vertices[i]) return false;
+        }
+        return true;
+    }
+
+    // True if both paths start with the same first n vertices
+    bool sharesRoot(const CityRankedPath& other, int n) const {
+        if (count < n || other.count < n) return false;
+        for (int i = 0; i < n; i++) {
+            if (vertices[i] != other.vertices[i]) return false;
+        }
+        return true;
+    }
+};
+
+// Plain edge lengths, except for a short list of forbidden edges
+template <class Graph>
+struct CityDetourWeight {
+    const typename Graph::Edge* blocked;
+    int blockedCount;
+
+    double operator()(const Graph& graph, typename Graph::Edge e, double) const {
+        for (int i = 0; i < blockedCount; i++) {
+            if (blocked[i] == e) return DBL_MAX;
+        }
+        return graph.edgeLength(e);
+    }
+};
+
+// Stop at dest, never entering a marked (root) vertex
+struct CityDetourGoal {
+    int dest;
+    const CityVertexMarks* root;
+
+    bool onSettle(int u) { return u == dest; }
+    double lowerBound(int v) { return root->isMarked(v) ? DBL_MAX : 0; }
+};
+
+// Spur searches of one Yen iteration (a thread pool job)
+template <class Graph>
+struct CityYenJob {
+    const Graph* graph;
+    int dest;
+    CityRankedPath* const* found;   // Paths accepted so far
+    int foundCount;
+    const CityRankedPath* last;     // The path being deviated from
+    int firstSpur;
+    CityRankedPath* spurs;          // spurs[i] = candidate from spur vertex firstSpur + i
+
+    static void run(void* arg, int slot) {
+        CityYenJob* job = (CityYenJob*)arg;
+        const Graph& graph = *job->graph;
+        const CityRankedPath* last = job->last;
+        int spurIndex = job->firstSpur + slot;
+        int spur = last->vertices[spurIndex];
+
+        CityVertexMarks& root = getCityVertexMarks();
+        root.prepare(graph.vertexCount());
+        for (int i = 0; i < spurIndex; i++) {
+            root.mark(last->vertices[i]);
+        }
+
+        // Next hops already used by found paths with this same root
+        typedef typename Graph::Edge Edge;
+        int edgeCount = 0;
+        Edge end = graph.endEdge(spur);
+        for (Edge e = graph.firstEdge(spur); e != end; e = graph.nextEdge(e)) edgeCount++;
+        Edge* blocked = new Edge[edgeCount > 0 ? edgeCount : 1];
+        int blockedCount = 0;
+        for (int p = 0; p < job->foundCount; p++) {
+            const CityRankedPath* path = job->found[p];
+            if (path->count <= spurIndex + 1 || !path->sharesRoot(*last, spurIndex + 1)) continue;
+            int next = path->vertices[spurIndex + 1];
+            for (Edge e = graph.firstEdge(spur); e != end; e = graph.nextEdge(e)) {
+                if (graph.edgeTarget(e) != next) continue;
+                bool listed = false;
+                for (int b = 0; b < blockedCount && !listed; b++) listed = (blocked[b] == e);
+                if (!listed) blocked[blockedCount++] = e;
+            }
+        }
+
+        CityDetourWeight<Graph> weight = { blocked, blockedCount };
+        CityDetourGoal goal = { job->dest, &root };
+        CitySearchScratch& sc = getCitySearchScratch();
+        cityShortestPaths(graph, weight, goal, spur, sc);
+
+        CityRankedPath& candidate = job->spurs[slot];
+        if (sc.isSettled(job->dest)) {
+            int spurHops = sc.hopsTo(job->dest);
+            candidate.allocate(spurIndex + spurHops);
+            for (int i = 0; i < spurIndex; i++) {
+                candidate.vertices[i] = last->vertices[i];
+                candidate.prefix[i] = last->prefix[i];
+            }
+            double rootLength = last->prefix[spurIndex];
+            int pos = candidate.count - 1;
+            for (int v = job->dest; v != -1; v = sc.prev[v], pos--) {
+                candidate.vertices[pos] = v;
+                candidate.prefix[pos] = rootLength + sc.dist[v];
+            }
+            candidate.length = candidate.prefix[candidate.count - 1];
+            candidate.deviation = spurIndex;
+        }
+        delete[] blocked;
+    }
+};
+
+// Up to k shortest loopless src -> dest paths, shortest first; returns how
+// many exist. results[] must hold k entries.
+template <class Graph>
+int cityKShortestPaths(const Graph& graph, int src, int dest, int k, CityRankedPath results[]) {
+    if (k <= 0 || src < 0 || dest < 0) return 0;
+
+    CitySearchScratch& sc = getCitySearchScratch();
+    CityUntilTarget goal(dest);
+    cityShortestPaths(graph, goal, src, sc);
+    if (!sc.isSettled(dest)) return 0;
+
+    CityRankedPath& first = results[0];
+    first.allocate(sc.hopsTo(dest));
+    int pos = first.count - 1;
+    for (int v = dest; v != -1; v = sc.prev[v], pos--) {
+        first.vertices[pos] = v;
+        first.prefix[pos] = sc.dist[v];
+    }
+    first.length = sc.dist[dest];
+    first.deviation = 0;
+
+    CityRankedPath** found = new CityRankedPath * [k];
+    found[0] = &results[0];
+    int foundCount = 1;
+
+    // Candidate pool, shared by all iterations
+    int poolCapacity = 16;
+    int poolSize = 0;
+    CityRankedPath** pool = new CityRankedPath * [poolCapacity];
+
+    while (foundCount < k) {
+        const CityRankedPath* last = found[foundCount - 1];
+        int spurCount = last->count - 1 - last->deviation;
+
+        if (spurCount > 0) {
+            CityYenJob<Graph> job;
+            job.graph = &graph;
+            job.dest = dest;
+            job.found = found;
+            job.foundCount = foundCount;
+            job.last = last;
+            job.firstSpur = last->deviation;
+            job.spurs = new CityRankedPath[spurCount];
+            CityThreadPool::getInstance()->parallelFor(spurCount, CityYenJob<Graph>::run, &job);
+
+            for (int i = 0; i < spurCount; i++) {
+                CityRankedPath& candidate = job.spurs[i];
+                if (candidate.count == 0) continue;
+
+                bool duplicate = false;
+                for (int c = 0; c < poolSize && !duplicate; c++) {
+                    duplicate = (pool[c]->length == candidate.length && pool[c]->sameVertices(candidate));
+                }
+                if (duplicate) continue;
+
+                if (poolSize == poolCapacity) {
+                    poolCapacity *= 2;
+                    CityRankedPath** newPool = new CityRankedPath * [poolCapacity];
+                    for (int c = 0; c < poolSize; c++) newPool[c] = pool[c];
+                    delete[] pool;
+                    pool = newPool;
+                }
+                pool[poolSize] = new CityRankedPath();
+                pool[poolSize]->take(candidate);
+                poolSize++;
+            }
+            delete[] job.spurs;
+        }
+
+        if (poolSize == 0) break;
+
+        // Shortest candidate next (fewer stops breaks ties)
+        int best = 0;
+        for (int c = 1; c < poolSize; c++) {
+            if (pool[c]->length < pool[best]->length ||
+                (pool[c]->length == pool[best]->length && pool[c]->count < pool[best]->count)) {
+                best = c;
+            }
+        }
+        results[foundCount].take(*pool[best]);
+        delete pool[best];
+        pool[best] = pool[--poolSize];
+        found[foundCount] = &results[foundCount];
+        foundCount++;
+    }
+
+    for (int c = 0; c < poolSize; c++) delete pool[c];
+    delete[] pool;
+    delete[] found;
+    return foundCount;
+}
+
+
+
+// PARALLEL DELTA-STEPPING (Meyer & Sanders)
+// One-to-all distances for big networks. Tentative distances are sorted
+// into buckets of width delta; every vertex of the lowest non-empty bucket
+// is expanded at once on the thread pool. Light edges (length <= delta) may
+// refill the same bucket, so they are relaxed phase by phase until it stays
+// empty; heavy edges can only reach later buckets and are relaxed once per
+// bucket. Each final distance is still the minimum of (final tail distance
+// + edge length) over the incoming edges, so the result is exactly the
+// Dijkstra result. A small delta approaches Dijkstra (little parallel
+// work), a large one approaches Bellman-Ford (wasted relaxations).
+
+// Vertices expanded per thread pool task
+const int DELTA_STEP_CHUNK = 256;
+
+// Most buckets kept at once; a tiny delta is widened to stay within it
+const int DELTA_STEP_MAX_RING = 1 << 20;
+
+// Work done by one delta-stepping run
+struct CityDeltaStats {
+    double delta;
+    long long buckets;      // Non-empty buckets processed
+    long long phases;       // Parallel relaxation rounds
+    long long relaxations;  // Edges looked at
+
+    CityDeltaStats() : delta(0), buckets(0), phases(0), relaxations(0) {}
+};
+
+// Growable int list (one per task, reused between phases)
+struct CityIntList {
+    int* items;
+    int size;
+    int capacity;
+
+    CityIntList() : items(nullptr), size(0), capacity(0) {}
+    ~CityIntList() { delete[] items; }
+
+    CityIntList(const CityIntList&) = delete;
+    CityIntList& operator=(const CityIntList&) = delete;
+
+    void push(int v) {
+        if (size == capacity) {
+            int newCapacity = (capacity > 0) ? capacity * 2 : 64;
+            int* newItems = new int[newCapacity];
+            for (int i = 0; i < size; i++) newItems[i] = items[i];
+            delete[] items;
+            items = newItems;
+            capacity = newCapacity;
+        }
+        items[size++] = v;
+    }
+};
+
+// Bucket width from the edge lengths: twice the mean length. Nearly every
+// street is then light, and a bucket holds a couple of "rings" of the
+// search front - fewer synchronizing phases for about 1% extra relaxations
+template <class Graph>
+double cityAutoDelta(const Graph& graph) {
+    double total = 0;
+    long long edges = 0;
+    for (int u = 0; u < graph.vertexCount(); u++) {
+        typename Graph::Edge end = graph.endEdge(u);
+        for (typename Graph::Edge e = graph.firstEdge(u); e != end; e = graph.nextEdge(e)) {
+            if (graph.edgeTarget(e) < 0) continue;
+            total += graph.edgeLength(e);
+            edges++;
+        }
+    }
+    return (edges > 0 && total > 0) ? 2.0 * total / edges : 1.0;
+}
+
+template <class Graph>
+struct CityDeltaJob {
+    const Graph* graph;
+    atomic<double>* dist;
+    double delta;
+    bool heavy;                 // Relax edges longer than delta instead of the short ones
+    const int* frontier;
+    int frontierSize;
+    CityIntList* improved;      // improved[task] = vertices whose distance dropped
+    long long* relaxations;     // Per task
+
+    // Lower dist[v] to d if that is shorter; true if it was
+    static bool lowerTo(atomic<double>& slot, double d) {
+        double current = slot.load(memory_order_relaxed);
+        while (d < current) {
+            if (slot.compare_exchange_weak(current, d, memory_order_relaxed)) return true;
+        }
+        return false;
+    }
+
+    static void run(void* arg, int task) {
+        CityDeltaJob* job = (CityDeltaJob*)arg;
+        const Graph& graph = *job->graph;
+        CityIntList& out = job->improved[task];
+        out.size = 0;
+        long long relaxed = 0;
+
+        int from = task * DELTA_STEP_CHUNK;
+        int to = (from + DELTA_STEP_CHUNK < job->frontierSize) ? from + DELTA_STEP_CHUNK : job->frontierSize;
+        for (int i = from; i < to; i++) {
+            int u = job->frontier[i];
+            double du = job->dist[u].load(memory_order_relaxed);
+            typename Graph::Edge end = graph.endEdge(u);
+            for (typename Graph::Edge e = graph.firstEdge(u); e != end; e = graph.nextEdge(e)) {
+                int v = graph.edgeTarget(e);
+                if (v < 0) continue;
+                double w = graph.edgeLength(e);
+                if ((w > job->delta) != job->heavy) continue;
+                relaxed++;
+                if (lowerTo(job->dist[v], du + w)) out.push(v);
+            }
+        }
+        job->relaxations[task] = relaxed;
+    }
+};
+
+// Distances from src to every vertex into dist[] (DBL_MAX = unreachable).
+// delta <= 0 picks the width with cityAutoDelta.
+template <class Graph>
+CityDeltaStats cityDeltaStepping(const Graph& graph, int src, double dist[], double delta = 0) {
+    CityDeltaStats stats;
+    int n = graph.vertexCount();
+    for (int v = 0; v < n; v++) dist[v] = DBL_MAX;
+    if (src < 0 || src >= n) return stats;
+
+    if (delta <= 0) delta = cityAutoDelta(graph);
+
+    // Pending distances never run more than one longest edge past the
+    // current bucket, so a ring of buckets covering that span is enough
+    double longest = 0;
+    for (int u = 0; u < n; u++) {
+        typename Graph::Edge end = graph.endEdge(u);
+        for (typename Graph::Edge e = graph.firstEdge(u); e != end; e = graph.nextEdge(e)) {
+            if (graph.edgeTarget(e) >= 0 && graph.edgeLength(e) > longest) longest = graph.edgeLength(e);
+        }
+    }
+    if (longest / delta > DELTA_STEP_MAX_RING) delta = longest / DELTA_STEP_MAX_RING;
+    stats.delta = delta;
+    int ringSize = (int)(longest / delta) + 3;     // +1 for rounding in the bucket index
+    CityIntList* ring = new CityIntList[ringSize];
+    int pendingBuckets = 0;
+
+    atomic<double>* tentative = new atomic<double>[n];
+    long long* queuedIn = new long long[n];     // Bucket v is listed in (-1 = none)
+    long long* doneIn = new long long[n];       // Last bucket v was expanded in
+    for (int v = 0; v < n; v++) {
+        tentative[v].store(DBL_MAX, memory_order_relaxed);
+        queuedIn[v] = -1;
+        doneIn[v] = -1;
+    }
+
+    int frontierCapacity = 64;
+    int* frontier = new int[frontierCapacity];
+    int settledCapacity = 64;
+    int* settled = new int[settledCapacity];    // Expanded in the current bucket
+    int taskCapacity = 0;
+    CityIntList* improved = nullptr;
+    long long* relaxations = nullptr;
+
+    CityDeltaJob<Graph> job;
+    job.graph = &graph;
+    job.dist = tentative;
+    job.delta = delta;
+
+    tentative[src].store(0, memory_order_relaxed);
+    ring[0].push(src);
+    queuedIn[src] = 0;
+    pendingBuckets = 1;
+
+    CityThreadPool* pool = CityThreadPool::getInstance();
+
+    for (long long bucket = 0; pendingBuckets > 0; bucket++) {
+        CityIntList& current = ring[bucket % ringSize];
+        if (current.size == 0) continue;
+        stats.buckets++;
+        int settledCount = 0;
+
+        // Relax the light edges, then those of anything they pulled into
+        // this bucket, until it stays empty; finally the heavy edges
+        for (int round = 0; ; round++) {
+            bool heavy = (current.size == 0);
+            int frontierSize = 0;
+
+            if (!heavy) {
+                if (current.size > frontierCapacity) {
+                    delete[] frontier;
+                    while (frontierCapacity < current.size) frontierCapacity *= 2;
+                    frontier = new int[frontierCapacity];
+                }
+                for (int i = 0; i < current.size; i++) {
+                    int v = current.items[i];
+                    // Skip stale entries (moved to an earlier slot meanwhile, or duplicates)
+                    if (queuedIn[v] != bucket) continue;
+                    queuedIn[v] = -1;
+                    frontier[frontierSize++] = v;
+                    if (doneIn[v] != bucket) {
+                        doneIn[v] = bucket;
+                        if (settledCount == settledCapacity) {
+                            settledCapacity *= 2;
+                            int* newSettled = new int[settledCapacity];
+                            for (int j = 0; j < settledCount; j++) newSettled[j] = settled[j];
+                            delete[] settled;
+                            settled = newSettled;
+                        }
+                        settled[settledCount++] = v;
+                    }
+                }
+                current.size = 0;
+                pendingBuckets--;
+                if (frontierSize == 0) continue;
+                job.frontier = frontier;
+            }
+            else {
+                job.frontier = settled;
+                frontierSize = settledCount;
+            }
+
+            int tasks = (frontierSize + DELTA_STEP_CHUNK - 1) / DELTA_STEP_CHUNK;
+            if (tasks > taskCapacity) {
+                delete[] improved;
+                delete[] relaxations;
+                taskCapacity = tasks * 2;
+                improved = new CityIntList[taskCapacity];
+                relaxations = new long long[taskCapacity];
+            }
+            job.frontierSize = frontierSize;
+            job.heavy = heavy;
+            job.improved = improved;
+            job.relaxations = relaxations;
+            pool->parallelFor(tasks, CityDeltaJob<Graph>::run, &job);
+            stats.phases++;
+
+            // File every improved vertex under its new bucket
+            for (int t = 0; t < tasks; t++) {
+                stats.relaxations += relaxations[t];
+                for (int i = 0; i < improved[t].size; i++) {
+                    int v = improved[t].items[i];
+                    long long target = (long long)(tentative[v].load(memory_order_relaxed) / delta);
+                    // A heavy edge always leaves the bucket, but rounding can
+                    // floor it back into this one after its light loop ended
+                    long long earliest = heavy ? bucket + 1 : bucket;
+                    if (target < earliest) target = earliest;
+                    if (queuedIn[v] == target) continue;
+                    queuedIn[v] = target;
+                    CityIntList& slot = ring[target % ringSize];
+                    if (slot.size == 0) pendingBuckets++;
+                    slot.push(v);
+                }
+            }
+
+            if (heavy) break;
+        }
+    }
+
+    for (int v = 0; v < n; v++) {
+        dist[v] = tentative[v].load(memory_order_relaxed);
+    }
+
+    delete[] ring;
+    delete[] tentative;
+    delete[] queuedIn;
+    delete[] doneIn;
+    delete[] frontier;
+    delete[] settled;
+    delete[] improved;
+    delete[] relaxations;
+    return stats;
+}
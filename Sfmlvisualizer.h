@@ -860,4 +860,123 @@ public:
             window.display();
         }
     }
+
+    // REACHABILITY (ISOCHRONE) VISUALIZATION
+    // distances[i] is the road distance from the origin (DBL_MAX / beyond
+    // budget = not reachable); reachable locations are shaded green (near)
+    // to orange (at the budget), the rest are drawn small and grey
+    static void visualizeReachability(const string names[],
+        const double lats[],
+        const double lons[],
+        const double distances[],
+        int count,
+        int originIndex,
+        double budget) {
+        if (count == 0) {
+            cout << "No locations to visualize!" << endl;
+            return;
+        }
+
+        sf::RenderWindow window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), "Reachability Map");
+
+        // Find bounds
+        double minLat = lats[0], maxLat = lats[0];
+        double minLon = lons[0], maxLon = lons[0];
+
+        for (int i = 1; i < count; i++) {
+            if (lats[i] < minLat) minLat = lats[i];
+            if (lats[i] > maxLat) maxLat = lats[i];
+            if (lons[i] < minLon) minLon = lons[i];
+            if (lons[i] > maxLon) maxLon = lons[i];
+        }
+
+        double latPadding = (maxLat - minLat) * 0.1;
+        double lonPadding = (maxLon - minLon) * 0.1;
+        minLat -= latPadding; maxLat += latPadding;
+        minLon -= lonPadding; maxLon += lonPadding;
+
+        sf::Font font;
+        bool fontLoaded = font.loadFromFile("arial.ttf");
+
+        int reachable = 0;
+        for (int i = 0; i < count; i++) {
+            if (i != originIndex && distances[i] <= budget) reachable++;
+        }
+
+        while (window.isOpen()) {
+            sf::Event event;
+            while (window.pollEvent(event)) {
+                if (event.type == sf::Event::Closed)
+                    window.close();
+            }
+
+            window.clear(sf::Color(245, 245, 245));
+
+            // Title
+            if (fontLoaded) {
+                char title[200];
+                snprintf(title, sizeof(title), "Within %.4f units of %s: %d locations",
+                    budget, (originIndex >= 0 ? names[originIndex].c_str() : "?"), reachable);
+                sf::Text titleText(title, font, 24);
+                titleText.setPosition(10, 10);
+                titleText.setFillColor(sf::Color::Black);
+                window.draw(titleText);
+            }
+
+            // Unreachable first, so the shaded set draws on top
+            for (int pass = 0; pass < 2; pass++) {
+                for (int i = 0; i < count; i++) {
+                    if (i == originIndex) continue;
+                    bool inside = (distances[i] <= budget);
+                    if (inside != (pass == 1)) continue;
+
+                    sf::Vector2f pos = latLonToScreen(lats[i], lons[i],
+                        minLat, maxLat, minLon, maxLon);
+
+                    float radius = inside ? 9.0f : 5.0f;
+                    sf::CircleShape circle(radius);
+                    circle.setPosition(pos.x - radius, pos.y - radius);
+                    if (inside) {
+                        double t = (budget > 0) ? distances[i] / budget : 0;
+                        circle.setFillColor(sf::Color((sf::Uint8)(60 + 195 * t), (sf::Uint8)(200 - 60 * t), 60));
+                        circle.setOutlineColor(sf::Color::Black);
+                        circle.setOutlineThickness(1);
+                    }
+                    else {
+                        circle.setFillColor(sf::Color(190, 190, 190));
+                    }
+                    window.draw(circle);
+
+                    if (inside && fontLoaded) {
+                        sf::Text label(names[i], font, 10);
+                        label.setPosition(pos.x + 11, pos.y - 7);
+                        label.setFillColor(sf::Color::Black);
+                        window.draw(label);
+                    }
+                }
+            }
+
+            // Origin
+            if (originIndex >= 0) {
+                sf::Vector2f pos = latLonToScreen(lats[originIndex], lons[originIndex],
+                    minLat, maxLat, minLon, maxLon);
+                sf::CircleShape origin(13);
+                origin.setPosition(pos.x - 13, pos.y - 13);
+                origin.setFillColor(sf::Color(30, 60, 160));
+                origin.setOutlineColor(sf::Color::Black);
+                origin.setOutlineThickness(2);
+                window.draw(origin);
+
+                if (fontLoaded) {
+                    sf::Text label(names[originIndex], font, 13);
+                    label.setPosition(pos.x + 15, pos.y - 9);
+                    label.setFillColor(sf::Color(30, 60, 160));
+                    label.setStyle(sf::Text::Bold);
+                    window.draw(label);
+                }
+            }
+
+            window.display();
+        }
+    }
 };
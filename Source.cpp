@@ -3,6 +3,8 @@
 #include <string>
 #include <cmath>
 #include <cfloat>
+#include <chrono>
+#include <new>
 
 using namespace std;
 
@@ -27,6 +29,9 @@ const string BOLD = "\033[1m";
 #include "Facilities.h"
 #include "Population.h"
 #include "BonusModules.h" 
+#include "ContractionHierarchy.h"
+#include "RoadOverlay.h"
+#include "LoadPipeline.h"
 #include "../Project1/Sfmlvisualizer.h"
 
 
@@ -60,6 +65,11 @@ void displayMainMenu() {
     cout << GREEN << "8.  " << RESET << "Load All Data from Files" << endl;
     cout << MAGENTA << "9.  BONUS MODULES (Extended Features)" << RESET << endl;
     cout << MAGENTA << "10. SFML GRAPHICAL VISUALIZATIONS" << RESET << endl;  // NEW!
+    cout << GREEN << "11. " << RESET << "City Route Planner (Contraction Hierarchies)" << endl;
+    cout << GREEN << "12. " << RESET << "Distance Matrix (Planning)" << endl;
+    cout << GREEN << "13. " << RESET << "Reachability Within Distance (Isochrone)" << endl;
+    cout << GREEN << "14. " << RESET << "Road Closure What-If" << endl;
+    cout << GREEN << "15. " << RESET << "Save City Snapshot" << endl;
     cout << RED << "0.  Exit" << RESET << endl;
     cout << BLUE << "===================================================" << RESET << endl;
 }
@@ -108,6 +118,16 @@ void displayTransportMenu() {
     cout << YELLOW << "--- Statistics ---" << RESET << endl;
     cout << "28. Display Statistics" << endl;
     cout << endl;
+    cout << YELLOW << "--- Alternate Routes ---" << RESET << endl;
+    cout << "29. Find Alternate Routes (k Shortest Paths)" << endl;
+    cout << endl;
+    cout << YELLOW << "--- Time-of-Day Routing ---" << RESET << endl;
+    cout << "30. Plan Trip by Departure Time" << endl;
+    cout << "31. School Bus Timetable (Traffic-Aware)" << endl;
+    cout << endl;
+    cout << YELLOW << "--- Goal-Directed Routing ---" << RESET << endl;
+    cout << "32. Find Shortest Path (A*)" << endl;
+    cout << endl;
     cout << RED << "0.  Back to Main Menu" << RESET << endl;
     cout << CYAN << "=====================================================" << RESET << endl;
 }
@@ -218,6 +238,24 @@ void handleTransportMenu() {
             transportSystem.displayStatistics();
             break;
 
+            // Alternate Routes
+        case 29:
+            transportSystem.findAlternateRoutes();
+            break;
+
+            // Time-of-Day Routing
+        case 30:
+            transportSystem.planTripByDepartureTime();
+            break;
+        case 31:
+            transportSystem.displaySchoolBusTimetable();
+            break;
+
+            // Goal-Directed Routing
+        case 32:
+            transportSystem.findShortestPath(true);
+            break;
+
 
         default: cout << RED << "Invalid choice!  Please try again." << RESET << endl;
         }
@@ -260,6 +298,9 @@ void displayMedicalMenu() {
     cout << YELLOW << "--- Statistics ---" << RESET << endl;
     cout << "21. Display Statistics" << endl;
     cout << endl;
+    cout << YELLOW << "--- Navigation ---" << RESET << endl;
+    cout << "22. Find Nearest Hospitals by Road" << endl;
+    cout << endl;
     cout << RED << "0.   Back to Main Menu" << RESET << endl;
     cout << CYAN << "=====================================================" << RESET << endl;
 }
@@ -343,6 +384,11 @@ void handleMedicalMenu() {
             medicalSystem.displayStatistics();
             break;
 
+            // Navigation
+        case 22:
+            medicalSystem.findNearestHospitalsByRoad();
+            break;
+
 
         default: cout << RED << "Invalid choice!  Please try again." << RESET << endl;
         }
@@ -673,6 +719,7 @@ void displayFacilitiesMenu() {
     cout << endl;
     cout << YELLOW << "--- Navigation ---" << RESET << endl;
     cout << "19. Find Shortest Path" << endl;
+    cout << "21. Nearest Fire Station by Road" << endl;
     cout << endl;
     cout << YELLOW << "--- Statistics ---" << RESET << endl;
     cout << "20.  Display Statistics" << endl;
@@ -759,6 +806,9 @@ void handleFacilitiesMenu() {
         case 19:
             facilitiesSystem.findShortestPath();
             break;
+        case 21:
+            facilitiesSystem.findNearestFireStationByRoad();
+            break;
 
             // Statistics
         case 20:
@@ -915,32 +965,84 @@ void displaySystemStatistics() {
     GlobalLocationManager* locMgr = GlobalLocationManager::getInstance();
     cout << "Total Registered Locations: " << locMgr->getLocationCount() << endl;
 
+    cout << "\n" << YELLOW << "=== Shortest Path Caches ===" << RESET << endl;
+    CityGraph::getInstance()->getPathCache().displayStats("City Graph");
+    transportSystem.getPathCache().displayStats("Transport");
+    commercialSystem.getPathCache().displayStats("Commercial Delivery");
+
+    cout << "\n" << YELLOW << "=== Road Network Components ===" << RESET << endl;
+    CityGraph* cityGraph = CityGraph::getInstance();
+    cout << "Components: " << cityGraph->getComponentCount() << " (largest: "
+        << cityGraph->getLargestComponentSize() << " of " << cityGraph->getLocationCount() << " locations)" << endl;
+    int histogram[4];
+    cityGraph->getComponentSizeHistogram(histogram, 4);
+    cout << "Sizes: 1-9: " << histogram[0] << ", 10-99: " << histogram[1] << ", 100-999: " << histogram[2]
+        << ", 1000+: " << histogram[3] << endl;
+    cout << "Unreachable route queries rejected: " << cityGraph->getUnreachableRejectedCount() << endl;
+
+    cout << "\n" << YELLOW << "=== Maintained Nearest-Source Trees ===" << RESET << endl;
+    for (CityShortestPathTree* tree = CityGraph::getInstance()->getHotSourceTrees(); tree != nullptr; tree = tree->next) {
+        cout << tree->getName() << ": " << tree->getSourceCount() << " sources, "
+            << tree->getUpdateCount() << " updates, " << tree->getTouchedCount() << " locations recomputed" << endl;
+    }
+
     cout << "\n" << CYAN << "============================================" << RESET << endl;
 }
 
 // LOAD ALL DATA
 
-void loadAllData() {
-    cout << "\n" << BOLD << GREEN << "=== Loading All Data from Files ===" << RESET << endl;
-    cout << "-----------------------------------" << endl;
-
-    cout << "\n" << CYAN << "[1/6] Loading Transport Data..." << RESET << endl;
-    transportSystem.loadFromFiles();
-
-    cout << "\n" << CYAN << "[2/6] Loading Medical Data..." << RESET << endl;
-    medicalSystem.loadFromFiles();
+// Milliseconds elapsed since start
+double elapsedMs(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
 
-    cout << "\n" << CYAN << "[3/6] Loading Education Data..." << RESET << endl;
-    educationSystem.loadFromFile();
+void mergeTransport(void*) { transportSystem.loadFromFiles(); }
+void mergeMedical(void*) { medicalSystem.loadFromFiles(); }
+void mergeEducation(void*) { educationSystem.loadFromFile(); }
+void mergeCommercial(void*) { commercialSystem.loadFromFiles(); }
+void mergeFacilities(void*) { facilitiesSystem.loadFromFile(); }
+void mergePopulation(void*) { populationSystem.loadFromFile(); }
 
-    cout << "\n" << CYAN << "[4/6] Loading Commercial Data..." << RESET << endl;
-    commercialSystem.loadFromFiles();
+// Load (or build and cache) the route hierarchy for the loaded road network
+void buildRouteIndex(void* hierarchy) { ((CityContractionHierarchy*)hierarchy)->ensureBuilt(); }
 
-    cout << "\n" << CYAN << "[5/6] Loading Facilities Data..." << RESET << endl;
-    facilitiesSystem.loadFromFile();
+// Files are read and tokenized in the background while earlier modules
+// merge; see LoadPipeline.h
+void loadAllData() {
+    cout << "\n" << BOLD << GREEN << "=== Loading All Data from Files ===" << RESET << endl;
+    cout << "-----------------------------------" << endl;
 
-    cout << "\n" << CYAN << "[6/6] Loading Population Data..." << RESET << endl;
-    populationSystem.loadFromFile();
+    const char* transportFiles[] = { "stops.csv", "busstops.csv", "roads.csv", "traffic.csv", "buses.csv" };
+    const char* medicalFiles[] = { "hospitals.csv", "pharmacies.csv" };
+    const char* educationFiles[] = { "schools.csv" };
+    const char* commercialFiles[] = { "malls.csv", "products.csv" };
+    const char* facilitiesFiles[] = { "facilities.csv" };
+    const char* populationFiles[] = { "population.csv" };
+
+    CityLoadPipeline pipeline;
+    pipeline.addStage("Transport Data", transportFiles, 5, mergeTransport, nullptr);
+    pipeline.addStage("Medical Data", medicalFiles, 2, mergeMedical, nullptr);
+    pipeline.addStage("Education Data", educationFiles, 1, mergeEducation, nullptr);
+    pipeline.addStage("Commercial Data", commercialFiles, 2, mergeCommercial, nullptr);
+    pipeline.addStage("Facilities Data", facilitiesFiles, 1, mergeFacilities, nullptr);
+    pipeline.addStage("Population Data", populationFiles, 1, mergePopulation, nullptr);
+    // Citizens have no map locations, so the routes are final after facilities.
+    // The hierarchy is created here, not on the index thread.
+    CityContractionHierarchy* routeIndex = CityContractionHierarchy::getInstance();
+    pipeline.setIndexJob(buildRouteIndex, routeIndex, 5);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    pipeline.start();
+    int stageCount = pipeline.getStageCount();
+    for (int i = 0; i < stageCount; i++) {
+        CityLoadStage& stage = pipeline.getStage(i);
+        cout << "\n" << CYAN << "[" << (i + 1) << "/" << stageCount << "] Loading " << stage.title << "..." << RESET << endl;
+        pipeline.mergeStage(i);
+        cout << "Stages: read " << stage.readMs << " ms, parse " << stage.parseMs << " ms ("
+            << stage.rows << " rows, " << stage.chunks << " chunks), merge " << stage.mergeMs << " ms" << endl;
+    }
+    pipeline.finish();
+    double totalMs = elapsedMs(start);
 
     cout << "\n-----------------------------------" << endl;
     cout << BOLD << GREEN << "All data loaded successfully!" << RESET << endl;
@@ -956,6 +1058,484 @@ void loadAllData() {
     cout << "Malls: " << commercialSystem.getMallCount() << endl;
     cout << "Facilities: " << facilitiesSystem.getFacilityCount() << endl;
     cout << "Citizens: " << populationSystem.getCitizenCount() << endl;
+    cout << "Route planner shortcuts: " << routeIndex->getShortcutCount()
+        << " (built in " << pipeline.getIndexMs() << " ms alongside the population merge)" << endl;
+    cout << "Total load time: " << totalMs << " ms" << endl;
+}
+
+// CITY SNAPSHOT
+
+bool citySnapshotExists() {
+    ifstream file(CITY_SNAPSHOT_FILE.c_str(), ios::binary);
+    return file.is_open();
+}
+
+bool cityIsEmpty() {
+    return GlobalLocationManager::getInstance()->getLocationCount() == 0 &&
+        transportSystem.getStopCount() == 0 && transportSystem.getBusCount() == 0 &&
+        medicalSystem.getHospitalCount() == 0 && medicalSystem.getPharmacyCount() == 0 &&
+        educationSystem.getSchoolCount() == 0 && commercialSystem.getMallCount() == 0 &&
+        facilitiesSystem.getFacilityCount() == 0 && populationSystem.getCitizenCount() == 0 &&
+        bonusModulesMenu.getHubCount() == 0;
+}
+
+void saveCitySnapshot() {
+    cout << "\n" << BOLD << GREEN << "=== Save City Snapshot ===" << RESET << endl;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    CitySnapshotWriter out;
+    if (!out.open(CITY_SNAPSHOT_FILE)) {
+        cout << RED << "Error: Could not create " << CITY_SNAPSHOT_FILE << RESET << endl;
+        return;
+    }
+
+    writeTrafficSnapshot(out);
+    GlobalLocationManager::getInstance()->writeSnapshot(out);
+    CityGraph::getInstance()->writeSnapshot(out);
+    transportSystem.writeSnapshot(out);
+    medicalSystem.writeSnapshot(out);
+    educationSystem.writeSnapshot(out);
+    commercialSystem.writeSnapshot(out);
+    facilitiesSystem.writeSnapshot(out);
+    populationSystem.writeSnapshot(out);
+    bonusModulesMenu.writeSnapshot(out);
+
+    if (!out.finish()) {
+        cout << RED << "Error: Could not write " << CITY_SNAPSHOT_FILE << RESET << endl;
+        return;
+    }
+
+    cout << "Saved " << CITY_SNAPSHOT_FILE << " (" << out.getSize() / 1024 << " KB) in "
+        << elapsedMs(start) << " ms" << endl;
+}
+
+// Destroy a module and construct it again in place, empty
+template <class Module>
+void resetModule(Module& module) {
+    module.~Module();
+    new (&module) Module();
+}
+
+// Back to an empty city, for a snapshot that failed part-way through
+void resetCity() {
+    resetModule(transportSystem);
+    resetModule(medicalSystem);
+    resetModule(educationSystem);
+    resetModule(commercialSystem);
+    resetModule(facilitiesSystem);
+    resetModule(populationSystem);
+    resetModule(bonusModulesMenu);
+    CityGraph::getInstance()->reset();
+    GlobalLocationManager::getInstance()->reset();
+}
+
+// Restores the whole city from the snapshot. A file that is missing, stale,
+// from another version or damaged is rejected before anything is touched;
+// one that fails while restoring leaves an empty city. Either way the
+// result is false and the CSV import can run instead.
+bool loadCitySnapshot() {
+    cout << "\n" << BOLD << GREEN << "=== Loading City Snapshot ===" << RESET << endl;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    if (!cityIsEmpty()) {
+        cout << RED << "Error: A snapshot can only be loaded into an empty city." << RESET << endl;
+        return false;
+    }
+
+    CitySnapshotReader in;
+    if (!in.open(CITY_SNAPSHOT_FILE)) {
+        cout << RED << "Error: " << in.getError() << RESET << endl;
+        return false;
+    }
+
+    CityGraph* cityGraph = CityGraph::getInstance();
+    CitySnapshotLinks links;
+    bool ok = readTrafficSnapshot(in, links) &&
+        GlobalLocationManager::getInstance()->readSnapshot(in) &&
+        cityGraph->beginSnapshotRestore(in, links) &&
+        transportSystem.readSnapshot(in, links) &&
+        medicalSystem.readSnapshot(in, links) &&
+        educationSystem.readSnapshot(in, links) &&
+        commercialSystem.readSnapshot(in, links) &&
+        facilitiesSystem.readSnapshot(in, links) &&
+        populationSystem.readSnapshot(in) &&
+        bonusModulesMenu.readSnapshot(in, links) &&
+        cityGraph->readSnapshot(in, links);
+
+    if (!ok) {
+        // The checksum passed, so this is a file written by a different build
+        cout << RED << "Error: Snapshot contents do not match this build"
+            << (in.getError().empty() ? string("") : " (" + in.getError() + ")") << "." << RESET << endl;
+        cout << RED << "The snapshot was discarded; import the CSV files instead." << RESET << endl;
+        resetCity();
+        return false;
+    }
+    double restoreMs = elapsedMs(start);
+
+    cout << "Restored " << CITY_SNAPSHOT_FILE << " (" << in.getSize() / 1024 << " KB) in "
+        << restoreMs << " ms" << endl;
+    cout << "Bus Stops: " << transportSystem.getStopCount() << endl;
+    cout << "Buses: " << transportSystem.getBusCount() << endl;
+    cout << "Hospitals: " << medicalSystem.getHospitalCount() << endl;
+    cout << "Pharmacies: " << medicalSystem.getPharmacyCount() << endl;
+    cout << "Schools: " << educationSystem.getSchoolCount() << endl;
+    cout << "Malls: " << commercialSystem.getMallCount() << endl;
+    cout << "Facilities: " << facilitiesSystem.getFacilityCount() << endl;
+    cout << "Citizens: " << populationSystem.getCitizenCount() << endl;
+
+    // The road network is identical, so this normally hits the route cache
+    CityContractionHierarchy::getInstance()->ensureBuilt();
+    cout << "Route planner shortcuts: " << CityContractionHierarchy::getInstance()->getShortcutCount() << endl;
+    return true;
+}
+
+// CITY ROUTE PLANNER
+
+void cityRoutePlanner() {
+    cout << "\n" << BOLD << CYAN << "============== CITY ROUTE PLANNER ==============" << RESET << endl;
+
+    CityGraph* cityGraph = CityGraph::getInstance();
+    if (cityGraph->getLocationCount() < 2) {
+        cout << RED << "Need at least 2 locations. Please load data first (Main Menu -> 8)" << RESET << endl;
+        return;
+    }
+
+    string srcID = getStringInput("Enter Source Location ID: ");
+    CityLocation* srcLoc = cityGraph->findLocationByID(srcID);
+    if (srcLoc == nullptr) {
+        cout << RED << "Location '" << srcID << "' not found!" << RESET << endl;
+        return;
+    }
+
+    string destID = getStringInput("Enter Destination Location ID: ");
+    CityLocation* destLoc = cityGraph->findLocationByID(destID);
+    if (destLoc == nullptr) {
+        cout << RED << "Location '" << destID << "' not found!" << RESET << endl;
+        return;
+    }
+
+    CityContractionHierarchy* ch = CityContractionHierarchy::getInstance();
+    if (ch->isStale()) {
+        cout << CYAN << "Road network changed, updating route hierarchy..." << RESET << endl;
+    }
+
+    int maxPathLen = cityGraph->getLocationCount();
+    string* path = new string[maxPathLen];
+    int pathLen = 0;
+    double distance = ch->findShortestPath(srcID, destID, path, pathLen, maxPathLen);
+
+    if (distance == DBL_MAX) {
+        cout << RED << "No road route between '" << srcLoc->name << "' and '" << destLoc->name << "'." << RESET << endl;
+    }
+    else {
+        cout << "\n" << YELLOW << "=== Route Found ===" << RESET << endl;
+        cout << "From: " << srcLoc->name << " [" << locationTypeToString(srcLoc->type) << "]" << endl;
+        cout << "To: " << destLoc->name << " [" << locationTypeToString(destLoc->type) << "]" << endl;
+        cout << "Total Distance: " << distance << " units" << endl;
+        cout << "\nPath: ";
+        for (int i = 0; i < pathLen; i++) {
+            CityLocation* loc = cityGraph->findLocationByID(path[i]);
+            if (i > 0) cout << " -> ";
+            cout << (loc ? loc->name : path[i]);
+        }
+        cout << endl;
+    }
+
+    delete[] path;
+}
+
+
+// Road distances from every location of one type to every location of another
+void cityDistanceMatrix() {
+    cout << "\n" << BOLD << CYAN << "============== DISTANCE MATRIX ==============" << RESET << endl;
+
+    CityGraph* cityGraph = CityGraph::getInstance();
+    int total = cityGraph->getLocationCount();
+    if (total < 2) {
+        cout << RED << "Need at least 2 locations. Please load data first (Main Menu -> 8)" << RESET << endl;
+        return;
+    }
+
+    for (int t = 0; t < LOCATION_TYPE_COUNT; t++) {
+        cout << (t + 1) << ". " << locationTypeToString(t) << endl;
+    }
+    int srcType = getIntInput("Origin type: ") - 1;
+    int destType = getIntInput("Destination type: ") - 1;
+    if (srcType < 0 || srcType >= LOCATION_TYPE_COUNT || destType < 0 || destType >= LOCATION_TYPE_COUNT) {
+        cout << RED << "Invalid type!" << RESET << endl;
+        return;
+    }
+
+    CityLocation** origins = new CityLocation * [total];
+    CityLocation** destinations = new CityLocation * [total];
+    int originCount = cityGraph->getLocationsOfType(srcType, origins, total);
+    int destCount = cityGraph->getLocationsOfType(destType, destinations, total);
+
+    if (originCount == 0 || destCount == 0) {
+        cout << RED << "No locations of the selected type(s)." << RESET << endl;
+        delete[] origins;
+        delete[] destinations;
+        return;
+    }
+
+    string* sources = new string[originCount];
+    string* targets = new string[destCount];
+    for (int i = 0; i < originCount; i++) sources[i] = origins[i]->id;
+    for (int i = 0; i < destCount; i++) targets[i] = destinations[i]->id;
+
+    CityDistanceMatrix matrix;
+    cityGraph->distanceMatrix(sources, originCount, targets, destCount, matrix);
+
+    cout << "\n" << YELLOW << "=== " << locationTypeToString(srcType) << " x " << locationTypeToString(destType)
+        << " (" << originCount << " x " << destCount << ", " << CityThreadPool::getInstance()->getThreadCount()
+        << " threads) ===" << RESET << endl;
+
+    // Closest destination per origin (first 20 origins)
+    int shown = (originCount < 20) ? originCount : 20;
+    int unreachable = 0;
+    for (int r = 0; r < originCount; r++) {
+        int best = -1;
+        for (int c = 0; c < destCount; c++) {
+            if (matrix.at(r, c) == DBL_MAX) {
+                unreachable++;
+            }
+            else if (origins[r] != destinations[c] && (best == -1 || matrix.at(r, c) < matrix.at(r, best))) {
+                best = c;
+            }
+        }
+
+        if (r < shown) {
+            cout << origins[r]->name << " -> ";
+            if (best == -1) cout << RED << "no reachable destination" << RESET << endl;
+            else cout << destinations[best]->name << " (" << matrix.at(r, best) << " units)" << endl;
+        }
+    }
+    if (originCount > shown) {
+        cout << "... " << (originCount - shown) << " more origins" << endl;
+    }
+    cout << "Unreachable pairs: " << unreachable << " of " << (originCount * destCount) << endl;
+
+    delete[] sources;
+    delete[] targets;
+    delete[] origins;
+    delete[] destinations;
+}
+
+
+// Everything within a road-distance budget of one location, or a summary
+// for every location of one type (searched in parallel)
+void cityReachability() {
+    cout << "\n" << BOLD << CYAN << "============== REACHABILITY (ISOCHRONE) ==============" << RESET << endl;
+
+    CityGraph* cityGraph = CityGraph::getInstance();
+    int total = cityGraph->getLocationCount();
+    if (total < 2) {
+        cout << RED << "Need at least 2 locations. Please load data first (Main Menu -> 8)" << RESET << endl;
+        return;
+    }
+
+    cout << "1. From one location" << endl;
+    cout << "2. From every location of a type" << endl;
+    int mode = getIntInput("Choice: ");
+
+    if (mode == 1) {
+        string originID = getStringInput("Enter Origin Location ID (e.g. a bus stop or house): ");
+        CityLocation* origin = cityGraph->findLocationByID(originID);
+        if (origin == nullptr) {
+            cout << RED << "Location '" << originID << "' not found!" << RESET << endl;
+            return;
+        }
+        double budget = getDoubleInput("Maximum road distance: ");
+        if (budget < 0) {
+            cout << RED << "Distance cannot be negative!" << RESET << endl;
+            return;
+        }
+
+        CityIsochrone area;
+        int found = cityGraph->findWithinDistance(originID, budget, area);
+        cout << "\n" << YELLOW << "=== Within " << budget << " units of " << origin->name << ": "
+            << found << " locations ===" << RESET << endl;
+
+        const int SHOWN_PER_TYPE = 10;
+        for (int t = 0; t < LOCATION_TYPE_COUNT; t++) {
+            int n = area.countOfType(t);
+            if (n == 0) continue;
+            cout << "\n" << locationTypeToString(t) << " (" << n << "):" << endl;
+            for (int i = area.typeStart[t]; i < area.typeStart[t + 1] && i < area.typeStart[t] + SHOWN_PER_TYPE; i++) {
+                CityLocation* loc = cityGraph->findLocationByID(area.ids[i]);
+                cout << "  " << (loc ? loc->name : area.ids[i]) << " - " << area.distances[i] << " units" << endl;
+            }
+            if (n > SHOWN_PER_TYPE) cout << "  ... " << (n - SHOWN_PER_TYPE) << " more" << endl;
+        }
+        if (found == 0) cout << "Nothing else is reachable within that distance." << endl;
+        return;
+    }
+
+    if (mode != 2) {
+        cout << RED << "Invalid choice!" << RESET << endl;
+        return;
+    }
+
+    for (int t = 0; t < LOCATION_TYPE_COUNT; t++) {
+        cout << (t + 1) << ". " << locationTypeToString(t) << endl;
+    }
+    int originType = getIntInput("Origin type: ") - 1;
+    if (originType < 0 || originType >= LOCATION_TYPE_COUNT) {
+        cout << RED << "Invalid type!" << RESET << endl;
+        return;
+    }
+    double budget = getDoubleInput("Maximum road distance: ");
+    if (budget < 0) {
+        cout << RED << "Distance cannot be negative!" << RESET << endl;
+        return;
+    }
+
+    CityLocation** origins = new CityLocation * [total];
+    int originCount = cityGraph->getLocationsOfType(originType, origins, total);
+    if (originCount == 0) {
+        cout << RED << "No locations of the selected type." << RESET << endl;
+        delete[] origins;
+        return;
+    }
+
+    string* originIDs = new string[originCount];
+    for (int i = 0; i < originCount; i++) originIDs[i] = origins[i]->id;
+    CityIsochrone* areas = new CityIsochrone[originCount];
+    cityGraph->findWithinDistanceBatch(originIDs, originCount, budget, areas);
+
+    cout << "\n" << YELLOW << "=== Within " << budget << " units of each " << locationTypeToString(originType)
+        << " (" << originCount << " origins, " << CityThreadPool::getInstance()->getThreadCount()
+        << " threads) ===" << RESET << endl;
+
+    int shown = (originCount < 20) ? originCount : 20;
+    int noHospital = 0;
+    for (int i = 0; i < originCount; i++) {
+        if (areas[i].countOfType(LOC_HOSPITAL) == 0) noHospital++;
+        if (i >= shown) continue;
+        cout << origins[i]->name << ": " << areas[i].countOfType(LOC_SCHOOL) << " schools, "
+            << areas[i].countOfType(LOC_HOSPITAL) << " hospitals, " << areas[i].countOfType(LOC_MALL)
+            << " malls (" << areas[i].count << " locations)" << endl;
+    }
+    if (originCount > shown) {
+        cout << "... " << (originCount - shown) << " more origins" << endl;
+    }
+    cout << "Origins with no hospital in reach: " << noHospital << " of " << originCount << endl;
+
+    delete[] areas;
+    delete[] originIDs;
+    delete[] origins;
+}
+
+// Road closure what-if: edits go into an overlay, the live graph is never touched
+void cityRoadClosureWhatIf() {
+    cout << "\n" << BOLD << CYAN << "============== ROAD CLOSURE WHAT-IF ==============" << RESET << endl;
+
+    CityGraph* cityGraph = CityGraph::getInstance();
+    if (cityGraph->getLocationCount() < 2) {
+        cout << RED << "Need at least 2 locations. Please load data first (Main Menu -> 8)" << RESET << endl;
+        return;
+    }
+
+    CityRoadOverlay scenario(getStringInput("Scenario name (e.g. Marathon Sunday): "));
+    const int MAX_PATH = 500;
+    string path[MAX_PATH];
+    int pathLen = 0;
+
+    int choice;
+    do {
+        cout << "\n" << YELLOW << "--- Scenario: " << scenario.getName() << " (" << scenario.getChangeCount()
+            << " changes) ---" << RESET << endl;
+        cout << "1. Close Road" << endl;
+        cout << "2. Open Temporary Road" << endl;
+        cout << "3. Change Road Length (detour)" << endl;
+        cout << "4. Compare Route (before / after)" << endl;
+        cout << "5. Facility Access Report" << endl;
+        cout << "6. List Changes" << endl;
+        cout << "0. Discard Scenario and Return" << endl;
+        choice = getIntInput("Enter choice: ");
+
+        if (choice >= 1 && choice <= 3) {
+            string id1 = getStringInput("First Location ID: ");
+            string id2 = getStringInput("Second Location ID: ");
+            bool ok;
+            if (choice == 1) {
+                ok = scenario.closeRoad(id1, id2);
+            }
+            else if (choice == 2) {
+                ok = scenario.addRoad(id1, id2, getDoubleInput("Length (-1 = straight line): "));
+            }
+            else {
+                ok = scenario.setRoadLength(id1, id2, getDoubleInput("New length: "));
+            }
+            if (!ok) {
+                cout << RED << "Unknown location ID or invalid length!" << RESET << endl;
+                continue;
+            }
+            cout << GREEN << "Change recorded." << RESET << endl;
+            if (scenario.getUnresolvedCount() > 0) {
+                cout << YELLOW << "Note: " << scenario.getUnresolvedCount()
+                    << " change(s) name a road that does not exist and have no effect." << RESET << endl;
+            }
+        }
+        else if (choice == 4) {
+            string srcID = getStringInput("Enter Source Location ID: ");
+            string destID = getStringInput("Enter Destination Location ID: ");
+            double before = cityGraph->findShortestPath(srcID, destID, path, pathLen, MAX_PATH);
+            double after = scenario.findShortestPath(srcID, destID, path, pathLen, MAX_PATH);
+
+            cout << "Before: ";
+            if (before == DBL_MAX) cout << "no route" << endl;
+            else cout << before << " units" << endl;
+            cout << "After:  ";
+            if (after == DBL_MAX) {
+                cout << RED << "no route" << RESET << endl;
+                continue;
+            }
+            cout << after << " units";
+            if (before != DBL_MAX) cout << " (" << (after >= before ? "+" : "") << (after - before) << ")";
+            cout << endl << "Route: ";
+            for (int i = 0; i < pathLen; i++) {
+                CityLocation* loc = cityGraph->findLocationByID(path[i]);
+                if (i > 0) cout << " -> ";
+                cout << (loc ? loc->name : path[i]);
+            }
+            cout << endl;
+        }
+        else if (choice == 5) {
+            const int types[] = { LOC_HOSPITAL, LOC_SCHOOL, LOC_PHARMACY, LOC_FACILITY };
+            cout << "\n" << YELLOW << "=== Distance to Nearest Facility: " << scenario.getName() << " ===" << RESET << endl;
+            for (int t = 0; t < 4; t++) {
+                CityOverlayImpact impact = scenario.compareNearest(types[t]);
+                cout << locationTypeToString(types[t]) << " (" << impact.facilityCount << "): ";
+                if (impact.facilityCount == 0) {
+                    cout << "none in the city" << endl;
+                    continue;
+                }
+                cout << impact.longer << " of " << impact.servedBefore << " locations farther";
+                if (impact.longer > 0) {
+                    cout << " (avg +" << (impact.totalIncrease / impact.longer) << ", worst +"
+                        << impact.maxIncrease << " at " << impact.worstID << ")";
+                }
+                cout << ", " << impact.shorter << " closer";
+                if (impact.cutOff > 0) cout << ", " << RED << impact.cutOff << " cut off" << RESET;
+                cout << endl;
+            }
+        }
+        else if (choice == 6) {
+            int index = 1;
+            for (CityOverlayChange* change = scenario.getChanges(); change != nullptr; change = change->next) {
+                cout << index++ << ". ";
+                if (change->kind == OVERLAY_CLOSE_ROAD) cout << "Close ";
+                else if (change->kind == OVERLAY_ADD_ROAD) cout << "Open ";
+                else cout << "Set length " << change->distance << " on ";
+                cout << change->id1 << " <-> " << change->id2 << endl;
+            }
+            if (scenario.getChangeCount() == 0) cout << "No changes yet." << endl;
+        }
+        else if (choice != 0) {
+            cout << RED << "Invalid choice!" << RESET << endl;
+        }
+    } while (choice != 0);
 }
 
 
@@ -974,6 +1554,7 @@ void displaySFMLVisualizationMenu() {
     cout << "8.  School Locations" << endl;
     cout << "9.  Mall Locations" << endl;
     cout << "10. All Public Facilities" << endl;
+    cout << "11. Reachability Map (Isochrone)" << endl;
     cout << endl;
     cout << RED << "0.  Back to Main Menu" << RESET << endl;
     cout << MAGENTA << "=====================================================" << RESET << endl;
@@ -1125,6 +1706,68 @@ void visualizePopulationHeatmapSFML() {
     SFMLVisualizer::visualizePopulationHeatmap(sectors, populations, sectorCount);
 }
 
+// Shade everything within a road distance of one location
+void visualizeReachabilitySFML() {
+    const int MAX_LOCS = 500;
+    string names[MAX_LOCS];
+    string ids[MAX_LOCS];
+    double lats[MAX_LOCS];
+    double lons[MAX_LOCS];
+    double distances[MAX_LOCS];
+
+    CityGraph* cityGraph = CityGraph::getInstance();
+    if (cityGraph->getLocationCount() == 0) {
+        cout << RED << "No locations to display. Please load data first (Main Menu -> 8)" << RESET << endl;
+        return;
+    }
+
+    string originID = getStringInput("Enter Origin Location ID: ");
+    CityLocation* origin = cityGraph->findLocationByID(originID);
+    if (origin == nullptr) {
+        cout << RED << "Location '" << originID << "' not found!" << RESET << endl;
+        return;
+    }
+    double budget = getDoubleInput("Maximum road distance: ");
+
+    CityIsochrone area;
+    cityGraph->findWithinDistance(originID, budget, area);
+
+    // Origin first, then the reachable set, then everything else (up to MAX_LOCS)
+    int count = 0;
+    names[count] = origin->name;
+    ids[count] = origin->id;
+    lats[count] = origin->lat;
+    lons[count] = origin->lon;
+    distances[count++] = 0;
+    for (int i = 0; i < area.count && count < MAX_LOCS; i++) {
+        CityLocation* loc = cityGraph->findLocationByID(area.ids[i]);
+        if (loc == nullptr) continue;
+        names[count] = loc->name;
+        ids[count] = loc->id;
+        lats[count] = loc->lat;
+        lons[count] = loc->lon;
+        distances[count++] = area.distances[i];
+    }
+    int reachableEnd = count;
+    for (int v = 0; v < cityGraph->getLocationCount() && count < MAX_LOCS; v++) {
+        CityLocation* loc = cityGraph->getVertex(v);
+        bool listed = false;
+        for (int i = 0; i < reachableEnd && !listed; i++) {
+            listed = (ids[i] == loc->id);
+        }
+        if (listed) continue;
+        names[count] = loc->name;
+        ids[count] = loc->id;
+        lats[count] = loc->lat;
+        lons[count] = loc->lon;
+        distances[count++] = DBL_MAX;
+    }
+
+    cout << area.count << " locations within " << budget << " units." << endl;
+    cout << GREEN << "Opening SFML window..." << RESET << endl;
+    SFMLVisualizer::visualizeReachability(names, lats, lons, distances, count, 0, budget);
+}
+
 // Handle SFML visualization menu
 void handleSFMLVisualizationMenu() {
     int choice;
@@ -1173,6 +1816,10 @@ void handleSFMLVisualizationMenu() {
             visualizeLocationTypeSFML(5, "Public Facilities");
             break;
 
+        case 11:
+            visualizeReachabilitySFML();
+            break;
+
         case 0:
             cout << BLUE << "Returning to Main Menu..." << RESET << endl;
             break;
@@ -1181,7 +1828,7 @@ void handleSFMLVisualizationMenu() {
             cout << RED << "Invalid choice!" << RESET << endl;
         }
 
-        if (choice != 0 && choice >= 1 && choice <= 10) {
+        if (choice != 0 && choice >= 1 && choice <= 11) {
             cout << "\nPress Enter to continue... ";
             cin.get();
         }
@@ -1195,16 +1842,33 @@ int main() {
     cout << "This system manages Transport, Medical, Education," << endl;
     cout << "Commercial, Public Facilities, and Population data." << endl;
 
+    // A saved snapshot restores the whole city without parsing the CSV files
+    bool restored = false;
+    if (citySnapshotExists()) {
+        cout << "\n" << YELLOW << "Would you like to restore the saved city snapshot? (yes/no): " << RESET;
+        string snapshotChoice;
+        getline(cin, snapshotChoice);
+
+        if (toLowerStr(trimString(snapshotChoice)) == "yes" ||
+            toLowerStr(trimString(snapshotChoice)) == "y") {
+            restored = loadCitySnapshot();
+            cout << "\nPress Enter to continue... ";
+            cin.get();
+        }
+    }
+
     // Ask if user wants to load data from files
-    cout << "\n" << YELLOW << "Would you like to load existing data from files? (yes/no): " << RESET;
-    string loadChoice;
-    getline(cin, loadChoice);
-
-    if (toLowerStr(trimString(loadChoice)) == "yes" ||
-        toLowerStr(trimString(loadChoice)) == "y") {
-        loadAllData();
-        cout << "\nPress Enter to continue to Main Menu... ";
-        cin.get();
+    if (!restored && cityIsEmpty()) {
+        cout << "\n" << YELLOW << "Would you like to load existing data from files? (yes/no): " << RESET;
+        string loadChoice;
+        getline(cin, loadChoice);
+
+        if (toLowerStr(trimString(loadChoice)) == "yes" ||
+            toLowerStr(trimString(loadChoice)) == "y") {
+            loadAllData();
+            cout << "\nPress Enter to continue to Main Menu... ";
+            cin.get();
+        }
     }
 
     int choice;
@@ -1257,6 +1921,34 @@ int main() {
             handleSFMLVisualizationMenu();
             break;
 
+        case 11:
+            cityRoutePlanner();
+            cout << "\nPress Enter to continue...";
+            cin.get();
+            break;
+
+        case 12:
+            cityDistanceMatrix();
+            cout << "\nPress Enter to continue...";
+            cin.get();
+            break;
+
+        case 13:
+            cityReachability();
+            cout << "\nPress Enter to continue...";
+            cin.get();
+            break;
+
+        case 14:
+            cityRoadClosureWhatIf();
+            break;
+
+        case 15:
+            saveCitySnapshot();
+            cout << "\nPress Enter to continue...";
+            cin.get();
+            break;
+
         case 0:
             cout << "\n" << endl;
             cout << BOLD << CYAN << " Thank you for using Islamabad City Management System!       " << RESET << endl;
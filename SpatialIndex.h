@@ -0,0 +1,413 @@
+#pragma once
+#include "Utils.h"
+#include <cmath>
+#include <cfloat>
+
+using namespace std;
+
+// Uniform grid over (lat, lon). Only occupied cells are stored, in a hash
+// table keyed by (row, col), so the grid can cover any coordinate range.
+// Items are opaque pointers; the owner decides what they point to.
+
+// Optional callback to skip items during nearest / k-nearest searches
+typedef bool (*SpatialFilter)(void* item, void* context);
+
+struct SpatialEntry {
+    double lat, lon;
+    void* item;
+    SpatialEntry* next;
+
+    SpatialEntry(double la, double lo, void* it) : lat(la), lon(lo), item(it), next(nullptr) {}
+};
+
+struct SpatialCell {
+    int row, col;
+    SpatialEntry* entries;
+    int entryCount;
+    SpatialCell* next;      // Hash chain
+
+    SpatialCell(int r, int c) : row(r), col(c), entries(nullptr), entryCount(0), next(nullptr) {}
+};
+
+// One search result: the item and its straight-line distance
+struct SpatialHit {
+    void* item;
+    double distance;
+
+    SpatialHit() : item(nullptr), distance(DBL_MAX) {}
+};
+
+class SpatialGrid {
+private:
+    double cellSize;
+    SpatialCell** table;
+    int tableSize;
+    int cellCount;
+    int entryCount;
+
+    // Bounding box of every cell ever occupied (never shrinks, only used
+    // to stop ring searches early)
+    int minRow, maxRow, minCol, maxCol;
+
+    int cellRow(double lat) { return (int)floor(lat / cellSize); }
+    int cellCol(double lon) { return (int)floor(lon / cellSize); }
+
+    int cellHash(int row, int col) {
+        unsigned int h = (unsigned int)row * 73856093u ^ (unsigned int)col * 19349663u;
+        return (int)(h % (unsigned int)tableSize);
+    }
+
+    void resizeTable() {
+        int oldSize = tableSize;
+        SpatialCell** oldTable = table;
+
+        tableSize = oldSize * 2;
+        table = new SpatialCell * [tableSize];
+        for (int i = 0; i < tableSize; i++) {
+            table[i] = nullptr;
+        }
+
+        for (int i = 0; i < oldSize; i++) {
+            SpatialCell* current = oldTable[i];
+            while (current != nullptr) {
+                SpatialCell* nextCell = current->next;
+                int index = cellHash(current->row, current->col);
+                current->next = table[index];
+                table[index] = current;
+                current = nextCell;
+            }
+        }
+        delete[] oldTable;
+    }
+
+    SpatialCell* findCell(int row, int col) {
+        SpatialCell* current = table[cellHash(row, col)];
+        while (current != nullptr) {
+            if (current->row == row && current->col == col) return current;
+            current = current->next;
+        }
+        return nullptr;
+    }
+
+    SpatialCell* getOrCreateCell(int row, int col) {
+        SpatialCell* cell = findCell(row, col);
+        if (cell != nullptr) return cell;
+
+        if ((double)(cellCount + 1) / tableSize > 0.75) {
+            resizeTable();
+        }
+
+        cell = new SpatialCell(row, col);
+        int index = cellHash(row, col);
+        cell->next = table[index];
+        table[index] = cell;
+        cellCount++;
+
+        if (entryCount == 0 && cellCount == 1) {
+            minRow = maxRow = row;
+            minCol = maxCol = col;
+        }
+        else {
+            if (row < minRow) minRow = row;
+            if (row > maxRow) maxRow = row;
+            if (col < minCol) minCol = col;
+            if (col > maxCol) maxCol = col;
+        }
+        return cell;
+    }
+
+    void deleteCell(SpatialCell* cell) {
+        int index = cellHash(cell->row, cell->col);
+        if (table[index] == cell) {
+            table[index] = cell->next;
+        }
+        else {
+            SpatialCell* current = table[index];
+            while (current->next != cell) {
+                current = current->next;
+            }
+            current->next = cell->next;
+        }
+        delete cell;
+        cellCount--;
+    }
+
+    // Offer every entry of a cell to the sorted results[0..count-1] (k best)
+    void scanCell(SpatialCell* cell, double lat, double lon, int k, SpatialHit results[], int& count,
+        SpatialFilter filter, void* context) {
+        SpatialEntry* entry = cell->entries;
+        while (entry != nullptr) {
+            double dLat = entry->lat - lat;
+            double dLon = entry->lon - lon;
+            double dist = sqrt(dLat * dLat + dLon * dLon);
+
+            if ((count < k || dist < results[count - 1].distance) &&
+                (filter == nullptr || filter(entry->item, context))) {
+                int pos = (count < k) ? count++ : count - 1;
+                while (pos > 0 && results[pos - 1].distance > dist) {
+                    results[pos] = results[pos - 1];
+                    pos--;
+                }
+                results[pos].item = entry->item;
+                results[pos].distance = dist;
+            }
+            entry = entry->next;
+        }
+    }
+
+    // Visit cell (row, col) if it is occupied; returns false if it was skipped
+    // because it lies outside the occupied bounding box
+    bool scanCellAt(int row, int col, double lat, double lon, int k, SpatialHit results[], int& count,
+        SpatialFilter filter, void* context) {
+        if (row < minRow || row > maxRow || col < minCol || col > maxCol) return false;
+        SpatialCell* cell = findCell(row, col);
+        if (cell != nullptr) {
+            scanCell(cell, lat, lon, k, results, count, filter, context);
+        }
+        return true;
+    }
+
+    int scanAllCells(double lat, double lon, int k, SpatialHit results[], SpatialFilter filter, void* context) {
+        int count = 0;
+        for (int i = 0; i < tableSize; i++) {
+            SpatialCell* cell = table[i];
+            while (cell != nullptr) {
+                scanCell(cell, lat, lon, k, results, count, filter, context);
+                cell = cell->next;
+            }
+        }
+        return count;
+    }
+
+    // Append the entries of a cell that lie within radius
+    void collectInRadius(SpatialCell* cell, double lat, double lon, double radius,
+        SpatialHit results[], int& count, int maxResults) {
+        SpatialEntry* entry = cell->entries;
+        while (entry != nullptr && count < maxResults) {
+            double dLat = entry->lat - lat;
+            double dLon = entry->lon - lon;
+            double dist = sqrt(dLat * dLat + dLon * dLon);
+            if (dist <= radius) {
+                results[count].item = entry->item;
+                results[count].distance = dist;
+                count++;
+            }
+            entry = entry->next;
+        }
+    }
+
+public:
+    SpatialGrid(double size = 0.01) : cellSize(size), tableSize(64), cellCount(0), entryCount(0),
+        minRow(0), maxRow(-1), minCol(0), maxCol(-1) {
+        table = new SpatialCell * [tableSize];
+        for (int i = 0; i < tableSize; i++) {
+            table[i] = nullptr;
+        }
+    }
+
+    SpatialGrid(const SpatialGrid&) = delete;
+    SpatialGrid& operator=(const SpatialGrid&) = delete;
+
+    double getCellSize() { return cellSize; }
+    int getEntryCount() { return entryCount; }
+    int getCellCount() { return cellCount; }
+
+    void insert(double lat, double lon, void* item) {
+        SpatialCell* cell = getOrCreateCell(cellRow(lat), cellCol(lon));
+        SpatialEntry* entry = new SpatialEntry(lat, lon, item);
+        entry->next = cell->entries;
+        cell->entries = entry;
+        cell->entryCount++;
+        entryCount++;
+    }
+
+    // Removes item, which must have been inserted at (lat, lon)
+    bool remove(double lat, double lon, void* item) {
+        SpatialCell* cell = findCell(cellRow(lat), cellCol(lon));
+        if (cell == nullptr) return false;
+
+        SpatialEntry* prev = nullptr;
+        SpatialEntry* entry = cell->entries;
+        while (entry != nullptr && entry->item != item) {
+            prev = entry;
+            entry = entry->next;
+        }
+        if (entry == nullptr) return false;
+
+        if (prev == nullptr) cell->entries = entry->next;
+        else prev->next = entry->next;
+        delete entry;
+        cell->entryCount--;
+        entryCount--;
+
+        if (cell->entryCount == 0) {
+            deleteCell(cell);
+        }
+        return true;
+    }
+
+    // Closest item that passes coordinatesMatch(lat, lon, epsilon), or nullptr.
+    // With cellSize == epsilon only the 3 x 3 block around the query cell is read.
+    void* findMatch(double lat, double lon, double epsilon) {
+        if (entryCount == 0) return nullptr;
+
+        void* best = nullptr;
+        double bestDist = DBL_MAX;
+        int rowTo = cellRow(lat + epsilon), colTo = cellCol(lon + epsilon);
+
+        for (int row = cellRow(lat - epsilon); row <= rowTo; row++) {
+            for (int col = cellCol(lon - epsilon); col <= colTo; col++) {
+                SpatialCell* cell = findCell(row, col);
+                if (cell == nullptr) continue;
+
+                SpatialEntry* entry = cell->entries;
+                while (entry != nullptr) {
+                    if (coordinatesMatch(entry->lat, entry->lon, lat, lon, epsilon)) {
+                        double dLat = entry->lat - lat;
+                        double dLon = entry->lon - lon;
+                        double dist = dLat * dLat + dLon * dLon;
+                        if (dist < bestDist) {
+                            bestDist = dist;
+                            best = entry->item;
+                        }
+                    }
+                    entry = entry->next;
+                }
+            }
+        }
+        return best;
+    }
+
+    // Fills results[] with the k closest items, nearest first, and returns
+    // how many were found. Rings of cells are searched outward from the
+    // query cell until no unvisited cell can beat the k-th best distance.
+    int kNearest(double lat, double lon, int k, SpatialHit results[],
+        SpatialFilter filter = nullptr, void* context = nullptr) {
+        if (k <= 0 || entryCount == 0) return 0;
+
+        int qRow = cellRow(lat);
+        int qCol = cellCol(lon);
+
+        int maxRing = abs(qRow - minRow);
+        if (abs(qRow - maxRow) > maxRing) maxRing = abs(qRow - maxRow);
+        if (abs(qCol - minCol) > maxRing) maxRing = abs(qCol - minCol);
+        if (abs(qCol - maxCol) > maxRing) maxRing = abs(qCol - maxCol);
+
+        // Rings that do not reach the occupied box can be skipped outright
+        int minRing = 0;
+        if (minRow - qRow > minRing) minRing = minRow - qRow;
+        if (qRow - maxRow > minRing) minRing = qRow - maxRow;
+        if (minCol - qCol > minRing) minRing = minCol - qCol;
+        if (qCol - maxCol > minRing) minRing = qCol - maxCol;
+
+        // Once more cells have been probed than exist, a flat scan is cheaper
+        long long probeBudget = 2LL * cellCount + 16;
+        long long probes = 0;
+        int count = 0;
+
+        for (int r = minRing; r <= maxRing; r++) {
+            // Every cell in ring r is at least (r - 1) cells away
+            if (r > 0 && count == k && results[k - 1].distance <= (r - 1) * cellSize) break;
+
+            if (r == 0) {
+                if (scanCellAt(qRow, qCol, lat, lon, k, results, count, filter, context)) probes++;
+                continue;
+            }
+
+            int top = qRow - r, bottom = qRow + r;
+            int left = qCol - r, right = qCol + r;
+            int colFrom = (left > minCol) ? left : minCol;
+            int colTo = (right < maxCol) ? right : maxCol;
+            int rowFrom = (top + 1 > minRow) ? top + 1 : minRow;
+            int rowTo = (bottom - 1 < maxRow) ? bottom - 1 : maxRow;
+
+            for (int c = colFrom; c <= colTo; c++) {
+                if (scanCellAt(top, c, lat, lon, k, results, count, filter, context)) probes++;
+                if (scanCellAt(bottom, c, lat, lon, k, results, count, filter, context)) probes++;
+            }
+            for (int row = rowFrom; row <= rowTo; row++) {
+                if (scanCellAt(row, left, lat, lon, k, results, count, filter, context)) probes++;
+                if (scanCellAt(row, right, lat, lon, k, results, count, filter, context)) probes++;
+            }
+
+            if (probes > probeBudget) {
+                return scanAllCells(lat, lon, k, results, filter, context);
+            }
+        }
+        return count;
+    }
+
+    // Closest item (nullptr if none); its distance goes to outDistance
+    void* nearest(double lat, double lon, double& outDistance,
+        SpatialFilter filter = nullptr, void* context = nullptr) {
+        SpatialHit best;
+        kNearest(lat, lon, 1, &best, filter, context);
+        outDistance = best.distance;
+        return best.item;
+    }
+
+    // Every item within radius of (lat, lon), in no particular order.
+    // At most maxResults are stored; the return value is how many were stored.
+    int withinRadius(double lat, double lon, double radius, SpatialHit results[], int maxResults) {
+        if (entryCount == 0 || radius < 0) return 0;
+
+        int rowFrom = cellRow(lat - radius), rowTo = cellRow(lat + radius);
+        int colFrom = cellCol(lon - radius), colTo = cellCol(lon + radius);
+        if (rowFrom < minRow) rowFrom = minRow;
+        if (rowTo > maxRow) rowTo = maxRow;
+        if (colFrom < minCol) colFrom = minCol;
+        if (colTo > maxCol) colTo = maxCol;
+        if (rowFrom > rowTo || colFrom > colTo) return 0;
+
+        int count = 0;
+        double boxCells = (double)(rowTo - rowFrom + 1) * (colTo - colFrom + 1);
+
+        if (boxCells > cellCount) {
+            // Box is larger than the occupied area: walk the occupied cells
+            for (int i = 0; i < tableSize && count < maxResults; i++) {
+                SpatialCell* cell = table[i];
+                while (cell != nullptr && count < maxResults) {
+                    if (cell->row >= rowFrom && cell->row <= rowTo && cell->col >= colFrom && cell->col <= colTo) {
+                        collectInRadius(cell, lat, lon, radius, results, count, maxResults);
+                    }
+                    cell = cell->next;
+                }
+            }
+            return count;
+        }
+
+        for (int row = rowFrom; row <= rowTo && count < maxResults; row++) {
+            for (int col = colFrom; col <= colTo && count < maxResults; col++) {
+                SpatialCell* cell = findCell(row, col);
+                if (cell != nullptr) {
+                    collectInRadius(cell, lat, lon, radius, results, count, maxResults);
+                }
+            }
+        }
+        return count;
+    }
+
+    void clear() {
+        for (int i = 0; i < tableSize; i++) {
+            while (table[i] != nullptr) {
+                SpatialCell* cell = table[i];
+                table[i] = cell->next;
+                while (cell->entries != nullptr) {
+                    SpatialEntry* entry = cell->entries;
+                    cell->entries = entry->next;
+                    delete entry;
+                }
+                delete cell;
+            }
+        }
+        cellCount = 0;
+        entryCount = 0;
+        minRow = minCol = 0;
+        maxRow = maxCol = -1;
+    }
+
+    ~SpatialGrid() {
+        clear();
+        delete[] table;
+    }
+};
@@ -0,0 +1,219 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+// WORK-STEALING THREAD POOL
+// parallelFor(count, func, arg) runs func(arg, i) for every i in [0, count).
+// Indices are dealt out to per-worker queues in contiguous blocks; a worker
+// takes from the back of its own queue and, once that is empty, steals from
+// the front of the others. The caller blocks until every index has run.
+// One job runs at a time; tasks must not call parallelFor themselves.
+
+typedef void (*CityTaskFunc)(void* arg, int index);
+
+// Per-worker queue of task indices (ring buffer, guarded by its own lock)
+struct CityWorkQueue {
+    mutex lock;
+    int* items;
+    int capacity;
+    int front;
+    int size;
+
+    CityWorkQueue() : items(nullptr), capacity(0), front(0), size(0) {}
+    ~CityWorkQueue() { delete[] items; }
+
+    // Only called while no worker is inside a job
+    void fill(int from, int to) {
+        int needed = to - from;
+        if (needed > capacity) {
+            delete[] items;
+            capacity = needed;
+            items = new int[capacity];
+        }
+        for (int i = 0; i < needed; i++) {
+            items[i] = from + i;
+        }
+        front = 0;
+        size = needed;
+    }
+
+    // Owner end
+    bool popBack(int& index) {
+        lock_guard<mutex> guard(lock);
+        if (size == 0) return false;
+        size--;
+        index = items[(front + size) % capacity];
+        return true;
+    }
+
+    // Thief end
+    bool popFront(int& index) {
+        lock_guard<mutex> guard(lock);
+        if (size == 0) return false;
+        index = items[front];
+        front = (front + 1) % capacity;
+        size--;
+        return true;
+    }
+};
+
+class CityThreadPool {
+private:
+    thread* workers;
+    CityWorkQueue* queues;
+    int threadCount;
+
+    // Current job
+    CityTaskFunc jobFunc;
+    void* jobArg;
+    int remaining;               // Indices not yet run (guarded by stateLock)
+    unsigned int generation;     // Bumped for every job, wakes the workers
+    bool stopping;
+
+    mutex stateLock;
+    condition_variable workReady;
+    condition_variable workDone;
+    mutex jobLock;               // Serializes parallelFor callers
+    int activeWorkers;
+
+    static CityThreadPool* instance;
+
+    CityThreadPool(int threads) : workers(nullptr), queues(nullptr), threadCount(0), jobFunc(nullptr),
+        jobArg(nullptr), remaining(0), generation(0), stopping(false), activeWorkers(0) {
+        startWorkers(threads);
+    }
+
+    void startWorkers(int threads) {
+        if (threads < 1) threads = 1;
+        threadCount = threads;
+        stopping = false;
+        queues = new CityWorkQueue[threadCount];
+        workers = new thread[threadCount];
+        for (int i = 0; i < threadCount; i++) {
+            workers[i] = thread(&CityThreadPool::workerLoop, this, i);
+        }
+    }
+
+    void stopWorkers() {
+        {
+            lock_guard<mutex> guard(stateLock);
+            stopping = true;
+        }
+        workReady.notify_all();
+        for (int i = 0; i < threadCount; i++) {
+            workers[i].join();
+        }
+        delete[] workers;
+        delete[] queues;
+        workers = nullptr;
+        queues = nullptr;
+        threadCount = 0;
+    }
+
+    // Next index for worker 'self': own queue first, then steal round-robin
+    bool takeTask(int self, int& index) {
+        if (queues[self].popBack(index)) return true;
+        for (int i = 1; i < threadCount; i++) {
+            if (queues[(self + i) % threadCount].popFront(index)) return true;
+        }
+        return false;
+    }
+
+    void workerLoop(int self) {
+        unsigned int seenGeneration = 0;
+        while (true) {
+            CityTaskFunc func;
+            void* arg;
+            {
+                unique_lock<mutex> guard(stateLock);
+                while (!stopping && generation == seenGeneration) {
+                    workReady.wait(guard);
+                }
+                if (stopping) return;
+                seenGeneration = generation;
+                func = jobFunc;
+                arg = jobArg;
+                activeWorkers++;
+            }
+
+            int index;
+            int done = 0;
+            while (takeTask(self, index)) {
+                func(arg, index);
+                done++;
+            }
+
+            lock_guard<mutex> guard(stateLock);
+            activeWorkers--;
+            remaining -= done;
+            if (activeWorkers == 0) {
+                workDone.notify_all();
+            }
+        }
+    }
+
+public:
+    static CityThreadPool* getInstance() {
+        if (instance == nullptr) {
+            int threads = (int)thread::hardware_concurrency();
+            instance = new CityThreadPool(threads > 0 ? threads : 4);
+        }
+        return instance;
+    }
+
+    CityThreadPool(const CityThreadPool&) = delete;
+    CityThreadPool& operator=(const CityThreadPool&) = delete;
+
+    int getThreadCount() { return threadCount; }
+
+    // Restart the pool with a different number of workers
+    void setThreadCount(int threads) {
+        lock_guard<mutex> job(jobLock);
+        if (threads < 1) threads = 1;
+        if (threads == threadCount) return;
+        stopWorkers();
+        startWorkers(threads);
+    }
+
+    void parallelFor(int count, CityTaskFunc func, void* arg) {
+        if (count <= 0) return;
+        lock_guard<mutex> job(jobLock);
+
+        if (threadCount == 1 || count == 1) {
+            for (int i = 0; i < count; i++) func(arg, i);
+            return;
+        }
+
+        // A worker that woke late for the previous job may still be leaving it;
+        // the queues are only refilled once nobody is inside a job
+        unique_lock<mutex> guard(stateLock);
+        while (activeWorkers > 0) {
+            workDone.wait(guard);
+        }
+
+        // Deal out contiguous blocks so neighbouring indices stay together
+        for (int w = 0; w < threadCount; w++) {
+            queues[w].fill((int)((long long)count * w / threadCount), (int)((long long)count * (w + 1) / threadCount));
+        }
+
+        jobFunc = func;
+        jobArg = arg;
+        remaining = count;
+        generation++;
+        workReady.notify_all();
+
+        // Done when every index ran and no worker is still inside the job
+        while (remaining > 0 || activeWorkers > 0) {
+            workDone.wait(guard);
+        }
+    }
+
+    ~CityThreadPool() {
+        stopWorkers();
+    }
+};
+
+CityThreadPool* CityThreadPool::instance = nullptr;
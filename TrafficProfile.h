@@ -0,0 +1,204 @@
+#pragma once
+#include "Utils.h"
+
+using namespace std;
+
+// TIME-OF-DAY TRAFFIC PROFILES
+// A profile gives a road's speed through the day at a few breakpoints
+// ("07:00=40;08:00=15;09:30=40", km/h). Between breakpoints the slowdown
+// (free-flow speed / speed) is interpolated linearly and the day wraps at
+// midnight, so a road's travel time at clock time t is
+//   freeFlowMinutes(length) * slowdownAt(t)
+// which is piecewise linear in t. Roads with the same profile share one
+// pattern; a road only stores a pointer (nullptr = free flow all day).
+// Time-dependent searches assume FIFO: leaving later never gets you there
+// earlier. That holds as long as the slowdown changes slowly compared to
+// the time it takes to drive the road.
+
+const int MINUTES_PER_DAY = 1440;
+const double CITY_FREE_FLOW_KMH = 40.0;     // Speed on a road without a profile
+const double CITY_KM_PER_UNIT = 111.0;      // Coordinates are degrees
+const int TRAFFIC_MAX_BREAKPOINTS = 48;
+const int TRAFFIC_TABLE_SIZE = 257;
+
+// Minutes to drive 'length' coordinate units at free-flow speed
+double freeFlowMinutes(double length) {
+    return length * CITY_KM_PER_UNIT / CITY_FREE_FLOW_KMH * 60.0;
+}
+
+// "08:15" -> 495; false if the text is not a valid HH:MM clock time
+bool parseClockTime(const string& text, int& minutes) {
+    string t = trimString(text);
+    size_t colon = t.find(':');
+    if (colon == string::npos || colon == 0 || colon > 2 || t.length() - colon != 3) return false;
+
+    int hours = 0, mins = 0;
+    for (size_t i = 0; i < t.length(); i++) {
+        if (i == colon) continue;
+        if (t[i] < '0' || t[i] > '9') return false;
+        if (i < colon) hours = hours * 10 + (t[i] - '0');
+        else mins = mins * 10 + (t[i] - '0');
+    }
+    if (hours > 23 || mins > 59) return false;
+    minutes = hours * 60 + mins;
+    return true;
+}
+
+// Minutes since midnight -> "HH:MM" (rounded to the minute, "+1d" past midnight)
+string formatClockTime(double minutes) {
+    long long total = (long long)(minutes + 0.5);
+    if (total < 0) total = 0;
+    int days = (int)(total / MINUTES_PER_DAY);
+    int inDay = (int)(total % MINUTES_PER_DAY);
+
+    string result = "";
+    int hours = inDay / 60, mins = inDay % 60;
+    if (hours < 10) result += "0";
+    result += intToString(hours) + ":";
+    if (mins < 10) result += "0";
+    result += intToString(mins);
+    if (days > 0) result += " +" + intToString(days) + "d";
+    return result;
+}
+
+// One shared speed profile
+struct CityTrafficPattern {
+    string key;                 // Canonical profile text
+    int count;
+    unsigned short* minute;     // Breakpoint clock times, ascending, < MINUTES_PER_DAY
+    float* slowdown;            // Free-flow speed / speed at each breakpoint
+    int id;                     // Position in CityTrafficTable (0 .. patternCount-1)
+    CityTrafficPattern* hashNext;
+
+    CityTrafficPattern(const string& k, int n) : key(k), count(n), id(-1), hashNext(nullptr) {
+        minute = new unsigned short[n];
+        slowdown = new float[n];
+    }
+    ~CityTrafficPattern() {
+        delete[] minute;
+        delete[] slowdown;
+    }
+
+    // Slowdown at any clock time (minutes, may run past midnight)
+    double slowdownAt(double clock) const {
+        if (count == 1) return slowdown[0];
+        double t = clock - MINUTES_PER_DAY * (long long)(clock / MINUTES_PER_DAY);
+        if (t < 0) t += MINUTES_PER_DAY;
+
+        // Before the first or after the last breakpoint: the segment that wraps midnight
+        if (t < minute[0] || t >= minute[count - 1]) {
+            double start = minute[count - 1];
+            double span = minute[0] + MINUTES_PER_DAY - start;
+            double offset = (t >= start) ? t - start : t + MINUTES_PER_DAY - start;
+            return slowdown[count - 1] + (slowdown[0] - slowdown[count - 1]) * (offset / span);
+        }
+
+        // Binary search for the segment [minute[lo], minute[lo + 1])
+        int lo = 0, hi = count - 1;
+        while (hi - lo > 1) {
+            int mid = (lo + hi) / 2;
+            if (minute[mid] <= t) lo = mid;
+            else hi = mid;
+        }
+        double offset = t - minute[lo];
+        double span = minute[hi] - minute[lo];
+        return slowdown[lo] + (slowdown[hi] - slowdown[lo]) * (offset / span);
+    }
+
+    // Minutes to drive 'length' units when entering the road at clock time 'clock'
+    double travelMinutes(double length, double clock) const {
+        return freeFlowMinutes(length) * slowdownAt(clock);
+    }
+};
+
+// Interns parsed profiles so identical ones share a pattern (Singleton)
+class CityTrafficTable {
+private:
+    CityTrafficPattern** table;
+    CityTrafficPattern** byID;  // Patterns in intern order, for saving references
+    int patternCount;
+    int capacity;
+
+    static CityTrafficTable* instance;
+
+    CityTrafficTable() : patternCount(0), capacity(16) {
+        table = new CityTrafficPattern * [TRAFFIC_TABLE_SIZE];
+        for (int i = 0; i < TRAFFIC_TABLE_SIZE; i++) table[i] = nullptr;
+        byID = new CityTrafficPattern * [capacity];
+    }
+
+public:
+    static CityTrafficTable* getInstance() {
+        if (instance == nullptr) {
+            instance = new CityTrafficTable();
+        }
+        return instance;
+    }
+
+    CityTrafficTable(const CityTrafficTable&) = delete;
+    CityTrafficTable& operator=(const CityTrafficTable&) = delete;
+
+    // Parse "HH:MM=speed;HH:MM=speed;..." (km/h, any order) into a shared
+    // pattern. Returns nullptr if the profile is malformed or has more than
+    // TRAFFIC_MAX_BREAKPOINTS breakpoints (one extra is split to notice).
+    const CityTrafficPattern* internProfile(const string& profile) {
+        string parts[TRAFFIC_MAX_BREAKPOINTS + 1];
+        int count = splitString(profile, ';', parts, TRAFFIC_MAX_BREAKPOINTS + 1);
+        if (count == 0 || count > TRAFFIC_MAX_BREAKPOINTS) return nullptr;
+
+        int minutes[TRAFFIC_MAX_BREAKPOINTS];
+        double speeds[TRAFFIC_MAX_BREAKPOINTS];
+        for (int i = 0; i < count; i++) {
+            size_t eq = parts[i].find('=');
+            if (eq == string::npos) return nullptr;
+            if (!parseClockTime(parts[i].substr(0, eq), minutes[i])) return nullptr;
+            const char* speed = parts[i].data();
+            if (!parseDouble(speed + eq + 1, speed + parts[i].length(), speeds[i]) || speeds[i] <= 0) return nullptr;
+
+            // Insertion sort by clock time; repeated times are rejected
+            for (int j = i; j > 0 && minutes[j] <= minutes[j - 1]; j--) {
+                if (minutes[j] == minutes[j - 1]) return nullptr;
+                int m = minutes[j]; minutes[j] = minutes[j - 1]; minutes[j - 1] = m;
+                double s = speeds[j]; speeds[j] = speeds[j - 1]; speeds[j - 1] = s;
+            }
+        }
+
+        string key = "";
+        for (int i = 0; i < count; i++) {
+            if (i > 0) key += ";";
+            key += formatClockTime(minutes[i]) + "=" + to_string(speeds[i]);
+        }
+
+        int bucket = polynomialHash(key, TRAFFIC_TABLE_SIZE);
+        for (CityTrafficPattern* p = table[bucket]; p != nullptr; p = p->hashNext) {
+            if (p->key == key) return p;
+        }
+
+        CityTrafficPattern* pattern = new CityTrafficPattern(key, count);
+        for (int i = 0; i < count; i++) {
+            pattern->minute[i] = (unsigned short)minutes[i];
+            pattern->slowdown[i] = (float)(CITY_FREE_FLOW_KMH / speeds[i]);
+        }
+        pattern->hashNext = table[bucket];
+        table[bucket] = pattern;
+
+        if (patternCount == capacity) {
+            CityTrafficPattern** grown = new CityTrafficPattern * [capacity * 2];
+            for (int i = 0; i < patternCount; i++) grown[i] = byID[i];
+            delete[] byID;
+            byID = grown;
+            capacity *= 2;
+        }
+        pattern->id = patternCount;
+        byID[patternCount++] = pattern;
+        return pattern;
+    }
+
+    int getPatternCount() const { return patternCount; }
+
+    const CityTrafficPattern* getPattern(int id) const {
+        return (id >= 0 && id < patternCount) ? byID[id] : nullptr;
+    }
+};
+
+CityTrafficTable* CityTrafficTable::instance = nullptr;
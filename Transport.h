@@ -3,6 +3,8 @@
 #include "Utils.h"
 #include "GlobalLocationManager.h"
 #include "CityGraph.h"
+#include "PathCache.h"
+#include "CitySnapshot.h"
 #include <iomanip>
 
 
@@ -21,13 +23,17 @@ struct BusStop {
 
 
 
+struct AdjListNode;
+
 struct RoadEdge {
 
     string destStopID;
     double distance;
+    AdjListNode* destAdj;   // Destination's adjacency list, to reach the reverse edge
+    const CityTrafficPattern* traffic;  // Time-of-day speeds, nullptr = free flow
     RoadEdge* next;
 
-    RoadEdge(const string& dest, double dist) : destStopID(dest), distance(dist), next(nullptr) {
+    RoadEdge(const string& dest, double dist) : destStopID(dest), distance(dist), destAdj(nullptr), traffic(nullptr), next(nullptr) {
 
     }
 
@@ -40,8 +46,10 @@ struct AdjListNode {
     string stopID;
     RoadEdge* edgeHead;
     AdjListNode* next;
+    BusStop* stop;      // Stop coordinates for the A* bound (nullptr if unknown)
+    int routeIndex;     // Vertex number in the current routing search
 
-    AdjListNode(const string& id) : stopID(id), edgeHead(nullptr), next(nullptr) {
+    AdjListNode(const string& id) : stopID(id), edgeHead(nullptr), next(nullptr), stop(nullptr), routeIndex(-1) {
 
 
     }
@@ -223,6 +231,28 @@ public:
 
     }
 
+    void writeSnapshot(CitySnapshotWriter& out) {
+        out.putInt(count);
+        int idx = front;
+        for (int i = 0; i < count; i++) {
+            out.putString(passengers[idx].name);
+            out.putString(passengers[idx].sourceStop);
+            out.putString(passengers[idx].destStop);
+            idx = (idx + 1) % MAX_SIZE;
+        }
+    }
+
+    bool readSnapshot(CitySnapshotReader& in) {
+        clear();
+        int saved = in.getCount();
+        for (int i = 0; i < saved && !in.hasFailed(); i++) {
+            string name = in.getString();
+            string src = in.getString();
+            if (!enqueue(name, src, in.getString())) return false;
+        }
+        return !in.hasFailed();
+    }
+
     void clear() {
 
         front = 0;
@@ -304,89 +334,47 @@ public:
         }
     }
 
-    void clear() {
-        top = -1;
+    // Oldest entry first
+    void writeSnapshot(CitySnapshotWriter& out) {
+        out.putInt(top + 1);
+        for (int i = 0; i <= top; i++) out.putString(history[i]);
     }
-};
-
-
-struct DijkstraNode {
-
-    string stopID;
-    double distance;
 
-};
-// Applying dijstra for finding the min value for min heap 
-
-class DijkstraMinHeap {
-private:
-    static const int MAX_SIZE = 500;
-
-    DijkstraNode heap[MAX_SIZE];
-    int size;
-
-    void swap(int i, int j) {
-        DijkstraNode temp = heap[i];
-        heap[i] = heap[j];
-        heap[j] = temp;
-    }
-
-    void siftUp(int i) {
-        while (i > 0) {
-            int parent = (i - 1) / 2;
-            if (heap[i].distance < heap[parent].distance) {
-                swap(i, parent);
-                i = parent;
-            }
-            else break;
+    bool readSnapshot(CitySnapshotReader& in) {
+        clear();
+        int saved = in.getCount();
+        for (int i = 0; i < saved && !in.hasFailed(); i++) {
+            if (!push(in.getString())) return false;
         }
+        return !in.hasFailed();
     }
 
-    void siftDown(int i) {
-        while (true) {
-            int smallest = i;
-            int left = 2 * i + 1;
-            int right = 2 * i + 2;
-
-            if (left < size && heap[left].distance < heap[smallest].distance)
-                smallest = left;
-            if (right < size && heap[right].distance < heap[smallest].distance)
-                smallest = right;
-
-            if (smallest != i) {
-                swap(i, smallest);
-                i = smallest;
-            }
-            else break;
-        }
+    void clear() {
+        top = -1;
     }
+};
 
 
+// Routing engine view of the road network
+typedef CityLinkedGraph<AdjListNode, RoadEdge> TransportRoadGraph;
 
-public:
-    DijkstraMinHeap() : size(0) {}
-
-    bool isEmpty() { return size == 0; }
-
-    void insert(const string& id, double dist) {
-        if (size >= MAX_SIZE) return;
-        heap[size].stopID = id;
-        heap[size].distance = dist;
-        siftUp(size);
-        size++;
-    }
+// Stops at the destination stop; with A* every key also gets the
+// straight-line distance to it. That is safe because every transport
+// road is the straight-line distance between its stops.
+struct TransportRouteGoal {
+    const TransportRoadGraph* graph;
+    int dest;
+    bool useAStar;
+    double destLat, destLon;
 
+    bool onSettle(int u) { return u == dest; }
 
-
-    DijkstraNode extractMin() {
-        DijkstraNode minNode = heap[0];
-        heap[0] = heap[size - 1];
-        size--;
-        if (size > 0) siftDown(0);
-        return minNode;
+    double lowerBound(int v) {
+        if (!useAStar) return 0;
+        BusStop* stop = graph->node(v)->stop;
+        if (stop == nullptr) return 0;
+        return calculateDistance(stop->lat, stop->lon, destLat, destLon);
     }
-
-    void clear() { size = 0; }
 };
 
 
@@ -408,6 +396,12 @@ private:
 
     int busCount;
 
+    // Bumped on every road network change; keys the shortest path cache
+    unsigned int graphVersion;
+    CityPathCache pathCache;
+
+    void markGraphChanged() { graphVersion++; }
+
     // PRIVATE HELPER FUNCTIONS
 
     int busHash(const string& busNumber) {
@@ -481,8 +475,10 @@ private:
         if (existing != nullptr) return existing;
 
         AdjListNode* newNode = new AdjListNode(stopID);
+        newNode->stop = findStopByID(stopID);
         newNode->next = adjListHead;
         adjListHead = newNode;
+        markGraphChanged();
         return newNode;
     }
 
@@ -500,6 +496,7 @@ private:
 
     void removeEdgeFromAdjList(AdjListNode* adj, const string& destID) {
         if (adj == nullptr || adj->edgeHead == nullptr) return;
+        markGraphChanged();
 
         while (adj->edgeHead != nullptr &&
             stringsEqualIgnoreCase(adj->edgeHead->destStopID, destID)) {
@@ -526,6 +523,7 @@ private:
 
     void removeAdjListEntry(const string& stopID) {
         if (adjListHead == nullptr) return;
+        markGraphChanged();
 
         if (stringsEqualIgnoreCase(adjListHead->stopID, stopID)) {
             AdjListNode* temp = adjListHead;
@@ -582,22 +580,6 @@ private:
         }
     }
 
-    // Helper: Normalize separators 
-
-    void normalizeSeparatorsHelper(string& s) {
-        for (size_t i = 0; i < s.length(); i++) {
-            if (s[i] == '\t') s[i] = ',';
-        }
-    }
-
-    // Helper: Strip quotes from string
-    void stripQuotesHelper(string& s) {
-        s = trimString(s);
-        if (!s.empty() && s[0] == '"') s = s.substr(1);
-        if (!s.empty() && s[s.length() - 1] == '"')
-            s = s.substr(0, s.length() - 1);
-    }
-
     // Generate roads from bus routes automatically
     void generateRoadsFromBusRoutes() {
         cout << "Generating road network from bus routes..." << endl;
@@ -631,6 +613,9 @@ private:
                     RoadEdge* edge2 = new RoadEdge(fromStop, distance);
                     edge2->next = adj2->edgeHead;
                     adj2->edgeHead = edge2;
+                    edge1->destAdj = adj2;
+                    edge2->destAdj = adj1;
+                    markGraphChanged();
 
 
                     CityGraph::getInstance()->connectLocations(fromStop, toStop, distance);
@@ -651,7 +636,7 @@ private:
 
 public:
     TransportSystem() : stopsHead(nullptr), adjListHead(nullptr), busesHead(nullptr),
-        stopCount(0), busCount(0) {
+        stopCount(0), busCount(0), graphVersion(0) {
         for (int i = 0; i < BUS_TABLE_SIZE; i++) {
             busHashTable[i] = nullptr;
         }
@@ -852,11 +837,15 @@ public:
 
 
 
-        // Remove all edges TO this stop from other stops
-        AdjListNode* adj = adjListHead;
-        while (adj != nullptr) {
-            removeEdgeFromAdjList(adj, id);
-            adj = adj->next;
+        // Remove all edges TO this stop. Roads are stored both ways, so only
+        // this stop's neighbors can hold one
+        AdjListNode* ownAdj = getAdjList(id);
+        if (ownAdj != nullptr) {
+            RoadEdge* edge = ownAdj->edgeHead;
+            while (edge != nullptr) {
+                if (edge->destAdj != ownAdj) removeEdgeFromAdjList(edge->destAdj, id);
+                edge = edge->next;
+            }
         }
 
 
@@ -952,57 +941,72 @@ public:
 
             double newLon = getDoubleInput("Enter new longitude: ");
 
-            GlobalLocationManager* locMgr = GlobalLocationManager::getInstance();
-            locMgr->removeLocation(stop->lat, stop->lon);
-
-            if (!locMgr->registerLocation(newLat, newLon, "BusStop", stop->name)) {
-
-                // Re-register old location
-                locMgr->registerLocation(stop->lat, stop->lon, "BusStop", stop->name);
-
+            if (!moveBusStop(id, newLat, newLon)) {
                 cout << "Error: New location is occupied.  Update cancelled." << endl;
 
                 return;
             }
+        }
 
-            stop->lat = newLat;
+        cout << "Bus stop updated successfully!" << endl;
 
-            stop->lon = newLon;
+    }
 
-            // Update distances to connected stops
+    // Move a stop and re-measure its roads; false if the new spot is taken
+    bool moveBusStop(const string& id, double newLat, double newLon) {
+        BusStop* stop = findStopByID(id);
+        if (stop == nullptr) return false;
 
-            AdjListNode* adj = getAdjList(id);
-            if (adj != nullptr) {
-                RoadEdge* edge = adj->edgeHead;
-                while (edge != nullptr) {
-                    BusStop* destStop = findStopByID(edge->destStopID);
+        GlobalLocationManager* locMgr = GlobalLocationManager::getInstance();
+        locMgr->removeLocation(stop->lat, stop->lon);
 
-                    if (destStop != nullptr) {
-                        edge->distance = calculateDistance(stop->lat, stop->lon,
-                            destStop->lat, destStop->lon);
-                        // Update reverse edge
+        if (!locMgr->registerLocation(newLat, newLon, "BusStop", stop->name)) {
 
-                        AdjListNode* destAdj = getAdjList(edge->destStopID);
-                        if (destAdj != nullptr) {
-                            RoadEdge* revEdge = destAdj->edgeHead;
-                            while (revEdge != nullptr) {
-                                if (stringsEqualIgnoreCase(revEdge->destStopID, id)) {
-                                    revEdge->distance = edge->distance;
+            // Re-register old location
+            locMgr->registerLocation(stop->lat, stop->lon, "BusStop", stop->name);
 
-                                    break;
-                                }
-                                revEdge = revEdge->next;
+            return false;
+        }
+
+        stop->lat = newLat;
+
+        stop->lon = newLon;
+
+        // Update distances to connected stops
+
+        AdjListNode* adj = getAdjList(id);
+        if (adj != nullptr) {
+            RoadEdge* edge = adj->edgeHead;
+            while (edge != nullptr) {
+                BusStop* destStop = findStopByID(edge->destStopID);
+
+                if (destStop != nullptr) {
+                    edge->distance = calculateDistance(stop->lat, stop->lon,
+                        destStop->lat, destStop->lon);
+                    // Update reverse edge
+
+                    AdjListNode* destAdj = getAdjList(edge->destStopID);
+                    if (destAdj != nullptr) {
+                        RoadEdge* revEdge = destAdj->edgeHead;
+                        while (revEdge != nullptr) {
+                            if (stringsEqualIgnoreCase(revEdge->destStopID, id)) {
+                                revEdge->distance = edge->distance;
+
+                                break;
                             }
+                            revEdge = revEdge->next;
                         }
                     }
-                    edge = edge->next;
-
                 }
+                edge = edge->next;
+
             }
         }
 
-        cout << "Bus stop updated successfully!" << endl;
-
+        // Cached routes were measured with the old lengths
+        markGraphChanged();
+        CityGraph::getInstance()->moveLocation(id, newLat, newLon);
+        return true;
     }
 
     void connectStops() {
@@ -1057,6 +1061,9 @@ public:
         RoadEdge* edge2 = new RoadEdge(id1, distance);
         edge2->next = adj2->edgeHead;
         adj2->edgeHead = edge2;
+        edge1->destAdj = adj2;
+        edge2->destAdj = adj1;
+        markGraphChanged();
 
 
 
@@ -1473,8 +1480,60 @@ public:
 
     // DIJKSTRA'S ALGORITHM - SHORTEST PATH
 
-    void findShortestPath() {
-        cout << "\n=== Find Shortest Path (Dijkstra's Algorithm) ===" << endl;
+    // Shortest route between two stops (DBL_MAX if none), keeping the first
+    // maxStops stops of it in routePath[]; cached tells whether the answer
+    // came from the path cache
+    double findRoute(const string& srcID, const string& destID, bool useAStar,
+        string routePath[], int& routeLen, int maxStops, int& stopsExplored, bool& cached) {
+        double totalDistance = DBL_MAX;
+        routeLen = 0;
+        stopsExplored = 0;
+
+        // Repeated queries are answered from the cache until the network changes
+        cached = pathCache.lookup(srcID, destID, useAStar ? 2 : 1, graphVersion,
+            totalDistance, routePath, routeLen, maxStops);
+
+        if (!cached) {
+            AdjListNode* srcAdj = getAdjList(srcID);
+            AdjListNode* destAdj = getAdjList(destID);
+            BusStop* destStop = findStopByID(destID);
+            bool complete = true;
+
+            if (srcAdj != nullptr && destAdj != nullptr && destStop != nullptr) {
+                TransportRoadGraph roads(adjListHead);
+                TransportRouteGoal goal = { &roads, destAdj->routeIndex, useAStar, destStop->lat, destStop->lon };
+                CitySearchScratch& sc = getCitySearchScratch();
+                cityShortestPaths(roads, goal, srcAdj->routeIndex, sc);
+                stopsExplored = sc.settledCount;
+
+                int dest = destAdj->routeIndex;
+                if (sc.isSettled(dest)) {
+                    totalDistance = sc.dist[dest];
+
+                    // Walk back from the destination, keeping the first maxStops stops
+                    int hops = sc.hopsTo(dest);
+                    routeLen = (hops < maxStops) ? hops : maxStops;
+                    complete = (hops <= maxStops);
+                    int pos = hops - 1;
+                    for (int v = dest; v != -1; v = sc.prev[v], pos--) {
+                        if (pos < maxStops) routePath[pos] = roads.node(v)->stopID;
+                    }
+                }
+            }
+
+            // Only complete routes are cached; a truncated one would be wrong
+            // for a later caller with a bigger buffer
+            if (complete) {
+                pathCache.store(srcID, destID, useAStar ? 2 : 1, graphVersion, totalDistance, routePath, routeLen);
+            }
+        }
+        return totalDistance;
+    }
+
+    // A* is safe here because every transport road is the straight-line
+    // distance between its stops, so that distance never overestimates
+    void findShortestPath(bool useAStar = false) {
+        cout << "\n=== Find Shortest Path (" << (useAStar ? "A* Search" : "Dijkstra's Algorithm") << ") ===" << endl;
 
         if (stopCount < 2) {
             cout << "Error: Need at least 2 stops." << endl;
@@ -1500,141 +1559,292 @@ public:
             return;
         }
 
-        // Initialize distances and visited arrays
         const int MAX_STOPS = 500;
-        string stopIDs[MAX_STOPS];
-        double distances[MAX_STOPS];
-        string previous[MAX_STOPS];
-        bool visited[MAX_STOPS];
-        int numStops = 0;
+        string routePath[MAX_STOPS];
+        int routeLen = 0;
+        int stopsExplored = 0;
+        bool cached = false;
+        double totalDistance = findRoute(srcID, destID, useAStar, routePath, routeLen, MAX_STOPS, stopsExplored, cached);
 
-        // Collect all stop IDs
-        BusStop* current = stopsHead;
-        while (current != nullptr && numStops < MAX_STOPS) {
-            stopIDs[numStops] = current->stopID;
-            distances[numStops] = DBL_MAX;
-            previous[numStops] = "";
-            visited[numStops] = false;
-            numStops++;
-            current = current->next;
+        if (totalDistance == DBL_MAX) {
+            cout << "\nNo path exists between '" << srcStop->name << "' and '" << destStop->name << "'!" << endl;
+            return;
         }
 
-        // Find source index
-        int srcIdx = -1;
-        for (int i = 0; i < numStops; i++) {
-            if (stringsEqualIgnoreCase(stopIDs[i], srcID)) {
-                srcIdx = i;
-                break;
-            }
+        // Display path
+        cout << "\n=== Shortest Path Found ===" << endl;
+        cout << "From: " << srcStop->name << endl;
+        cout << "To: " << destStop->name << endl;
+        cout << "Total Distance: " << totalDistance << " units" << endl;
+        if (cached) {
+            cout << "Stops Explored: 0 (cached result)" << endl;
         }
-        if (srcIdx == -1) {
-            cout << "Error: Source stop not in graph!" << endl;
-            return;
+        else {
+            cout << "Stops Explored: " << stopsExplored << (useAStar ? " (A*)" : " (Dijkstra)") << endl;
         }
+        cout << "\nPath: ";
 
-        distances[srcIdx] = 0;
+        bool first = true;
+        for (int i = 0; i < routeLen; i++) {
+            BusStop* s = findStopByID(routePath[i]);
+            if (s != nullptr) {
+                if (!first) cout << " -> ";
+                cout << s->name;
+                first = false;
 
-        // Dijkstra's algorithm using min-heap
-        DijkstraMinHeap minHeap;
-        minHeap.insert(srcID, 0);
+                // Add to route history
+                routeHistory.push(routePath[i]);
+            }
+        }
+        cout << endl;
+    }
 
-        while (!minHeap.isEmpty()) {
-            DijkstraNode minNode = minHeap.extractMin();
-            string currentID = minNode.stopID;
+    // K SHORTEST PATHS (YEN'S ALGORITHM) - ALTERNATE ROUTES
 
-            // Find index of current stop
-            int currentIdx = -1;
-            for (int i = 0; i < numStops; i++) {
-                if (stringsEqualIgnoreCase(stopIDs[i], currentID)) {
-                    currentIdx = i;
-                    break;
-                }
+    // Up to k loopless routes between two stops, shortest first.
+    // results[] must hold k entries; returns how many routes exist.
+    int findKShortestRoutes(const string& srcID, const string& destID, int k, CityRouteResult results[]) {
+        AdjListNode* srcAdj = getAdjList(srcID);
+        AdjListNode* destAdj = getAdjList(destID);
+        if (srcAdj == nullptr || destAdj == nullptr || k <= 0) return 0;
+
+        TransportRoadGraph roads(adjListHead);
+        CityRankedPath* ranked = new CityRankedPath[k];
+        int count = cityKShortestPaths(roads, srcAdj->routeIndex, destAdj->routeIndex, k, ranked);
+
+        for (int i = 0; i < count; i++) {
+            results[i].destID = destAdj->stopID;
+            results[i].distance = ranked[i].length;
+            delete[] results[i].path;
+            results[i].path = new string[ranked[i].count];
+            results[i].pathLen = ranked[i].count;
+            for (int j = 0; j < ranked[i].count; j++) {
+                results[i].path[j] = roads.node(ranked[i].vertices[j])->stopID;
             }
+        }
 
-            if (currentIdx == -1 || visited[currentIdx]) continue;
-            visited[currentIdx] = true;
+        delete[] ranked;
+        return count;
+    }
 
-            // Process all neighbors
-            AdjListNode* adj = getAdjList(currentID);
-            if (adj != nullptr) {
-                RoadEdge* edge = adj->edgeHead;
-                while (edge != nullptr) {
-                    // Find neighbor index
-                    int neighborIdx = -1;
-                    for (int i = 0; i < numStops; i++) {
-                        if (stringsEqualIgnoreCase(stopIDs[i], edge->destStopID)) {
-                            neighborIdx = i;
-                            break;
-                        }
-                    }
+    void findAlternateRoutes() {
+        cout << "\n=== Find Alternate Routes (k Shortest Paths) ===" << endl;
 
-                    if (neighborIdx != -1 && !visited[neighborIdx]) {
-                        double newDist = distances[currentIdx] + edge->distance;
-                        if (newDist < distances[neighborIdx]) {
-                            distances[neighborIdx] = newDist;
-                            previous[neighborIdx] = currentID;
-                            minHeap.insert(edge->destStopID, newDist);
-                        }
-                    }
-                    edge = edge->next;
-                }
-            }
+        if (stopCount < 2) {
+            cout << "Error: Need at least 2 stops." << endl;
+            return;
         }
 
-        // Find destination index
-        int destIdx = -1;
-        for (int i = 0; i < numStops; i++) {
-            if (stringsEqualIgnoreCase(stopIDs[i], destID)) {
-                destIdx = i;
-                break;
-            }
+        string srcID = getStringInput("Enter Source Stop ID: ");
+        BusStop* srcStop = findStopByID(srcID);
+        if (srcStop == nullptr) {
+            cout << "Error: Source stop not found!" << endl;
+            return;
+        }
+
+        string destID = getStringInput("Enter Destination Stop ID: ");
+        BusStop* destStop = findStopByID(destID);
+        if (destStop == nullptr) {
+            cout << "Error: Destination stop not found!" << endl;
+            return;
         }
 
-        if (destIdx == -1 || distances[destIdx] == DBL_MAX) {
+        if (stringsEqualIgnoreCase(srcID, destID)) {
+            cout << "You are already at the destination!" << endl;
+            return;
+        }
+
+        int k = getIntInput("How many routes (1-10)? ");
+        if (k < 1 || k > 10) {
+            cout << "Error: Enter a number between 1 and 10." << endl;
+            return;
+        }
+
+        CityRouteResult routes[10];
+        int count = findKShortestRoutes(srcID, destID, k, routes);
+        if (count == 0) {
             cout << "\nNo path exists between '" << srcStop->name << "' and '" << destStop->name << "'!" << endl;
             return;
         }
 
-        // Reconstruct path using stack
-        RouteHistoryStack pathStack;
-        string currentID = destID;
-        while (!currentID.empty()) {
-            pathStack.push(currentID);
-            int idx = -1;
-            for (int i = 0; i < numStops; i++) {
-                if (stringsEqualIgnoreCase(stopIDs[i], currentID)) {
-                    idx = i;
+        cout << "\n=== " << count << " Route(s) from " << srcStop->name << " to " << destStop->name << " ===" << endl;
+        for (int i = 0; i < count; i++) {
+            cout << "\n" << (i + 1) << ". Distance: " << routes[i].distance << " units";
+            if (i > 0) cout << " (+" << (routes[i].distance - routes[0].distance) << ")";
+            cout << ", " << routes[i].pathLen << " stops" << endl;
+            cout << "   Path: ";
+            for (int j = 0; j < routes[i].pathLen; j++) {
+                BusStop* s = findStopByID(routes[i].path[j]);
+                if (j > 0) cout << " -> ";
+                cout << (s != nullptr ? s->name : routes[i].path[j]);
+            }
+            cout << endl;
+        }
+        if (count < k) {
+            cout << "\nOnly " << count << " distinct route(s) exist." << endl;
+        }
+    }
+
+    // TIME-DEPENDENT ROUTING (TRAFFIC PROFILES)
+
+    // Attach a time-of-day profile to both directions of a road, here and
+    // in the city graph. False if the stops are not connected.
+    bool setRoadTraffic(const string& id1, const string& id2, const CityTrafficPattern* traffic) {
+        bool found = false;
+        for (int dir = 0; dir < 2; dir++) {
+            AdjListNode* adj = getAdjList(dir == 0 ? id1 : id2);
+            const string& other = (dir == 0) ? id2 : id1;
+            for (RoadEdge* edge = (adj != nullptr) ? adj->edgeHead : nullptr; edge != nullptr; edge = edge->next) {
+                if (stringsEqualIgnoreCase(edge->destStopID, other)) {
+                    edge->traffic = traffic;
+                    found = true;
                     break;
                 }
             }
-            if (idx == -1) break;
-            currentID = previous[idx];
         }
+        CityGraph::getInstance()->setRoadTraffic(id1, id2, traffic);
+        return found;
+    }
 
-        // Display path
-        cout << "\n=== Shortest Path Found ===" << endl;
+    // Earliest arrival (clock minutes) at destID when leaving srcID at
+    // departMinute, using the traffic profiles; DBL_MAX if unreachable.
+    // The stops of the fastest route go into path[].
+    double findEarliestArrival(const string& srcID, const string& destID, double departMinute,
+        string path[], int& pathLen, int maxPathLen) {
+        pathLen = 0;
+        AdjListNode* srcAdj = getAdjList(srcID);
+        AdjListNode* destAdj = getAdjList(destID);
+        if (srcAdj == nullptr || destAdj == nullptr) return DBL_MAX;
+
+        TransportRoadGraph roads(adjListHead);
+        CityTimeDependentWeight weight = { departMinute };
+        CityUntilTarget goal(destAdj->routeIndex);
+        CitySearchScratch& sc = getCitySearchScratch();
+        cityShortestPaths(roads, weight, goal, srcAdj->routeIndex, sc);
+
+        int dest = destAdj->routeIndex;
+        if (!sc.isSettled(dest)) return DBL_MAX;
+
+        int hops = sc.hopsTo(dest);
+        pathLen = (hops < maxPathLen) ? hops : maxPathLen;
+        int pos = hops - 1;
+        for (int v = dest; v != -1; v = sc.prev[v], pos--) {
+            if (pos < maxPathLen) path[pos] = roads.node(v)->stopID;
+        }
+        return departMinute + sc.dist[dest];
+    }
+
+    void planTripByDepartureTime() {
+        cout << "\n=== Plan Trip by Departure Time ===" << endl;
+
+        if (stopCount < 2) {
+            cout << "Error: Need at least 2 stops." << endl;
+            return;
+        }
+
+        string srcID = getStringInput("Enter Source Stop ID: ");
+        BusStop* srcStop = findStopByID(srcID);
+        if (srcStop == nullptr) {
+            cout << "Error: Source stop not found!" << endl;
+            return;
+        }
+
+        string destID = getStringInput("Enter Destination Stop ID: ");
+        BusStop* destStop = findStopByID(destID);
+        if (destStop == nullptr) {
+            cout << "Error: Destination stop not found!" << endl;
+            return;
+        }
+
+        int depart;
+        if (!parseClockTime(getStringInput("Departure time (HH:MM): "), depart)) {
+            cout << "Error: Enter the time as HH:MM (e.g. 08:15)." << endl;
+            return;
+        }
+
+        const int MAX_STOPS = 500;
+        string routePath[MAX_STOPS];
+        int routeLen = 0;
+        double arrival = findEarliestArrival(srcID, destID, depart, routePath, routeLen, MAX_STOPS);
+        if (arrival == DBL_MAX) {
+            cout << "\nNo path exists between '" << srcStop->name << "' and '" << destStop->name << "'!" << endl;
+            return;
+        }
+
+        cout << "\n=== Fastest Trip ===" << endl;
         cout << "From: " << srcStop->name << endl;
         cout << "To: " << destStop->name << endl;
-        cout << "Total Distance: " << distances[destIdx] << " units" << endl;
+        cout << "Depart " << formatClockTime(depart) << " -> arrive " << formatClockTime(arrival)
+            << " (" << fixed << setprecision(1) << (arrival - depart) << " min)" << endl;
         cout << "\nPath: ";
+        for (int i = 0; i < routeLen; i++) {
+            BusStop* s = findStopByID(routePath[i]);
+            if (i > 0) cout << " -> ";
+            cout << (s != nullptr ? s->name : routePath[i]);
+        }
+        cout << endl;
+    }
 
-        string stopOnPath;
-        bool first = true;
-        while (!pathStack.isEmpty()) {
-            pathStack.pop(stopOnPath);
-            BusStop* s = findStopByID(stopOnPath);
-            if (s != nullptr) {
-                if (!first) cout << " -> ";
-                cout << s->name;
-                first = false;
+    // Morning run of a school bus: arrival time at every stop of its route,
+    // driving the fastest road route between consecutive stops
+    void displaySchoolBusTimetable() {
+        cout << "\n=== School Bus Timetable (Traffic-Aware) ===" << endl;
 
-                // Add to route history
-                routeHistory.push(stopOnPath);
+        string busNum = getStringInput("Enter School Bus Number: ");
+        BusNode* bus = searchBusByNumber(busNum);
+        if (bus == nullptr) {
+            cout << "Error: Bus not found!" << endl;
+            return;
+        }
+        if (!bus->isSchoolBus) {
+            cout << "Error: This bus is not registered as a school bus!" << endl;
+            return;
+        }
+        if (bus->routeHead == nullptr) {
+            cout << "Error: Bus has no route!" << endl;
+            return;
+        }
+
+        int depart;
+        if (!parseClockTime(getStringInput("Departure time from first stop (HH:MM): "), depart)) {
+            cout << "Error: Enter the time as HH:MM (e.g. 07:30)." << endl;
+            return;
+        }
+
+        const int MAX_STOPS = 500;
+        const double DWELL_MINUTES = 1.0;   // Boarding time at each stop
+        string legPath[MAX_STOPS];
+        int legLen = 0;
+
+        cout << "\nBus " << bus->busNumber << " to " << bus->schoolName << endl;
+        cout << left << setw(6) << "Stop" << setw(25) << "Name" << "Arrival" << endl;
+        cout << "----------------------------------------" << endl;
+
+        double clock = depart;
+        int index = 1;
+        RouteStopNode* previous = nullptr;
+        for (RouteStopNode* route = bus->routeHead; route != nullptr; previous = route, route = route->next, index++) {
+            if (previous != nullptr) {
+                clock = findEarliestArrival(previous->stopID, route->stopID, clock + DWELL_MINUTES,
+                    legPath, legLen, MAX_STOPS);
             }
+            BusStop* s = findStopByID(route->stopID);
+            cout << left << setw(6) << index << setw(25) << (s != nullptr ? s->name : route->stopID);
+            if (clock == DBL_MAX) {
+                cout << "unreachable" << endl;
+                cout << right;
+                return;
+            }
+            cout << formatClockTime(clock) << endl;
         }
-        cout << endl;
+        cout << right;
+        cout << "----------------------------------------" << endl;
+        cout << "Total trip time: " << fixed << setprecision(1) << (clock - depart) << " min" << endl;
     }
 
+    // Shortest path cache statistics (for the system statistics screen)
+    CityPathCache& getPathCache() { return pathCache; }
+
 
     // PASSENGER QUEUE OPERATIONS
 
@@ -2118,52 +2328,36 @@ public:
 
     void loadFromFiles() {
         bool loadedStops = false;
+        int badCoordinates = 0;
 
 
         {
-            ifstream stopsFile("stops.csv");
-            if (stopsFile.is_open()) {
-                string line;
-                getline(stopsFile, line); // Skip header
-
-                while (getline(stopsFile, line)) {
-                    if (line.empty()) continue;
-                    normalizeSeparatorsHelper(line);
+            CsvReader stopsFile("stops.csv");
+            if (stopsFile.isOpen()) {
+                stopsFile.readRow(); // Skip header
 
-                    string parts[4];
-                    int count = splitString(line, ',', parts, 4);
+                while (stopsFile.readRow()) {
+                    int count = stopsFile.getFieldCount();
 
                     string id, name;
                     double lat = 0, lon = 0;
                     bool valid = false;
 
                     if (count == 3) {
-                        id = trimString(parts[0]);
-                        name = trimString(parts[1]);
-                        string coordStr = parts[2];
-                        stripQuotesHelper(coordStr);
-
-                        string coordParts[2];
-                        int coordCount = splitString(coordStr, ',', coordParts, 2);
-                        if (coordCount >= 2) {
-                            lat = stringToDouble(trimString(coordParts[0]));
-                            lon = stringToDouble(trimString(coordParts[1]));
-                            valid = true;
-                        }
+                        // "lat, lon" in one quoted field
+                        id = stopsFile.getString(0);
+                        name = stopsFile.getString(1);
+                        CsvField coords = stopsFile.field(2);
+                        int comma = coords.find(',');
+                        valid = comma >= 0 && coords.substr(0, comma).toDouble(lat) &&
+                            coords.substr(comma + 1).toDouble(lon);
+                        if (!valid) badCoordinates++;
                     }
                     else if (count == 4) {
-                        id = trimString(parts[0]);
-                        name = trimString(parts[1]);
-
-                        string latStr = parts[2];
-                        string lonStr = parts[3];
-
-                        stripQuotesHelper(latStr);
-                        stripQuotesHelper(lonStr);
-
-                        lat = stringToDouble(latStr);
-                        lon = stringToDouble(lonStr);
-                        valid = true;
+                        id = stopsFile.getString(0);
+                        name = stopsFile.getString(1);
+                        valid = stopsFile.field(2).toDouble(lat) && stopsFile.field(3).toDouble(lon);
+                        if (!valid) badCoordinates++;
                     }
 
                     if (valid && !id.empty() && !name.empty()) {
@@ -2192,22 +2386,19 @@ public:
 
 
         if (!loadedStops) {
-            ifstream stopsFile2("busstops.csv");
-            if (stopsFile2.is_open()) {
-                string line;
-                getline(stopsFile2, line);
-
-                while (getline(stopsFile2, line)) {
-                    if (line.empty()) continue;
-                    normalizeSeparatorsHelper(line);
-
-                    string parts[4];
-                    int count = splitString(line, ',', parts, 4);
-                    if (count >= 4) {
-                        string id = trimString(parts[0]);
-                        string name = trimString(parts[1]);
-                        double lat = stringToDouble(trimString(parts[2]));
-                        double lon = stringToDouble(trimString(parts[3]));
+            CsvReader stopsFile2("busstops.csv");
+            if (stopsFile2.isOpen()) {
+                stopsFile2.readRow();
+
+                while (stopsFile2.readRow()) {
+                    if (stopsFile2.getFieldCount() >= 4) {
+                        double lat, lon;
+                        if (!stopsFile2.field(2).toDouble(lat) || !stopsFile2.field(3).toDouble(lon)) {
+                            badCoordinates++;
+                            continue;
+                        }
+                        string id = stopsFile2.getString(0);
+                        string name = stopsFile2.getString(1);
 
                         if (findStopByID(id) == nullptr) {
                             GlobalLocationManager* locMgr = GlobalLocationManager::getInstance();
@@ -2235,24 +2426,21 @@ public:
         if (!loadedStops) {
             cout << "Warning: No bus stops file found or parsed." << endl;
         }
+        if (badCoordinates > 0) {
+            cout << "Skipped " << badCoordinates << " bus stops with invalid coordinates." << endl;
+        }
 
         // ---------- Load roads ----------
         int roadsLoadedFromFile = 0;
         {
-            ifstream roadsFile("roads.csv");
-            if (roadsFile.is_open()) {
-                string line;
-                getline(roadsFile, line); // Skip header
-
-                while (getline(roadsFile, line)) {
-                    if (line.empty()) continue;
-                    normalizeSeparatorsHelper(line);
+            CsvReader roadsFile("roads.csv");
+            if (roadsFile.isOpen()) {
+                roadsFile.readRow(); // Skip header
 
-                    string parts[3];
-                    int count = splitString(line, ',', parts, 3);
-                    if (count >= 2) {
-                        string id1 = trimString(parts[0]);
-                        string id2 = trimString(parts[1]);
+                while (roadsFile.readRow()) {
+                    if (roadsFile.getFieldCount() >= 2) {
+                        string id1 = roadsFile.getString(0);
+                        string id2 = roadsFile.getString(1);
 
                         BusStop* stop1 = findStopByID(id1);
                         BusStop* stop2 = findStopByID(id2);
@@ -2269,6 +2457,9 @@ public:
                             RoadEdge* edge2 = new RoadEdge(id1, distance);
                             edge2->next = adj2->edgeHead;
                             adj2->edgeHead = edge2;
+                            edge1->destAdj = adj2;
+                            edge2->destAdj = adj1;
+                            markGraphChanged();
 
                             CityGraph::getInstance()->connectLocations(id1, id2, distance);
 
@@ -2284,24 +2475,51 @@ public:
             }
         }
 
+        // ---------- Load traffic profiles (optional) ----------
+        {
+            CsvReader trafficFile("traffic.csv");
+            if (trafficFile.isOpen()) {
+                int profiled = 0, rejected = 0;
+                trafficFile.readRow(); // Skip header
+
+                while (trafficFile.readRow()) {
+                    if (trafficFile.getFieldCount() < 3) continue;
+
+                    const CityTrafficPattern* pattern = CityTrafficTable::getInstance()->internProfile(trafficFile.getString(2));
+                    if (pattern == nullptr) {
+                        cout << "Error: traffic.csv line " << trafficFile.getRowNumber()
+                            << ": profile is malformed or has more than " << TRAFFIC_MAX_BREAKPOINTS << " breakpoints." << endl;
+                        rejected++;
+                    }
+                    else if (!setRoadTraffic(trafficFile.getString(0), trafficFile.getString(1), pattern)) {
+                        cout << "Error: traffic.csv line " << trafficFile.getRowNumber() << ": no road between "
+                            << trafficFile.getString(0) << " and " << trafficFile.getString(1) << "." << endl;
+                        rejected++;
+                    }
+                    else {
+                        profiled++;
+                    }
+                }
+                trafficFile.close();
+                cout << "Loaded traffic profiles for " << profiled << " roads ("
+                    << CityTrafficTable::getInstance()->getPatternCount() << " distinct profiles";
+                if (rejected > 0) cout << ", " << rejected << " rows skipped";
+                cout << ")." << endl;
+            }
+        }
+
 
         int busesLoaded = 0;
         {
-            ifstream busesFile("buses.csv");
-            if (busesFile.is_open()) {
-                string line;
-                getline(busesFile, line); // Skip header
-
-                while (getline(busesFile, line)) {
-                    if (line.empty()) continue;
-                    normalizeSeparatorsHelper(line);
-
-                    string parts[4];
-                    int count = splitString(line, ',', parts, 4);
-                    if (count >= 3) {
-                        string busNum = trimString(parts[0]);
-                        string company = trimString(parts[1]);
-                        string currentStop = trimString(parts[2]);
+            CsvReader busesFile("buses.csv");
+            if (busesFile.isOpen()) {
+                busesFile.readRow(); // Skip header
+
+                while (busesFile.readRow()) {
+                    if (busesFile.getFieldCount() >= 3) {
+                        string busNum = busesFile.getString(0);
+                        string company = busesFile.getString(1);
+                        string currentStop = busesFile.getString(2);
 
                         if (searchBusByNumber(busNum) == nullptr) {
                             BusNode* newBus = new BusNode(busNum, company);
@@ -2312,28 +2530,24 @@ public:
                             addBusToHash(newBus);
 
 
-                            if (count >= 4 && !parts[3].empty()) {
-                                string routeRaw = parts[3];
+                            // Route as "ST1 -> ST2 -> ST3" or "ST1-ST2-ST3", up to 50 stops
+                            CsvField routeRaw = busesFile.field(3);
+                            int pos = 0;
+                            for (int i = 0; i < 50 && pos < routeRaw.length; i++) {
+                                int stop = pos;
+                                while (stop < routeRaw.length && routeRaw.data[stop] != '-' && routeRaw.data[stop] != '>') stop++;
+                                string stopID = routeRaw.substr(pos, stop - pos).trimmed().str();
+                                pos = stop + 1;
 
-
-                                for (size_t i = 0; i < routeRaw.length(); i++) {
-                                    if (routeRaw[i] == '>') routeRaw[i] = '-';
-                                }
-
-                                string routeStops[200];
-                                int routeCount = splitString(routeRaw, '-', routeStops, 50);
-                                for (int i = 0; i < routeCount; i++) {
-                                    string stopID = trimString(routeStops[i]);
-                                    if (!stopID.empty() && findStopByID(stopID) != nullptr) {
-                                        RouteStopNode* newRouteStop = new RouteStopNode(stopID);
-                                        if (newBus->routeHead == nullptr) {
-                                            newBus->routeHead = newRouteStop;
-                                        }
-                                        else {
-                                            RouteStopNode* temp = newBus->routeHead;
-                                            while (temp->next != nullptr) temp = temp->next;
-                                            temp->next = newRouteStop;
-                                        }
+                                if (!stopID.empty() && findStopByID(stopID) != nullptr) {
+                                    RouteStopNode* newRouteStop = new RouteStopNode(stopID);
+                                    if (newBus->routeHead == nullptr) {
+                                        newBus->routeHead = newRouteStop;
+                                    }
+                                    else {
+                                        RouteStopNode* temp = newBus->routeHead;
+                                        while (temp->next != nullptr) temp = temp->next;
+                                        temp->next = newRouteStop;
                                     }
                                 }
                             }
@@ -2358,6 +2572,146 @@ public:
 
 
 
+    // SNAPSHOT
+
+    // TRANSPRT section: stops, road lists, buses and the passenger/history
+    // state, each list in its current order
+    void writeSnapshot(CitySnapshotWriter& out) {
+        CityGraph* cityGraph = CityGraph::getInstance();
+        out.beginSection("TRANSPRT");
+
+        out.putInt(stopCount);
+        for (BusStop* stop = stopsHead; stop != nullptr; stop = stop->next) {
+            out.putString(stop->stopID);
+            out.putString(stop->name);
+            out.putDouble(stop->lat);
+            out.putDouble(stop->lon);
+            out.putInt(cityGraph->getEntityVertex(stop->stopID, stop));
+        }
+
+        // Edges refer to their destination's list by position
+        int adjCount = 0;
+        for (AdjListNode* adj = adjListHead; adj != nullptr; adj = adj->next) {
+            adj->routeIndex = adjCount++;
+        }
+        out.putInt(adjCount);
+        for (AdjListNode* adj = adjListHead; adj != nullptr; adj = adj->next) {
+            out.putString(adj->stopID);
+            out.putInt((adj->stop != nullptr) ? cityGraph->getEntityVertex(adj->stop->stopID, adj->stop) : -1);
+            int edgeCount = 0;
+            for (RoadEdge* edge = adj->edgeHead; edge != nullptr; edge = edge->next) edgeCount++;
+            out.putInt(edgeCount);
+            for (RoadEdge* edge = adj->edgeHead; edge != nullptr; edge = edge->next) {
+                out.putString(edge->destStopID);
+                out.putDouble(edge->distance);
+                out.putInt((edge->destAdj != nullptr) ? edge->destAdj->routeIndex : -1);
+                out.putInt((edge->traffic != nullptr) ? edge->traffic->id : -1);
+            }
+        }
+        for (AdjListNode* adj = adjListHead; adj != nullptr; adj = adj->next) {
+            adj->routeIndex = -1;
+        }
+
+        out.putInt(busCount);
+        for (BusNode* bus = busesHead; bus != nullptr; bus = bus->next) {
+            out.putString(bus->busNumber);
+            out.putString(bus->company);
+            out.putString(bus->currentStopID);
+            out.putBool(bus->isSchoolBus);
+            out.putString(bus->schoolName);
+            out.putString(bus->schoolID);
+            int routeLength = 0;
+            for (RouteStopNode* node = bus->routeHead; node != nullptr; node = node->next) routeLength++;
+            out.putInt(routeLength);
+            for (RouteStopNode* node = bus->routeHead; node != nullptr; node = node->next) {
+                out.putString(node->stopID);
+            }
+        }
+
+        passengerQueue.writeSnapshot(out);
+        routeHistory.writeSnapshot(out);
+        out.endSection();
+    }
+
+    // Restore into an empty system (locations and graph vertices are
+    // restored by their own sections)
+    bool readSnapshot(CitySnapshotReader& in, CitySnapshotLinks& links) {
+        if (stopsHead != nullptr || adjListHead != nullptr || busesHead != nullptr) return false;
+        if (!in.beginSection("TRANSPRT")) return false;
+
+        int savedStops = in.getCount();
+        BusStop* stopTail = nullptr;
+        for (int i = 0; i < savedStops && !in.hasFailed(); i++) {
+            string id = in.getString();
+            string name = in.getString();
+            double lat = in.getDouble();
+            double lon = in.getDouble();
+            BusStop* stop = new BusStop(id, name, lat, lon);
+            if (stopTail == nullptr) stopsHead = stop;
+            else stopTail->next = stop;
+            stopTail = stop;
+            stopCount++;
+            links.setEntity(in.getInt(), stop);
+        }
+
+        // Lists are created up front so edges can point at later ones
+        int adjCount = in.getCount();
+        AdjListNode** adjs = new AdjListNode * [adjCount > 0 ? adjCount : 1];
+        for (int i = 0; i < adjCount; i++) {
+            adjs[i] = new AdjListNode("");
+            if (i == 0) adjListHead = adjs[i];
+            else adjs[i - 1]->next = adjs[i];
+        }
+        for (int i = 0; i < adjCount && !in.hasFailed(); i++) {
+            AdjListNode* adj = adjs[i];
+            adj->stopID = in.getString();
+            adj->stop = (BusStop*)links.entity(in.getInt());
+
+            int edgeCount = in.getCount();
+            RoadEdge* edgeTail = nullptr;
+            for (int e = 0; e < edgeCount && !in.hasFailed(); e++) {
+                string dest = in.getString();
+                RoadEdge* edge = new RoadEdge(dest, in.getDouble());
+                int target = in.getInt();
+                if (target >= 0 && target < adjCount) edge->destAdj = adjs[target];
+                edge->traffic = links.pattern(in.getInt());
+                if (edgeTail == nullptr) adj->edgeHead = edge;
+                else edgeTail->next = edge;
+                edgeTail = edge;
+            }
+        }
+        delete[] adjs;
+
+        int savedBuses = in.getCount();
+        BusNode* busTail = nullptr;
+        for (int i = 0; i < savedBuses && !in.hasFailed(); i++) {
+            string number = in.getString();
+            BusNode* bus = new BusNode(number, in.getString());
+            bus->currentStopID = in.getString();
+            bus->isSchoolBus = in.getBool();
+            bus->schoolName = in.getString();
+            bus->schoolID = in.getString();
+            if (busTail == nullptr) busesHead = bus;
+            else busTail->next = bus;
+            busTail = bus;
+            busCount++;
+            addBusToHash(bus);
+
+            int routeLength = in.getCount();
+            RouteStopNode* routeTail = nullptr;
+            for (int r = 0; r < routeLength && !in.hasFailed(); r++) {
+                RouteStopNode* node = new RouteStopNode(in.getString());
+                if (routeTail == nullptr) bus->routeHead = node;
+                else routeTail->next = node;
+                routeTail = node;
+            }
+        }
+
+        if (!passengerQueue.readSnapshot(in) || !routeHistory.readSnapshot(in)) return false;
+        markGraphChanged();
+        return !in.hasFailed();
+    }
+
     int getStopCount() {
         return stopCount;
     }
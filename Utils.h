@@ -4,76 +4,209 @@
 #include <fstream>
 #include <cmath>
 #include <cfloat>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+#include <mutex>
+#include <condition_variable>
+
+#ifdef _WIN32
+#include <sys/stat.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
-// String to int 
-int stringToInt(const string& str) {
-    if (str.empty()) return 0;
-    int res = 0;
-    int sign = 1;
-    long long i = 0;
+// NUMBER PARSING
+// The scan functions read a number at the start of [first, last) without
+// allocating and set end just past it. They return false if there is no
+// number there or it does not fit (end still marks what was read).
 
-    while (i < str.length() && (str[i] == ' ' || str[i] == '\t')) i++;
+// Powers of ten that are exact doubles
+const double EXACT_POWERS_OF_TEN[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
 
-    if (i < str.length() && str[i] == '-') {
-        sign = -1;
-        i++;
-    }
-    else if (i < str.length() && str[i] == '+') {
-        i++;
+bool scanInt(const char* first, const char* last, int& value, const char*& end) {
+    const char* p = first;
+    bool negative = false;
+    if (p < last && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
     }
 
-    for (; i < str.length(); i++) {
-        if (str[i] >= '0' && str[i] <= '9') {
-            res = res * 10 + (str[i] - '0');
-        }
-        else {
-            break;
+    const char* digits = p;
+    long long result = 0;
+    bool overflow = false;
+    const long long limit = negative ? -(long long)INT_MIN : INT_MAX;
+    while (p < last && *p >= '0' && *p <= '9') {
+        if (!overflow) {
+            result = result * 10 + (*p - '0');
+            if (result > limit) overflow = true;
         }
+        p++;
     }
-    return res * sign;
-}
-
-// Converts String to double 
-double stringToDouble(const string& str) {
-    if (str.empty()) return 0.0;
-    double res = 0.0;
-    double factor = 1.0;
-    bool decimalFound = false;
-    int sign = 1;
-    long long i = 0;
 
-    while (i < str.length() && (str[i] == ' ' || str[i] == '\t')) i++;
-
-    if (i < str.length() && str[i] == '-') {
-        sign = -1;
-        i++;
+    if (p == digits) {
+        end = first;
+        return false;
     }
-    else if (i < str.length() && str[i] == '+') {
-        i++;
+    end = p;
+    if (overflow) return false;
+    value = (int)(negative ? -result : result);
+    return true;
+}
+
+// Decimal with optional fraction and exponent ("33.6844", "-.5", "1e-3").
+// Up to 19 significant digits and a power of ten within 1e22 are combined
+// in one correctly rounded operation (all coordinates and prices take this
+// path); anything longer goes through strtod, which also rounds exactly.
+bool scanDouble(const char* first, const char* last, double& value, const char*& end) {
+    const char* p = first;
+    bool negative = false;
+    if (p < last && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
     }
 
-    for (; i < str.length(); i++) {
-        if (str[i] == '.') {
-            if (decimalFound) break;
-            decimalFound = true;
-            continue;
+    // Plain accumulation; more than 19 digits (rare) is redone below
+    unsigned long long mantissa = 0;
+    const char* digitsStart = p;
+    while (p < last && (unsigned)(*p - '0') <= 9) {
+        mantissa = mantissa * 10 + (unsigned)(*p - '0');
+        p++;
+    }
+    int integerDigits = (int)(p - digitsStart);
+    int fractionDigits = 0;
+    if (p < last && *p == '.') {
+        const char* fraction = ++p;
+        while (p < last && (unsigned)(*p - '0') <= 9) {
+            mantissa = mantissa * 10 + (unsigned)(*p - '0');
+            p++;
         }
-        if (str[i] >= '0' && str[i] <= '9') {
-            if (decimalFound) {
-                factor /= 10.0;
-                res += (str[i] - '0') * factor;
+        fractionDigits = (int)(p - fraction);
+    }
+    if (integerDigits + fractionDigits == 0) {
+        end = first;
+        return false;
+    }
+    int exponent = -fractionDigits;
+
+    bool truncated = false;
+    if (integerDigits + fractionDigits > 19) {
+        // Keep the first 19 significant digits, note if any dropped digit is non-zero
+        mantissa = 0;
+        exponent = integerDigits;
+        int significant = 0;
+        for (const char* d = digitsStart; d < p; d++) {
+            if (*d == '.') continue;
+            if (significant < 19) {
+                mantissa = mantissa * 10 + (unsigned)(*d - '0');
+                if (mantissa != 0) significant++;
+                exponent--;
             }
-            else {
-                res = res * 10.0 + (str[i] - '0');
+            else if (*d != '0') {
+                truncated = true;
             }
         }
-        else {
-            break;
+    }
+
+    // Exponent only counts if digits follow the 'e'
+    if (p < last && (*p == 'e' || *p == 'E')) {
+        const char* e = p + 1;
+        bool negativeExponent = false;
+        if (e < last && (*e == '-' || *e == '+')) {
+            negativeExponent = (*e == '-');
+            e++;
+        }
+        if (e < last && *e >= '0' && *e <= '9') {
+            int written = 0;
+            while (e < last && *e >= '0' && *e <= '9') {
+                if (written < 100000) written = written * 10 + (*e - '0');
+                e++;
+            }
+            exponent += negativeExponent ? -written : written;
+            p = e;
         }
     }
-    return res * sign;
+    end = p;
+
+    if (mantissa == 0) {
+        value = negative ? -0.0 : 0.0;
+        return true;
+    }
+    if (!truncated && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+        double result = (double)mantissa;
+        if (exponent < 0) result /= EXACT_POWERS_OF_TEN[-exponent];
+        else result *= EXACT_POWERS_OF_TEN[exponent];
+        value = negative ? -result : result;
+        return true;
+    }
+
+    // Slow path: strtod needs a terminated copy
+    char local[64];
+    size_t length = (size_t)(p - first);
+    string spill;
+    const char* text = local;
+    if (length < sizeof(local)) {
+        memcpy(local, first, length);
+        local[length] = '\0';
+    }
+    else {
+        spill.assign(first, length);
+        text = spill.c_str();
+    }
+    errno = 0;
+    double result = strtod(text, nullptr);
+    if (errno == ERANGE && (result == HUGE_VAL || result == -HUGE_VAL)) return false;
+    value = result;
+    return true;
+}
+
+// Whole range must be the number (surrounding spaces allowed); value is
+// only set on success
+bool parseInt(const char* first, const char* last, int& value) {
+    while (first < last && (*first == ' ' || *first == '\t')) first++;
+    while (last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r')) last--;
+    int result;
+    const char* end;
+    if (!scanInt(first, last, result, end) || end != last) return false;
+    value = result;
+    return true;
+}
+
+bool parseDouble(const char* first, const char* last, double& value) {
+    while (first < last && (*first == ' ' || *first == '\t')) first++;
+    while (last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r')) last--;
+    double result;
+    const char* end;
+    if (!scanDouble(first, last, result, end) || end != last) return false;
+    value = result;
+    return true;
+}
+
+// String to int: leading number, 0 if there is none
+int stringToInt(const string& str) {
+    const char* first = str.data();
+    const char* last = first + str.length();
+    while (first < last && (*first == ' ' || *first == '\t')) first++;
+    int value = 0;
+    const char* end;
+    return scanInt(first, last, value, end) ? value : 0;
+}
+
+// Converts String to double (leading number, 0 if there is none)
+double stringToDouble(const string& str) {
+    const char* first = str.data();
+    const char* last = first + str.length();
+    while (first < last && (*first == ' ' || *first == '\t')) first++;
+    double value = 0.0;
+    const char* end;
+    return scanDouble(first, last, value, end) ? value : 0.0;
 }
 
 // Converts int to string 
@@ -95,37 +228,28 @@ string intToString(int num) {
 
 // STRING HELPERS
 
+// Splits on delimiter, trimming spaces; each token is copied out once
 int splitString(const string& str, char delimiter, string outputArray[], int maxTokens) {
     int count = 0;
-    string currentToken = "";
-
-    for (long long i = 0; i < str.length(); i++) {
-        if (str[i] == delimiter) {
-            if (count < maxTokens) {
-                // Trim whitespace
-                while (!currentToken.empty() && currentToken[0] == ' ')
-                    currentToken = currentToken.substr(1);
-                while (!currentToken.empty() && currentToken[currentToken.length() - 1] == ' ')
-                    currentToken = currentToken.substr(0, currentToken.length() - 1);
-                outputArray[count++] = currentToken;
-                currentToken = "";
-            }
-        }
-        else {
-            currentToken += str[i];
-        }
-    }
+    size_t length = str.length();
+    size_t start = 0;
+
+    for (size_t i = 0; i <= length && count < maxTokens; i++) {
+        if (i < length && str[i] != delimiter)
+            continue;
 
-    if (count < maxTokens && !currentToken.empty()) {
-        // Remove trailing \r for Windows files
-        while (!currentToken.empty() && (currentToken.back() == '\r' || currentToken.back() == '\n'))
-            currentToken = currentToken.substr(0, currentToken.length() - 1);
+        size_t first = start, last = i;
+        if (i == length) {
+            if (first == last) break;  // Nothing after the last delimiter
+            // Remove trailing \r for Windows files
+            while (last > first && (str[last - 1] == '\r' || str[last - 1] == '\n')) last--;
+        }
         // Trim whitespace
-        while (!currentToken.empty() && currentToken[0] == ' ')
-            currentToken = currentToken.substr(1);
-        while (!currentToken.empty() && currentToken[currentToken.length() - 1] == ' ')
-            currentToken = currentToken.substr(0, currentToken.length() - 1);
-        outputArray[count++] = currentToken;
+        while (first < last && str[first] == ' ') first++;
+        while (last > first && str[last - 1] == ' ') last--;
+
+        outputArray[count++].assign(str, first, last - first);
+        start = i + 1;
     }
     return count;
 }
@@ -164,6 +288,499 @@ bool stringsEqualIgnoreCase(const string& a, const string& b) {
     return true;
 }
 
+// CSV READER
+
+const int CSV_MAX_FIELDS = 32;
+const int CSV_BLOCK_SIZE = 1 << 16;
+
+// Characters of one field, pointing into the reader's buffer. Only valid
+// until the next row is read; call str() to keep a copy.
+struct CsvField {
+    const char* data;
+    int length;
+
+    CsvField() : data(""), length(0) {}
+    CsvField(const char* d, int len) : data(d), length(len) {}
+
+    bool empty() const {
+        return length == 0;
+    }
+
+    string str() const {
+        return string(data, length);
+    }
+
+    // Position of c, or -1
+    int find(char c) const {
+        const void* hit = memchr(data, c, length);
+        return hit ? (int)((const char*)hit - data) : -1;
+    }
+
+    CsvField substr(int pos, int len = -1) const {
+        if (pos > length) pos = length;
+        if (len < 0 || pos + len > length) len = length - pos;
+        return CsvField(data + pos, len);
+    }
+
+    // False if the field is not exactly one number
+    bool toInt(int& value) const {
+        return parseInt(data, data + length, value);
+    }
+
+    bool toDouble(double& value) const {
+        return parseDouble(data, data + length, value);
+    }
+
+    CsvField trimmed() const {
+        int first = 0, last = length;
+        while (first < last && (data[first] == ' ' || data[first] == '\t')) first++;
+        while (last > first && (data[last - 1] == ' ' || data[last - 1] == '\t')) last--;
+        return CsvField(data + first, last - first);
+    }
+};
+
+// Length of a line without trailing \r (Windows files) and spaces
+int csvLineLength(const char* line, int length) {
+    while (length > 0 && (line[length - 1] == '\r' || line[length - 1] == ' ')) length--;
+    return length;
+}
+
+// Splits one line into trimmed fields in place; returns the field count.
+// Fields are split on commas or tabs; a field in double quotes may contain
+// commas ("Cardiology, Neurology") and "" for a quote.
+int csvSplitRow(char* line, int length, CsvField fields[]) {
+    int fieldCount = 0;
+    int i = 0;
+    while (fieldCount < CSV_MAX_FIELDS) {
+        while (i < length && line[i] == ' ') i++;
+
+        if (i < length && line[i] == '"') {
+            // Quoted: unescape "" by shifting left over the same bytes
+            int start = ++i;
+            int out = i;
+            while (i < length) {
+                if (line[i] == '"') {
+                    if (i + 1 < length && line[i + 1] == '"') {
+                        line[out++] = '"';
+                        i += 2;
+                        continue;
+                    }
+                    i++;
+                    break;
+                }
+                line[out++] = line[i++];
+            }
+            while (i < length && line[i] != ',' && line[i] != '\t') i++;
+            fields[fieldCount++] = CsvField(line + start, out - start).trimmed();
+        }
+        else {
+            int start = i;
+            while (i < length && line[i] != ',' && line[i] != '\t') i++;
+            fields[fieldCount++] = CsvField(line + start, i - start).trimmed();
+        }
+
+        if (i >= length) break;
+        i++;  // Past the separator
+    }
+    return fieldCount;
+}
+
+// CSV PREFETCH
+// A whole CSV file memory-mapped and split into rows ahead of its loader,
+// so reading and tokenizing can run on other threads. The text is cut into
+// chunks at line ends; each chunk is tokenized on its own and the rows are
+// replayed in file order. A CsvReader opened on a prefetched file name reads
+// from the table instead of the disk.
+
+const int CSV_CHUNK_SIZE = 1 << 22;
+
+struct CsvTableRow {
+    int firstField;
+    int fieldCount;
+    int line;       // Line within the chunk, from 1
+};
+
+struct CsvTableChunk {
+    char* begin;
+    char* end;
+    CsvTableRow* rows;
+    int rowCount;
+    CsvField* fields;
+    int fieldCount;
+    int lineCount;
+    long long firstLine;    // Lines in the chunks before this one
+
+    CsvTableChunk() : begin(nullptr), end(nullptr), rows(nullptr), rowCount(0), fields(nullptr),
+        fieldCount(0), lineCount(0), firstLine(0) {}
+
+    ~CsvTableChunk() {
+        delete[] rows;
+        delete[] fields;
+    }
+};
+
+class CsvTable {
+private:
+    string filename;
+    bool found;
+    char* data;
+    long long size;
+    bool mapped;        // data is a mapping rather than new[]
+    CsvTableChunk* chunks;
+    int chunkCount;
+
+    // Whole file into memory in one read (no mmap, or an empty file)
+    bool readWhole() {
+        ifstream file(filename.c_str(), ios::binary);
+        if (!file.is_open()) return false;
+        file.seekg(0, ios::end);
+        size = (long long)file.tellg();
+        file.seekg(0, ios::beg);
+        if (size < 0) size = 0;
+        data = new char[size + 1];
+        file.read(data, size);
+        size = (long long)file.gcount();
+        return true;
+    }
+
+public:
+    CsvTable* next;     // Prefetch list
+    bool ready;         // Read and tokenized (guarded by the prefetch cache lock)
+
+    CsvTable(const string& name) : filename(name), found(false), data(nullptr), size(0), mapped(false),
+        chunks(nullptr), chunkCount(0), next(nullptr), ready(false) {
+    }
+
+    ~CsvTable() {
+        delete[] chunks;
+#ifndef _WIN32
+        if (mapped) {
+            munmap(data, (size_t)size);
+            data = nullptr;
+        }
+#endif
+        delete[] data;
+    }
+
+    CsvTable(const CsvTable&) = delete;
+    CsvTable& operator=(const CsvTable&) = delete;
+
+    // Maps the whole file; a missing file leaves the table "not found". The
+    // mapping is private and writable because tokenizing unescapes quotes in
+    // place; the file itself is never changed.
+    bool read() {
+#ifdef _WIN32
+        found = readWhole();
+#else
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* mapping = mmap(nullptr, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                madvise(mapping, (size_t)info.st_size, MADV_WILLNEED);
+                data = (char*)mapping;
+                size = (long long)info.st_size;
+                mapped = true;
+            }
+        }
+        ::close(fd);
+        found = mapped || readWhole();
+#endif
+        return found;
+    }
+
+    // Cuts the text into chunks of about chunkSize bytes ending at line ends;
+    // returns the chunk count
+    int splitChunks(long long chunkSize = CSV_CHUNK_SIZE) {
+        delete[] chunks;
+        if (chunkSize < 1) chunkSize = 1;
+        chunkCount = (int)(size / chunkSize) + 1;
+        chunks = new CsvTableChunk[chunkCount];
+
+        char* last = data + size;
+        char* start = data;
+        int c = 0;
+        while (c < chunkCount && start < last) {
+            char* stop = (c == chunkCount - 1 || last - start <= chunkSize) ? last : start + chunkSize;
+            if (stop < last) {
+                char* newline = (char*)memchr(stop, '\n', last - stop);
+                stop = newline ? newline + 1 : last;
+            }
+            chunks[c].begin = start;
+            chunks[c].end = stop;
+            start = stop;
+            c++;
+        }
+        chunkCount = c;
+        return chunkCount;
+    }
+
+    // Splits every line of chunk c into fields; chunks are independent, so
+    // different chunks may be tokenized on different threads
+    void tokenizeChunk(int c) {
+        CsvTableChunk& chunk = chunks[c];
+        int rowCapacity = (int)((chunk.end - chunk.begin) / 32) + 16;
+        int fieldCapacity = rowCapacity * 4;
+        chunk.rows = new CsvTableRow[rowCapacity];
+        chunk.fields = new CsvField[fieldCapacity];
+
+        char* line = chunk.begin;
+        while (line < chunk.end) {
+            char* newline = (char*)memchr(line, '\n', chunk.end - line);
+            char* lineEnd = newline ? newline : chunk.end;
+            chunk.lineCount++;
+
+            int length = csvLineLength(line, (int)(lineEnd - line));
+            if (length > 0) {
+                if (chunk.rowCount == rowCapacity) {
+                    CsvTableRow* grown = new CsvTableRow[rowCapacity * 2];
+                    memcpy(grown, chunk.rows, sizeof(CsvTableRow) * rowCapacity);
+                    delete[] chunk.rows;
+                    chunk.rows = grown;
+                    rowCapacity *= 2;
+                }
+                if (fieldCapacity - chunk.fieldCount < CSV_MAX_FIELDS) {
+                    CsvField* grown = new CsvField[fieldCapacity * 2];
+                    memcpy(grown, chunk.fields, sizeof(CsvField) * chunk.fieldCount);
+                    delete[] chunk.fields;
+                    chunk.fields = grown;
+                    fieldCapacity *= 2;
+                }
+
+                CsvTableRow& row = chunk.rows[chunk.rowCount++];
+                row.firstField = chunk.fieldCount;
+                row.fieldCount = csvSplitRow(line, length, chunk.fields + chunk.fieldCount);
+                row.line = chunk.lineCount;
+                chunk.fieldCount += row.fieldCount;
+            }
+            line = newline ? newline + 1 : chunk.end;
+        }
+    }
+
+    // Frees the rows of chunk c once nothing reads them any more
+    void releaseChunk(int c) {
+        delete[] chunks[c].rows;
+        delete[] chunks[c].fields;
+        chunks[c].rows = nullptr;
+        chunks[c].fields = nullptr;
+        chunks[c].rowCount = 0;
+        chunks[c].fieldCount = 0;
+    }
+
+    // After every chunk is tokenized: number the lines across chunks
+    void finishChunks() {
+        long long lines = 0;
+        for (int c = 0; c < chunkCount; c++) {
+            chunks[c].firstLine = lines;
+            lines += chunks[c].lineCount;
+        }
+    }
+
+    const string& getFilename() { return filename; }
+    bool isFound() { return found; }
+    long long getSize() { return size; }
+    int getChunkCount() { return chunkCount; }
+    CsvTableChunk& getChunk(int c) { return chunks[c]; }
+    bool isTokenized(int c) { return chunks[c].rows != nullptr; }
+
+    long long getRowCount() {
+        long long rows = 0;
+        for (int c = 0; c < chunkCount; c++) rows += chunks[c].rowCount;
+        return rows;
+    }
+};
+
+// Files prefetched for the loaders. Tables are added before any loader
+// runs and removed after the last one. A loader may open a file that is
+// still being prefetched (it belongs to a later module), so find() waits
+// until the prefetcher has marked that table ready.
+class CsvPrefetchCache {
+private:
+    CsvTable* head;
+    mutex lock;
+    condition_variable tableReady;
+    static CsvPrefetchCache* instance;
+
+    CsvPrefetchCache() : head(nullptr) {}
+
+public:
+    static CsvPrefetchCache* getInstance() {
+        if (instance == nullptr) {
+            instance = new CsvPrefetchCache();
+        }
+        return instance;
+    }
+
+    void add(CsvTable* table) {
+        lock_guard<mutex> guard(lock);
+        table->next = head;
+        head = table;
+    }
+
+    // Called by the prefetcher once the table is read and tokenized
+    void markReady(CsvTable* table) {
+        lock_guard<mutex> guard(lock);
+        table->ready = true;
+        tableReady.notify_all();
+    }
+
+    CsvTable* find(const string& filename) {
+        unique_lock<mutex> guard(lock);
+        for (CsvTable* table = head; table != nullptr; table = table->next) {
+            if (table->getFilename() == filename) {
+                while (!table->ready) {
+                    tableReady.wait(guard);
+                }
+                return table;
+            }
+        }
+        return nullptr;
+    }
+
+    // Drops the tables from the cache (the caller still owns them)
+    void clear() {
+        lock_guard<mutex> guard(lock);
+        head = nullptr;
+    }
+};
+
+CsvPrefetchCache* CsvPrefetchCache::instance = nullptr;
+
+// Streams a CSV file row by row through one reused buffer; fields are split
+// by csvSplitRow. Rows end at the line end. If the file was prefetched, the
+// rows come from its CsvTable instead.
+class CsvReader {
+private:
+    ifstream file;
+    char* buffer;
+    int capacity;
+    int begin;      // Start of the unread text
+    int end;        // End of the text read so far
+    bool eof;
+    CsvField fields[CSV_MAX_FIELDS];
+    int fieldCount;
+    long long rowNumber;
+
+    // Prefetched rows, or nullptr
+    CsvTable* table;
+    int tableChunk;
+    int tableRow;
+
+    // Make sure a whole line starting at begin is in the buffer; returns
+    // its length (without the newline), or -1 at the end of the file
+    int nextLine() {
+        int searched = 0;
+        while (true) {
+            char* newline = (char*)memchr(buffer + begin + searched, '\n', end - begin - searched);
+            if (newline != nullptr)
+                return (int)(newline - (buffer + begin));
+
+            if (eof) {
+                return (end > begin) ? end - begin : -1;
+            }
+
+            searched = end - begin;
+            // Slide the partial line to the front, growing for very long lines
+            if (begin > 0) {
+                memmove(buffer, buffer + begin, end - begin);
+                end -= begin;
+                begin = 0;
+            }
+            if (capacity - end < CSV_BLOCK_SIZE) {
+                char* grown = new char[capacity * 2];
+                memcpy(grown, buffer, end);
+                delete[] buffer;
+                buffer = grown;
+                capacity *= 2;
+            }
+            file.read(buffer + end, capacity - end);
+            int got = (int)file.gcount();
+            if (got == 0) eof = true;
+            end += got;
+        }
+    }
+
+    bool readTableRow() {
+        while (tableChunk < table->getChunkCount()) {
+            CsvTableChunk& chunk = table->getChunk(tableChunk);
+            if (tableRow < chunk.rowCount) {
+                CsvTableRow& row = chunk.rows[tableRow++];
+                fieldCount = row.fieldCount;
+                memcpy(fields, chunk.fields + row.firstField, sizeof(CsvField) * fieldCount);
+                rowNumber = chunk.firstLine + row.line;
+                return true;
+            }
+            tableChunk++;
+            tableRow = 0;
+        }
+        fieldCount = 0;
+        return false;
+    }
+
+public:
+    CsvReader(const string& filename) : buffer(nullptr), capacity(0), begin(0), end(0), eof(false),
+        fieldCount(0), rowNumber(0), table(nullptr), tableChunk(0), tableRow(0) {
+        table = CsvPrefetchCache::getInstance()->find(filename);
+        if (table == nullptr) {
+            file.open(filename.c_str(), ios::binary);
+            buffer = new char[CSV_BLOCK_SIZE * 2];
+            capacity = CSV_BLOCK_SIZE * 2;
+        }
+    }
+
+    ~CsvReader() {
+        delete[] buffer;
+    }
+
+    bool isOpen() {
+        return table != nullptr ? table->isFound() : file.is_open();
+    }
+
+    // Next non-blank row; false at the end of the file
+    bool readRow() {
+        if (table != nullptr) return readTableRow();
+        while (true) {
+            int length = nextLine();
+            if (length < 0) {
+                fieldCount = 0;
+                return false;
+            }
+            char* line = buffer + begin;
+            begin += (begin + length < end) ? length + 1 : length;
+            rowNumber++;
+
+            length = csvLineLength(line, length);
+            if (length == 0) continue;
+
+            fieldCount = csvSplitRow(line, length, fields);
+            return true;
+        }
+    }
+
+    int getFieldCount() {
+        return fieldCount;
+    }
+
+    // Row number in the file, counting the header
+    long long getRowNumber() {
+        return rowNumber;
+    }
+
+    // Empty field when out of range
+    CsvField field(int i) {
+        return (i >= 0 && i < fieldCount) ? fields[i] : CsvField();
+    }
+
+    string getString(int i) {
+        return field(i).str();
+    }
+
+    void close() {
+        file.close();
+    }
+};
+
 // HASH FUNCTIONS
 
 // Polynomial Rolling Hash
@@ -221,7 +838,10 @@ double calculateDistance(double lat1, double lon1, double lat2, double lon2) {
     return sqrt(pow(lat2 - lat1, 2) + pow(lon2 - lon1, 2));
 }
 
-bool coordinatesMatch(double lat1, double lon1, double lat2, double lon2, double epsilon = 0.0001) {
+// Two coordinates closer than this on both axes count as the same place
+const double LOCATION_MATCH_EPSILON = 0.0001;
+
+bool coordinatesMatch(double lat1, double lon1, double lat2, double lon2, double epsilon = LOCATION_MATCH_EPSILON) {
     return (abs(lat1 - lat2) < epsilon && abs(lon1 - lon2) < epsilon);
 }
 